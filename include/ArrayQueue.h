@@ -1,11 +1,19 @@
 #pragma once
 #include <cassert>
+#include <cstddef>
 #include <iostream>
 #include <iterator>
+#include <memory>
+#include "Config.h"
+#include "ContainerStats.h"
+#include "Expected.h"
+#include "MemoryResource.h"
 
-template<typename E>
-class ArrayQueue {
+template<typename E, typename Alloc = std::allocator<E>>
+class ArrayQueue : private StatsHook, private AllocHolder<Alloc> {
 private:
+    using AllocTraits = std::allocator_traits<Alloc>;
+    using AllocHolder<Alloc>::alloc;
     static const int DEFAULT_CAPACITY = 10;
 
     int n;
@@ -15,34 +23,56 @@ private:
     E* pq;
 
     void resize(int size);
+    bool shrinkInPlace(int size);
 public:
-    explicit ArrayQueue(int cap = DEFAULT_CAPACITY);
+    using allocator_type = Alloc;
+    using StatsHook::setStatsCategory;
+#ifdef CPPLIB_STATS
+    using StatsHook::stats;
+#endif
+
+    explicit ArrayQueue(int cap = DEFAULT_CAPACITY, const Alloc& alloc = Alloc());
+    explicit ArrayQueue(const Alloc& alloc) : ArrayQueue(DEFAULT_CAPACITY, alloc) {}
     ArrayQueue(const ArrayQueue& that);
     ArrayQueue(ArrayQueue&& that) noexcept;
-    ~ArrayQueue() { delete[] pq; }
+    ~ArrayQueue();
 
     int size() const { return n; }
     bool isEmpty() const { return n == 0; }
     void enqueue(E elem);
+    template<typename... Args>
+    void emplace(Args&&... args);
     E dequeue();
-    E front();
-    E back();
+    bool tryDequeue(E& elem);
+    Expected<E> tryDequeue();
+    E popBack();
+    E& front();
+    const E& front() const;
+    E& back();
+    const E& back() const;
     void swap(ArrayQueue& that);
     void clear();
+    allocator_type get_allocator() const { return alloc(); }
 
     ArrayQueue& operator=(ArrayQueue that);
-    template <typename T>
-    friend bool operator==(const ArrayQueue<T>& lhs, const ArrayQueue<T>& rhs);
-    template <typename T>
-    friend bool operator!=(const ArrayQueue<T>& lhs, const ArrayQueue<T>& rhs);
-    template <typename T>
-    friend std::ostream& operator<<(std::ostream& os, const ArrayQueue<T>& queue);
-
-    class iterator : public std::iterator<std::forward_iterator_tag, E> {
+    template <typename T, typename A>
+    friend bool operator==(const ArrayQueue<T, A>& lhs, const ArrayQueue<T, A>& rhs);
+    template <typename T, typename A>
+    friend bool operator!=(const ArrayQueue<T, A>& lhs, const ArrayQueue<T, A>& rhs);
+    template <typename T, typename A>
+    friend std::ostream& operator<<(std::ostream& os, const ArrayQueue<T, A>& queue);
+
+    class iterator {
     private:
         const ArrayQueue* queue;
         int i;
     public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = E;
+        using difference_type = std::ptrdiff_t;
+        using pointer = E*;
+        using reference = E&;
+
         iterator() : queue(nullptr), i(0) {}
         iterator(const ArrayQueue* queue, int i) : queue(queue), i(i) {}
         iterator(const iterator& that) : queue(that.queue), i(that.i) {}
@@ -59,93 +89,216 @@ public:
     iterator end() const { return iterator(this, n); }
 };
 
-template<typename E>
-ArrayQueue<E>::ArrayQueue(int cap) {
+template<typename E, typename Alloc>
+ArrayQueue<E, Alloc>::ArrayQueue(int cap, const Alloc& alloc) : StatsHook("ArrayQueue"), AllocHolder<Alloc>(alloc) {
     n = 0;
     head = 0;
     tail = 0;
     capacity = cap;
-    pq = new E[capacity];
+    pq = capacity > 0 ? AllocTraits::allocate(this->alloc(), capacity) : nullptr;
+    statsAllocate(capacity * sizeof(E));
+    statsCapacity(capacity);
 }
 
-template<typename E>
-ArrayQueue<E>::ArrayQueue(const ArrayQueue& that) {
-    n = that.n;
-    head = that.head;
-    tail = that.tail;
+template<typename E, typename Alloc>
+ArrayQueue<E, Alloc>::ArrayQueue(const ArrayQueue& that)
+    : StatsHook(that), AllocHolder<Alloc>(AllocTraits::select_on_container_copy_construction(that.alloc())) {
+    n = 0;
+    head = 0;
+    tail = 0;
     capacity = that.capacity;
-    pq = new E[capacity];
-    std::copy(that.pq, that.pq + n, pq);
+    pq = capacity > 0 ? AllocTraits::allocate(alloc(), capacity) : nullptr;
+    for (; n < that.n; ++n)
+        AllocTraits::construct(alloc(), pq + n, that.pq[(that.head + n) % that.capacity]);
+    tail = n == capacity ? 0 : n;
+    statsAllocate(capacity * sizeof(E));
+    statsCapacity(capacity);
+    statsSize(n);
 }
 
-template<typename E>
-ArrayQueue<E>::ArrayQueue(ArrayQueue&& that) noexcept {
+template<typename E, typename Alloc>
+ArrayQueue<E, Alloc>::ArrayQueue(ArrayQueue&& that) noexcept
+    : StatsHook(that), AllocHolder<Alloc>(std::move(that.alloc())) {
     n = that.n;
     head = that.head;
     tail = that.tail;
     capacity = that.capacity;
     pq = that.pq;
+    that.n = 0;
+    that.head = 0;
+    that.tail = 0;
+    that.capacity = 0;
     that.pq = nullptr;
 }
 
-template<typename E>
-void ArrayQueue<E>::resize(int size) {
+template<typename E, typename Alloc>
+ArrayQueue<E, Alloc>::~ArrayQueue() {
+    clear();
+    if (pq != nullptr)
+        AllocTraits::deallocate(alloc(), pq, capacity);
+}
+
+template<typename E, typename Alloc>
+void ArrayQueue<E, Alloc>::resize(int size) {
     assert(size >= n);
 
-    E* pnew = new E[size];
+    if (size < capacity && allocCanShrink(alloc(), capacity, size) && shrinkInPlace(size))
+        return;
 
-    for (int i = 0; i < n; ++i)
-        pnew[i] = std::move(pq[(head + i) % capacity]);
+    E* pnew = AllocTraits::allocate(alloc(), size);
+
+    for (int i = 0; i < n; ++i) {
+        E* p = pq + (head + i) % capacity;
+        AllocTraits::construct(alloc(), pnew + i, std::move(*p));
+        AllocTraits::destroy(alloc(), p);
+    }
 
-    delete[] pq;
+    if (pq != nullptr)
+        AllocTraits::deallocate(alloc(), pq, capacity);
+    statsResize(capacity, size, n, size * sizeof(E));
     pq = pnew;
     head = 0;
     tail = n;
     capacity = size;
 }
 
-template<typename E>
-void ArrayQueue<E>::enqueue(E elem) {
+// Compact the ring into [0, size) and let the allocator release the rest.
+template<typename E, typename Alloc>
+bool ArrayQueue<E, Alloc>::shrinkInPlace(int size) {
+    int moved = 0;
+    if (head + n <= capacity) {
+        if (head + n > size) {
+            if (head < n) return false;
+            for (int i = 0; i < n; ++i) {
+                AllocTraits::construct(alloc(), pq + i, std::move(pq[head + i]));
+                AllocTraits::destroy(alloc(), pq + head + i);
+            }
+            head = 0;
+            moved = n;
+        }
+    } else {
+        // Wrapped: move [head, capacity) to the end of the kept prefix
+        int k = capacity - head;
+        if (size - k < tail || size > head) return false;
+        for (int i = 0; i < k; ++i) {
+            AllocTraits::construct(alloc(), pq + size - k + i, std::move(pq[head + i]));
+            AllocTraits::destroy(alloc(), pq + head + i);
+        }
+        head = size - k;
+        moved = k;
+    }
+
+    statsResize(capacity, size, moved, 0);
+    allocShrink(alloc(), pq, capacity, size);
+    capacity = size;
+    tail = (head + n) % capacity;
+    return true;
+}
+
+template<typename E, typename Alloc>
+void ArrayQueue<E, Alloc>::enqueue(E elem) {
+    emplace(std::move(elem));
+}
+
+template<typename E, typename Alloc>
+template<typename... Args>
+void ArrayQueue<E, Alloc>::emplace(Args&&... args) {
     if (n == capacity) 
-        resize(capacity * 2);
+        resize(capacity > 0 ? capacity * 2 : 1);
 
-    pq[tail++] = std::move(elem); 
-    if (tail == capacity) tail = 0;
+    AllocTraits::construct(alloc(), pq + tail, std::forward<Args>(args)...);
+    if (++tail == capacity) tail = 0;
     n++;
+    statsSize(n);
 }
 
-template<typename E>
-E ArrayQueue<E>::dequeue() {
+template<typename E, typename Alloc>
+E ArrayQueue<E, Alloc>::dequeue() {
     if (isEmpty()) 
-        throw std::out_of_range("Queue underflow.");
+        CPPLIB_THROW(std::out_of_range, "Queue underflow.");
+
+    E tmp = std::move(pq[head]);
+    AllocTraits::destroy(alloc(), pq + head++);
+    if (head == capacity) head = 0;
+    n--;
 
-    E tmp = pq[head++];
+    if (n > 0 && n == capacity / 4) 
+        resize(capacity / 2);
+
+    return tmp;
+}
+
+// Move the front element into elem and remove it; return false if empty.
+template<typename E, typename Alloc>
+bool ArrayQueue<E, Alloc>::tryDequeue(E& elem) {
+    if (isEmpty())
+        return false;
+
+    elem = std::move(pq[head]);
+    AllocTraits::destroy(alloc(), pq + head++);
     if (head == capacity) head = 0;
     n--;
 
+    if (n > 0 && n == capacity / 4) 
+        resize(capacity / 2);
+
+    return true;
+}
+
+// Remove and return the front element, or Error::EMPTY.
+template<typename E, typename Alloc>
+Expected<E> ArrayQueue<E, Alloc>::tryDequeue() {
+    if (isEmpty())
+        return Error::EMPTY;
+    return dequeue();
+}
+
+// Remove and return the most recently enqueued element.
+template<typename E, typename Alloc>
+E ArrayQueue<E, Alloc>::popBack() {
+    if (isEmpty())
+        CPPLIB_THROW(std::out_of_range, "Queue underflow.");
+
+    tail = (tail == 0 ? capacity : tail) - 1;
+    E tmp = std::move(pq[tail]);
+    AllocTraits::destroy(alloc(), pq + tail);
+    n--;
+
     if (n > 0 && n == capacity / 4) 
         resize(capacity / 2);
 
     return tmp;
 }
 
-template<typename E>
-E ArrayQueue<E>::front() {
+template<typename E, typename Alloc>
+E& ArrayQueue<E, Alloc>::front() {
+    return const_cast<E&>(static_cast<const ArrayQueue&>(*this).front());
+}
+
+template<typename E, typename Alloc>
+const E& ArrayQueue<E, Alloc>::front() const {
     if (isEmpty()) 
-        throw std::out_of_range("Queue underflow.");
+        CPPLIB_THROW(std::out_of_range, "Queue underflow.");
     return pq[head];
 }
 
-template<typename E>
-E ArrayQueue<E>::back() {
+template<typename E, typename Alloc>
+E& ArrayQueue<E, Alloc>::back() {
+    return const_cast<E&>(static_cast<const ArrayQueue&>(*this).back());
+}
+
+template<typename E, typename Alloc>
+const E& ArrayQueue<E, Alloc>::back() const {
     if (isEmpty()) 
-        throw std::out_of_range("Queue underflow.");
+        CPPLIB_THROW(std::out_of_range, "Queue underflow.");
     return pq[(tail + capacity - 1) % capacity];
 }
 
-template<typename E>
-void ArrayQueue<E>::swap(ArrayQueue<E>& that) {
+template<typename E, typename Alloc>
+void ArrayQueue<E, Alloc>::swap(ArrayQueue<E, Alloc>& that) {
     using std::swap;
+    swapStats(that);
+    swap(alloc(), that.alloc());
     swap(n, that.n);
     swap(head, that.head);
     swap(tail, that.tail);
@@ -153,39 +306,41 @@ void ArrayQueue<E>::swap(ArrayQueue<E>& that) {
     swap(pq, that.pq);
 }
 
-template<typename E>
-void ArrayQueue<E>::clear() {
+template<typename E, typename Alloc>
+void ArrayQueue<E, Alloc>::clear() {
+    for (int i = 0; i < n; ++i)
+        AllocTraits::destroy(alloc(), pq + (head + i) % capacity);
     n = 0;
     head = 0;
     tail = 0;
 }
 
-template<typename E>
-ArrayQueue<E>& ArrayQueue<E>::operator=(ArrayQueue<E> that) {
+template<typename E, typename Alloc>
+ArrayQueue<E, Alloc>& ArrayQueue<E, Alloc>::operator=(ArrayQueue<E, Alloc> that) {
     swap(that);
     return *this;
 }
 
-template<typename E>
-bool operator==(const ArrayQueue<E>& lhs, const ArrayQueue<E>& rhs) {
+template<typename E, typename Alloc>
+bool operator==(const ArrayQueue<E, Alloc>& lhs, const ArrayQueue<E, Alloc>& rhs) {
     if (&lhs == &rhs) return true;
     if (lhs.size() != rhs.size()) return false;
     return std::equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
-template<typename E>
-bool operator!=(const ArrayQueue<E>& lhs, const ArrayQueue<E>& rhs) {
+template<typename E, typename Alloc>
+bool operator!=(const ArrayQueue<E, Alloc>& lhs, const ArrayQueue<E, Alloc>& rhs) {
     return !(lhs == rhs);
 }
 
-template<typename E>
-std::ostream& operator<<(std::ostream& os, const ArrayQueue<E>& queue) {
+template<typename E, typename Alloc>
+std::ostream& operator<<(std::ostream& os, const ArrayQueue<E, Alloc>& queue) {
     for (int i = 0; i < queue.n; ++i)
         os << queue.pq[(queue.head + i) % queue.capacity] << " ";
     return os;
 }
 
-template<typename E>
-void swap(ArrayQueue<E>& lhs, ArrayQueue<E>& rhs) {
+template<typename E, typename Alloc>
+void swap(ArrayQueue<E, Alloc>& lhs, ArrayQueue<E, Alloc>& rhs) {
     lhs.swap(rhs);
 }
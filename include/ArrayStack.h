@@ -1,11 +1,19 @@
 #pragma once
 #include <cassert>
+#include <cstddef>
 #include <iostream>
 #include <iterator>
-
-template<typename E>
-class ArrayStack {
+#include <memory>
+#include "Config.h"
+#include "ContainerStats.h"
+#include "Expected.h"
+#include "MemoryResource.h"
+
+template<typename E, typename Alloc = std::allocator<E>>
+class ArrayStack : private StatsHook, private AllocHolder<Alloc> {
 private:
+    using AllocTraits = std::allocator_traits<Alloc>;
+    using AllocHolder<Alloc>::alloc;
     static const int DEFAULT_CAPACITY = 10;
 
     int n;
@@ -14,32 +22,51 @@ private:
 
     void resize(int size);
 public:
-    explicit ArrayStack(int cap = DEFAULT_CAPACITY);
+    using allocator_type = Alloc;
+    using StatsHook::setStatsCategory;
+#ifdef CPPLIB_STATS
+    using StatsHook::stats;
+#endif
+
+    explicit ArrayStack(int cap = DEFAULT_CAPACITY, const Alloc& alloc = Alloc());
+    explicit ArrayStack(const Alloc& alloc) : ArrayStack(DEFAULT_CAPACITY, alloc) {}
     ArrayStack(const ArrayStack& that);
     ArrayStack(ArrayStack&& that) noexcept;
-    ~ArrayStack() { delete[] ps; }
+    ~ArrayStack();
 
     int size() const { return n; }
     bool isEmpty() const { return n == 0; }
     void push(E elem);
+    template<typename... Args>
+    void emplace(Args&&... args);
     E pop();
-    E top();
+    bool tryPop(E& elem);
+    Expected<E> tryPop();
+    E& top();
+    const E& top() const;
     void swap(ArrayStack& that);
-    void clear() { n = 0; }
+    void clear();
+    allocator_type get_allocator() const { return alloc(); }
 
     ArrayStack& operator=(ArrayStack that);
-    template <typename T>
-    friend bool operator==(const ArrayStack<T>& lhs, const ArrayStack<T>& rhs);
-    template <typename T>
-    friend bool operator!=(const ArrayStack<T>& lhs, const ArrayStack<T>& rhs);
-    template <typename T>
-    friend std::ostream& operator<<(std::ostream& os, const ArrayStack<T>& stack);
-
-    class iterator : public std::iterator<std::forward_iterator_tag, E> {
+    template <typename T, typename A>
+    friend bool operator==(const ArrayStack<T, A>& lhs, const ArrayStack<T, A>& rhs);
+    template <typename T, typename A>
+    friend bool operator!=(const ArrayStack<T, A>& lhs, const ArrayStack<T, A>& rhs);
+    template <typename T, typename A>
+    friend std::ostream& operator<<(std::ostream& os, const ArrayStack<T, A>& stack);
+
+    class iterator {
     private:
         const ArrayStack* stack;
         int i;
     public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = E;
+        using difference_type = std::ptrdiff_t;
+        using pointer = E*;
+        using reference = E&;
+
         iterator() : stack(nullptr), i(0) {}
         iterator(const ArrayStack* stack, int i) : stack(stack), i(i) {}
         iterator(const iterator& that) : stack(that.stack), i(that.i) {}
@@ -56,98 +83,168 @@ public:
     iterator end() const { return iterator(this, n); }
 };
 
-template<typename E>
-ArrayStack<E>::ArrayStack(int cap) {
+template<typename E, typename Alloc>
+ArrayStack<E, Alloc>::ArrayStack(int cap, const Alloc& alloc) : StatsHook("ArrayStack"), AllocHolder<Alloc>(alloc) {
     n = 0;
     capacity = cap;
-    ps = new E[capacity];
+    ps = capacity > 0 ? AllocTraits::allocate(this->alloc(), capacity) : nullptr;
+    statsAllocate(capacity * sizeof(E));
+    statsCapacity(capacity);
 }
 
-template<typename E>
-ArrayStack<E>::ArrayStack(const ArrayStack& that) {
-    n = that.n;
+template<typename E, typename Alloc>
+ArrayStack<E, Alloc>::ArrayStack(const ArrayStack& that)
+    : StatsHook(that), AllocHolder<Alloc>(AllocTraits::select_on_container_copy_construction(that.alloc())) {
+    n = 0;
     capacity = that.capacity;
-    ps = new E[capacity];
-    for (int i = 0; i < n; ++i)
-        ps[i] = that.ps[i];
+    ps = capacity > 0 ? AllocTraits::allocate(alloc(), capacity) : nullptr;
+    for (; n < that.n; ++n)
+        AllocTraits::construct(alloc(), ps + n, that.ps[n]);
+    statsAllocate(capacity * sizeof(E));
+    statsCapacity(capacity);
+    statsSize(n);
 }
 
-template<typename E>
-ArrayStack<E>::ArrayStack(ArrayStack&& that) noexcept {
+template<typename E, typename Alloc>
+ArrayStack<E, Alloc>::ArrayStack(ArrayStack&& that) noexcept
+    : StatsHook(that), AllocHolder<Alloc>(std::move(that.alloc())) {
     n = that.n;
     capacity = that.capacity;
     ps = that.ps;
+    that.n = 0;
+    that.capacity = 0;
     that.ps = nullptr;
 }
 
-template<typename E>
-void ArrayStack<E>::resize(int size) {
+template<typename E, typename Alloc>
+ArrayStack<E, Alloc>::~ArrayStack() {
+    clear();
+    if (ps != nullptr)
+        AllocTraits::deallocate(alloc(), ps, capacity);
+}
+
+template<typename E, typename Alloc>
+void ArrayStack<E, Alloc>::resize(int size) {
     assert(size >= n);
-    E* pnew = new E[size];
-    std::move(ps, ps + n, pnew);
-    delete[] ps;
+    if (size < capacity && allocCanShrink(alloc(), capacity, size)) {
+        statsResize(capacity, size, 0, 0);
+        allocShrink(alloc(), ps, capacity, size);
+        capacity = size;
+        return;
+    }
+    E* pnew = AllocTraits::allocate(alloc(), size);
+    for (int i = 0; i < n; ++i) {
+        AllocTraits::construct(alloc(), pnew + i, std::move(ps[i]));
+        AllocTraits::destroy(alloc(), ps + i);
+    }
+    if (ps != nullptr)
+        AllocTraits::deallocate(alloc(), ps, capacity);
+    statsResize(capacity, size, n, size * sizeof(E));
     ps = pnew;
     capacity = size;
 }
 
-template<typename E>
-void ArrayStack<E>::push(E elem) {
+template<typename E, typename Alloc>
+void ArrayStack<E, Alloc>::push(E elem) {
+    emplace(std::move(elem));
+}
+
+template<typename E, typename Alloc>
+template<typename... Args>
+void ArrayStack<E, Alloc>::emplace(Args&&... args) {
     if (n == capacity) 
-        resize(capacity * 2);
-    ps[n++] = std::move(elem);
+        resize(capacity > 0 ? capacity * 2 : 1);
+    AllocTraits::construct(alloc(), ps + n, std::forward<Args>(args)...);
+    n++;
+    statsSize(n);
 }
 
-template<typename E>
-E ArrayStack<E>::pop() {
+template<typename E, typename Alloc>
+E ArrayStack<E, Alloc>::pop() {
     if (isEmpty()) 
-        throw std::out_of_range("Stack underflow.");
-    E tmp = ps[--n];
+        CPPLIB_THROW(std::out_of_range, "Stack underflow.");
+    E tmp = std::move(ps[--n]);
+    AllocTraits::destroy(alloc(), ps + n);
     if (n > 0 && n == capacity / 4) 
         resize(capacity / 2);
     return tmp;
 }
 
-template<typename E>
-E ArrayStack<E>::top() {
+// Move the top element into elem and remove it; return false if empty.
+template<typename E, typename Alloc>
+bool ArrayStack<E, Alloc>::tryPop(E& elem) {
+    if (isEmpty()) 
+        return false;
+    elem = std::move(ps[--n]);
+    AllocTraits::destroy(alloc(), ps + n);
+    if (n > 0 && n == capacity / 4) 
+        resize(capacity / 2);
+    return true;
+}
+
+// Remove and return the top element, or Error::EMPTY.
+template<typename E, typename Alloc>
+Expected<E> ArrayStack<E, Alloc>::tryPop() {
+    if (isEmpty())
+        return Error::EMPTY;
+    return pop();
+}
+
+template<typename E, typename Alloc>
+E& ArrayStack<E, Alloc>::top() {
+    return const_cast<E&>(static_cast<const ArrayStack&>(*this).top());
+}
+
+template<typename E, typename Alloc>
+const E& ArrayStack<E, Alloc>::top() const {
     if (isEmpty()) 
-        throw std::out_of_range("Stack underflow.");
+        CPPLIB_THROW(std::out_of_range, "Stack underflow.");
     return ps[n - 1];
 }
 
-template<typename E>
-void ArrayStack<E>::swap(ArrayStack<E>& that) {
+template<typename E, typename Alloc>
+void ArrayStack<E, Alloc>::swap(ArrayStack<E, Alloc>& that) {
     using std::swap;
+    swapStats(that);
+    swap(alloc(), that.alloc());
     swap(n, that.n);
     swap(capacity, that.capacity);
     swap(ps, that.ps);
 }
 
-template<typename E>
-ArrayStack<E>& ArrayStack<E>::operator=(ArrayStack that) {
+template<typename E, typename Alloc>
+void ArrayStack<E, Alloc>::clear() {
+    for (int i = 0; i < n; ++i)
+        AllocTraits::destroy(alloc(), ps + i);
+    n = 0;
+}
+
+template<typename E, typename Alloc>
+ArrayStack<E, Alloc>& ArrayStack<E, Alloc>::operator=(ArrayStack that) {
     swap(that);
     return *this;
 }
 
-template<typename E>
-bool operator==(const ArrayStack<E>& lhs, const ArrayStack<E>& rhs) {
+template<typename E, typename Alloc>
+bool operator==(const ArrayStack<E, Alloc>& lhs, const ArrayStack<E, Alloc>& rhs) {
     if (&lhs == &rhs) return true;
     if (lhs.size() != rhs.size()) return false;
     return std::equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
-template<typename E>
-bool operator!=(const ArrayStack<E>& lhs, const ArrayStack<E>& rhs) {
+template<typename E, typename Alloc>
+bool operator!=(const ArrayStack<E, Alloc>& lhs, const ArrayStack<E, Alloc>& rhs) {
     return !(lhs == rhs);
 }
 
-template<typename E>
-std::ostream& operator<<(std::ostream& os, const ArrayStack<E>& stack) {
+template<typename E, typename Alloc>
+std::ostream& operator<<(std::ostream& os, const ArrayStack<E, Alloc>& stack) {
     for (int i = 0; i < stack.n; ++i)
         os << stack.ps[i] << " ";
     return os;
 }
 
-template<typename E>
-void swap(ArrayStack<E>& lhs, ArrayStack<E>& rhs) {
+template<typename E, typename Alloc>
+void swap(ArrayStack<E, Alloc>& lhs, ArrayStack<E, Alloc>& rhs) {
     lhs.swap(rhs);
 }
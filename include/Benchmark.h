@@ -0,0 +1,97 @@
+/*******************************************************************************
+ * Benchmark.h
+ *
+ * Timing harness shared by the demo drivers in src/.
+ ******************************************************************************/
+
+#pragma once
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "PerfCounters.h"
+
+/**
+ * Benchmark, used to time a batch of operations and print one table row per
+ * run: total seconds, nanoseconds per operation and million operations per
+ * second, followed by each event of PerfCounters that can be counted here,
+ * per operation. Where no counter can be opened the rows hold time alone.
+ * Runs are timed with the steady clock at its full resolution, not the
+ * milliseconds of Timer, so short runs still give exact rates.
+ */
+class Benchmark
+{
+private:
+    std::ostream& os;
+    std::unique_ptr<PerfCounters> perf; // nullptr if counters are off
+public:
+    explicit Benchmark(std::ostream& os = std::cout, bool counters = true)
+        : os(os), perf(counters ? new PerfCounters() : nullptr) {}
+
+    // Print a title line followed by the column header
+    void header(const std::string& title);
+    // Time f(), which performs ops operations, print one row and return seconds
+    template<typename F>
+    double run(const std::string& name, size_t ops, F f);
+    // Keep the compiler from discarding a computed value
+    template<typename T>
+    static void keep(const T& value) { asm volatile("" : : "r"(&value) : "memory"); }
+};
+
+/**
+ * Print a title line followed by the column header.
+ *
+ * @param title: Title of the table
+ */
+inline void Benchmark::header(const std::string& title)
+{
+    os << title << std::endl;
+    os << std::left << std::setw(28) << "CASE" << std::right
+       << std::setw(10) << "seconds" << std::setw(12) << "ns/op" << std::setw(12) << "Mops/s";
+    for (int e = 0; perf != nullptr && e < PERF_EVENT_COUNT; ++e)
+    {
+        if (perf->available(static_cast<PerfEvent>(e)))
+            os << std::setw(12) << std::string(PerfCounters::name(static_cast<PerfEvent>(e))) + "/op";
+    }
+    os << std::endl;
+}
+
+/**
+ * Time f(), which performs ops operations, and print one row.
+ *
+ * @param name: Name of the row
+ * @param ops: Number of operations f performs
+ * @param f: Callable running the operations
+ * @return Seconds taken by f
+ */
+template<typename F>
+double Benchmark::run(const std::string& name, size_t ops, F f)
+{
+    using clock = std::chrono::steady_clock;
+    PerfReading counts;
+    clock::time_point start = clock::now();
+    if (perf != nullptr)
+    {
+        PerfScope scope(*perf, counts);
+        f();
+    }
+    else
+    {
+        f();
+    }
+    double secs = std::chrono::duration<double>(clock::now() - start).count();
+    double ns = ops > 0 ? secs * 1e9 / ops : 0.0;
+    double mops = secs > 0 ? ops / secs / 1e6 : 0.0;
+    os << std::left << std::setw(28) << name << std::right << std::fixed
+       << std::setw(10) << std::setprecision(6) << secs
+       << std::setprecision(3) << std::setw(12) << ns << std::setw(12) << mops;
+    for (int e = 0; perf != nullptr && e < PERF_EVENT_COUNT; ++e)
+    {
+        if (perf->available(static_cast<PerfEvent>(e)))
+            os << std::setw(12) << (counts.has[e] && ops > 0 ? counts.value[e] / ops : 0.0);
+    }
+    os << std::endl;
+    os.unsetf(std::ios::fixed);
+    return secs;
+}
@@ -0,0 +1,468 @@
+#pragma once
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include "Config.h"
+#include "Simd.h"
+#include "Vector.h"
+
+/**
+ * Bit vector packed into 64-bit words, one bit per flag instead of the byte
+ * a Vector<bool> element takes, and a rank/select index over it.
+ *
+ * Bits past size() in the last word are kept zero, so counting never has
+ * to mask them out.
+ */
+
+/**
+ * Word kernels. HW uses the popcnt instruction and PDEP the BMI2 pdep
+ * instruction; those variants are only inlined into functions compiled for
+ * them, and the portable variant uses broadword arithmetic.
+ */
+template<bool HW, bool PDEP>
+struct BitKernel {
+    static CPPLIB_ALWAYS_INLINE int pop(uint64_t w) {
+        w = w - ((w >> 1) & 0x5555555555555555ULL);
+        w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+        w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        return static_cast<int>((w * 0x0101010101010101ULL) >> 56);
+    }
+    // Return the position of the k-th (from 0) set bit of w, which has more than k
+    static CPPLIB_ALWAYS_INLINE int select(uint64_t w, int k) {
+        int pos = 0;
+        for (int c = BitKernel::pop(w & 0xffffffffULL); k >= c; c = BitKernel::pop(w & 0xffffffffULL)) {
+            k -= c;
+            w >>= 32;
+            pos += 32;
+        }
+        for (int c = BitKernel::pop(w & 0xff); k >= c; c = BitKernel::pop(w & 0xff)) {
+            k -= c;
+            w >>= 8;
+            pos += 8;
+        }
+        for (; k > 0; --k)
+            w &= w - 1;
+        return pos + __builtin_ctzll(w);
+    }
+};
+
+#ifdef CPPLIB_SIMD_X86
+template<>
+struct BitKernel<true, false> {
+    static CPPLIB_ALWAYS_INLINE int pop(uint64_t w) { return __builtin_popcountll(w); }
+    static CPPLIB_ALWAYS_INLINE int select(uint64_t w, int k) { return BitKernel<false, false>::select(w, k); }
+};
+
+#ifdef __x86_64__
+// pdep is emitted with asm: its builtin is unavailable outside bmi2 functions,
+// and the kernels are templates without a target of their own
+template<>
+struct BitKernel<true, true> {
+    static CPPLIB_ALWAYS_INLINE int pop(uint64_t w) { return __builtin_popcountll(w); }
+    static CPPLIB_ALWAYS_INLINE int select(uint64_t w, int k) {
+        uint64_t bit;
+        asm("pdep %2, %1, %0" : "=r"(bit) : "r"(uint64_t(1) << k), "r"(w));
+        return __builtin_ctzll(bit);
+    }
+};
+#endif
+
+__attribute__((target("popcnt")))
+inline size_t bitCountPopcnt(const uint64_t* p, size_t n) {
+    size_t c = 0;
+    for (size_t i = 0; i < n; ++i)
+        c += BitKernel<true, false>::pop(p[i]);
+    return c;
+}
+
+#endif
+
+/**
+ * Instruction set the bit kernels dispatch to: 0 portable, 1 popcnt,
+ * 2 popcnt and BMI2. Capped to portable when simdLevel() is SCALAR.
+ */
+inline int bitLevel() {
+#ifdef CPPLIB_SIMD_X86
+#ifdef __x86_64__
+    static const int detected = (__builtin_cpu_init(), __builtin_cpu_supports("popcnt"))
+                                ? (__builtin_cpu_supports("bmi2") ? 2 : 1) : 0;
+#else
+    static const int detected = (__builtin_cpu_init(), __builtin_cpu_supports("popcnt")) ? 1 : 0;
+#endif
+    return simdLevel() == SimdLevel::SCALAR ? 0 : detected;
+#else
+    return 0;
+#endif
+}
+
+// Return the number of set bits in w
+inline int bitCount(uint64_t w) {
+#ifdef __POPCNT__
+    return __builtin_popcountll(w);
+#else
+    return BitKernel<false, false>::pop(w);
+#endif
+}
+
+// Return the number of set bits in p[0, n)
+inline size_t bitCount(const uint64_t* p, size_t n) {
+#ifdef CPPLIB_SIMD_X86
+    if (bitLevel() > 0)
+        return bitCountPopcnt(p, n);
+#endif
+    size_t c = 0;
+    for (size_t i = 0; i < n; ++i)
+        c += bitCount(p[i]);
+    return c;
+}
+
+// Return the position of the k-th (from 0) set bit of w, which has more than k
+inline int bitSelect(uint64_t w, int k) {
+#ifdef __x86_64__
+    if (bitLevel() == 2)
+        return BitKernel<true, true>::select(w, k);
+#endif
+    return BitKernel<false, false>::select(w, k);
+}
+
+template<typename Alloc = std::allocator<uint64_t>>
+class BitVector {
+private:
+    static const size_t WORD = 64;
+
+    Vector<uint64_t, Alloc> words;
+    size_t n;
+
+    static uint64_t maskFrom(size_t i) { return ~uint64_t(0) << (i % WORD); }
+    static uint64_t maskTo(size_t i) { return i % WORD == 0 ? ~uint64_t(0) : ~(~uint64_t(0) << (i % WORD)); }
+    static int wordsFor(size_t bits);
+    // Apply op(word, mask) to the words covering [first, last)
+    template<typename Op>
+    void apply(size_t first, size_t last, Op op);
+    void trim() { if (n % WORD != 0) words.back() &= maskTo(n); }
+public:
+    using allocator_type = Alloc;
+
+    explicit BitVector(size_t bits = 0, bool value = false, const Alloc& alloc = Alloc());
+
+    // Return the number of bits
+    size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    bool operator[](size_t i) const { return (words[i / WORD] >> (i % WORD)) & 1; }
+    // Return the bit at i, with bounds checking
+    bool at(size_t i) const;
+    void set(size_t i) { words[i / WORD] |= uint64_t(1) << (i % WORD); }
+    void set(size_t i, bool value) { if (value) set(i); else reset(i); }
+    void reset(size_t i) { words[i / WORD] &= ~(uint64_t(1) << (i % WORD)); }
+    void flip(size_t i) { words[i / WORD] ^= uint64_t(1) << (i % WORD); }
+    // Set, clear or flip every bit in [first, last)
+    void setRange(size_t first, size_t last) { apply(first, last, [](uint64_t& w, uint64_t m) { w |= m; }); }
+    void resetRange(size_t first, size_t last) { apply(first, last, [](uint64_t& w, uint64_t m) { w &= ~m; }); }
+    void flipRange(size_t first, size_t last) { apply(first, last, [](uint64_t& w, uint64_t m) { w ^= m; }); }
+    // Add a bit to the end
+    void insert_back(bool value);
+    // Change the number of bits; new bits take value
+    void resize(size_t bits, bool value = false);
+    // Return the number of set bits
+    size_t count() const { return bitCount(words.begin(), words.size()); }
+    // Return the number of set bits in [first, last)
+    size_t count(size_t first, size_t last) const;
+    // Return the underlying words; bit i is bit i % 64 of word i / 64
+    const uint64_t* data() const { return words.begin(); }
+    int wordCount() const { return words.size(); }
+    allocator_type get_allocator() const { return words.get_allocator(); }
+
+    BitVector& operator&=(const BitVector& that);
+    BitVector& operator|=(const BitVector& that);
+    BitVector& operator^=(const BitVector& that);
+    template<typename A>
+    friend bool operator==(const BitVector<A>& lhs, const BitVector<A>& rhs);
+    template<typename A>
+    friend bool operator!=(const BitVector<A>& lhs, const BitVector<A>& rhs);
+};
+
+template<typename Alloc>
+int BitVector<Alloc>::wordsFor(size_t bits) {
+    size_t count = (bits + WORD - 1) / WORD;
+    if (count > INT_MAX)
+        CPPLIB_THROW(std::length_error, "BitVector too large.");
+    return static_cast<int>(count);
+}
+
+template<typename Alloc>
+BitVector<Alloc>::BitVector(size_t bits, bool value, const Alloc& alloc) : words(wordsFor(bits), alloc), n(0) {
+    resize(bits, value);
+}
+
+template<typename Alloc>
+bool BitVector<Alloc>::at(size_t i) const {
+    if (i >= n)
+        CPPLIB_THROW(std::out_of_range, "BitVector::at");
+    return (*this)[i];
+}
+
+template<typename Alloc>
+template<typename Op>
+void BitVector<Alloc>::apply(size_t first, size_t last, Op op) {
+    if (first > last || last > n)
+        CPPLIB_THROW(std::out_of_range, "BitVector range");
+    if (first == last)
+        return;
+    size_t lo = first / WORD;
+    size_t hi = (last - 1) / WORD;
+    if (lo == hi) {
+        op(words[lo], maskFrom(first) & maskTo(last));
+        return;
+    }
+    op(words[lo], maskFrom(first));
+    for (size_t i = lo + 1; i < hi; ++i)
+        op(words[i], ~uint64_t(0));
+    op(words[hi], maskTo(last));
+}
+
+template<typename Alloc>
+void BitVector<Alloc>::insert_back(bool value) {
+    if (n % WORD == 0)
+        words.insert_back(0);
+    if (value)
+        words.back() |= uint64_t(1) << (n % WORD);
+    n++;
+}
+
+template<typename Alloc>
+void BitVector<Alloc>::resize(size_t bits, bool value) {
+    int count = wordsFor(bits);
+    while (words.size() > count)
+        words.remove_back();
+    if (bits < n) {
+        n = bits;
+        trim();
+        return;
+    }
+    size_t old = n;
+    while (words.size() < count)
+        words.insert_back(value ? ~uint64_t(0) : 0);
+    n = bits;
+    if (value && old % WORD != 0)
+        words[old / WORD] |= maskFrom(old);
+    trim();
+}
+
+template<typename Alloc>
+size_t BitVector<Alloc>::count(size_t first, size_t last) const {
+    if (first > last || last > n)
+        CPPLIB_THROW(std::out_of_range, "BitVector range");
+    if (first == last)
+        return 0;
+    size_t lo = first / WORD;
+    size_t hi = (last - 1) / WORD;
+    if (lo == hi)
+        return bitCount(words[lo] & maskFrom(first) & maskTo(last));
+    return bitCount(words[lo] & maskFrom(first)) + bitCount(words.begin() + lo + 1, hi - lo - 1)
+           + bitCount(words[hi] & maskTo(last));
+}
+
+template<typename Alloc>
+BitVector<Alloc>& BitVector<Alloc>::operator&=(const BitVector& that) {
+    if (n != that.n)
+        CPPLIB_THROW(std::invalid_argument, "BitVector sizes differ.");
+    for (int i = 0; i < words.size(); ++i)
+        words[i] &= that.words[i];
+    return *this;
+}
+
+template<typename Alloc>
+BitVector<Alloc>& BitVector<Alloc>::operator|=(const BitVector& that) {
+    if (n != that.n)
+        CPPLIB_THROW(std::invalid_argument, "BitVector sizes differ.");
+    for (int i = 0; i < words.size(); ++i)
+        words[i] |= that.words[i];
+    return *this;
+}
+
+template<typename Alloc>
+BitVector<Alloc>& BitVector<Alloc>::operator^=(const BitVector& that) {
+    if (n != that.n)
+        CPPLIB_THROW(std::invalid_argument, "BitVector sizes differ.");
+    for (int i = 0; i < words.size(); ++i)
+        words[i] ^= that.words[i];
+    return *this;
+}
+
+template<typename A>
+bool operator==(const BitVector<A>& lhs, const BitVector<A>& rhs) {
+    return lhs.n == rhs.n && simdEqual(lhs.words.begin(), rhs.words.begin(), lhs.words.size());
+}
+
+template<typename A>
+bool operator!=(const BitVector<A>& lhs, const BitVector<A>& rhs) {
+    return !(lhs == rhs);
+}
+
+/**
+ * Rank/select index over the words of a bit vector, after Zhou, Andersen
+ * and Kaminsky's Poppy layout. The bits are split into 2048-bit blocks of
+ * four 512-bit basic blocks; each block has one 64-bit entry holding the
+ * number of ones before it (32 bits, relative to its 2^32-bit segment) and
+ * the counts of its first three basic blocks (10 bits each). Segments have
+ * a 64-bit count each. That is 3.1% of space, plus 0.4% at most for select
+ * samples: the block of every 8192nd one.
+ *
+ * rank1() reads one entry and popcounts at most 8 words. select1() binary
+ * searches the entries between the samples around the wanted one, at most
+ * log2 of the blocks in a segment steps however sparse the bits are, then
+ * steps over at most 3 basic blocks and 8 words and selects within one. Both are compiled for popcnt (and
+ * BMI2 pdep for select) and picked by bitLevel() when the index is built.
+ *
+ * The index refers to the bits it was built over, which must neither change
+ * nor move while it is used.
+ */
+class RankSelect {
+private:
+    static const size_t BLOCK = 2048;
+    static const size_t BASIC = 512;
+    static const size_t SEGMENT_BITS = 32;
+    static const size_t SAMPLE = 8192;
+
+    const uint64_t* bits;
+    size_t n;
+    size_t ones;
+    Vector<uint64_t> entries;
+    Vector<uint64_t> segments;
+    Vector<uint32_t> samples;
+
+    int level;
+
+    static uint32_t basicCount(uint64_t entry, size_t k) { return (entry >> (32 + 10 * k)) & 1023; }
+    template<bool HW, bool PDEP>
+    CPPLIB_ALWAYS_INLINE size_t rankKernel(size_t i) const;
+    template<bool HW, bool PDEP>
+    CPPLIB_ALWAYS_INLINE size_t selectKernel(size_t k) const;
+#ifdef CPPLIB_SIMD_X86
+    __attribute__((target("popcnt"))) size_t rankPopcnt(size_t i) const { return rankKernel<true, false>(i); }
+    __attribute__((target("popcnt"))) size_t selectPopcnt(size_t k) const { return selectKernel<true, false>(k); }
+#endif
+#ifdef __x86_64__
+    __attribute__((target("popcnt,bmi2"))) size_t selectBmi2(size_t k) const { return selectKernel<true, true>(k); }
+#endif
+public:
+    RankSelect(const uint64_t* bits, size_t n);
+    template<typename A>
+    explicit RankSelect(const BitVector<A>& bv) : RankSelect(bv.data(), bv.size()) {}
+
+    // Return the number of ones in [0, i), for i <= size()
+    size_t rank1(size_t i) const;
+    // Return the number of zeros in [0, i), for i <= size()
+    size_t rank0(size_t i) const { return i - rank1(i); }
+    // Return the position of the k-th one, counting from 0
+    size_t select1(size_t k) const;
+    size_t size() const { return n; }
+    // Return the total number of ones
+    size_t count() const { return ones; }
+    // Return the bytes the index takes besides the bits
+    size_t bytes() const;
+};
+
+inline RankSelect::RankSelect(const uint64_t* bits, size_t n)
+    : bits(bits), n(n), ones(0), entries(static_cast<int>(n / BLOCK + 2)),
+      segments(static_cast<int>((n >> SEGMENT_BITS) + 2)), samples(0), level(bitLevel()) {
+    size_t words = (n + 63) / 64;
+    size_t blocks = n / BLOCK + 1;    // one more so rank1(n) never reads past the end
+    for (size_t b = 0; b < blocks; ++b) {
+        if (b % (size_t(1) << (SEGMENT_BITS - 11)) == 0)
+            segments.insert_back(ones);
+        uint64_t entry = ones - segments.back();
+        for (size_t k = 0; k < 4; ++k) {
+            size_t lo = b * (BLOCK / 64) + k * (BASIC / 64);
+            size_t hi = lo + BASIC / 64 < words ? lo + BASIC / 64 : words;
+            size_t c = lo < hi ? bitCount(bits + lo, hi - lo) : 0;
+            if (k < 3)
+                entry |= uint64_t(c) << (32 + 10 * k);
+            for (; c > 0 && ones + c > samples.size() * SAMPLE; )
+                samples.insert_back(static_cast<uint32_t>(b));
+            ones += c;
+        }
+        entries.insert_back(entry);
+    }
+}
+
+template<bool HW, bool PDEP>
+size_t RankSelect::rankKernel(size_t i) const {
+    size_t b = i / BLOCK;
+    uint64_t entry = entries[b];
+    size_t r = segments[i >> SEGMENT_BITS] + static_cast<uint32_t>(entry);
+    size_t k = (i / BASIC) % 4;
+    for (size_t j = 0; j < k; ++j)
+        r += basicCount(entry, j);
+    size_t lo = i / BASIC * (BASIC / 64);
+    size_t hi = i / 64;
+    for (size_t w = lo; w < hi; ++w)
+        r += BitKernel<HW, PDEP>::pop(bits[w]);
+    if (i % 64 != 0)
+        r += BitKernel<HW, PDEP>::pop(bits[hi] & ~(~uint64_t(0) << (i % 64)));
+    return r;
+}
+
+template<bool HW, bool PDEP>
+size_t RankSelect::selectKernel(size_t k) const {
+    size_t s = 0;
+    while (s + 1 < static_cast<size_t>(segments.size()) && segments[s + 1] <= k)
+        ++s;
+    size_t blocks = entries.size();
+    size_t first = s << (SEGMENT_BITS - 11);
+    size_t end = (s + 1) << (SEGMENT_BITS - 11) < blocks ? (s + 1) << (SEGMENT_BITS - 11) : blocks;
+    // The k-th one lies between the blocks of the samples before and after it,
+    // which on a sparse bitmap can be far apart: binary search that run
+    size_t b = samples[k / SAMPLE] > first ? samples[k / SAMPLE] : first;
+    size_t next = k / SAMPLE + 1 < static_cast<size_t>(samples.size()) ? samples[k / SAMPLE + 1] + size_t(1) : end;
+    size_t hi = next < end ? next : end;
+    size_t rem = k - segments[s];
+    while (hi - b > 1) {
+        size_t mid = b + (hi - b) / 2;
+        if (static_cast<uint32_t>(entries[mid]) <= rem)
+            b = mid;
+        else
+            hi = mid;
+    }
+    uint64_t entry = entries[b];
+    rem -= static_cast<uint32_t>(entry);
+    size_t basic = 0;
+    for (; basic < 3 && rem >= basicCount(entry, basic); ++basic)
+        rem -= basicCount(entry, basic);
+    size_t w = b * (BLOCK / 64) + basic * (BASIC / 64);
+    for (int c = BitKernel<HW, PDEP>::pop(bits[w]); rem >= static_cast<size_t>(c);
+         c = BitKernel<HW, PDEP>::pop(bits[w])) {
+        rem -= c;
+        ++w;
+    }
+    return w * 64 + BitKernel<HW, PDEP>::select(bits[w], static_cast<int>(rem));
+}
+
+inline size_t RankSelect::rank1(size_t i) const {
+#ifdef CPPLIB_SIMD_X86
+    if (level > 0)
+        return rankPopcnt(i);
+#endif
+    return rankKernel<false, false>(i);
+}
+
+inline size_t RankSelect::select1(size_t k) const {
+    if (k >= ones)
+        CPPLIB_THROW(std::out_of_range, "RankSelect::select1");
+#ifdef __x86_64__
+    if (level == 2)
+        return selectBmi2(k);
+#endif
+#ifdef CPPLIB_SIMD_X86
+    if (level == 1)
+        return selectPopcnt(k);
+#endif
+    return selectKernel<false, false>(k);
+}
+
+inline size_t RankSelect::bytes() const {
+    return entries.size() * sizeof(uint64_t) + segments.size() * sizeof(uint64_t)
+           + samples.size() * sizeof(uint32_t);
+}
@@ -0,0 +1,268 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include "Config.h"
+#include "Hash.h"
+#include "MemoryResource.h"
+#include "Simd.h"
+#include "StringView.h"
+
+/**
+ * Blocked Bloom filter: a set membership test with no false negatives and a
+ * configurable false-positive rate, meant to turn away lookups of absent
+ * keys before they reach a slower table.
+ *
+ * The bits are split into 32-byte blocks, aligned so a block never spans
+ * two cache lines, and allocated from a MemoryResource. A key sets one bit in each of the eight 32-bit words of
+ * the block its hash selects, so inserting or testing it touches one cache
+ * line, and the eight bit positions are computed lane-parallel with one
+ * multiply and one shift each (the split block layout used by Parquet).
+ * Blocking costs a few more bits per key than a classic Bloom filter at the
+ * same rate; the constructor sizes the filter for the blocked layout.
+ *
+ * The bulk contains() hashes a batch of keys, prefetches their blocks and
+ * then tests them, using AVX2 when simdLevel() allows.
+ *
+ * save() writes the bits in native byte order after a short header; load()
+ * reads them back with one read of the whole array.
+ *
+ * A moved-from filter has no bits: it contains nothing, copies to another
+ * such filter and can be assigned to, but insert() on it fails.
+ */
+class BloomFilter {
+private:
+    static const uint64_t MAGIC = 0x314d4f4f4c42504cULL;    // "LPBLOOM1"
+    static const size_t BATCH = 16;
+
+    struct Block {
+        uint32_t w[8];
+    };
+
+    MemoryResource* resource;
+    size_t nb;
+    Block* blocks;    // Aligned to a cache line
+
+    // Private tag constructor: nb zeroed blocks
+    BloomFilter(size_t nb, MemoryResource* resource, int);
+    static size_t blocksFor(size_t count, double fpr);
+    size_t blockOf(uint64_t hash) const { return ((hash >> 32) * nb) >> 32; }
+    static double blockedRate(double bitsPerKey);
+public:
+    explicit BloomFilter(size_t count, double fpr = 0.01, MemoryResource* resource = newDeleteResource());
+    BloomFilter(const BloomFilter& that);
+    BloomFilter(BloomFilter&& that) noexcept;
+    ~BloomFilter() { if (blocks != nullptr) resource->deallocate(blocks, bytes(), 64); }
+    BloomFilter& operator=(BloomFilter that);
+
+    void insert(StringView key) { insertHash(hashBytes(key.data(), key.size())); }
+    void insertHash(uint64_t hash);
+    bool contains(StringView key) const { return containsHash(hashBytes(key.data(), key.size())); }
+    bool containsHash(uint64_t hash) const;
+    // Set out[i] to contains(keys[i]) for i < n; return the number of hits
+    size_t contains(const StringView* keys, size_t n, bool* out) const;
+    size_t containsHash(const uint64_t* hashes, size_t n, bool* out) const;
+    void clear();
+    // Return the size of the bit array in bytes
+    size_t bytes() const { return nb * sizeof(Block); }
+    // Return the expected false-positive rate after inserting count distinct keys
+    double falsePositiveRate(size_t count) const { return blockedRate(8.0 * bytes() / (count > 0 ? count : 1)); }
+
+    void save(std::ostream& os) const;
+    static BloomFilter load(std::istream& is, MemoryResource* resource = newDeleteResource());
+};
+
+/**
+ * Lane kernels. Members are always inlined so each ISA entry point compiles
+ * them with its own target.
+ */
+struct BloomKernel {
+    typedef uint32_t Lanes __attribute__((vector_size(32)));
+
+    // Set one bit per lane, chosen by the low 32 bits of the hash
+    static CPPLIB_ALWAYS_INLINE void mask(uint64_t hash, Lanes* m) {
+        const Lanes salt = { 0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                             0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U };
+        Lanes key = Lanes{} + static_cast<uint32_t>(hash);
+        *m = (Lanes{} + 1) << ((key * salt) >> 27);
+    }
+
+    static CPPLIB_ALWAYS_INLINE bool test(const void* block, uint64_t hash) {
+        Lanes m, b;
+        mask(hash, &m);
+        std::memcpy(&b, block, sizeof(b));
+        Lanes miss = m & ~b;
+        uint64_t w[4];
+        std::memcpy(w, &miss, sizeof(w));
+        return (w[0] | w[1] | w[2] | w[3]) == 0;
+    }
+
+    // Test n hashes against blocks: prefetch a batch, then probe it
+    template<size_t B>
+    static CPPLIB_ALWAYS_INLINE size_t probe(const char* blocks, size_t nb, const uint64_t* hashes, size_t n,
+                                             bool* out) {
+        size_t hits = 0;
+        for (size_t i = 0; i < n; i += B) {
+            size_t end = n - i < B ? n : i + B;
+            size_t at[B];
+            for (size_t j = i; j < end; ++j) {
+                at[j - i] = ((hashes[j] >> 32) * nb) >> 32;
+                __builtin_prefetch(blocks + 32 * at[j - i]);
+            }
+            for (size_t j = i; j < end; ++j) {
+                out[j] = test(blocks + 32 * at[j - i], hashes[j]);
+                hits += out[j];
+            }
+        }
+        return hits;
+    }
+};
+
+inline size_t bloomProbe(const char* blocks, size_t nb, const uint64_t* hashes, size_t n, bool* out) {
+    return BloomKernel::probe<16>(blocks, nb, hashes, n, out);
+}
+
+#ifdef CPPLIB_SIMD_X86
+__attribute__((target("avx2")))
+inline size_t bloomProbeAvx2(const char* blocks, size_t nb, const uint64_t* hashes, size_t n, bool* out) {
+    return BloomKernel::probe<16>(blocks, nb, hashes, n, out);
+}
+#endif
+
+inline BloomFilter::BloomFilter(size_t nb, MemoryResource* resource, int)
+    : resource(resource), nb(nb), blocks(nullptr) {
+    if (nb == 0 || nb > (size_t(1) << 32))
+        CPPLIB_THROW(std::invalid_argument, "BloomFilter size.");
+    blocks = static_cast<Block*>(resource->allocate(bytes(), 64));
+    std::memset(blocks, 0, bytes());
+}
+
+inline BloomFilter::BloomFilter(const BloomFilter& that) : resource(that.resource), nb(that.nb), blocks(nullptr) {
+    // A moved-from filter copies to another one without bits
+    if (nb > 0) {
+        blocks = static_cast<Block*>(resource->allocate(bytes(), 64));
+        std::memcpy(blocks, that.blocks, bytes());
+    }
+}
+
+inline BloomFilter::BloomFilter(BloomFilter&& that) noexcept
+    : resource(that.resource), nb(that.nb), blocks(that.blocks) {
+    that.nb = 0;
+    that.blocks = nullptr;
+}
+
+inline BloomFilter& BloomFilter::operator=(BloomFilter that) {
+    std::swap(resource, that.resource);
+    std::swap(nb, that.nb);
+    std::swap(blocks, that.blocks);
+    return *this;
+}
+
+/**
+ * Size the filter to keep the false-positive rate at most fpr with count
+ * distinct keys inserted.
+ *
+ * @param count: Expected number of keys
+ * @param fpr: Target false-positive rate, in (0, 1)
+ * @param resource: Memory resource for the bit array
+ */
+inline BloomFilter::BloomFilter(size_t count, double fpr, MemoryResource* resource)
+    : BloomFilter(blocksFor(count, fpr), resource, 0) {}
+
+inline size_t BloomFilter::blocksFor(size_t count, double fpr) {
+    if (!(fpr > 0 && fpr < 1))
+        CPPLIB_THROW(std::invalid_argument, "BloomFilter false-positive rate.");
+    // The rate falls as bits per key grow; search for the smallest that meets fpr
+    double lo = 1, hi = 256;
+    for (int i = 0; i < 40; ++i) {
+        double mid = (lo + hi) / 2;
+        (blockedRate(mid) > fpr ? lo : hi) = mid;
+    }
+    size_t nb = static_cast<size_t>(std::ceil(hi * (count > 0 ? count : 1) / 256));
+    return nb > 0 ? nb : 1;
+}
+
+/**
+ * False-positive rate of the blocked layout at a given number of bits per
+ * key: the number of keys in a block is Poisson, and a block with j keys
+ * answers yes if all eight probed bits were set by them.
+ */
+inline double BloomFilter::blockedRate(double bitsPerKey) {
+    double lambda = 256 / bitsPerKey;
+    double p = std::exp(-lambda);    // P(j keys in the block)
+    double rate = 0;
+    size_t last = static_cast<size_t>(lambda + 10 * std::sqrt(lambda) + 20);
+    for (size_t j = 0; j <= last; ++j) {
+        if (j > 0)
+            p *= lambda / j;
+        rate += p * std::pow(1 - std::pow(31.0 / 32, static_cast<double>(j)), 8);
+    }
+    return rate;
+}
+
+inline void BloomFilter::insertHash(uint64_t hash) {
+    if (nb == 0)
+        CPPLIB_THROW(std::logic_error, "BloomFilter::insert on a moved-from filter.");
+    BloomKernel::Lanes m;
+    BloomKernel::mask(hash, &m);
+    Block& b = blocks[blockOf(hash)];
+    for (int i = 0; i < 8; ++i)
+        b.w[i] |= m[i];
+}
+
+inline bool BloomFilter::containsHash(uint64_t hash) const {
+    return nb > 0 && BloomKernel::test(&blocks[blockOf(hash)], hash);
+}
+
+inline size_t BloomFilter::containsHash(const uint64_t* hashes, size_t n, bool* out) const {
+    if (nb == 0) {
+        std::fill(out, out + n, false);
+        return 0;
+    }
+    const char* p = reinterpret_cast<const char*>(blocks);
+#ifdef CPPLIB_SIMD_X86
+    if (simdLevel() >= SimdLevel::AVX2)
+        return bloomProbeAvx2(p, nb, hashes, n, out);
+#endif
+    return bloomProbe(p, nb, hashes, n, out);
+}
+
+inline size_t BloomFilter::contains(const StringView* keys, size_t n, bool* out) const {
+    size_t hits = 0;
+    uint64_t hashes[BATCH];
+    for (size_t i = 0; i < n; i += BATCH) {
+        size_t len = n - i < BATCH ? n - i : BATCH;
+        for (size_t j = 0; j < len; ++j)
+            hashes[j] = hashBytes(keys[i + j].data(), keys[i + j].size());
+        hits += containsHash(hashes, len, out + i);
+    }
+    return hits;
+}
+
+inline void BloomFilter::clear() {
+    if (nb > 0)
+        std::memset(blocks, 0, bytes());
+}
+
+inline void BloomFilter::save(std::ostream& os) const {
+    uint64_t header[2] = { MAGIC, static_cast<uint64_t>(nb) };
+    os.write(reinterpret_cast<const char*>(header), sizeof(header));
+    if (nb > 0)
+        os.write(reinterpret_cast<const char*>(blocks), bytes());
+}
+
+inline BloomFilter BloomFilter::load(std::istream& is, MemoryResource* resource) {
+    uint64_t header[2];
+    if (!is.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != MAGIC)
+        CPPLIB_THROW(std::runtime_error, "BloomFilter::load: bad header.");
+    BloomFilter filter(static_cast<size_t>(header[1]), resource, 0);
+    if (!is.read(reinterpret_cast<char*>(filter.blocks), filter.bytes()))
+        CPPLIB_THROW(std::runtime_error, "BloomFilter::load: truncated.");
+    return filter;
+}
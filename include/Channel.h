@@ -0,0 +1,167 @@
+#pragma once
+#include <coroutine>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include "ArrayQueue.h"
+#include "Config.h"
+#include "Executor.h"
+#include "IntrusiveQueue.h"
+
+/**
+ * Bounded channel between coroutines running on an Executor:
+ *
+ *   bool sent = co_await ch.send(x);          // false once the channel is closed
+ *   std::optional<E> got = co_await ch.recv(); // empty once closed and drained
+ *
+ * Up to capacity elements wait in an ArrayQueue. A sender suspends while
+ * the buffer is full and a receiver while it is empty, instead of blocking
+ * the thread; each waits in an intrusive list, the awaiter itself being the
+ * node, and is handed to the executor when a receiver or sender makes
+ * progress for it. A value sent while a receiver waits goes straight to
+ * it. With capacity 0 every send waits for a receiver.
+ *
+ * All operations take one mutex, so a channel may be shared by coroutines
+ * on a PoolExecutor.
+ */
+template<typename E>
+class Channel {
+public:
+    class Send;
+    class Recv;
+private:
+    std::mutex mtx;
+    Executor& executor;
+    int cap;
+    bool closed;
+    ArrayQueue<E> buffer;
+    IntrusiveQueue<Send> senders;
+    IntrusiveQueue<Recv> receivers;
+public:
+    Channel(Executor& executor, int capacity);
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+
+    Send send(E elem) { return Send(*this, std::move(elem)); }
+    Recv recv() { return Recv(*this); }
+    // Wake every waiter; later sends fail and receives drain what is buffered
+    void close();
+
+    int capacity() const { return cap; }
+    int size();
+    bool isClosed();
+
+    class Send : public QueueHook<> {
+    private:
+        friend class Channel;
+
+        Channel& ch;
+        E elem;
+        bool sent;
+        std::coroutine_handle<> h;
+    public:
+        Send(Channel& ch, E elem) : ch(ch), elem(std::move(elem)), sent(false) {}
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> h);
+        bool await_resume() const noexcept { return sent; }
+    };
+
+    class Recv : public QueueHook<> {
+    private:
+        friend class Channel;
+
+        Channel& ch;
+        std::optional<E> elem;
+        std::coroutine_handle<> h;
+    public:
+        explicit Recv(Channel& ch) : ch(ch) {}
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> h);
+        std::optional<E> await_resume() { return std::move(elem); }
+    };
+};
+
+template<typename E>
+Channel<E>::Channel(Executor& executor, int capacity)
+    : executor(executor), cap(capacity), closed(false), buffer(capacity > 0 ? capacity : 1) {
+    if (capacity < 0)
+        CPPLIB_THROW(std::invalid_argument, "Channel capacity.");
+}
+
+template<typename E>
+void Channel<E>::close() {
+    std::lock_guard<std::mutex> lock(mtx);
+    closed = true;
+    Send* s;
+    while (senders.tryDequeue(s))
+        executor.schedule(s->h);
+    Recv* r;
+    while (receivers.tryDequeue(r))
+        executor.schedule(r->h);
+}
+
+template<typename E>
+int Channel<E>::size() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return buffer.size();
+}
+
+template<typename E>
+bool Channel<E>::isClosed() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return closed;
+}
+
+// Return false, without suspending, if the value was delivered or the channel is closed
+template<typename E>
+bool Channel<E>::Send::await_suspend(std::coroutine_handle<> h) {
+    std::lock_guard<std::mutex> lock(ch.mtx);
+    if (ch.closed)
+        return false;
+    sent = true;
+    Recv* r;
+    if (ch.receivers.tryDequeue(r)) {
+        r->elem.emplace(std::move(elem));
+        ch.executor.schedule(r->h);
+        return false;
+    }
+    if (ch.buffer.size() < ch.cap) {
+        ch.buffer.enqueue(std::move(elem));
+        return false;
+    }
+    sent = false;
+    this->h = h;
+    ch.senders.enqueue(*this);
+    return true;
+}
+
+// Return false, without suspending, if a value was taken or the channel is closed
+template<typename E>
+bool Channel<E>::Recv::await_suspend(std::coroutine_handle<> h) {
+    std::lock_guard<std::mutex> lock(ch.mtx);
+    Send* s;
+    if (!ch.buffer.isEmpty()) {
+        elem.emplace(ch.buffer.dequeue());
+        // Room for the longest waiting sender
+        if (ch.senders.tryDequeue(s)) {
+            ch.buffer.enqueue(std::move(s->elem));
+            s->sent = true;
+            ch.executor.schedule(s->h);
+        }
+        return false;
+    }
+    if (ch.senders.tryDequeue(s)) {
+        elem.emplace(std::move(s->elem));
+        s->sent = true;
+        ch.executor.schedule(s->h);
+        return false;
+    }
+    if (ch.closed)
+        return false;
+    this->h = h;
+    ch.receivers.enqueue(*this);
+    return true;
+}
@@ -0,0 +1,411 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include "Config.h"
+#include "Simd.h"
+#include "Vector.h"
+
+/**
+ * Four 32-bit lanes, loaded from and stored to uint32_t arrays without
+ * alignment requirements. On x86 the operations compile to SSE2, which
+ * every x86-64 CPU has, so unpacking needs no runtime dispatch; other
+ * targets get their own 16-byte vectors or scalar code.
+ */
+typedef uint32_t PackLanes __attribute__((vector_size(16), aligned(4), may_alias));
+
+/**
+ * Unpack value group I of a block packed B bits per delta and add it to the
+ * running sums in acc. Group g holds deltas 4g .. 4g+3, one per lane, and
+ * lane j of packed word k holds bits 32k .. 32k+31 of the deltas of lane j.
+ * All shifts and word indices are constants, so the recursion unrolls into
+ * straight-line code for each width.
+ */
+template<int B, int I = 0>
+struct BlockUnpack
+{
+    static CPPLIB_ALWAYS_INLINE void run(const PackLanes* in, PackLanes acc, PackLanes* out)
+    {
+        static const int K = I * B / 32;
+        static const int S = I * B % 32;
+        PackLanes d = in[K] >> S;
+        if (S + B > 32)
+            d |= in[K + 1] << ((32 - S) & 31);
+        if (B < 32)
+            d &= (uint32_t(1) << (B & 31)) - 1;
+        acc += d;
+        out[I] = acc;
+        BlockUnpack<B, I + 1>::run(in, acc, out);
+    }
+};
+
+template<int B>
+struct BlockUnpack<B, 32>
+{
+    static CPPLIB_ALWAYS_INLINE void run(const PackLanes*, PackLanes, PackLanes*) {}
+};
+
+// Decode a block of 128 values packed B bits per delta from first
+template<int B>
+void unpackBlock(const uint32_t* in, uint32_t first, uint32_t* out)
+{
+    PackLanes acc = { first, first, first, first };
+    BlockUnpack<B>::run(reinterpret_cast<const PackLanes*>(in), acc, reinterpret_cast<PackLanes*>(out));
+}
+
+// All deltas are zero: the block repeats its first value
+template<>
+inline void unpackBlock<0>(const uint32_t*, uint32_t first, uint32_t* out)
+{
+    std::fill(out, out + 128, first);
+}
+
+typedef void (*BlockUnpacker)(const uint32_t*, uint32_t, uint32_t*);
+
+// Return the decoder of blocks packed with the specified number of bits
+inline BlockUnpacker blockUnpacker(int bits)
+{
+#define CPPLIB_UNPACK8(B) &unpackBlock<B>, &unpackBlock<B + 1>, &unpackBlock<B + 2>, &unpackBlock<B + 3>, \
+    &unpackBlock<B + 4>, &unpackBlock<B + 5>, &unpackBlock<B + 6>, &unpackBlock<B + 7>
+    static const BlockUnpacker TABLE[33] = {
+        CPPLIB_UNPACK8(0), CPPLIB_UNPACK8(8), CPPLIB_UNPACK8(16), CPPLIB_UNPACK8(24), &unpackBlock<32>
+    };
+#undef CPPLIB_UNPACK8
+    return TABLE[bits];
+}
+
+/**
+ * Pack the 128 deltas of a block bits per delta into out, which must hold
+ * 4 * bits zeroed words, in the layout BlockUnpack reads.
+ */
+inline void packBlock(const uint32_t* deltas, int bits, uint32_t* out)
+{
+    if (bits == 0)
+        return;
+    for (int g = 0; g < 32; ++g)
+    {
+        int k = g * bits / 32;
+        int s = g * bits % 32;
+        for (int j = 0; j < 4; ++j)
+        {
+            uint32_t d = deltas[4 * g + j];
+            out[4 * k + j] |= d << s;
+            if (s + bits > 32)
+                out[4 * (k + 1) + j] |= d >> (32 - s);
+        }
+    }
+}
+
+/**
+* Compressed vector of non-decreasing 32-bit unsigned integers, such as
+* sorted IDs or IPv4 addresses.
+* Values are stored in blocks of 128. Each block keeps its first value and
+* the deltas of every value from the one four places before it, packed
+* with the fewest bits that hold the largest delta of the block, so a block
+* of values 2^b apart on average takes about b bits per value. The deltas
+* are laid out so that four lanes decode at once with vector shifts and adds.
+* Per block skip pointers (first value and offset of the packed words) give
+* random access and lower_bound() in one block decode; the last, partial
+* block is kept uncompressed.
+*
+* Iterators decode a block at a time into a buffer they carry, so they are
+* large to copy; for_each() and decode() are the fast ways to read it all.
+ */
+class CompressedVector
+{
+public:
+    static const int BLOCK = 128;
+    class const_iterator;
+    using iterator = const_iterator;
+    using value_type = uint32_t;
+private:
+    int n; // Vector size
+    Vector<uint32_t> words; // Packed deltas of the full blocks
+    Vector<uint32_t> firsts; // First value of each full block
+    Vector<uint32_t> offsets; // Start of the words of each full block, and the end of the last
+    uint32_t tail[BLOCK]; // Values of the partial block, n % BLOCK of them
+
+    int full() const { return firsts.size(); }
+    int tailSize() const { return n - full() * BLOCK; }
+    // Pack tail into a new full block.
+    void seal();
+public:
+    CompressedVector();
+    template<typename InputIt>
+    CompressedVector(InputIt first, InputIt last);
+
+    // Return the number of elements in the CompressedVector
+    int size() const { return n; }
+    // Check if the CompressedVector is empty
+    bool empty() const { return n == 0; }
+    // Return the number of blocks, counting the partial one
+    int blocks() const { return (n + BLOCK - 1) / BLOCK; }
+    // Return the number of bytes of encoded values and skip pointers
+    size_t bytes() const;
+    // Add an element to the end of the CompressedVector, no less than the last
+    void insert_back(uint32_t elem);
+    // Return the element at the specified position
+    uint32_t operator[](int i) const;
+    // Return the element at the specified position, with bounds checking
+    uint32_t at(int i) const;
+    // Return the first element of the CompressedVector
+    uint32_t front() const;
+    // Return the last element of the CompressedVector
+    uint32_t back() const;
+    // Return the position of the first element not less than x, or size() if none
+    int lower_bound(uint32_t x) const;
+    // Decode the specified block into out, which must hold BLOCK values, and return its size
+    int decode(int block, uint32_t* out) const;
+    // Call f on each element in order
+    template<typename F>
+    void for_each(F f) const;
+    // Swap two CompressedVector objects
+    void swap(CompressedVector& that);
+    // Clear all elements in the CompressedVector
+    void clear();
+
+    friend bool operator==(const CompressedVector& lhs, const CompressedVector& rhs);
+    friend bool operator!=(const CompressedVector& lhs, const CompressedVector& rhs) { return !(lhs == rhs); }
+    friend std::ostream& operator<<(std::ostream& os, const CompressedVector& vector);
+
+    // Forward iterator decoding one block at a time
+    class const_iterator
+    {
+    private:
+        const CompressedVector* vector;
+        int i;
+        uint32_t block[BLOCK]; // Decoded block holding i
+
+        void load() { if (i < vector->n && i % BLOCK == 0) vector->decode(i / BLOCK, block); }
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = uint32_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const uint32_t*;
+        using reference = const uint32_t&;
+
+        const_iterator() : vector(nullptr), i(0) {}
+        const_iterator(const CompressedVector* vector, int i) : vector(vector), i(i)
+        {
+            if (i < vector->n)
+                vector->decode(i / BLOCK, block);
+        }
+
+        const uint32_t& operator*() const { return block[i % BLOCK]; }
+        const uint32_t* operator->() const { return &block[i % BLOCK]; }
+        const_iterator& operator++()
+        {
+            ++i;
+            load();
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            const_iterator temp(*this);
+            ++*this;
+            return temp;
+        }
+        bool operator==(const const_iterator& that) const { return i == that.i; }
+        bool operator!=(const const_iterator& that) const { return i != that.i; }
+    };
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, n); }
+};
+
+inline CompressedVector::CompressedVector() : n(0), words(0), firsts(0), offsets(1)
+{
+    offsets.insert_back(0);
+}
+
+/**
+ * @param first: Iterator to the first value, in non-decreasing order
+ * @param last: Iterator past the last value
+ */
+template<typename InputIt>
+CompressedVector::CompressedVector(InputIt first, InputIt last) : CompressedVector()
+{
+    for (; first != last; ++first)
+        insert_back(*first);
+}
+
+inline size_t CompressedVector::bytes() const
+{
+    return (words.size() + firsts.size() + offsets.size() + tailSize()) * sizeof(uint32_t);
+}
+
+inline void CompressedVector::seal()
+{
+    uint32_t first = tail[0];
+    uint32_t deltas[BLOCK];
+    uint32_t bits = 0;
+    for (int i = 0; i < BLOCK; ++i)
+    {
+        deltas[i] = tail[i] - (i < 4 ? first : tail[i - 4]);
+        bits |= deltas[i];
+    }
+    int width = 0;
+    for (; bits != 0; bits >>= 1)
+        ++width;
+    uint32_t packed[4 * 32] = {};
+    packBlock(deltas, width, packed);
+    words.append(packed, packed + 4 * width);
+    firsts.insert_back(first);
+    offsets.insert_back(words.size());
+}
+
+/**
+ * @param elem: Element no less than back()
+ */
+inline void CompressedVector::insert_back(uint32_t elem)
+{
+    if (n > 0 && elem < back())
+        CPPLIB_THROW(std::invalid_argument, "CompressedVector order.");
+    tail[tailSize()] = elem;
+    ++n;
+    if (tailSize() == BLOCK)
+        seal();
+}
+
+/**
+ * @param i: Index, 0 <= i < size()
+ * @return Element at index i
+ */
+inline uint32_t CompressedVector::operator[](int i) const
+{
+    if (i >= full() * BLOCK)
+        return tail[i - full() * BLOCK];
+    uint32_t block[BLOCK];
+    decode(i / BLOCK, block);
+    return block[i % BLOCK];
+}
+
+/**
+ * @param i: Index
+ * @return Element at index i
+ */
+inline uint32_t CompressedVector::at(int i) const
+{
+    if (i < 0 || i >= n)
+        CPPLIB_THROW(std::out_of_range, "CompressedVector::at");
+    return (*this)[i];
+}
+
+inline uint32_t CompressedVector::front() const
+{
+    if (n == 0)
+        CPPLIB_THROW(std::out_of_range, "CompressedVector::front");
+    return full() > 0 ? firsts[0] : tail[0];
+}
+
+inline uint32_t CompressedVector::back() const
+{
+    if (n == 0)
+        CPPLIB_THROW(std::out_of_range, "CompressedVector::back");
+    return (*this)[n - 1];
+}
+
+/**
+ * Find the first block starting at or above x by the skip pointers; the
+ * answer is in the block before it, or is its first element.
+ * @param x: Value to search for
+ * @return Index of the first element not less than x, or size() if none
+ */
+inline int CompressedVector::lower_bound(uint32_t x) const
+{
+    int b = static_cast<int>(std::lower_bound(firsts.begin(), firsts.end(), x) - firsts.begin());
+    if (b > 0)
+    {
+        uint32_t block[BLOCK];
+        decode(b - 1, block);
+        int j = static_cast<int>(std::lower_bound(block, block + BLOCK, x) - block);
+        if (j < BLOCK)
+            return (b - 1) * BLOCK + j;
+    }
+    if (b < full())
+        return b * BLOCK;
+    return full() * BLOCK + static_cast<int>(std::lower_bound(tail, tail + tailSize(), x) - tail);
+}
+
+/**
+ * @param block: Block index, 0 <= block < blocks()
+ * @param out: Array of at least BLOCK elements
+ * @return Number of elements decoded: BLOCK, or fewer for the partial block
+ */
+inline int CompressedVector::decode(int block, uint32_t* out) const
+{
+    if (block == full())
+    {
+        std::copy(tail, tail + tailSize(), out);
+        return tailSize();
+    }
+    int offset = offsets[block];
+    blockUnpacker((offsets[block + 1] - offset) / 4)(words.begin() + offset, firsts[block], out);
+    return BLOCK;
+}
+
+/**
+ * @param f: Function called with each element
+ */
+template<typename F>
+void CompressedVector::for_each(F f) const
+{
+    uint32_t block[BLOCK];
+    for (int b = 0; b < blocks(); ++b)
+    {
+        int count = decode(b, block);
+        for (int i = 0; i < count; ++i)
+            f(block[i]);
+    }
+}
+
+/**
+ * @param that: CompressedVector to swap with
+ */
+inline void CompressedVector::swap(CompressedVector& that)
+{
+    std::swap(n, that.n);
+    words.swap(that.words);
+    firsts.swap(that.firsts);
+    offsets.swap(that.offsets);
+    std::swap(tail, that.tail);
+}
+
+inline void CompressedVector::clear()
+{
+    n = 0;
+    words.clear();
+    firsts.clear();
+    offsets.clear();
+    offsets.insert_back(0);
+}
+
+/**
+ * The encoding of a sequence is unique, so equal vectors have equal blocks.
+ * @param lhs: CompressedVector
+ * @param rhs: CompressedVector
+ * @return True if the vectors hold the same elements
+ */
+inline bool operator==(const CompressedVector& lhs, const CompressedVector& rhs)
+{
+    return lhs.n == rhs.n && lhs.firsts == rhs.firsts && lhs.offsets == rhs.offsets && lhs.words == rhs.words &&
+           std::equal(lhs.tail, lhs.tail + lhs.tailSize(), rhs.tail);
+}
+
+inline std::ostream& operator<<(std::ostream& os, const CompressedVector& vector)
+{
+    vector.for_each([&os](uint32_t x) { os << x << " "; });
+    return os;
+}
+
+/**
+ * @param lhs: CompressedVector
+ * @param rhs: CompressedVector
+ */
+inline void swap(CompressedVector& lhs, CompressedVector& rhs)
+{
+    lhs.swap(rhs);
+}
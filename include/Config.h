@@ -0,0 +1,48 @@
+#pragma once
+
+/**
+ * Compiler and language feature switches shared by the headers.
+ */
+
+// constexpr on functions that need C++14 relaxed constexpr (loops,
+// assignments, several statements); plain functions under C++11
+#if __cplusplus >= 201402L
+#define CPPLIB_CONSTEXPR14 constexpr
+#else
+#define CPPLIB_CONSTEXPR14
+#endif
+
+/**
+ * Error policy. By default a failed precondition, such as popping an empty
+ * container, throws the std exception named at the throw site. Under
+ * CPPLIB_NO_EXCEPTIONS, which compiling with -fno-exceptions defines, it
+ * prints the exception type and message to stderr and aborts instead, and
+ * the rollback code in CPPLIB_TRY/CPPLIB_CATCH_ALL blocks compiles away.
+ * The try* members returning an Expected report the common failures as
+ * values under either policy.
+ */
+#if !defined(CPPLIB_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && !defined(__EXCEPTIONS)
+#define CPPLIB_NO_EXCEPTIONS 1
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+
+[[noreturn]] inline void cpplibAbort(const char* type, const char* what) {
+    std::fprintf(stderr, "%s: %s\n", type, what);
+    std::abort();
+}
+
+#ifdef CPPLIB_NO_EXCEPTIONS
+#define CPPLIB_THROW(Type, what) cpplibAbort(#Type, what)
+#define CPPLIB_THROW_BAD_ALLOC() cpplibAbort("std::bad_alloc", "out of memory")
+#define CPPLIB_TRY if (true)
+#define CPPLIB_CATCH_ALL else
+#define CPPLIB_RETHROW ((void)0)
+#else
+#define CPPLIB_THROW(Type, what) throw Type(what)
+#define CPPLIB_THROW_BAD_ALLOC() throw std::bad_alloc()
+#define CPPLIB_TRY try
+#define CPPLIB_CATCH_ALL catch (...)
+#define CPPLIB_RETHROW throw
+#endif
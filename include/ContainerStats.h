@@ -0,0 +1,199 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * Opt-in container statistics, enabled by compiling with -DCPPLIB_STATS
+ * (cmake -DCPPLIB_ENABLE_STATS=ON).
+ *
+ * Containers derive privately from StatsHook and report every resize,
+ * allocation and size change to a named category of ContainerStats. By
+ * default the category is the container name ("Vector", "ArrayQueue", ...);
+ * setStatsCategory() moves one instance to its own category. The
+ * StatsRegistry holds all categories and dumps them as JSON.
+ *
+ * Without CPPLIB_STATS, StatsHook is an empty base with inline no-op
+ * members, so it adds neither space nor code to the containers.
+ */
+#ifdef CPPLIB_STATS
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Counters of one category. Updated with relaxed atomics so instances on
+ * several threads can share a category.
+ */
+struct ContainerStats {
+    std::atomic<size_t> grows;          // Capacity increases
+    std::atomic<size_t> shrinks;        // Capacity decreases
+    std::atomic<size_t> moved;          // Elements moved or copied by resizes
+    std::atomic<size_t> allocations;    // Storage allocations
+    std::atomic<size_t> bytes;          // Bytes allocated
+    std::atomic<size_t> peakSize;       // Largest size reached
+    std::atomic<size_t> peakCapacity;   // Largest capacity reached
+
+    ContainerStats() { reset(); }
+
+    void reset();
+    // Raise counter to value if value is larger
+    static void raise(std::atomic<size_t>& counter, size_t value);
+};
+
+inline void ContainerStats::reset() {
+    grows = 0;
+    shrinks = 0;
+    moved = 0;
+    allocations = 0;
+    bytes = 0;
+    peakSize = 0;
+    peakCapacity = 0;
+}
+
+inline void ContainerStats::raise(std::atomic<size_t>& counter, size_t value) {
+    size_t old = counter.load(std::memory_order_relaxed);
+    while (value > old && !counter.compare_exchange_weak(old, value, std::memory_order_relaxed)) {}
+}
+
+/**
+ * Process-wide registry of statistics categories.
+ */
+class StatsRegistry {
+private:
+    std::mutex mtx;
+    std::map<std::string, std::unique_ptr<ContainerStats>> categories;
+
+    StatsRegistry() {}
+public:
+    static StatsRegistry& instance();
+
+    // Return the category with the given name, creating it if needed
+    ContainerStats* category(const std::string& name);
+    // Write all categories as one JSON object
+    void dumpJson(std::ostream& os);
+    // Write name as a quoted JSON string
+    static void writeJsonString(std::ostream& os, const std::string& name);
+    // Zero the counters of every category
+    void reset();
+};
+
+inline StatsRegistry& StatsRegistry::instance() {
+    static StatsRegistry registry;
+    return registry;
+}
+
+inline ContainerStats* StatsRegistry::category(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::unique_ptr<ContainerStats>& stats = categories[name];
+    if (!stats)
+        stats.reset(new ContainerStats());
+    return stats.get();
+}
+
+inline void StatsRegistry::dumpJson(std::ostream& os) {
+    std::lock_guard<std::mutex> lock(mtx);
+    os << "{";
+    bool first = true;
+    for (auto& i : categories) {
+        const ContainerStats& s = *i.second;
+        os << (first ? "" : ",") << "\n  ";
+        writeJsonString(os, i.first);
+        os << ": {"
+           << "\"grows\": " << s.grows << ", "
+           << "\"shrinks\": " << s.shrinks << ", "
+           << "\"moved\": " << s.moved << ", "
+           << "\"allocations\": " << s.allocations << ", "
+           << "\"bytes\": " << s.bytes << ", "
+           << "\"peakSize\": " << s.peakSize << ", "
+           << "\"peakCapacity\": " << s.peakCapacity << "}";
+        first = false;
+    }
+    os << "\n}\n";
+}
+
+inline void StatsRegistry::writeJsonString(std::ostream& os, const std::string& name) {
+    static const char* hex = "0123456789abcdef";
+    os << '"';
+    for (char c : name) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\')
+            os << '\\' << c;
+        else if (u < 0x20)
+            os << "\\u00" << hex[u >> 4] << hex[u & 15];
+        else
+            os << c;
+    }
+    os << '"';
+}
+
+inline void StatsRegistry::reset() {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (auto& i : categories)
+        i.second->reset();
+}
+
+/**
+ * Base of the instrumented containers.
+ */
+class StatsHook {
+private:
+    ContainerStats* cat;
+
+    // Look up a category by literal, caching the result per thread
+    static ContainerStats* lookup(const char* name);
+protected:
+    explicit StatsHook(const char* name) : cat(lookup(name)) {}
+
+    void statsAllocate(size_t bytes) {
+        cat->allocations.fetch_add(1, std::memory_order_relaxed);
+        cat->bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    void statsResize(size_t oldCapacity, size_t newCapacity, size_t moved, size_t bytes);
+    void statsCapacity(size_t capacity) { ContainerStats::raise(cat->peakCapacity, capacity); }
+    void statsSize(size_t size) { ContainerStats::raise(cat->peakSize, size); }
+    void swapStats(StatsHook& that) { std::swap(cat, that.cat); }
+public:
+    // Report this instance under its own category from now on
+    void setStatsCategory(const char* name) { cat = StatsRegistry::instance().category(name); }
+    // Return the counters of this instance's category
+    const ContainerStats& stats() const { return *cat; }
+};
+
+inline ContainerStats* StatsHook::lookup(const char* name) {
+    static thread_local std::unordered_map<const char*, ContainerStats*> cache;
+    ContainerStats*& stats = cache[name];
+    if (stats == nullptr)
+        stats = StatsRegistry::instance().category(name);
+    return stats;
+}
+
+inline void StatsHook::statsResize(size_t oldCapacity, size_t newCapacity, size_t moved, size_t bytes) {
+    if (newCapacity > oldCapacity)
+        cat->grows.fetch_add(1, std::memory_order_relaxed);
+    else
+        cat->shrinks.fetch_add(1, std::memory_order_relaxed);
+    cat->moved.fetch_add(moved, std::memory_order_relaxed);
+    if (bytes > 0)
+        statsAllocate(bytes);
+    statsCapacity(newCapacity);
+}
+
+#else
+
+class StatsHook {
+protected:
+    explicit StatsHook(const char*) {}
+
+    void statsAllocate(size_t) {}
+    void statsResize(size_t, size_t, size_t, size_t) {}
+    void statsCapacity(size_t) {}
+    void statsSize(size_t) {}
+    void swapStats(StatsHook&) {}
+public:
+    void setStatsCategory(const char*) {}
+};
+
+#endif
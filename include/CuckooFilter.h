@@ -0,0 +1,279 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include "Config.h"
+#include "Hash.h"
+#include "MemoryResource.h"
+#include "StringView.h"
+#include "Vector.h"
+
+/**
+ * Cuckoo filter: a set membership test like BloomFilter that also supports
+ * erase().
+ *
+ * Each key is reduced to a fingerprint (a nonzero Tag) that can live in one
+ * of two buckets of four slots, the second bucket being the first XOR a
+ * hash of the fingerprint, so either bucket can be found from the other
+ * without the key. Inserting into two full buckets kicks a random resident
+ * fingerprint to its other bucket, and so on; if that does not settle
+ * after MAX_KICKS moves, the last homeless fingerprint is kept aside and
+ * the filter reports itself full. Buckets are sized for a 95% load at the
+ * given capacity.
+ *
+ * The false-positive rate is set by the width of Tag: about 8 / 2^bits, so
+ * 3% for uint8_t, 0.012% for uint16_t (the default) and 2e-9 for uint32_t.
+ * Erasing a key that was never inserted may erase another key that shares
+ * its fingerprint and bucket.
+ *
+ * The bulk contains() hashes a batch of keys and prefetches both buckets of
+ * each before testing them. save() and load() write and read the slots in
+ * native byte order after a short header.
+ */
+template<typename Tag = uint16_t>
+class CuckooFilter {
+private:
+    static const uint64_t MAGIC = 0x314f4f4b43504cULL;    // "LPCKOO1"
+    static const size_t SLOTS = 4;
+    static const int MAX_KICKS = 500;
+    static const size_t BATCH = 16;
+
+    Vector<Tag, PolymorphicAllocator<Tag>> slots;
+    size_t mask;
+    int count;
+    uint64_t rng;
+    // A fingerprint that could not be placed, with one of its buckets
+    bool hasVictim;
+    Tag victimTag;
+    size_t victimBucket;
+
+    // Private tag constructor: nb empty buckets, nb a power of two
+    CuckooFilter(size_t nb, MemoryResource* resource, int);
+    static size_t bucketsFor(size_t capacity);
+    static Tag tagOf(uint64_t hash) {
+        Tag t = static_cast<Tag>(hash >> 32);
+        return t != 0 ? t : 1;
+    }
+    size_t altBucket(size_t b, Tag t) const { return (b ^ hashMix(t)) & mask; }
+    bool inBucket(size_t b, Tag t) const;
+    bool addToBucket(size_t b, Tag t);
+    bool removeFromBucket(size_t b, Tag t);
+public:
+    explicit CuckooFilter(size_t capacity, MemoryResource* resource = newDeleteResource());
+
+    // Add key; false, without adding it, if the filter is already full
+    bool insert(StringView key) { return insertHash(hashBytes(key.data(), key.size())); }
+    bool insertHash(uint64_t hash);
+    bool contains(StringView key) const { return containsHash(hashBytes(key.data(), key.size())); }
+    bool containsHash(uint64_t hash) const;
+    // Set out[i] to contains(keys[i]) for i < n; return the number of hits
+    size_t contains(const StringView* keys, size_t n, bool* out) const;
+    size_t containsHash(const uint64_t* hashes, size_t n, bool* out) const;
+    // Remove one copy of key, which must have been inserted; false if not found
+    bool erase(StringView key) { return eraseHash(hashBytes(key.data(), key.size())); }
+    bool eraseHash(uint64_t hash);
+    void clear();
+    // Return the number of fingerprints stored
+    int size() const { return count; }
+    bool isFull() const { return hasVictim; }
+    // Return the size of the slot array in bytes
+    size_t bytes() const { return slots.size() * sizeof(Tag); }
+    // Return the expected false-positive rate at the current load
+    double falsePositiveRate() const;
+
+    void save(std::ostream& os) const;
+    static CuckooFilter load(std::istream& is, MemoryResource* resource = newDeleteResource());
+};
+
+template<typename Tag>
+CuckooFilter<Tag>::CuckooFilter(size_t nb, MemoryResource* resource, int)
+    : slots(nb > 0 && nb * SLOTS <= INT32_MAX ? static_cast<int>(nb * SLOTS)
+                                              : (CPPLIB_THROW(std::invalid_argument, "CuckooFilter size."), 0),
+            PolymorphicAllocator<Tag>(resource)),
+      mask(nb - 1), count(0), rng(0x9e3779b97f4a7c15ULL), hasVictim(false), victimTag(0), victimBucket(0) {
+    for (size_t i = 0; i < nb * SLOTS; ++i)
+        slots.insert_back(0);
+}
+
+template<typename Tag>
+CuckooFilter<Tag>::CuckooFilter(size_t capacity, MemoryResource* resource)
+    : CuckooFilter(bucketsFor(capacity), resource, 0) {}
+
+template<typename Tag>
+size_t CuckooFilter<Tag>::bucketsFor(size_t capacity) {
+    size_t nb = 1;
+    while (nb * SLOTS * 95 < capacity * 100)
+        nb *= 2;
+    return nb;
+}
+
+template<typename Tag>
+bool CuckooFilter<Tag>::inBucket(size_t b, Tag t) const {
+    const Tag* p = &slots[b * SLOTS];
+    return (p[0] == t) | (p[1] == t) | (p[2] == t) | (p[3] == t);
+}
+
+template<typename Tag>
+bool CuckooFilter<Tag>::addToBucket(size_t b, Tag t) {
+    Tag* p = &slots[b * SLOTS];
+    for (size_t i = 0; i < SLOTS; ++i) {
+        if (p[i] == 0) {
+            p[i] = t;
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename Tag>
+bool CuckooFilter<Tag>::removeFromBucket(size_t b, Tag t) {
+    Tag* p = &slots[b * SLOTS];
+    for (size_t i = 0; i < SLOTS; ++i) {
+        if (p[i] == t) {
+            p[i] = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename Tag>
+bool CuckooFilter<Tag>::insertHash(uint64_t hash) {
+    if (hasVictim)
+        return false;
+    Tag t = tagOf(hash);
+    size_t b = hash & mask;
+    count++;
+    if (addToBucket(b, t))
+        return true;
+    b = altBucket(b, t);
+    if (addToBucket(b, t))
+        return true;
+    for (int k = 0; k < MAX_KICKS; ++k) {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        Tag& slot = slots[b * SLOTS + rng % SLOTS];
+        Tag kicked = slot;
+        slot = t;
+        t = kicked;
+        b = altBucket(b, t);
+        if (addToBucket(b, t))
+            return true;
+    }
+    hasVictim = true;
+    victimTag = t;
+    victimBucket = b;
+    return true;
+}
+
+template<typename Tag>
+bool CuckooFilter<Tag>::containsHash(uint64_t hash) const {
+    Tag t = tagOf(hash);
+    size_t b = hash & mask;
+    if (inBucket(b, t) || inBucket(altBucket(b, t), t))
+        return true;
+    return hasVictim && victimTag == t && (victimBucket == b || victimBucket == altBucket(b, t));
+}
+
+template<typename Tag>
+size_t CuckooFilter<Tag>::containsHash(const uint64_t* hashes, size_t n, bool* out) const {
+    size_t hits = 0;
+    const Tag* base = slots.begin();
+    for (size_t i = 0; i < n; i += BATCH) {
+        size_t end = n - i < BATCH ? n : i + BATCH;
+        size_t alt[BATCH];
+        for (size_t j = i; j < end; ++j) {
+            size_t b = hashes[j] & mask;
+            alt[j - i] = altBucket(b, tagOf(hashes[j]));
+            __builtin_prefetch(base + b * SLOTS);
+            __builtin_prefetch(base + alt[j - i] * SLOTS);
+        }
+        for (size_t j = i; j < end; ++j) {
+            Tag t = tagOf(hashes[j]);
+            size_t b = hashes[j] & mask;
+            out[j] = inBucket(b, t) || inBucket(alt[j - i], t)
+                     || (hasVictim && victimTag == t && (victimBucket == b || victimBucket == alt[j - i]));
+            hits += out[j];
+        }
+    }
+    return hits;
+}
+
+template<typename Tag>
+size_t CuckooFilter<Tag>::contains(const StringView* keys, size_t n, bool* out) const {
+    size_t hits = 0;
+    uint64_t hashes[BATCH];
+    for (size_t i = 0; i < n; i += BATCH) {
+        size_t len = n - i < BATCH ? n - i : BATCH;
+        for (size_t j = 0; j < len; ++j)
+            hashes[j] = hashBytes(keys[i + j].data(), keys[i + j].size());
+        hits += containsHash(hashes, len, out + i);
+    }
+    return hits;
+}
+
+template<typename Tag>
+bool CuckooFilter<Tag>::eraseHash(uint64_t hash) {
+    Tag t = tagOf(hash);
+    size_t b = hash & mask;
+    size_t a = altBucket(b, t);
+    if (hasVictim && victimTag == t && (victimBucket == b || victimBucket == a)) {
+        hasVictim = false;
+        count--;
+        return true;
+    }
+    if (!removeFromBucket(b, t) && !removeFromBucket(a, t))
+        return false;
+    count--;
+    // A slot is free now; give the victim another try
+    if (hasVictim) {
+        hasVictim = false;
+        count--;
+        insertHash(uint64_t(victimTag) << 32 | victimBucket);
+    }
+    return true;
+}
+
+template<typename Tag>
+void CuckooFilter<Tag>::clear() {
+    for (Tag& t : slots)
+        t = 0;
+    count = 0;
+    hasVictim = false;
+}
+
+template<typename Tag>
+double CuckooFilter<Tag>::falsePositiveRate() const {
+    // Two buckets of occupied slots, each matching with chance 1 / (2^bits - 1)
+    double load = static_cast<double>(count) / slots.size();
+    double tags = static_cast<double>(Tag(~Tag(0)));
+    return 2 * SLOTS * load / tags;
+}
+
+template<typename Tag>
+void CuckooFilter<Tag>::save(std::ostream& os) const {
+    uint64_t header[6] = { MAGIC, sizeof(Tag), mask + 1, static_cast<uint64_t>(count),
+                           hasVictim ? 1u : 0u, uint64_t(victimTag) << 32 | victimBucket };
+    os.write(reinterpret_cast<const char*>(header), sizeof(header));
+    os.write(reinterpret_cast<const char*>(slots.begin()), bytes());
+}
+
+template<typename Tag>
+CuckooFilter<Tag> CuckooFilter<Tag>::load(std::istream& is, MemoryResource* resource) {
+    uint64_t header[6];
+    if (!is.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != MAGIC || header[1] != sizeof(Tag)
+        || header[2] == 0 || (header[2] & (header[2] - 1)) != 0)
+        CPPLIB_THROW(std::runtime_error, "CuckooFilter::load: bad header.");
+    CuckooFilter filter(static_cast<size_t>(header[2]), resource, 0);
+    if (!is.read(reinterpret_cast<char*>(filter.slots.begin()), filter.bytes()))
+        CPPLIB_THROW(std::runtime_error, "CuckooFilter::load: truncated.");
+    filter.count = static_cast<int>(header[3]);
+    filter.hasVictim = header[4] != 0;
+    filter.victimTag = static_cast<Tag>(header[5] >> 32);
+    filter.victimBucket = static_cast<size_t>(header[5] & 0xffffffffu) & filter.mask;
+    return filter;
+}
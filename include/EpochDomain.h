@@ -0,0 +1,193 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include "Config.h"
+#include "MemoryResource.h"
+#include "Vector.h"
+
+/**
+ * Epoch-based reclamation: frees objects a writer has unlinked once no
+ * reader can still be using them, without readers writing anything shared.
+ *
+ * Each reader owns a slot from attach(). enter() copies the global epoch
+ * into the slot and exit() clears it; both are a store to a cache line
+ * only that reader writes, so reads are wait-free. A writer unlinks an
+ * object (e.g. swaps a new version into an atomic pointer), then passes it
+ * to retire(), which tags it with the epoch and advances the epoch.
+ * reclaim() frees every retired object tagged before the oldest epoch a
+ * reader is in: a reader that entered later read the pointer after the
+ * swap.
+ *
+ * A reader that stays inside enter()/exit() holds back every object
+ * retired since it entered, so keep read sections short.
+ */
+class EpochDomain {
+private:
+    static const uint64_t IDLE = 0;
+
+    // One reader's epoch, on a cache line of its own
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch;
+        std::atomic<bool> used;
+    };
+    struct Retired {
+        void* object;
+        void (*destroy)(void*);
+        uint64_t epoch;
+    };
+
+    int readers;
+    Slot* slots;    // From newDeleteResource(), which honours the alignment new[] does not before C++17
+    std::atomic<uint64_t> global;
+    std::mutex mtx;
+    Vector<Retired> retired;
+
+    // Return the oldest epoch a reader is in, or the current one if none is
+    uint64_t oldest() const;
+public:
+    explicit EpochDomain(int readers = 256);
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+    // Frees everything still retired; no reader may be inside a read section
+    ~EpochDomain();
+
+    // Claim a reader slot
+    int attach();
+    // Give back a reader slot
+    void detach(int slot) { slots[slot].used.store(false, std::memory_order_release); }
+    // Start a read section: pointers loaded after this with memory_order_seq_cst stay valid until exit()
+    void enter(int slot) {
+        slots[slot].epoch.store(global.load(std::memory_order_acquire), std::memory_order_seq_cst);
+    }
+    // End a read section
+    void exit(int slot) { slots[slot].epoch.store(IDLE, std::memory_order_release); }
+    // Hand over an unlinked object to be destroyed once no reader can see it
+    template<typename T>
+    void retire(T* object) { retire(object, [](void* p) { delete static_cast<T*>(p); }); }
+    void retire(void* object, void (*destroy)(void*));
+    // Destroy the retired objects no reader can see and return how many
+    size_t reclaim();
+    // Return the number of retired objects not yet destroyed
+    size_t pending();
+    // Wait until every object retired so far is destroyed
+    void synchronize();
+};
+
+/**
+ * Hold a reader slot for a scope:
+ *
+ *   EpochReader reader(domain);
+ *   reader.enter();
+ *   ...
+ *   reader.exit();
+ */
+class EpochReader {
+private:
+    EpochDomain& domain;
+    int slot;
+public:
+    explicit EpochReader(EpochDomain& domain) : domain(domain), slot(domain.attach()) {}
+    EpochReader(const EpochReader&) = delete;
+    EpochReader& operator=(const EpochReader&) = delete;
+    ~EpochReader() { domain.detach(slot); }
+
+    void enter() { domain.enter(slot); }
+    void exit() { domain.exit(slot); }
+};
+
+inline EpochDomain::EpochDomain(int readers)
+    : readers(readers), slots(nullptr), global(1), retired(0) {
+    if (readers < 1)
+        CPPLIB_THROW(std::invalid_argument, "EpochDomain readers.");
+    slots = static_cast<Slot*>(newDeleteResource()->allocate(readers * sizeof(Slot), alignof(Slot)));
+    for (int i = 0; i < readers; ++i) {
+        new (&slots[i]) Slot;
+        slots[i].epoch.store(IDLE, std::memory_order_relaxed);
+        slots[i].used.store(false, std::memory_order_relaxed);
+    }
+}
+
+inline EpochDomain::~EpochDomain() {
+    for (const Retired& r : retired)
+        r.destroy(r.object);
+    newDeleteResource()->deallocate(slots, readers * sizeof(Slot), alignof(Slot));
+}
+
+inline int EpochDomain::attach() {
+    for (int i = 0; i < readers; ++i) {
+        bool expected = false;
+        if (!slots[i].used.load(std::memory_order_relaxed) &&
+            slots[i].used.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            return i;
+    }
+    CPPLIB_THROW(std::length_error, "EpochDomain readers.");
+}
+
+inline uint64_t EpochDomain::oldest() const {
+    uint64_t min = global.load(std::memory_order_seq_cst);
+    for (int i = 0; i < readers; ++i) {
+        uint64_t e = slots[i].epoch.load(std::memory_order_seq_cst);
+        if (e != IDLE && e < min)
+            min = e;
+    }
+    return min;
+}
+
+/**
+ * @param object: Object no longer reachable by readers that enter from now on
+ * @param destroy: Function destroying object
+ */
+inline void EpochDomain::retire(void* object, void (*destroy)(void*)) {
+    std::lock_guard<std::mutex> lock(mtx);
+    // Readers that saw object entered at this epoch or earlier
+    retired.insert_back(Retired{ object, destroy, global.fetch_add(1, std::memory_order_seq_cst) });
+}
+
+/**
+ * @return Number of objects destroyed
+ */
+inline size_t EpochDomain::reclaim() {
+    Vector<Retired> ready(0);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        uint64_t min = oldest();
+        int kept = 0;
+        for (int i = 0; i < retired.size(); ++i) {
+            if (retired[i].epoch < min)
+                ready.insert_back(retired[i]);
+            else
+                retired[kept++] = retired[i];
+        }
+        while (retired.size() > kept)
+            retired.remove_back();
+    }
+    // Destroy outside the lock, so slow destructors do not hold up retire()
+    for (const Retired& r : ready)
+        r.destroy(r.object);
+    return ready.size();
+}
+
+inline size_t EpochDomain::pending() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return retired.size();
+}
+
+inline void EpochDomain::synchronize() {
+    uint64_t target = global.load(std::memory_order_seq_cst);
+    while (true) {
+        reclaim();
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            bool waiting = false;
+            for (const Retired& r : retired)
+                waiting = waiting || r.epoch < target;
+            if (!waiting)
+                return;
+        }
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,203 @@
+#pragma once
+#if !defined(__cpp_impl_coroutine)
+#error "Executor.h needs C++20 coroutines (-std=c++20)"
+#endif
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "ArrayQueue.h"
+
+class Executor;
+
+/**
+ * Coroutine that runs on an Executor. A Task does nothing until it is given
+ * to Executor::spawn(); from then on the executor owns it and destroys its
+ * frame when it finishes. An exception escaping a Task terminates the
+ * program.
+ */
+class Task {
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    // Destroys the frame, then tells the executor the task is done
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(Handle h) noexcept;
+        void await_resume() const noexcept {}
+    };
+
+    struct promise_type {
+        Executor* executor = nullptr;
+
+        Task get_return_object() { return Task(Handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() const {}
+        void unhandled_exception() const { std::terminate(); }
+    };
+
+    Task(const Task&) = delete;
+    Task(Task&& that) noexcept : h(std::exchange(that.h, nullptr)) {}
+    Task& operator=(const Task&) = delete;
+    ~Task() { if (h) h.destroy(); }
+private:
+    friend class Executor;
+
+    Handle h;
+
+    explicit Task(Handle h) : h(h) {}
+};
+
+/**
+ * Queue of coroutines ready to resume. Channels and other awaitables hand
+ * the coroutines they wake to schedule() rather than resuming them inline,
+ * so a long chain of stages never nests resumptions on one stack.
+ */
+class Executor {
+public:
+    virtual ~Executor() {}
+
+    // Take ownership of task and schedule its first resumption
+    void spawn(Task task);
+    // Queue h to be resumed on one of the executor's threads
+    virtual void schedule(std::coroutine_handle<> h) = 0;
+protected:
+    friend struct Task::FinalAwaiter;
+
+    // A spawned task was created / has finished
+    virtual void started() = 0;
+    virtual void finished() = 0;
+};
+
+inline void Task::FinalAwaiter::await_suspend(Handle h) noexcept {
+    Executor* executor = h.promise().executor;
+    h.destroy();
+    executor->finished();
+}
+
+inline void Executor::spawn(Task task) {
+    Task::Handle h = std::exchange(task.h, nullptr);
+    h.promise().executor = this;
+    started();
+    schedule(h);
+}
+
+/**
+ * Single-threaded executor: run() resumes ready coroutines on the calling
+ * thread until none are left.
+ */
+class LoopExecutor : public Executor {
+private:
+    ArrayQueue<std::coroutine_handle<>> ready;
+    int live;
+protected:
+    void started() override { live++; }
+    void finished() override { live--; }
+public:
+    LoopExecutor() : live(0) {}
+
+    void schedule(std::coroutine_handle<> h) override { ready.enqueue(h); }
+    // Run until no coroutine is ready; return the number of tasks still suspended
+    int run();
+};
+
+inline int LoopExecutor::run() {
+    std::coroutine_handle<> h;
+    while (ready.tryDequeue(h))
+        h.resume();
+    return live;
+}
+
+/**
+ * Multi-threaded executor: run() resumes ready coroutines on the calling
+ * thread and threads - 1 helpers, all taking from one locked ready queue.
+ * A coroutine may suspend on one thread and resume on another.
+ */
+class PoolExecutor : public Executor {
+private:
+    std::mutex mtx;
+    std::condition_variable cv;
+    ArrayQueue<std::coroutine_handle<>> ready;
+    int threads;
+    int live;
+    int idle;
+    bool stop;
+
+    void work();
+protected:
+    void started() override;
+    void finished() override;
+public:
+    explicit PoolExecutor(int threads = std::thread::hardware_concurrency());
+
+    void schedule(std::coroutine_handle<> h) override;
+    /**
+     * Run until every spawned task has finished, or until every thread is
+     * idle with nothing ready; return the number of tasks still suspended.
+     */
+    int run();
+};
+
+inline PoolExecutor::PoolExecutor(int threads)
+    : threads(threads > 0 ? threads : 1), live(0), idle(0), stop(false) {}
+
+inline void PoolExecutor::started() {
+    std::lock_guard<std::mutex> lock(mtx);
+    live++;
+}
+
+inline void PoolExecutor::finished() {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (--live == 0) {
+        stop = true;
+        cv.notify_all();
+    }
+}
+
+inline void PoolExecutor::schedule(std::coroutine_handle<> h) {
+    std::lock_guard<std::mutex> lock(mtx);
+    ready.enqueue(h);
+    if (idle > 0)
+        cv.notify_one();
+}
+
+inline void PoolExecutor::work() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (!stop) {
+        std::coroutine_handle<> h;
+        if (ready.tryDequeue(h)) {
+            lock.unlock();
+            h.resume();
+            lock.lock();
+            continue;
+        }
+        // Only running coroutines schedule others: with every thread idle, nothing can become ready
+        if (++idle == threads) {
+            stop = true;
+            cv.notify_all();
+            break;
+        }
+        cv.wait(lock, [this]() { return stop || !ready.isEmpty(); });
+        idle--;
+    }
+}
+
+inline int PoolExecutor::run() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = live == 0;
+        idle = 0;
+    }
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < threads; ++i)
+        helpers.emplace_back([this]() { work(); });
+    work();
+    for (std::thread& helper : helpers)
+        helper.join();
+    return live;
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "Config.h"
+
+/**
+ * Failures the try* members of the containers report as values.
+ */
+enum class Error { EMPTY, FULL, OUT_OF_RANGE, INVALID_ARGUMENT };
+
+inline const char* errorName(Error error) {
+    switch (error) {
+    case Error::EMPTY:        return "empty";
+    case Error::FULL:         return "full";
+    case Error::OUT_OF_RANGE: return "out of range";
+    default:                  return "invalid argument";
+    }
+}
+
+// Fail with the exception the throwing member would use, under the error policy
+[[noreturn]] inline void raiseError(Error error) {
+    if (error == Error::INVALID_ARGUMENT)
+        CPPLIB_THROW(std::invalid_argument, errorName(error));
+    CPPLIB_THROW(std::out_of_range, errorName(error));
+}
+
+/**
+ * Either a value of type T or the Error that prevented producing one, for
+ * callers that check results instead of catching exceptions:
+ *
+ *   Expected<int> x = queue.tryDequeue();
+ *   if (x)
+ *       use(*x);
+ *   else if (x.error() == Error::EMPTY)
+ *       ...
+ *
+ * value() on an Expected holding an Error fails like the throwing member,
+ * under the error policy of Config.h.
+ */
+template<typename T>
+class Expected {
+private:
+    bool ok;
+    Error err;
+    union {
+        T val;
+    };
+
+    void destroy() { if (ok) val.~T(); }
+public:
+    Expected(const T& value) : ok(true), err(Error::EMPTY) { new (&val) T(value); }
+    Expected(T&& value) : ok(true), err(Error::EMPTY) { new (&val) T(std::move(value)); }
+    Expected(Error error) : ok(false), err(error) {}
+    Expected(const Expected& that) : ok(that.ok), err(that.err) {
+        if (ok)
+            new (&val) T(that.val);
+    }
+    Expected(Expected&& that) noexcept(std::is_nothrow_move_constructible<T>::value) : ok(that.ok), err(that.err) {
+        if (ok)
+            new (&val) T(std::move(that.val));
+    }
+    ~Expected() { destroy(); }
+    // If moving the value in throws, *this is left holding an Error
+    Expected& operator=(Expected that) {
+        destroy();
+        ok = false;
+        err = that.err;
+        if (that.ok) {
+            new (&val) T(std::move(that.val));
+            ok = true;
+        }
+        return *this;
+    }
+
+    // Check if a value is held
+    bool hasValue() const { return ok; }
+    explicit operator bool() const { return ok; }
+    // Return the value, failing if an Error is held
+    T& value() {
+        if (!ok)
+            raiseError(err);
+        return val;
+    }
+    const T& value() const {
+        if (!ok)
+            raiseError(err);
+        return val;
+    }
+    // Return the value, or fallback if an Error is held
+    T valueOr(T fallback) const { return ok ? val : fallback; }
+    // Return the Error; only meaningful if no value is held
+    Error error() const { return err; }
+
+    // Unchecked access to the value
+    T& operator*() { return val; }
+    const T& operator*() const { return val; }
+    T* operator->() { return &val; }
+    const T* operator->() const { return &val; }
+};
+
+/**
+ * Success, or the Error of an operation that returns nothing.
+ */
+template<>
+class Expected<void> {
+private:
+    bool ok;
+    Error err;
+public:
+    Expected() : ok(true), err(Error::EMPTY) {}
+    Expected(Error error) : ok(false), err(error) {}
+
+    bool hasValue() const { return ok; }
+    explicit operator bool() const { return ok; }
+    // Fail if an Error is held
+    void value() const {
+        if (!ok)
+            raiseError(err);
+    }
+    Error error() const { return err; }
+};
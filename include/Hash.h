@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Non-cryptographic hash functions shared by the hashed containers.
+ * Not stable across versions; do not persist the values.
+ */
+
+// Finalize a 64-bit value so every input bit affects every output bit
+inline uint64_t hashMix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+inline uint64_t hashLoad64(const unsigned char* p) {
+    uint64_t w;
+    std::memcpy(&w, p, 8);
+    return w;
+}
+
+inline uint64_t hashLoad32(const unsigned char* p) {
+    uint32_t w;
+    std::memcpy(&w, p, 4);
+    return w;
+}
+
+// Hash n bytes: one multiply per 8-byte word, then a final mix. The last
+// word of a string of 8 or more bytes overlaps the previous one rather
+// than reading a variable-length tail.
+inline uint64_t hashBytes(const void* data, size_t n, uint64_t seed = 0) {
+    const uint64_t K = 0x9e3779b97f4a7c15ULL;
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t h = seed ^ (n * K);
+    if (n >= 8) {
+        const unsigned char* last = p + n - 8;
+        for (; p < last; p += 8)
+            h = (((h << 27) | (h >> 37)) ^ hashLoad64(p)) * K;
+        h = (((h << 27) | (h >> 37)) ^ hashLoad64(last)) * K;
+    } else if (n >= 4) {
+        h = (h ^ (hashLoad32(p) | hashLoad32(p + n - 4) << 32)) * K;
+    } else if (n > 0) {
+        h = (h ^ (p[0] | uint64_t(p[n / 2]) << 8 | uint64_t(p[n - 1]) << 16)) * K;
+    }
+    return hashMix(h);
+}
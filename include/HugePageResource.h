@@ -0,0 +1,171 @@
+#pragma once
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <vector>
+#include "Config.h"
+#include "MemoryResource.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Resource for large container buffers (Linux only).
+ *
+ * Requests of at least `threshold` bytes are served by mmap, rounded to and
+ * aligned on 2 MiB, and advised with MADV_HUGEPAGE so the kernel backs them
+ * with transparent huge pages. Smaller requests go to the upstream resource.
+ *
+ * Mapped blocks can be prefaulted, either by MAP_POPULATE (huge pages only
+ * when THP is set to "always") or by touching every page from `threads`
+ * threads after the huge page advice. Shrinking a mapped block keeps its
+ * prefix in place and hands the tail back with MADV_DONTNEED and munmap.
+ *
+ *     HugePageResource huge(64 << 20, HugePageResource::TOUCH, 4);
+ *     Vector<uint64_t, PolymorphicAllocator<uint64_t>> v(1 << 28, &huge);
+ */
+class HugePageResource : public MemoryResource {
+public:
+    static const size_t HUGE_PAGE = size_t(2) << 20;
+    static const size_t DEFAULT_THRESHOLD = size_t(16) << 20;
+
+    enum Prefault {
+        NONE,       // Fault pages lazily on first access
+        POPULATE,   // Map with MAP_POPULATE
+        TOUCH       // Write one byte per page after madvise
+    };
+private:
+    size_t threshold;
+    Prefault prefault;
+    int threads;
+    MemoryResource* upstream;
+
+    static size_t roundUp(size_t bytes, size_t unit) { return (bytes + unit - 1) / unit * unit; }
+    static size_t pageSize();
+    void touch(char* p, size_t len) const;
+public:
+    explicit HugePageResource(size_t threshold = DEFAULT_THRESHOLD, Prefault prefault = NONE,
+                              int threads = 1, MemoryResource* upstream = newDeleteResource());
+
+    size_t getThreshold() const { return threshold; }
+    // Check if a request of the given size is served by mmap
+    bool mapped(size_t bytes) const;
+protected:
+    void* doAllocate(size_t bytes, size_t align) override;
+    void doDeallocate(void* p, size_t bytes, size_t align) override;
+    bool doCanShrink(size_t oldBytes, size_t newBytes) const override;
+    void doShrink(void* p, size_t oldBytes, size_t newBytes) override;
+};
+
+inline HugePageResource::HugePageResource(size_t threshold, Prefault prefault, int threads, MemoryResource* upstream)
+    : threshold(threshold > 0 ? threshold : 1), prefault(prefault),
+      threads(threads > 0 ? threads : 1), upstream(upstream) {}
+
+inline size_t HugePageResource::pageSize() {
+#ifdef __linux__
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+#else
+    return 4096;
+#endif
+}
+
+inline bool HugePageResource::mapped(size_t bytes) const {
+#ifdef __linux__
+    return bytes >= threshold;
+#else
+    (void)bytes;
+    return false;
+#endif
+}
+
+inline void HugePageResource::touch(char* p, size_t len) const {
+    size_t page = pageSize();
+    size_t pages = len / page;
+    auto work = [=](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i)
+            *static_cast<volatile char*>(p + i * page) = 0;
+    };
+    if (threads == 1 || pages < size_t(threads)) {
+        work(0, pages);
+        return;
+    }
+    std::vector<std::thread> pool;
+    size_t step = (pages + threads - 1) / threads;
+    for (size_t first = 0; first < pages; first += step)
+        pool.emplace_back(work, first, first + step < pages ? first + step : pages);
+    for (auto& t : pool)
+        t.join();
+}
+
+inline void* HugePageResource::doAllocate(size_t bytes, size_t align) {
+    if (!mapped(bytes) || align > HUGE_PAGE)
+        return upstream->allocate(bytes, align);
+#ifdef __linux__
+    size_t len = roundUp(bytes, HUGE_PAGE);
+
+    // Over-map by one huge page, then trim both ends to get 2 MiB alignment
+    void* raw = mmap(nullptr, len + HUGE_PAGE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (raw == MAP_FAILED)
+        CPPLIB_THROW_BAD_ALLOC();
+    uintptr_t base = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = roundUp(base, HUGE_PAGE);
+    if (aligned > base)
+        munmap(raw, aligned - base);
+    if (aligned + len < base + len + HUGE_PAGE)
+        munmap(reinterpret_cast<void*>(aligned + len), base + HUGE_PAGE - aligned);
+
+    char* p = reinterpret_cast<char*>(aligned);
+    if (prefault == POPULATE) {
+        // Remap in place now that the address is fixed, faulting everything in
+        void* q = mmap(p, len, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_POPULATE, -1, 0);
+        if (q == MAP_FAILED) {
+            munmap(p, len);
+            CPPLIB_THROW_BAD_ALLOC();
+        }
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(p, len, MADV_HUGEPAGE);
+#endif
+    if (prefault == TOUCH)
+        touch(p, len);
+    return p;
+#else
+    return upstream->allocate(bytes, align);
+#endif
+}
+
+inline void HugePageResource::doDeallocate(void* p, size_t bytes, size_t align) {
+    if (p == nullptr) return;
+    if (!mapped(bytes) || align > HUGE_PAGE)
+        return upstream->deallocate(p, bytes, align);
+#ifdef __linux__
+    munmap(p, roundUp(bytes, HUGE_PAGE));
+#endif
+}
+
+inline bool HugePageResource::doCanShrink(size_t oldBytes, size_t newBytes) const {
+    return newBytes <= oldBytes && mapped(newBytes) && mapped(oldBytes);
+}
+
+inline void HugePageResource::doShrink(void* p, size_t oldBytes, size_t newBytes) {
+#ifdef __linux__
+    char* base = static_cast<char*>(p);
+    size_t keep = roundUp(newBytes, HUGE_PAGE);
+    size_t len = roundUp(oldBytes, HUGE_PAGE);
+    // Drop the pages past the new end inside the last kept huge page
+    size_t used = roundUp(newBytes, pageSize());
+    if (used < keep)
+        madvise(base + used, keep - used, MADV_DONTNEED);
+    if (keep < len)
+        munmap(base + keep, len - keep);
+#else
+    (void)p;
+    (void)oldBytes;
+    (void)newBytes;
+#endif
+}
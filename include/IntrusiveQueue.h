@@ -0,0 +1,223 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include "Config.h"
+
+/**
+ * Hook an element type inherits to be linked into an IntrusiveQueue. Tag
+ * tells hooks apart when an element must sit in several queues at once:
+ *
+ *   struct Message : QueueHook<>, QueueHook<Retry> { ... };
+ *   IntrusiveQueue<Message> inbox;
+ *   IntrusiveQueue<Message, Retry> retries;
+ *
+ * A hook is unlinked (next is null) or linked into exactly one queue; the
+ * last element of a queue points at itself. Copying an element does not
+ * copy its links. Destroying an element that is still linked trips an
+ * assertion.
+ */
+template<typename Tag = void>
+class QueueHook {
+private:
+    template<typename E, typename T>
+    friend class IntrusiveQueue;
+
+    QueueHook* next;
+public:
+    QueueHook() : next(nullptr) {}
+    QueueHook(const QueueHook&) : next(nullptr) {}
+    QueueHook& operator=(const QueueHook&) { return *this; }
+    ~QueueHook() { assert(next == nullptr && "element destroyed while in an IntrusiveQueue"); }
+
+    bool isLinked() const { return next != nullptr; }
+};
+
+/**
+ * FIFO queue of elements that carry their own link, so enqueue() and
+ * dequeue() relink pointers and never allocate, copy or move an element.
+ * The queue does not own its elements: they must outlive their stay in it,
+ * and clear() or destroying the queue only unlinks them.
+ *
+ * splice() moves a whole queue onto the back of another in O(1). With
+ * assertions enabled, enqueueing an element that is already linked and
+ * splicing a queue onto itself are caught.
+ */
+template<typename E, typename Tag = void>
+class IntrusiveQueue {
+private:
+    using Hook = QueueHook<Tag>;
+
+    int n;
+    Hook* head;
+    Hook* tail;
+
+    static Hook* hook(E& elem) { return static_cast<Hook*>(&elem); }
+    static E& elem(Hook* x) { return static_cast<E&>(*x); }
+public:
+    IntrusiveQueue() : n(0), head(nullptr), tail(nullptr) {}
+    IntrusiveQueue(const IntrusiveQueue&) = delete;
+    IntrusiveQueue(IntrusiveQueue&& that) noexcept;
+    IntrusiveQueue& operator=(const IntrusiveQueue&) = delete;
+    IntrusiveQueue& operator=(IntrusiveQueue&& that) noexcept;
+    ~IntrusiveQueue() { clear(); }
+
+    int size() const { return n; }
+    bool isEmpty() const { return n == 0; }
+    void enqueue(E& elem);
+    E& dequeue();
+    // Unlink the front element and point elem at it; return false if empty
+    bool tryDequeue(E*& elem);
+    E& front();
+    const E& front() const;
+    E& back();
+    const E& back() const;
+    // Move every element of that to the back of this queue, leaving that empty
+    void splice(IntrusiveQueue& that);
+    void swap(IntrusiveQueue& that);
+    // Unlink every element
+    void clear();
+
+    template <typename T, typename G>
+    friend std::ostream& operator<<(std::ostream& os, const IntrusiveQueue<T, G>& queue);
+
+    class iterator {
+    private:
+        Hook* i;
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = E;
+        using difference_type = std::ptrdiff_t;
+        using pointer = E*;
+        using reference = E&;
+
+        iterator() : i(nullptr) {}
+        explicit iterator(Hook* x) : i(x) {}
+
+        E& operator*() const { return elem(i); }
+        E* operator->() const { return &elem(i); }
+        bool operator==(const iterator& that) const { return i == that.i; }
+        bool operator!=(const iterator& that) const { return i != that.i; }
+        iterator& operator++() { i = i->next != i ? i->next : nullptr; return *this; }
+        iterator operator++(int) { iterator tmp(*this); operator++(); return tmp; }
+    };
+
+    iterator begin() const { return iterator(head); }
+    iterator end() const { return iterator(nullptr); }
+};
+
+template<typename E, typename Tag>
+IntrusiveQueue<E, Tag>::IntrusiveQueue(IntrusiveQueue&& that) noexcept
+    : n(that.n), head(that.head), tail(that.tail) {
+    that.n = 0;
+    that.head = that.tail = nullptr;
+}
+
+template<typename E, typename Tag>
+IntrusiveQueue<E, Tag>& IntrusiveQueue<E, Tag>::operator=(IntrusiveQueue&& that) noexcept {
+    clear();
+    swap(that);
+    return *this;
+}
+
+template<typename E, typename Tag>
+void IntrusiveQueue<E, Tag>::enqueue(E& elem) {
+    Hook* x = hook(elem);
+    assert(!x->isLinked() && "element is already in an IntrusiveQueue");
+    x->next = x;
+    if (tail != nullptr)
+        tail->next = x;
+    else
+        head = x;
+    tail = x;
+    n++;
+}
+
+template<typename E, typename Tag>
+E& IntrusiveQueue<E, Tag>::dequeue() {
+    E* x;
+    if (!tryDequeue(x))
+        CPPLIB_THROW(std::out_of_range, "Queue underflow.");
+    return *x;
+}
+
+template<typename E, typename Tag>
+bool IntrusiveQueue<E, Tag>::tryDequeue(E*& x) {
+    if (isEmpty())
+        return false;
+    Hook* h = head;
+    head = h->next != h ? h->next : nullptr;
+    if (head == nullptr)
+        tail = nullptr;
+    h->next = nullptr;
+    n--;
+    x = &elem(h);
+    return true;
+}
+
+template<typename E, typename Tag>
+E& IntrusiveQueue<E, Tag>::front() {
+    return const_cast<E&>(static_cast<const IntrusiveQueue&>(*this).front());
+}
+
+template<typename E, typename Tag>
+const E& IntrusiveQueue<E, Tag>::front() const {
+    if (isEmpty())
+        CPPLIB_THROW(std::out_of_range, "Queue underflow.");
+    return elem(head);
+}
+
+template<typename E, typename Tag>
+E& IntrusiveQueue<E, Tag>::back() {
+    return const_cast<E&>(static_cast<const IntrusiveQueue&>(*this).back());
+}
+
+template<typename E, typename Tag>
+const E& IntrusiveQueue<E, Tag>::back() const {
+    if (isEmpty())
+        CPPLIB_THROW(std::out_of_range, "Queue underflow.");
+    return elem(tail);
+}
+
+template<typename E, typename Tag>
+void IntrusiveQueue<E, Tag>::splice(IntrusiveQueue& that) {
+    assert(&that != this && "splicing an IntrusiveQueue onto itself");
+    if (that.isEmpty())
+        return;
+    if (tail != nullptr)
+        tail->next = that.head;
+    else
+        head = that.head;
+    tail = that.tail;
+    n += that.n;
+    that.n = 0;
+    that.head = that.tail = nullptr;
+}
+
+template<typename E, typename Tag>
+void IntrusiveQueue<E, Tag>::swap(IntrusiveQueue& that) {
+    using std::swap;
+    swap(n, that.n);
+    swap(head, that.head);
+    swap(tail, that.tail);
+}
+
+template<typename E, typename Tag>
+void IntrusiveQueue<E, Tag>::clear() {
+    E* x;
+    while (tryDequeue(x)) {}
+}
+
+template<typename E, typename Tag>
+std::ostream& operator<<(std::ostream& os, const IntrusiveQueue<E, Tag>& queue) {
+    for (const E& elem : queue)
+        os << elem << " ";
+    return os;
+}
+
+template<typename E, typename Tag>
+void swap(IntrusiveQueue<E, Tag>& lhs, IntrusiveQueue<E, Tag>& rhs) {
+    lhs.swap(rhs);
+}
@@ -1,20 +1,44 @@
 #pragma once
+#include <cstddef>
 #include <iostream>
 #include <iterator>
+#include <memory>
+#include "Config.h"
+#include "ContainerStats.h"
+#include "Expected.h"
+#include "MemoryResource.h"
 
+// Node of LinkedQueue, outside the class so its allocator can be a base
 template<typename E>
-class LinkedQueue {
+struct LinkedQueueNode {
+    E elem;
+    LinkedQueueNode* next;
+    template<typename... Args>
+    LinkedQueueNode(Args&&... args) : elem(std::forward<Args>(args)...), next(nullptr) {}
+};
+
+template<typename E, typename Alloc = std::allocator<E>>
+class LinkedQueue : private StatsHook,
+    private AllocHolder<typename std::allocator_traits<Alloc>::template rebind_alloc<LinkedQueueNode<E>>> {
 private:
-    struct Node {
-        E elem;
-        Node* next;
-        Node(E elem) : elem(std::move(elem)), next(nullptr) {}
-    };
+    using Node = LinkedQueueNode<E>;
+    using NodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+    using NodeTraits = std::allocator_traits<NodeAlloc>;
+    using AllocHolder<NodeAlloc>::alloc;
+
     int n;
     Node* head;
     Node* tail;
+
+    void destroy(Node* x);
 public:
-    LinkedQueue();
+    using allocator_type = Alloc;
+    using StatsHook::setStatsCategory;
+#ifdef CPPLIB_STATS
+    using StatsHook::stats;
+#endif
+
+    explicit LinkedQueue(const Alloc& alloc = Alloc());
     LinkedQueue(const LinkedQueue& that);
     LinkedQueue(LinkedQueue&& that) noexcept;
     ~LinkedQueue();
@@ -22,24 +46,37 @@ public:
     int size() const { return n; }
     bool isEmpty() const { return n == 0; }
     void enqueue(E elem);
+    template<typename... Args>
+    void emplace(Args&&... args);
     E dequeue();
-    E front();
-    E back();
+    bool tryDequeue(E& elem);
+    Expected<E> tryDequeue();
+    E& front();
+    const E& front() const;
+    E& back();
+    const E& back() const;
     void swap(LinkedQueue& that);
     void clear();
+    allocator_type get_allocator() const { return Alloc(alloc()); }
     
     LinkedQueue& operator=(LinkedQueue that);
-    template <typename T>
-    friend bool operator==(const LinkedQueue<T>& lhs, const LinkedQueue<T>& rhs);
-    template <typename T>
-    friend bool operator!=(const LinkedQueue<T>& lhs, const LinkedQueue<T>& rhs);
-    template <typename T>
-    friend std::ostream& operator<<(std::ostream& os, const LinkedQueue<T>& queue);
-
-    class iterator : public std::iterator<std::forward_iterator_tag, E> {
+    template <typename T, typename A>
+    friend bool operator==(const LinkedQueue<T, A>& lhs, const LinkedQueue<T, A>& rhs);
+    template <typename T, typename A>
+    friend bool operator!=(const LinkedQueue<T, A>& lhs, const LinkedQueue<T, A>& rhs);
+    template <typename T, typename A>
+    friend std::ostream& operator<<(std::ostream& os, const LinkedQueue<T, A>& queue);
+
+    class iterator {
     private:
         Node* i;
     public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = E;
+        using difference_type = std::ptrdiff_t;
+        using pointer = E*;
+        using reference = E&;
+
         iterator() : i(nullptr) {}
         iterator(Node* x) : i(x) {}
         iterator(const iterator& that) : i(that.i) {}
@@ -53,18 +90,19 @@ public:
     };
     
     iterator begin() const { return iterator(head); }
-    iterator end() const { return iterator(tail); }
+    iterator end() const { return iterator(nullptr); }
 };
 
-template<typename E>
-LinkedQueue<E>::LinkedQueue() {
+template<typename E, typename Alloc>
+LinkedQueue<E, Alloc>::LinkedQueue(const Alloc& alloc) : StatsHook("LinkedQueue"), AllocHolder<NodeAlloc>(alloc) {
     n = 0;
     head = nullptr;
     tail = nullptr;
 }
 
-template<typename E>
-LinkedQueue<E>::LinkedQueue(const LinkedQueue& that) {
+template<typename E, typename Alloc>
+LinkedQueue<E, Alloc>::LinkedQueue(const LinkedQueue& that)
+    : StatsHook(that), AllocHolder<NodeAlloc>(NodeTraits::select_on_container_copy_construction(that.alloc())) {
     n = 0;
     head = nullptr;
     tail = nullptr;
@@ -72,108 +110,163 @@ LinkedQueue<E>::LinkedQueue(const LinkedQueue& that) {
         enqueue(i->elem);
 }
 
-template<typename E>
-LinkedQueue<E>::LinkedQueue(LinkedQueue&& that) noexcept {
+template<typename E, typename Alloc>
+LinkedQueue<E, Alloc>::LinkedQueue(LinkedQueue&& that) noexcept
+    : StatsHook(that), AllocHolder<NodeAlloc>(std::move(that.alloc())) {
     n = that.n;
     head = that.head;
     tail = that.tail;
+    that.n = 0;
     that.head = nullptr;
     that.tail = nullptr;
 }
 
-template<typename E>
-LinkedQueue<E>::~LinkedQueue() {
-    Node* aux = nullptr;
-    while (head != nullptr) {
-        aux = head;
-        head = head->next;
-        delete aux;
-    }
+template<typename E, typename Alloc>
+LinkedQueue<E, Alloc>::~LinkedQueue() {
+    clear();
 }
 
-template<typename E>
-void LinkedQueue<E>::enqueue(E elem) {
+template<typename E, typename Alloc>
+void LinkedQueue<E, Alloc>::destroy(Node* x) {
+    NodeTraits::destroy(alloc(), x);
+    NodeTraits::deallocate(alloc(), x, 1);
+}
+
+template<typename E, typename Alloc>
+void LinkedQueue<E, Alloc>::enqueue(E elem) {
+    emplace(std::move(elem));
+}
+
+template<typename E, typename Alloc>
+template<typename... Args>
+void LinkedQueue<E, Alloc>::emplace(Args&&... args) {
     Node* pold = tail;
-    tail = new Node(std::move(elem));
+    Node* pnew = NodeTraits::allocate(alloc(), 1);
+    CPPLIB_TRY {
+        NodeTraits::construct(alloc(), pnew, std::forward<Args>(args)...);
+    }
+    CPPLIB_CATCH_ALL {
+        NodeTraits::deallocate(alloc(), pnew, 1);
+        CPPLIB_RETHROW;
+    }
+    tail = pnew;
     if (isEmpty()) head = tail;
     else pold->next = tail;
     n++;
+    statsAllocate(sizeof(Node));
+    statsSize(n);
 }
 
-template<typename E>
-E LinkedQueue<E>::dequeue() {
+template<typename E, typename Alloc>
+E LinkedQueue<E, Alloc>::dequeue() {
     if (isEmpty()) 
-        throw std::out_of_range("Queue underflow.");
+        CPPLIB_THROW(std::out_of_range, "Queue underflow.");
 
     Node* pold = head;
-    E tmp = head->elem;
+    E tmp = std::move(head->elem);
     head = head->next;
-    delete pold;
+    destroy(pold);
     n--;
+    if (isEmpty()) tail = nullptr;
     return tmp;
 }
 
-template<typename E>
-E LinkedQueue<E>::front() {
+// Move the front element into elem and remove it; return false if empty.
+template<typename E, typename Alloc>
+bool LinkedQueue<E, Alloc>::tryDequeue(E& elem) {
     if (isEmpty()) 
-        throw std::out_of_range("Queue underflow.");
+        return false;
+
+    Node* pold = head;
+    elem = std::move(head->elem);
+    head = head->next;
+    destroy(pold);
+    n--;
+    if (isEmpty()) tail = nullptr;
+    return true;
+}
+
+// Remove and return the front element, or Error::EMPTY.
+template<typename E, typename Alloc>
+Expected<E> LinkedQueue<E, Alloc>::tryDequeue() {
+    if (isEmpty())
+        return Error::EMPTY;
+    return dequeue();
+}
+
+template<typename E, typename Alloc>
+E& LinkedQueue<E, Alloc>::front() {
+    return const_cast<E&>(static_cast<const LinkedQueue&>(*this).front());
+}
+
+template<typename E, typename Alloc>
+const E& LinkedQueue<E, Alloc>::front() const {
+    if (isEmpty()) 
+        CPPLIB_THROW(std::out_of_range, "Queue underflow.");
     return head->elem;
 }
 
-template<typename E>
-E LinkedQueue<E>::back() {
+template<typename E, typename Alloc>
+E& LinkedQueue<E, Alloc>::back() {
+    return const_cast<E&>(static_cast<const LinkedQueue&>(*this).back());
+}
+
+template<typename E, typename Alloc>
+const E& LinkedQueue<E, Alloc>::back() const {
     if (isEmpty()) 
-        throw std::out_of_range("Queue underflow.");
+        CPPLIB_THROW(std::out_of_range, "Queue underflow.");
     return tail->elem;
 }
 
-template<typename E>
-void LinkedQueue<E>::swap(LinkedQueue<E>& that) {
+template<typename E, typename Alloc>
+void LinkedQueue<E, Alloc>::swap(LinkedQueue<E, Alloc>& that) {
     using std::swap;
+    swapStats(that);
+    swap(alloc(), that.alloc());
     swap(n, that.n);
     swap(head, that.head);
     swap(tail, that.tail);
 }
 
-template<typename E>
-void LinkedQueue<E>::clear() {
+template<typename E, typename Alloc>
+void LinkedQueue<E, Alloc>::clear() {
     Node* aux = nullptr;
     while (head != nullptr) {
         aux = head;
         head = head->next;
-        delete aux;
+        destroy(aux);
     }
     tail = nullptr;
     n = 0;
 }
 
-template<typename E>
-LinkedQueue<E>& LinkedQueue<E>::operator=(LinkedQueue<E> that) {
+template<typename E, typename Alloc>
+LinkedQueue<E, Alloc>& LinkedQueue<E, Alloc>::operator=(LinkedQueue<E, Alloc> that) {
     swap(that);
     return *this;
 }
 
-template<typename E>
-bool operator==(const LinkedQueue<E>& lhs, const LinkedQueue<E>& rhs) {
+template<typename E, typename Alloc>
+bool operator==(const LinkedQueue<E, Alloc>& lhs, const LinkedQueue<E, Alloc>& rhs) {
     if (&lhs == &rhs) return true;
     if (lhs.size() != rhs.size()) return false;
     return std::equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
-template<typename E>
-bool operator!=(const LinkedQueue<E>& lhs, const LinkedQueue<E>& rhs) {
+template<typename E, typename Alloc>
+bool operator!=(const LinkedQueue<E, Alloc>& lhs, const LinkedQueue<E, Alloc>& rhs) {
     return !(lhs == rhs);
 }
 
-template<typename E>
-std::ostream& operator<<(std::ostream& os, const LinkedQueue<E>& queue) {
-    using Node = typename LinkedQueue<E>::Node;
+template<typename E, typename Alloc>
+std::ostream& operator<<(std::ostream& os, const LinkedQueue<E, Alloc>& queue) {
+    using Node = typename LinkedQueue<E, Alloc>::Node;
     for (Node* i = queue.head; i != nullptr; i = i->next)
         os << i->elem << " ";
     return os;
 }
 
-template<typename E>
-void swap(LinkedQueue<E>& lhs, LinkedQueue<E>& rhs) {
+template<typename E, typename Alloc>
+void swap(LinkedQueue<E, Alloc>& lhs, LinkedQueue<E, Alloc>& rhs) {
     lhs.swap(rhs);
 }
@@ -0,0 +1,652 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include "Config.h"
+#include "EpochDomain.h"
+#include "Hash.h"
+#include "MemoryResource.h"
+#include "RwLock.h"
+#include "Vector.h"
+
+/**
+ * Fixed-capacity caches that evict the least recently used entry.
+ *
+ *   - LruCache:        single-threaded
+ *   - ShardedLruCache: thread-safe; keys are spread over independently
+ *                      locked shards by hash
+ *
+ * Entries live in one contiguous slab allocated up front, indexed by an
+ * open-addressing table of slab positions; nothing is allocated per entry.
+ * Two eviction modes:
+ *
+ *   - Eviction::LRU:   exact recency order, kept as a doubly linked list of
+ *                      slab positions. A hit moves its entry to the front,
+ *                      so it writes shared state.
+ *   - Eviction::CLOCK: approximate LRU. A hit only sets the entry's
+ *                      reference bit (and only if it is clear); eviction
+ *                      sweeps a hand over the slab, clearing set bits and
+ *                      evicting the first entry whose bit is clear. In
+ *                      ShardedLruCache, lookups through a Reader then take
+ *                      no lock at all.
+ *
+ * The slab and the index are allocated from a MemoryResource, so a large
+ * cache can be backed by a HugePageResource.
+ */
+enum class Eviction { LRU, CLOCK };
+
+template<typename K, typename V, typename Hash, typename Equal>
+class ShardedLruCache;
+
+template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+class LruCache {
+private:
+    friend class ShardedLruCache<K, V, Hash, Equal>;
+
+    static const uint32_t NIL = UINT32_MAX;
+    static const uint32_t EMPTY = 0;
+
+    struct Node {
+        K key;
+        V value;
+        uint32_t hash;
+        uint32_t prev;    // Towards the most recently used
+        uint32_t next;    // Towards the least recently used; next free node
+    };
+
+    Eviction mode;
+    uint32_t cap;
+    Hash hasher;
+    Equal equal;
+    size_t mask;
+    Vector<Node, PolymorphicAllocator<Node>> nodes;
+    // Open addressing with linear probing: node + 1, or EMPTY
+    Vector<uint32_t, PolymorphicAllocator<uint32_t>> slots;
+    std::unique_ptr<std::atomic<uint8_t>[]> referenced;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t freeHead;
+    uint32_t hand;
+    int count;
+
+    // Return the index size for capacity: a power of two, at least twice it
+    static size_t tableSize(size_t capacity);
+    // Return the slot holding key, or the empty slot ending its probe sequence
+    size_t findSlot(const K& key, uint32_t h) const;
+    // Empty slot j, shifting back the entries probed past it
+    void unindex(size_t j);
+    void unlink(uint32_t i);
+    void pushFront(uint32_t i);
+    void touch(uint32_t i);
+    // Pick a node to evict and take it out of the index
+    uint32_t evict();
+public:
+    explicit LruCache(size_t capacity, Eviction mode = Eviction::LRU,
+                      MemoryResource* resource = newDeleteResource());
+    LruCache(const LruCache&) = delete;
+    LruCache& operator=(const LruCache&) = delete;
+
+    // Return the hash the cache uses for key
+    uint64_t hash(const K& key) const { return hashMix(hasher(key)); }
+    // Copy key's value into value and mark it used; false on a miss
+    bool get(const K& key, V& value) { return get(key, hash(key), value); }
+    bool get(const K& key, uint64_t hash, V& value);
+    // Check for key without marking it used
+    bool contains(const K& key) const { return slots[findSlot(key, hash(key))] != EMPTY; }
+    // Insert or replace key's value, evicting an entry if the cache is full
+    void put(const K& key, const V& value) { put(key, hash(key), value); }
+    void put(const K& key, uint64_t hash, const V& value);
+    bool erase(const K& key) { return erase(key, hash(key)); }
+    bool erase(const K& key, uint64_t hash);
+    void clear();
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+    size_t capacity() const { return cap; }
+    Eviction eviction() const { return mode; }
+};
+
+template<typename K, typename V, typename Hash, typename Equal>
+LruCache<K, V, Hash, Equal>::LruCache(size_t capacity, Eviction mode, MemoryResource* resource)
+    : mode(mode), cap(static_cast<uint32_t>(capacity)), mask(tableSize(capacity) - 1),
+      nodes(cap, PolymorphicAllocator<Node>(resource)), slots(mask + 1, PolymorphicAllocator<uint32_t>(resource)),
+      head(NIL), tail(NIL), freeHead(NIL), hand(0), count(0) {
+    for (size_t j = 0; j <= mask; ++j)
+        slots.insert_back(EMPTY);
+    if (mode == Eviction::CLOCK)
+        referenced.reset(new std::atomic<uint8_t>[cap]());
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+size_t LruCache<K, V, Hash, Equal>::tableSize(size_t capacity) {
+    if (capacity == 0 || capacity > INT32_MAX / 2)
+        CPPLIB_THROW(std::invalid_argument, "LruCache capacity.");
+    // Keep the load factor at most 1/2
+    size_t table = 2;
+    while (table < 2 * capacity)
+        table *= 2;
+    return table;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+size_t LruCache<K, V, Hash, Equal>::findSlot(const K& key, uint32_t h) const {
+    size_t j = h & mask;
+    for (; slots[j] != EMPTY; j = (j + 1) & mask) {
+        const Node& n = nodes[slots[j] - 1];
+        if (n.hash == h && equal(n.key, key))
+            break;
+    }
+    return j;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+void LruCache<K, V, Hash, Equal>::unindex(size_t j) {
+    for (size_t k = (j + 1) & mask; slots[k] != EMPTY; k = (k + 1) & mask) {
+        size_t home = nodes[slots[k] - 1].hash & mask;
+        // The entry at k may fill j unless its home lies in (j, k]
+        if (((k - home) & mask) >= ((k - j) & mask)) {
+            slots[j] = slots[k];
+            j = k;
+        }
+    }
+    slots[j] = EMPTY;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+void LruCache<K, V, Hash, Equal>::unlink(uint32_t i) {
+    Node& n = nodes[i];
+    if (n.prev != NIL)
+        nodes[n.prev].next = n.next;
+    else
+        head = n.next;
+    if (n.next != NIL)
+        nodes[n.next].prev = n.prev;
+    else
+        tail = n.prev;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+void LruCache<K, V, Hash, Equal>::pushFront(uint32_t i) {
+    Node& n = nodes[i];
+    n.prev = NIL;
+    n.next = head;
+    if (head != NIL)
+        nodes[head].prev = i;
+    else
+        tail = i;
+    head = i;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+void LruCache<K, V, Hash, Equal>::touch(uint32_t i) {
+    if (mode == Eviction::LRU) {
+        if (i != head) {
+            unlink(i);
+            pushFront(i);
+        }
+    } else if (referenced[i].load(std::memory_order_relaxed) == 0) {
+        // Test first so hits on hot entries leave the cache line clean
+        referenced[i].store(1, std::memory_order_relaxed);
+    }
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+uint32_t LruCache<K, V, Hash, Equal>::evict() {
+    uint32_t i;
+    if (mode == Eviction::LRU) {
+        i = tail;
+        unlink(i);
+    } else {
+        for (;;) {
+            i = hand;
+            hand = hand + 1 < cap ? hand + 1 : 0;
+            if (referenced[i].load(std::memory_order_relaxed) == 0)
+                break;
+            referenced[i].store(0, std::memory_order_relaxed);
+        }
+    }
+    size_t j = nodes[i].hash & mask;
+    while (slots[j] != i + 1)
+        j = (j + 1) & mask;
+    unindex(j);
+    count--;
+    return i;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+bool LruCache<K, V, Hash, Equal>::get(const K& key, uint64_t hash, V& value) {
+    size_t j = findSlot(key, static_cast<uint32_t>(hash));
+    if (slots[j] == EMPTY)
+        return false;
+    uint32_t i = slots[j] - 1;
+    touch(i);
+    value = nodes[i].value;
+    return true;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+void LruCache<K, V, Hash, Equal>::put(const K& key, uint64_t hash, const V& value) {
+    uint32_t h = static_cast<uint32_t>(hash);
+    size_t j = findSlot(key, h);
+    if (slots[j] != EMPTY) {
+        uint32_t i = slots[j] - 1;
+        nodes[i].value = value;
+        touch(i);
+        return;
+    }
+
+    uint32_t i;
+    if (freeHead != NIL) {
+        i = freeHead;
+        freeHead = nodes[i].next;
+    } else if (static_cast<uint32_t>(nodes.size()) < cap) {
+        i = nodes.size();
+        nodes.insert_back(Node{ key, value, h, NIL, NIL });
+    } else {
+        i = evict();
+        // Evicting shifted the index; find the insertion slot again
+        j = findSlot(key, h);
+    }
+    Node& n = nodes[i];
+    n.key = key;
+    n.value = value;
+    n.hash = h;
+    slots[j] = i + 1;
+    count++;
+    if (mode == Eviction::LRU)
+        pushFront(i);
+    else
+        referenced[i].store(0, std::memory_order_relaxed);
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+bool LruCache<K, V, Hash, Equal>::erase(const K& key, uint64_t hash) {
+    size_t j = findSlot(key, static_cast<uint32_t>(hash));
+    if (slots[j] == EMPTY)
+        return false;
+    uint32_t i = slots[j] - 1;
+    unindex(j);
+    if (mode == Eviction::LRU)
+        unlink(i);
+    nodes[i].next = freeHead;
+    freeHead = i;
+    count--;
+    return true;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+void LruCache<K, V, Hash, Equal>::clear() {
+    nodes.clear();
+    for (size_t j = 0; j <= mask; ++j)
+        slots[j] = EMPTY;
+    head = tail = freeHead = NIL;
+    hand = 0;
+    count = 0;
+}
+
+/**
+ * Thread-safe cache made of 2^k shards, each behind its own RwLock. The
+ * top bits of the hash pick the shard. Writers take the shard lock
+ * exclusively.
+ *
+ * In LRU mode each shard is an LruCache and get() takes the lock
+ * exclusively too, since a hit reorders the recency list.
+ *
+ * In CLOCK mode each shard indexes immutable entries through atomic
+ * pointers, and a Reader's get() takes no lock: it probes the index,
+ * copies the value and sets the entry's reference bit if it is clear, so a
+ * hit on a hot entry writes nothing but the reader's own epoch slot. A
+ * writer replaces an entry rather than modifying it and retires the old
+ * one to an EpochDomain, which frees it once no reader can hold it. A
+ * per-shard sequence count, odd while entries are being shifted in the
+ * index, tells a reader that a miss may be spurious; it then retries, and
+ * after a few tries takes the lock shared. Each put() in CLOCK mode
+ * allocates one entry. get() without a Reader takes the lock shared.
+ */
+template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+class ShardedLruCache {
+private:
+    static const int RETRIES = 4;
+    static const int RECLAIM_EVERY = 64;
+
+    // A CLOCK shard's entry; only its reference bit changes once published
+    struct Entry {
+        K key;
+        V value;
+        uint32_t hash;
+        uint32_t pos;    // Position in the shard's ring, which the hand sweeps
+        std::atomic<uint8_t> referenced;
+        Entry(const K& key, const V& value, uint32_t hash, uint32_t pos, uint8_t referenced)
+            : key(key), value(value), hash(hash), pos(pos), referenced(referenced) {}
+    };
+
+    // CLOCK mode shard contents; every member but slots and seq is the writer's
+    class Clock {
+    private:
+        MemoryResource* resource;
+        size_t mask;
+        std::atomic<Entry*>* slots;    // Open addressing with linear probing
+        std::atomic<uint64_t> seq;
+        Vector<Entry*> ring;
+        Vector<uint32_t> freePos;
+        uint32_t cap;
+        uint32_t hand;
+        int count;
+
+        size_t findSlot(const K& key, uint32_t h, const Equal& equal) const;
+        // Empty slot j, shifting back the entries probed past it, with seq odd
+        void unindex(size_t j);
+        // Pick an entry to evict, take it out of the index and return it
+        Entry* evict(const Equal& equal);
+    public:
+        Clock(size_t capacity, MemoryResource* resource);
+        Clock(const Clock&) = delete;
+        Clock& operator=(const Clock&) = delete;
+        ~Clock();
+
+        // Look key up without a lock; false on a miss, or after retries if the index kept changing
+        bool tryFind(const K& key, uint32_t h, const Equal& equal, V& value, bool& sure) const;
+        // Look key up with the shard lock held
+        bool find(const K& key, uint32_t h, const Equal& equal, V& value) const;
+        // Return the entry key replaced or evicted, to retire, or nullptr
+        Entry* put(const K& key, uint32_t h, const Equal& equal, const V& value);
+        Entry* erase(const K& key, uint32_t h, const Equal& equal);
+        int size() const { return count; }
+        size_t capacity() const { return cap; }
+    };
+
+    struct Shard {
+        char pad[64];    // Keep the locks of neighbouring shards off one cache line
+        RwLock lock;
+        std::unique_ptr<LruCache<K, V, Hash, Equal>> lru;
+        std::unique_ptr<Clock> clock;
+        int retired;
+        Shard(size_t capacity, Eviction mode, MemoryResource* resource) : retired(0) {
+            if (mode == Eviction::LRU)
+                lru.reset(new LruCache<K, V, Hash, Equal>(capacity, mode, resource));
+            else
+                clock.reset(new Clock(capacity, resource));
+        }
+    };
+
+    int bits;
+    Eviction mode;
+    Hash hasher;
+    Equal equal;
+    EpochDomain domain;
+    std::unique_ptr<std::unique_ptr<Shard>[]> shards;
+
+    uint64_t hash(const K& key) const { return hashMix(hasher(key)); }
+    Shard& shardOf(uint64_t hash) const { return *shards[bits > 0 ? hash >> (64 - bits) : 0]; }
+    // Retire an entry a writer of shard took out, reclaiming every so often
+    void retire(Shard& shard, Entry* e);
+public:
+    class Reader;
+
+    explicit ShardedLruCache(size_t capacity, int bits = 4, Eviction mode = Eviction::LRU,
+                             MemoryResource* resource = newDeleteResource(), int readers = 256);
+
+    bool get(const K& key, V& value);
+    void put(const K& key, const V& value);
+    bool erase(const K& key);
+    int size() const;
+    // Return the total capacity, rounded up to a multiple of the shard count
+    size_t capacity() const;
+    Eviction eviction() const { return mode; }
+
+    /**
+     * A reading thread's handle on the cache: holds an epoch slot, so its
+     * get() in CLOCK mode takes no lock. No Reader may outlive the cache.
+     */
+    class Reader {
+    private:
+        ShardedLruCache& cache;
+        EpochReader epoch;
+    public:
+        explicit Reader(ShardedLruCache& cache) : cache(cache), epoch(cache.domain) {}
+
+        // Copy key's value into value and mark it used; false on a miss
+        bool get(const K& key, V& value);
+        void put(const K& key, const V& value) { cache.put(key, value); }
+        bool erase(const K& key) { return cache.erase(key); }
+    };
+};
+
+template<typename K, typename V, typename Hash, typename Equal>
+ShardedLruCache<K, V, Hash, Equal>::Clock::Clock(size_t capacity, MemoryResource* resource)
+    : resource(resource), mask(LruCache<K, V, Hash, Equal>::tableSize(capacity) - 1), slots(nullptr), seq(0),
+      ring(static_cast<int>(capacity)), freePos(0), cap(static_cast<uint32_t>(capacity)), hand(0), count(0) {
+    slots = static_cast<std::atomic<Entry*>*>(resource->allocate((mask + 1) * sizeof(std::atomic<Entry*>), 64));
+    for (size_t j = 0; j <= mask; ++j)
+        new (&slots[j]) std::atomic<Entry*>(nullptr);
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+ShardedLruCache<K, V, Hash, Equal>::Clock::~Clock() {
+    for (Entry* e : ring)
+        delete e;
+    resource->deallocate(slots, (mask + 1) * sizeof(std::atomic<Entry*>), 64);
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+size_t ShardedLruCache<K, V, Hash, Equal>::Clock::findSlot(const K& key, uint32_t h, const Equal& equal) const {
+    size_t j = h & mask;
+    for (Entry* e; (e = slots[j].load(std::memory_order_relaxed)) != nullptr; j = (j + 1) & mask)
+        if (e->hash == h && equal(e->key, key))
+            break;
+    return j;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+void ShardedLruCache<K, V, Hash, Equal>::Clock::unindex(size_t j) {
+    // While entries shift back, a reader probing past them may miss one. All
+    // seq_cst, so a reader that sees any of these stores also sees seq odd
+    uint64_t s = seq.load(std::memory_order_relaxed);
+    seq.store(s + 1, std::memory_order_seq_cst);
+    for (size_t k = (j + 1) & mask; ; k = (k + 1) & mask) {
+        Entry* e = slots[k].load(std::memory_order_relaxed);
+        if (e == nullptr)
+            break;
+        size_t home = e->hash & mask;
+        // The entry at k may fill j unless its home lies in (j, k]
+        if (((k - home) & mask) >= ((k - j) & mask)) {
+            slots[j].store(e, std::memory_order_seq_cst);
+            j = k;
+        }
+    }
+    slots[j].store(nullptr, std::memory_order_seq_cst);
+    seq.store(s + 2, std::memory_order_seq_cst);
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+typename ShardedLruCache<K, V, Hash, Equal>::Entry* ShardedLruCache<K, V, Hash, Equal>::Clock::evict(const Equal& equal) {
+    Entry* e;
+    for (;;) {
+        e = ring[hand];
+        hand = hand + 1 < cap ? hand + 1 : 0;
+        if (e->referenced.load(std::memory_order_relaxed) == 0)
+            break;
+        e->referenced.store(0, std::memory_order_relaxed);
+    }
+    unindex(findSlot(e->key, e->hash, equal));
+    count--;
+    return e;
+}
+
+/**
+ * @param sure: Set to whether a miss is certain, rather than possibly caused by concurrent writers
+ */
+template<typename K, typename V, typename Hash, typename Equal>
+bool ShardedLruCache<K, V, Hash, Equal>::Clock::tryFind(const K& key, uint32_t h, const Equal& equal,
+                                                         V& value, bool& sure) const {
+    for (int attempt = 0; attempt < RETRIES; ++attempt) {
+        uint64_t s = seq.load(std::memory_order_seq_cst);
+        if (s % 2 == 0) {
+            for (size_t j = h & mask; ; j = (j + 1) & mask) {
+                // seq_cst, so the entry stays valid until the reader leaves its epoch
+                Entry* e = slots[j].load(std::memory_order_seq_cst);
+                if (e == nullptr)
+                    break;
+                if (e->hash == h && equal(e->key, key)) {
+                    // Test first so hits on hot entries leave the cache line clean
+                    if (e->referenced.load(std::memory_order_relaxed) == 0)
+                        e->referenced.store(1, std::memory_order_relaxed);
+                    value = e->value;
+                    sure = true;
+                    return true;
+                }
+            }
+            if (seq.load(std::memory_order_seq_cst) == s) {
+                sure = true;
+                return false;
+            }
+        }
+    }
+    sure = false;
+    return false;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+bool ShardedLruCache<K, V, Hash, Equal>::Clock::find(const K& key, uint32_t h, const Equal& equal, V& value) const {
+    Entry* e = slots[findSlot(key, h, equal)].load(std::memory_order_relaxed);
+    if (e == nullptr)
+        return false;
+    if (e->referenced.load(std::memory_order_relaxed) == 0)
+        e->referenced.store(1, std::memory_order_relaxed);
+    value = e->value;
+    return true;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+typename ShardedLruCache<K, V, Hash, Equal>::Entry*
+ShardedLruCache<K, V, Hash, Equal>::Clock::put(const K& key, uint32_t h, const Equal& equal, const V& value) {
+    size_t j = findSlot(key, h, equal);
+    Entry* old = slots[j].load(std::memory_order_relaxed);
+    if (old != nullptr) {
+        // Readers see either the old entry or the new one, never a partial value
+        Entry* e = new Entry(key, value, h, old->pos, 1);
+        slots[j].store(e, std::memory_order_release);
+        ring[old->pos] = e;
+        return old;
+    }
+
+    // Allocate first, so a failure leaves the shard as it was
+    std::unique_ptr<Entry> e(new Entry(key, value, h, 0, 0));
+    if (freePos.size() > 0) {
+        e->pos = freePos.back();
+        freePos.remove_back();
+    } else if (static_cast<uint32_t>(ring.size()) < cap) {
+        e->pos = ring.size();
+        ring.insert_back(nullptr);
+    } else {
+        old = evict(equal);
+        e->pos = old->pos;
+        // Evicting shifted the index; find the insertion slot again
+        j = findSlot(key, h, equal);
+    }
+    ring[e->pos] = e.get();
+    slots[j].store(e.release(), std::memory_order_release);
+    count++;
+    return old;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+typename ShardedLruCache<K, V, Hash, Equal>::Entry*
+ShardedLruCache<K, V, Hash, Equal>::Clock::erase(const K& key, uint32_t h, const Equal& equal) {
+    size_t j = findSlot(key, h, equal);
+    Entry* e = slots[j].load(std::memory_order_relaxed);
+    if (e == nullptr)
+        return nullptr;
+    freePos.insert_back(e->pos);
+    unindex(j);
+    ring[e->pos] = nullptr;
+    count--;
+    return e;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+ShardedLruCache<K, V, Hash, Equal>::ShardedLruCache(size_t capacity, int bits, Eviction mode,
+                                                    MemoryResource* resource, int readers)
+    : bits(bits), mode(mode), domain(readers), shards(new std::unique_ptr<Shard>[size_t(1) << bits]) {
+    size_t per = (capacity + (size_t(1) << bits) - 1) >> bits;
+    for (size_t i = 0; i < size_t(1) << bits; ++i)
+        shards[i].reset(new Shard(per > 0 ? per : 1, mode, resource));
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+void ShardedLruCache<K, V, Hash, Equal>::retire(Shard& shard, Entry* e) {
+    if (e == nullptr)
+        return;
+    domain.retire(e);
+    if (++shard.retired % RECLAIM_EVERY == 0)
+        domain.reclaim();
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+bool ShardedLruCache<K, V, Hash, Equal>::get(const K& key, V& value) {
+    uint64_t h = hash(key);
+    Shard& shard = shardOf(h);
+    if (mode == Eviction::CLOCK) {
+        SharedLock lock(shard.lock);
+        return shard.clock->find(key, static_cast<uint32_t>(h), equal, value);
+    }
+    std::lock_guard<RwLock> lock(shard.lock);
+    return shard.lru->get(key, h, value);
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+bool ShardedLruCache<K, V, Hash, Equal>::Reader::get(const K& key, V& value) {
+    if (cache.mode != Eviction::CLOCK)
+        return cache.get(key, value);
+    uint64_t h = cache.hash(key);
+    Shard& shard = cache.shardOf(h);
+    bool sure;
+    epoch.enter();
+    bool hit = shard.clock->tryFind(key, static_cast<uint32_t>(h), cache.equal, value, sure);
+    epoch.exit();
+    if (sure)
+        return hit;
+    SharedLock lock(shard.lock);
+    return shard.clock->find(key, static_cast<uint32_t>(h), cache.equal, value);
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+void ShardedLruCache<K, V, Hash, Equal>::put(const K& key, const V& value) {
+    uint64_t h = hash(key);
+    Shard& shard = shardOf(h);
+    std::lock_guard<RwLock> lock(shard.lock);
+    if (mode == Eviction::CLOCK)
+        retire(shard, shard.clock->put(key, static_cast<uint32_t>(h), equal, value));
+    else
+        shard.lru->put(key, h, value);
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+bool ShardedLruCache<K, V, Hash, Equal>::erase(const K& key) {
+    uint64_t h = hash(key);
+    Shard& shard = shardOf(h);
+    std::lock_guard<RwLock> lock(shard.lock);
+    if (mode == Eviction::LRU)
+        return shard.lru->erase(key, h);
+    Entry* e = shard.clock->erase(key, static_cast<uint32_t>(h), equal);
+    retire(shard, e);
+    return e != nullptr;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+int ShardedLruCache<K, V, Hash, Equal>::size() const {
+    int n = 0;
+    for (size_t i = 0; i < size_t(1) << bits; ++i) {
+        SharedLock lock(shards[i]->lock);
+        n += mode == Eviction::LRU ? shards[i]->lru->size() : shards[i]->clock->size();
+    }
+    return n;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+size_t ShardedLruCache<K, V, Hash, Equal>::capacity() const {
+    return (mode == Eviction::LRU ? shards[0]->lru->capacity() : shards[0]->clock->capacity()) << bits;
+}
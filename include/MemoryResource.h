@@ -0,0 +1,477 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include "Config.h"
+
+/**
+ * Polymorphic memory resources for the containers.
+ *
+ * MemoryResource is the abstract interface, modelled on std::pmr (which is
+ * not available in C++11). PolymorphicAllocator adapts a resource to the
+ * standard Allocator interface so it can be passed as the allocator template
+ * argument of Vector, ArrayStack, ArrayQueue and LinkedQueue.
+ *
+ * Provided resources:
+ *   - newDeleteResource(): global operator new/delete (the default)
+ *   - MonotonicArena:      bump allocation, everything freed at once
+ *   - PoolResource:        size-class free lists, not synchronized;
+ *                          threadLocalPoolResource() returns one per thread
+ *   - TrackingResource:    counts calls and bytes of an upstream resource
+ *
+ * A resource may also support shrinking a block in place (see
+ * HugePageResource); containers use it instead of reallocating when they
+ * halve their capacity.
+ */
+class MemoryResource {
+public:
+    static const size_t MAX_ALIGN = alignof(std::max_align_t);
+
+    virtual ~MemoryResource() {}
+
+    // Allocate bytes with the specified alignment
+    void* allocate(size_t bytes, size_t align = MAX_ALIGN) { return doAllocate(bytes, align); }
+    // Return memory obtained from allocate() with the same bytes and alignment
+    void deallocate(void* p, size_t bytes, size_t align = MAX_ALIGN) { doDeallocate(p, bytes, align); }
+    // Check if memory allocated from this resource can be freed by that one
+    bool isEqual(const MemoryResource& that) const noexcept { return doIsEqual(that); }
+    // Check if a block of oldBytes can be shrunk in place to newBytes
+    bool canShrink(size_t oldBytes, size_t newBytes) const { return doCanShrink(oldBytes, newBytes); }
+    // Shrink a block in place; only valid if canShrink() returned true.
+    // Afterwards the block must be deallocated with newBytes.
+    void shrink(void* p, size_t oldBytes, size_t newBytes) { doShrink(p, oldBytes, newBytes); }
+protected:
+    virtual void* doAllocate(size_t bytes, size_t align) = 0;
+    virtual void doDeallocate(void* p, size_t bytes, size_t align) = 0;
+    virtual bool doIsEqual(const MemoryResource& that) const noexcept { return this == &that; }
+    virtual bool doCanShrink(size_t, size_t) const { return false; }
+    virtual void doShrink(void*, size_t, size_t) {}
+};
+
+/**
+ * Resource using the global operator new and operator delete.
+ * Over-aligned requests are served by over-allocating and storing the
+ * original pointer in front of the returned block.
+ */
+class NewDeleteResource : public MemoryResource {
+protected:
+    void* doAllocate(size_t bytes, size_t align) override;
+    void doDeallocate(void* p, size_t bytes, size_t align) override;
+};
+
+inline void* NewDeleteResource::doAllocate(size_t bytes, size_t align) {
+    if (align <= MAX_ALIGN)
+        return ::operator new(bytes);
+
+    void* raw = ::operator new(bytes + align + sizeof(void*));
+    uintptr_t p = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + align - 1) & ~(uintptr_t)(align - 1);
+    reinterpret_cast<void**>(p)[-1] = raw;
+    return reinterpret_cast<void*>(p);
+}
+
+inline void NewDeleteResource::doDeallocate(void* p, size_t, size_t align) {
+    if (p == nullptr) return;
+    if (align <= MAX_ALIGN)
+        ::operator delete(p);
+    else
+        ::operator delete(static_cast<void**>(p)[-1]);
+}
+
+// Return the process-wide new/delete resource
+inline MemoryResource* newDeleteResource() {
+    static NewDeleteResource resource;
+    return &resource;
+}
+
+inline std::atomic<MemoryResource*>& defaultResourceSlot() {
+    static std::atomic<MemoryResource*> slot(newDeleteResource());
+    return slot;
+}
+
+// Return the resource used by default-constructed PolymorphicAllocators
+inline MemoryResource* defaultResource() {
+    return defaultResourceSlot().load(std::memory_order_acquire);
+}
+
+// Replace the default resource, return the previous one
+inline MemoryResource* setDefaultResource(MemoryResource* r) {
+    return defaultResourceSlot().exchange(r != nullptr ? r : newDeleteResource(), std::memory_order_acq_rel);
+}
+
+/**
+ * Monotonic arena. Allocation bumps a pointer inside the current chunk;
+ * deallocate() is a no-op and all memory is returned to the upstream
+ * resource by release() or the destructor. Chunk sizes grow geometrically.
+ *
+ * Suited to request-scoped work: build any number of temporary containers
+ * on the arena and drop them all in one shot.
+ */
+class MonotonicArena : public MemoryResource {
+private:
+    static const size_t DEFAULT_CHUNK = 4096;
+
+    struct Chunk {
+        Chunk* next;
+        size_t size;
+    };
+
+    MemoryResource* upstream;
+    Chunk* chunks;
+    char* cur;
+    char* last;
+    size_t initialSize;
+    size_t nextSize;
+    size_t used;
+
+    void grow(size_t bytes, size_t align);
+public:
+    explicit MonotonicArena(size_t initial = DEFAULT_CHUNK, MemoryResource* upstream = newDeleteResource());
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+    ~MonotonicArena() { release(); }
+
+    // Free every chunk at once, invalidating all memory handed out so far
+    void release();
+    // Return the number of bytes handed out since the last release
+    size_t bytesUsed() const { return used; }
+    MemoryResource* upstreamResource() const { return upstream; }
+protected:
+    void* doAllocate(size_t bytes, size_t align) override;
+    void doDeallocate(void*, size_t, size_t) override {}
+};
+
+inline MonotonicArena::MonotonicArena(size_t initial, MemoryResource* upstream)
+    : upstream(upstream), chunks(nullptr), cur(nullptr), last(nullptr),
+      initialSize(initial > 0 ? initial : DEFAULT_CHUNK), nextSize(initialSize), used(0) {}
+
+inline void MonotonicArena::grow(size_t bytes, size_t align) {
+    size_t size = nextSize;
+    while (size < bytes + align + sizeof(Chunk))
+        size *= 2;
+    nextSize = size * 2;
+
+    Chunk* chunk = static_cast<Chunk*>(upstream->allocate(size, MAX_ALIGN));
+    chunk->next = chunks;
+    chunk->size = size;
+    chunks = chunk;
+    cur = reinterpret_cast<char*>(chunk + 1);
+    last = reinterpret_cast<char*>(chunk) + size;
+}
+
+inline void* MonotonicArena::doAllocate(size_t bytes, size_t align) {
+    uintptr_t p = (reinterpret_cast<uintptr_t>(cur) + align - 1) & ~(uintptr_t)(align - 1);
+    if (cur == nullptr || p + bytes > reinterpret_cast<uintptr_t>(last)) {
+        grow(bytes, align);
+        p = (reinterpret_cast<uintptr_t>(cur) + align - 1) & ~(uintptr_t)(align - 1);
+    }
+    cur = reinterpret_cast<char*>(p + bytes);
+    used += bytes;
+    return reinterpret_cast<void*>(p);
+}
+
+inline void MonotonicArena::release() {
+    while (chunks != nullptr) {
+        Chunk* aux = chunks;
+        chunks = chunks->next;
+        upstream->deallocate(aux, aux->size, MAX_ALIGN);
+    }
+    cur = nullptr;
+    last = nullptr;
+    nextSize = initialSize;
+    used = 0;
+}
+
+/**
+ * Pool resource with power-of-two size classes from 8 to MAX_BLOCK bytes.
+ * Freed blocks go to a per-class free list and are reused; blocks are carved
+ * from chunks obtained upstream, which are only returned by release() or the
+ * destructor. Larger requests go straight upstream.
+ *
+ * The pool is not synchronized: use one per thread, for instance through
+ * threadLocalPoolResource(). Blocks must be freed on the owning thread.
+ */
+class PoolResource : public MemoryResource {
+private:
+    static const size_t MIN_BLOCK = 8;
+    static const size_t MAX_BLOCK = 512;
+    static const int CLASSES = 7;
+    static const size_t BLOCKS_PER_CHUNK = 64;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+    struct Chunk {
+        Chunk* next;
+        size_t size;
+    };
+
+    MemoryResource* upstream;
+    FreeBlock* freeLists[CLASSES];
+    Chunk* chunks;
+
+    static int sizeClass(size_t bytes);
+    void refill(int c);
+public:
+    explicit PoolResource(MemoryResource* upstream = newDeleteResource());
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+    ~PoolResource() { release(); }
+
+    // Return all pooled chunks upstream
+    void release();
+protected:
+    void* doAllocate(size_t bytes, size_t align) override;
+    void doDeallocate(void* p, size_t bytes, size_t align) override;
+};
+
+inline PoolResource::PoolResource(MemoryResource* upstream) : upstream(upstream), chunks(nullptr) {
+    for (int c = 0; c < CLASSES; ++c)
+        freeLists[c] = nullptr;
+}
+
+inline int PoolResource::sizeClass(size_t bytes) {
+    int c = 0;
+    for (size_t size = MIN_BLOCK; size < bytes; size *= 2)
+        c++;
+    return c;
+}
+
+inline void PoolResource::refill(int c) {
+    size_t block = MIN_BLOCK << c;
+    // Chunk header occupies one block so every block stays block-aligned
+    size_t size = block * (BLOCKS_PER_CHUNK + 1);
+    Chunk* chunk = static_cast<Chunk*>(upstream->allocate(size, block > MAX_ALIGN ? block : MAX_ALIGN));
+    chunk->next = chunks;
+    chunk->size = size;
+    chunks = chunk;
+
+    char* p = reinterpret_cast<char*>(chunk) + (block > sizeof(Chunk) ? block : 2 * block);
+    char* end = reinterpret_cast<char*>(chunk) + size;
+    for (; p + block <= end; p += block) {
+        FreeBlock* b = reinterpret_cast<FreeBlock*>(p);
+        b->next = freeLists[c];
+        freeLists[c] = b;
+    }
+}
+
+inline void* PoolResource::doAllocate(size_t bytes, size_t align) {
+    size_t need = bytes > align ? bytes : align;
+    if (need > MAX_BLOCK)
+        return upstream->allocate(bytes, align);
+
+    int c = sizeClass(need);
+    if (freeLists[c] == nullptr)
+        refill(c);
+    FreeBlock* b = freeLists[c];
+    freeLists[c] = b->next;
+    return b;
+}
+
+inline void PoolResource::doDeallocate(void* p, size_t bytes, size_t align) {
+    if (p == nullptr) return;
+    size_t need = bytes > align ? bytes : align;
+    if (need > MAX_BLOCK)
+        return upstream->deallocate(p, bytes, align);
+
+    int c = sizeClass(need);
+    FreeBlock* b = static_cast<FreeBlock*>(p);
+    b->next = freeLists[c];
+    freeLists[c] = b;
+}
+
+inline void PoolResource::release() {
+    while (chunks != nullptr) {
+        Chunk* aux = chunks;
+        chunks = chunks->next;
+        size_t block = aux->size / (BLOCKS_PER_CHUNK + 1);
+        upstream->deallocate(aux, aux->size, block > MAX_ALIGN ? block : MAX_ALIGN);
+    }
+    for (int c = 0; c < CLASSES; ++c)
+        freeLists[c] = nullptr;
+}
+
+// Return the calling thread's pool, created on first use
+inline PoolResource* threadLocalPoolResource() {
+    static thread_local PoolResource pool;
+    return &pool;
+}
+
+/**
+ * Resource forwarding to an upstream resource while counting calls and
+ * bytes. Counters are atomic so one tracker can be shared between threads.
+ */
+class TrackingResource : public MemoryResource {
+private:
+    MemoryResource* upstream;
+    std::atomic<size_t> nalloc;
+    std::atomic<size_t> ndealloc;
+    std::atomic<size_t> allocated;
+    std::atomic<size_t> deallocated;
+    std::atomic<size_t> peak;
+public:
+    explicit TrackingResource(MemoryResource* upstream = newDeleteResource());
+
+    // Number of allocate() calls
+    size_t allocations() const { return nalloc.load(std::memory_order_relaxed); }
+    // Number of deallocate() calls
+    size_t deallocations() const { return ndealloc.load(std::memory_order_relaxed); }
+    // Total bytes requested
+    size_t bytesAllocated() const { return allocated.load(std::memory_order_relaxed); }
+    // Total bytes returned
+    size_t bytesDeallocated() const { return deallocated.load(std::memory_order_relaxed); }
+    // Bytes currently outstanding
+    size_t bytesInUse() const { return bytesAllocated() - bytesDeallocated(); }
+    // Highest value bytesInUse() has reached
+    size_t peakBytes() const { return peak.load(std::memory_order_relaxed); }
+    // Zero all counters
+    void reset();
+protected:
+    void* doAllocate(size_t bytes, size_t align) override;
+    void doDeallocate(void* p, size_t bytes, size_t align) override;
+    bool doCanShrink(size_t oldBytes, size_t newBytes) const override { return upstream->canShrink(oldBytes, newBytes); }
+    void doShrink(void* p, size_t oldBytes, size_t newBytes) override;
+};
+
+inline TrackingResource::TrackingResource(MemoryResource* upstream)
+    : upstream(upstream), nalloc(0), ndealloc(0), allocated(0), deallocated(0), peak(0) {}
+
+inline void* TrackingResource::doAllocate(size_t bytes, size_t align) {
+    void* p = upstream->allocate(bytes, align);
+    nalloc.fetch_add(1, std::memory_order_relaxed);
+    size_t inUse = allocated.fetch_add(bytes, std::memory_order_relaxed) + bytes
+                 - deallocated.load(std::memory_order_relaxed);
+    size_t old = peak.load(std::memory_order_relaxed);
+    while (inUse > old && !peak.compare_exchange_weak(old, inUse, std::memory_order_relaxed)) {}
+    return p;
+}
+
+inline void TrackingResource::doDeallocate(void* p, size_t bytes, size_t align) {
+    upstream->deallocate(p, bytes, align);
+    ndealloc.fetch_add(1, std::memory_order_relaxed);
+    deallocated.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+inline void TrackingResource::doShrink(void* p, size_t oldBytes, size_t newBytes) {
+    upstream->shrink(p, oldBytes, newBytes);
+    deallocated.fetch_add(oldBytes - newBytes, std::memory_order_relaxed);
+}
+
+inline void TrackingResource::reset() {
+    nalloc = 0;
+    ndealloc = 0;
+    allocated = 0;
+    deallocated = 0;
+    peak = 0;
+}
+
+/**
+ * Standard Allocator drawing from a MemoryResource, analogous to
+ * std::pmr::polymorphic_allocator. The containers accept it as their
+ * allocator template argument:
+ *
+ *     MonotonicArena arena;
+ *     Vector<int, PolymorphicAllocator<int>> v(16, &arena);
+ */
+template<typename T>
+class PolymorphicAllocator {
+private:
+    MemoryResource* res;
+
+    template<typename U>
+    friend class PolymorphicAllocator;
+public:
+    using value_type = T;
+
+    PolymorphicAllocator() noexcept : res(defaultResource()) {}
+    PolymorphicAllocator(MemoryResource* res) noexcept : res(res) { assert(res != nullptr); }
+    template<typename U>
+    PolymorphicAllocator(const PolymorphicAllocator<U>& that) noexcept : res(that.res) {}
+
+    T* allocate(size_t count);
+    void deallocate(T* p, size_t count) { res->deallocate(p, count * sizeof(T), alignof(T)); }
+    bool canShrink(size_t oldCount, size_t newCount) const { return res->canShrink(oldCount * sizeof(T), newCount * sizeof(T)); }
+    void shrink(T* p, size_t oldCount, size_t newCount) { res->shrink(p, oldCount * sizeof(T), newCount * sizeof(T)); }
+    MemoryResource* resource() const { return res; }
+};
+
+template<typename T>
+T* PolymorphicAllocator<T>::allocate(size_t count) {
+    if (count > std::numeric_limits<size_t>::max() / sizeof(T))
+        CPPLIB_THROW_BAD_ALLOC();
+    return static_cast<T*>(res->allocate(count * sizeof(T), alignof(T)));
+}
+
+template<typename T, typename U>
+bool operator==(const PolymorphicAllocator<T>& lhs, const PolymorphicAllocator<U>& rhs) {
+    return lhs.resource() == rhs.resource() || lhs.resource()->isEqual(*rhs.resource());
+}
+
+template<typename T, typename U>
+bool operator!=(const PolymorphicAllocator<T>& lhs, const PolymorphicAllocator<U>& rhs) {
+    return !(lhs == rhs);
+}
+
+/**
+ * In-place shrinking for container allocators. Allocators providing
+ * canShrink()/shrink() members (PolymorphicAllocator) are asked first;
+ * any other allocator reports false and the container reallocates.
+ */
+template<typename Alloc>
+auto allocCanShrink(const Alloc& alloc, size_t oldCount, size_t newCount, int)
+    -> decltype(alloc.canShrink(oldCount, newCount)) {
+    return alloc.canShrink(oldCount, newCount);
+}
+
+template<typename Alloc>
+bool allocCanShrink(const Alloc&, size_t, size_t, long) {
+    return false;
+}
+
+template<typename Alloc>
+bool allocCanShrink(const Alloc& alloc, size_t oldCount, size_t newCount) {
+    return allocCanShrink(alloc, oldCount, newCount, 0);
+}
+
+template<typename Alloc, typename T>
+auto allocShrink(Alloc& alloc, T* p, size_t oldCount, size_t newCount, int)
+    -> decltype(alloc.shrink(p, oldCount, newCount)) {
+    alloc.shrink(p, oldCount, newCount);
+}
+
+template<typename Alloc, typename T>
+void allocShrink(Alloc&, T*, size_t, size_t, long) {}
+
+template<typename Alloc, typename T>
+void allocShrink(Alloc& alloc, T* p, size_t oldCount, size_t newCount) {
+    allocShrink(alloc, p, oldCount, newCount, 0);
+}
+
+/**
+ * Storage for a container's allocator. A stateless allocator such as
+ * std::allocator becomes an empty base and takes no space in the container;
+ * any other allocator is held as a member. Containers inherit privately and
+ * reach the allocator through alloc().
+ */
+template<typename Alloc, bool = std::is_empty<Alloc>::value && !__is_final(Alloc)>
+class AllocHolder : private Alloc {
+protected:
+    explicit AllocHolder(const Alloc& alloc) : Alloc(alloc) {}
+
+    Alloc& alloc() { return *this; }
+    const Alloc& alloc() const { return *this; }
+};
+
+template<typename Alloc>
+class AllocHolder<Alloc, false> {
+private:
+    Alloc a;
+protected:
+    explicit AllocHolder(const Alloc& alloc) : a(alloc) {}
+
+    Alloc& alloc() { return a; }
+    const Alloc& alloc() const { return a; }
+};
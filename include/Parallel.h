@@ -0,0 +1,444 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Config.h"
+#include "Vector.h"
+
+/**
+ * Parallel algorithms over random access ranges and Vectors:
+ * parallel_for_each, parallel_transform, parallel_reduce and
+ * parallel_inclusive_scan / parallel_exclusive_scan, run on a ThreadPool.
+ *
+ * A ParallelPolicy picks the pool, the grain and the schedule. STATIC
+ * gives each thread one contiguous slice, which suits uniform work; the
+ * slices are cut by index alone, with no regard for NUMA placement.
+ * DYNAMIC cuts the range into grain-sized chunks that threads claim as
+ * they go, which suits uneven work. Either way the chunks are fixed before
+ * running, and partial results are combined in chunk order, so reduce and
+ * the scans need an associative op but not a commutative one, and give the
+ * same result on every run.
+ *
+ * The scans make two passes: the first reduces each chunk, a serial scan
+ * over the chunk totals gives each chunk its starting value, and the second
+ * scans each chunk from there. They may write over their input.
+ */
+
+/**
+ * Fixed set of worker threads for fork-join jobs. run() calls a function
+ * once on each of size() threads, the caller being thread 0, and waits for
+ * all of them. A run() from inside a job runs the calls one after another
+ * on the current thread.
+ */
+class ThreadPool
+{
+private:
+    std::vector<std::thread> workers;
+    std::mutex runMtx; // Held for the whole of a run()
+    std::mutex mtx;
+    std::condition_variable start;
+    std::condition_variable finish;
+    const std::function<void(int)>* job;
+    uint64_t generation;
+    int pending;
+    bool stop;
+    std::exception_ptr error;
+
+    static bool& inside()
+    {
+        static thread_local bool flag = false;
+        return flag;
+    }
+    void call(int t);
+    void work(int t);
+public:
+    explicit ThreadPool(int threads = std::thread::hardware_concurrency());
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    // Return the number of threads, counting the caller of run()
+    int size() const { return static_cast<int>(workers.size()) + 1; }
+    // Call f(t) for every t in [0, size()) in parallel; rethrow the first exception thrown
+    void run(const std::function<void(int)>& f);
+};
+
+// Pool with one thread per hardware thread, used when a policy names none
+inline ThreadPool& defaultThreadPool()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+enum class Schedule
+{
+    STATIC,
+    DYNAMIC
+};
+
+/**
+ * How to split a parallel algorithm. grain is the smallest slice worth a
+ * thread under STATIC and the chunk size under DYNAMIC; 0 picks one from
+ * the range size and the pool size.
+ */
+struct ParallelPolicy
+{
+    Schedule schedule;
+    size_t grain;
+    ThreadPool* pool;
+
+    explicit ParallelPolicy(Schedule schedule = Schedule::STATIC, size_t grain = 0, ThreadPool* pool = nullptr)
+        : schedule(schedule), grain(grain), pool(pool) {}
+};
+
+/**
+ * A range of n elements cut into chunks as a policy says.
+ */
+class ParallelChunks
+{
+private:
+    ThreadPool& pool;
+    bool dynamic;
+    size_t n;
+    size_t chunks;
+    size_t grain;
+public:
+    ParallelChunks(size_t n, const ParallelPolicy& policy);
+
+    // Return the number of chunks
+    size_t count() const { return chunks; }
+    // Return the first index of chunk c
+    size_t begin(size_t c) const { return dynamic ? c * grain : c * n / chunks; }
+    // Return one past the last index of chunk c
+    size_t end(size_t c) const { return dynamic ? std::min(n, (c + 1) * grain) : (c + 1) * n / chunks; }
+    // Call f(c) for every chunk c, in parallel
+    template<typename F>
+    void run(F f) const;
+};
+
+inline ThreadPool::ThreadPool(int threads)
+    : job(nullptr), generation(0), pending(0), stop(false)
+{
+    for (int t = 1; t < threads; ++t)
+        workers.emplace_back([this, t]() { work(t); });
+}
+
+inline ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = true;
+    }
+    start.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+inline void ThreadPool::call(int t)
+{
+    CPPLIB_TRY
+    {
+        (*job)(t);
+    }
+    CPPLIB_CATCH_ALL
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!error)
+            error = std::current_exception();
+    }
+}
+
+inline void ThreadPool::work(int t)
+{
+    inside() = true;
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mtx);
+    for (;;)
+    {
+        start.wait(lock, [&]() { return stop || generation != seen; });
+        if (stop)
+            return;
+        seen = generation;
+        lock.unlock();
+        call(t);
+        lock.lock();
+        if (--pending == 0)
+            finish.notify_one();
+    }
+}
+
+inline void ThreadPool::run(const std::function<void(int)>& f)
+{
+    if (inside() || workers.empty())
+    {
+        for (int t = 0; t < size(); ++t)
+            f(t);
+        return;
+    }
+    std::lock_guard<std::mutex> serial(runMtx);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        job = &f;
+        error = nullptr;
+        pending = static_cast<int>(workers.size());
+        generation++;
+    }
+    start.notify_all();
+    inside() = true;
+    call(0);
+    inside() = false;
+    std::unique_lock<std::mutex> lock(mtx);
+    finish.wait(lock, [&]() { return pending == 0; });
+    job = nullptr;
+    if (error)
+        std::rethrow_exception(error);
+}
+
+inline ParallelChunks::ParallelChunks(size_t n, const ParallelPolicy& policy)
+    : pool(policy.pool != nullptr ? *policy.pool : defaultThreadPool()),
+      dynamic(policy.schedule == Schedule::DYNAMIC), n(n)
+{
+    size_t threads = static_cast<size_t>(pool.size());
+    if (dynamic)
+    {
+        // Enough chunks to even out uneven work, few enough to keep claiming cheap
+        grain = policy.grain > 0 ? policy.grain : std::max<size_t>(n / (threads * 16), 1024);
+        chunks = (n + grain - 1) / grain;
+    }
+    else
+    {
+        grain = policy.grain > 0 ? policy.grain : 32768;
+        chunks = std::min(threads, std::max<size_t>(n / grain, 1));
+    }
+    if (n == 0)
+        chunks = 0;
+}
+
+template<typename F>
+void ParallelChunks::run(F f) const
+{
+    if (chunks <= 1)
+    {
+        if (chunks == 1)
+            f(size_t(0));
+        return;
+    }
+    if (dynamic)
+    {
+        std::atomic<size_t> next(0);
+        pool.run([&](int) {
+            for (size_t c; (c = next.fetch_add(1, std::memory_order_relaxed)) < chunks;)
+                f(c);
+        });
+    }
+    else
+    {
+        pool.run([&](int t) {
+            if (static_cast<size_t>(t) < chunks)
+                f(static_cast<size_t>(t));
+        });
+    }
+}
+
+/**
+ * Call f(x) for every element x of [first, last).
+ */
+template<typename RandomIt, typename F>
+void parallel_for_each(RandomIt first, RandomIt last, F f, const ParallelPolicy& policy = ParallelPolicy())
+{
+    ParallelChunks chunks(static_cast<size_t>(last - first), policy);
+    chunks.run([&](size_t c) {
+        RandomIt end = first + chunks.end(c);
+        for (RandomIt i = first + chunks.begin(c); i != end; ++i)
+            f(*i);
+    });
+}
+
+/**
+ * Write op(x) for every element x of [first, last) to the range starting at
+ * out, which may be first.
+ */
+template<typename RandomIt, typename OutIt, typename Op>
+void parallel_transform(RandomIt first, RandomIt last, OutIt out, Op op,
+                        const ParallelPolicy& policy = ParallelPolicy())
+{
+    ParallelChunks chunks(static_cast<size_t>(last - first), policy);
+    chunks.run([&](size_t c) {
+        size_t end = chunks.end(c);
+        for (size_t i = chunks.begin(c); i != end; ++i)
+            out[i] = op(first[i]);
+    });
+}
+
+/**
+ * Return init op x0 op x1 ... for the elements of [first, last).
+ */
+template<typename RandomIt, typename T, typename Op>
+T parallel_reduce(RandomIt first, RandomIt last, T init, Op op, const ParallelPolicy& policy = ParallelPolicy())
+{
+    ParallelChunks chunks(static_cast<size_t>(last - first), policy);
+    std::vector<T> partial(chunks.count());
+    chunks.run([&](size_t c) {
+        size_t i = chunks.begin(c), end = chunks.end(c);
+        T acc = first[i];
+        for (++i; i != end; ++i)
+            acc = op(acc, first[i]);
+        partial[c] = acc;
+    });
+    for (const T& x : partial)
+        init = op(init, x);
+    return init;
+}
+
+template<typename RandomIt, typename T>
+T parallel_reduce(RandomIt first, RandomIt last, T init)
+{
+    return parallel_reduce(first, last, init, std::plus<T>());
+}
+
+/**
+ * Write x0, x0 op x1, x0 op x1 op x2, ... to the range starting at out,
+ * which may be first.
+ */
+template<typename RandomIt, typename OutIt, typename Op>
+void parallel_inclusive_scan(RandomIt first, RandomIt last, OutIt out, Op op,
+                             const ParallelPolicy& policy = ParallelPolicy())
+{
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    ParallelChunks chunks(static_cast<size_t>(last - first), policy);
+    std::vector<T> offset(chunks.count());
+    chunks.run([&](size_t c) {
+        if (c + 1 == chunks.count())
+            return;
+        size_t i = chunks.begin(c), end = chunks.end(c);
+        T acc = first[i];
+        for (++i; i != end; ++i)
+            acc = op(acc, first[i]);
+        offset[c] = acc;
+    });
+    // offset[c] becomes the total of chunks before c; chunk 0 has none
+    for (size_t c = chunks.count(); c-- > 1;)
+        offset[c] = offset[c - 1];
+    for (size_t c = 2; c < chunks.count(); ++c)
+        offset[c] = op(offset[c - 1], offset[c]);
+    chunks.run([&](size_t c) {
+        size_t i = chunks.begin(c), end = chunks.end(c);
+        T acc = c > 0 ? op(offset[c], first[i]) : T(first[i]);
+        out[i] = acc;
+        for (++i; i != end; ++i)
+            out[i] = acc = op(acc, first[i]);
+    });
+}
+
+template<typename RandomIt, typename OutIt>
+void parallel_inclusive_scan(RandomIt first, RandomIt last, OutIt out)
+{
+    parallel_inclusive_scan(first, last, out, std::plus<typename std::iterator_traits<RandomIt>::value_type>());
+}
+
+/**
+ * Write init, init op x0, init op x0 op x1, ... to the range starting at
+ * out, which may be first; the last element is left out of every sum.
+ */
+template<typename RandomIt, typename OutIt, typename T, typename Op>
+void parallel_exclusive_scan(RandomIt first, RandomIt last, OutIt out, T init, Op op,
+                             const ParallelPolicy& policy = ParallelPolicy())
+{
+    ParallelChunks chunks(static_cast<size_t>(last - first), policy);
+    std::vector<T> offset(chunks.count());
+    chunks.run([&](size_t c) {
+        if (c + 1 == chunks.count())
+            return;
+        size_t i = chunks.begin(c), end = chunks.end(c);
+        T acc = first[i];
+        for (++i; i != end; ++i)
+            acc = op(acc, first[i]);
+        offset[c] = acc;
+    });
+    // offset[c] becomes init op the total of chunks before c
+    for (size_t c = chunks.count(); c-- > 1;)
+        offset[c] = offset[c - 1];
+    if (chunks.count() > 0)
+        offset[0] = init;
+    for (size_t c = 1; c < chunks.count(); ++c)
+        offset[c] = op(offset[c - 1], offset[c]);
+    chunks.run([&](size_t c) {
+        size_t end = chunks.end(c);
+        T acc = offset[c];
+        for (size_t i = chunks.begin(c); i != end; ++i)
+        {
+            T x = first[i];
+            out[i] = acc;
+            acc = op(acc, x);
+        }
+    });
+}
+
+template<typename RandomIt, typename OutIt, typename T>
+void parallel_exclusive_scan(RandomIt first, RandomIt last, OutIt out, T init)
+{
+    parallel_exclusive_scan(first, last, out, init, std::plus<T>());
+}
+
+/**
+ * Vector overloads: for_each and transform work on the elements in place,
+ * the scans replace them with their prefix sums.
+ */
+
+template<typename E, typename Alloc, typename F>
+void parallel_for_each(Vector<E, Alloc>& v, F f, const ParallelPolicy& policy = ParallelPolicy())
+{
+    parallel_for_each(v.begin(), v.end(), f, policy);
+}
+
+template<typename E, typename Alloc, typename Op>
+void parallel_transform(Vector<E, Alloc>& v, Op op, const ParallelPolicy& policy = ParallelPolicy())
+{
+    parallel_transform(v.begin(), v.end(), v.begin(), op, policy);
+}
+
+template<typename E, typename Alloc, typename T, typename Op>
+T parallel_reduce(const Vector<E, Alloc>& v, T init, Op op, const ParallelPolicy& policy = ParallelPolicy())
+{
+    return parallel_reduce(v.begin(), v.end(), init, op, policy);
+}
+
+template<typename E, typename Alloc, typename T>
+T parallel_reduce(const Vector<E, Alloc>& v, T init)
+{
+    return parallel_reduce(v.begin(), v.end(), init, std::plus<T>());
+}
+
+template<typename E, typename Alloc, typename Op>
+void parallel_inclusive_scan(Vector<E, Alloc>& v, Op op, const ParallelPolicy& policy = ParallelPolicy())
+{
+    parallel_inclusive_scan(v.begin(), v.end(), v.begin(), op, policy);
+}
+
+template<typename E, typename Alloc>
+void parallel_inclusive_scan(Vector<E, Alloc>& v)
+{
+    parallel_inclusive_scan(v.begin(), v.end(), v.begin(), std::plus<E>());
+}
+
+template<typename E, typename Alloc, typename Op>
+void parallel_exclusive_scan(Vector<E, Alloc>& v, typename Vector<E, Alloc>::value_type init, Op op,
+                             const ParallelPolicy& policy = ParallelPolicy())
+{
+    parallel_exclusive_scan(v.begin(), v.end(), v.begin(), init, op, policy);
+}
+
+template<typename E, typename Alloc>
+void parallel_exclusive_scan(Vector<E, Alloc>& v, typename Vector<E, Alloc>::value_type init)
+{
+    parallel_exclusive_scan(v.begin(), v.end(), v.begin(), init, std::plus<E>());
+}
@@ -0,0 +1,223 @@
+/*******************************************************************************
+ * PerfCounters.h
+ *
+ * Hardware and software event counters for the timing harness.
+ ******************************************************************************/
+
+#pragma once
+#include <cstdint>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum PerfEvent
+{
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_PAGE_FAULTS,
+    PERF_EVENT_COUNT
+};
+
+/**
+ * Counts of each event over a measured region; has[e] is false for events
+ * that could not be counted.
+ */
+struct PerfReading
+{
+    double value[PERF_EVENT_COUNT];
+    bool has[PERF_EVENT_COUNT];
+
+    PerfReading()
+    {
+        for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+        {
+            value[e] = 0;
+            has[e] = false;
+        }
+    }
+};
+
+/**
+ * PerfCounters, used to count cycles, instructions, cache misses, branch
+ * misses and page faults in user space over a region of the calling thread,
+ * and of threads it starts and joins within the region, through Linux
+ * perf_event_open. The events are opened as one group, so the
+ * kernel schedules them together; an event it cannot schedule all the time
+ * is scaled up from the share of time it ran.
+ *
+ * Counters may be missing: no PMU in a virtual machine, a restrictive
+ * /proc/sys/kernel/perf_event_paranoid, a seccomp filter or another OS.
+ * Each event that fails to open is left out of readings, and if none opens
+ * available() is false and stop() returns an empty reading, so callers fall
+ * back to time alone.
+ */
+class PerfCounters
+{
+private:
+    int fd[PERF_EVENT_COUNT];
+
+    int open(PerfEvent e, int group);
+public:
+    PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    ~PerfCounters();
+
+    // Check if any event can be counted
+    bool available() const;
+    // Check if event e can be counted
+    bool available(PerfEvent e) const { return fd[e] >= 0; }
+    // Reset the counts and start counting
+    void start();
+    // Stop counting and return the counts since start()
+    PerfReading stop();
+    // Return a short name of event e for column headers
+    static const char* name(PerfEvent e);
+};
+
+/**
+ * Count over the lifetime of a scope:
+ *
+ *   PerfReading r;
+ *   {
+ *       PerfScope scope(counters, r);
+ *       ...
+ *   }
+ */
+class PerfScope
+{
+private:
+    PerfCounters& counters;
+    PerfReading& reading;
+public:
+    PerfScope(PerfCounters& counters, PerfReading& reading) : counters(counters), reading(reading) { counters.start(); }
+    ~PerfScope() { reading = counters.stop(); }
+};
+
+inline PerfCounters::PerfCounters()
+{
+    int group = -1;
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+    {
+        fd[e] = open(static_cast<PerfEvent>(e), group);
+        // An event the group cannot take is counted on its own
+        if (fd[e] < 0 && group >= 0)
+            fd[e] = open(static_cast<PerfEvent>(e), -1);
+        if (group < 0)
+            group = fd[e];
+    }
+}
+
+inline PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+    {
+        if (fd[e] >= 0)
+            close(fd[e]);
+    }
+#endif
+}
+
+/**
+ * @param e: Event to open
+ * @param group: File descriptor of the group leader, or -1 to lead a new group
+ * @return File descriptor of the counter, or -1 if it cannot be opened
+ */
+inline int PerfCounters::open(PerfEvent e, int group)
+{
+#ifdef __linux__
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    switch (e)
+    {
+    case PERF_CYCLES:
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case PERF_INSTRUCTIONS:
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case PERF_CACHE_MISSES:
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+    case PERF_BRANCH_MISSES:
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    default:
+        attr.type = PERF_TYPE_SOFTWARE;
+        attr.config = PERF_COUNT_SW_PAGE_FAULTS;
+        break;
+    }
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    long fd = syscall(__NR_perf_event_open, &attr, 0, -1, group, 0);
+    return fd >= 0 ? static_cast<int>(fd) : -1;
+#else
+    (void)e;
+    (void)group;
+    return -1;
+#endif
+}
+
+inline bool PerfCounters::available() const
+{
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+    {
+        if (fd[e] >= 0)
+            return true;
+    }
+    return false;
+}
+
+inline void PerfCounters::start()
+{
+#ifdef __linux__
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+    {
+        if (fd[e] >= 0)
+        {
+            ioctl(fd[e], PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd[e], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+inline PerfReading PerfCounters::stop()
+{
+    PerfReading r;
+#ifdef __linux__
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+    {
+        if (fd[e] >= 0)
+            ioctl(fd[e], PERF_EVENT_IOC_DISABLE, 0);
+    }
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+    {
+        // Count, time enabled, time running
+        uint64_t buf[3];
+        if (fd[e] < 0 || read(fd[e], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf)) || buf[2] == 0)
+            continue;
+        r.value[e] = buf[2] < buf[1] ? static_cast<double>(buf[0]) * buf[1] / buf[2] : static_cast<double>(buf[0]);
+        r.has[e] = true;
+    }
+#endif
+    return r;
+}
+
+inline const char* PerfCounters::name(PerfEvent e)
+{
+    static const char* const NAMES[PERF_EVENT_COUNT] = { "cycles", "instrs", "cmiss", "bmiss", "faults" };
+    return NAMES[e];
+}
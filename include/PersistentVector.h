@@ -0,0 +1,656 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include "Config.h"
+#include "MemoryResource.h"
+
+/**
+* Persistent vector: an immutable sequence whose copies share structure.
+* Elements live in a 32-way radix tree of leaves of 32 elements, with the
+* last, partial leaf kept aside as a tail so insert_back() rarely touches
+* the tree. Copying is O(1); set(), insert_back() and remove_back() return
+* a new vector that copies only the O(log32 n) nodes on the changed path
+* and shares the rest with the original.
+*
+* Nodes are reference counted with atomic counts, so vectors sharing nodes
+* may be copied, read and destroyed on different threads; a single vector
+* object, like a std::shared_ptr, must not be assigned on one thread while
+* used on another. Nodes come from a MemoryResource, which must then be
+* thread-safe too.
+*
+* transient() returns a Transient: a builder that edits in place every node
+* it holds the only reference to, so a batch of edits copies each shared
+* node at most once. persistent() turns it back into a vector.
+ */
+template<typename E>
+class PersistentVector
+{
+    static const int BITS = 5;
+    static const int WIDTH = 1 << BITS;
+    static const int MASK = WIDTH - 1;
+
+    struct Node
+    {
+        std::atomic<int> refs;
+        Node() : refs(1) {}
+    };
+    // Interior node; children are Branches above level BITS, Leaves at it
+    struct Branch : Node
+    {
+        Node* child[WIDTH];
+        Branch() : child() {}
+    };
+    struct Leaf : Node
+    {
+        int n; // Number of constructed elements
+        alignas(E) unsigned char raw[WIDTH * sizeof(E)];
+        Leaf() : n(0) {}
+        E* elems() { return reinterpret_cast<E*>(raw); }
+        const E* elems() const { return reinterpret_cast<const E*>(raw); }
+    };
+public:
+    class Transient;
+    class const_iterator;
+    using iterator = const_iterator;
+    using value_type = E;
+private:
+    MemoryResource* resource;
+    int n; // Vector size
+    int shift; // Level of the root: BITS for a root over leaves
+    Branch* root; // Tree holding elements [0, tailOffset()), or nullptr
+    Leaf* tail; // Elements [tailOffset(), n), or nullptr if empty
+
+    int tailOffset() const { return n < WIDTH ? 0 : ((n - 1) >> BITS) << BITS; }
+    const Leaf* leafFor(int i) const;
+
+    static void retain(Node* x) { if (x != nullptr) x->refs.fetch_add(1, std::memory_order_relaxed); }
+    void release(Node* x, int level);
+    template<typename T>
+    T* make();
+    // Take over one reference to x and return a node only this vector refers to
+    Branch* own(Branch* x, int level);
+    Leaf* own(Leaf* x);
+    Branch* push_tail(int level, Branch* x, Leaf* leaf);
+    Branch* pop_tail(int level, Branch* x);
+
+    // In-place edits; shared nodes on the way are copied first
+    void assign(int i, E elem);
+    void push(E elem);
+    void pop();
+public:
+    explicit PersistentVector(MemoryResource* resource = newDeleteResource());
+    template<typename InputIt>
+    PersistentVector(InputIt first, InputIt last, MemoryResource* resource = newDeleteResource());
+    PersistentVector(const PersistentVector& that);
+    PersistentVector(PersistentVector&& that) noexcept;
+    ~PersistentVector();
+
+    // Return the number of elements in the PersistentVector
+    int size() const { return n; }
+    // Check if the PersistentVector is empty
+    bool empty() const { return n == 0; }
+    // Return a copy with the element at the specified position replaced
+    PersistentVector set(int i, E elem) const;
+    // Return a copy with an element added to the end
+    PersistentVector insert_back(E elem) const;
+    // Return a copy without the last element
+    PersistentVector remove_back() const;
+    // Return a builder starting from this PersistentVector
+    Transient transient() const { return Transient(*this); }
+    // Return a const reference to the element at the specified position, with bounds checking
+    const E& at(int i) const;
+    // Return a const reference to the first element of the PersistentVector
+    const E& front() const;
+    // Return a const reference to the last element of the PersistentVector
+    const E& back() const;
+    // Swap two PersistentVector objects
+    void swap(PersistentVector& that);
+
+    // [] operator overloading
+    const E& operator[](int i) const { return leafFor(i)->elems()[i & MASK]; }
+    PersistentVector& operator=(PersistentVector that);
+    template <typename T>
+    friend bool operator==(const PersistentVector<T>& lhs, const PersistentVector<T>& rhs);
+    template <typename T>
+    friend bool operator!=(const PersistentVector<T>& lhs, const PersistentVector<T>& rhs);
+    template<typename T>
+    friend std::ostream& operator<<(std::ostream& os, const PersistentVector<T>& vector);
+
+    // Random access iterator walking one leaf at a time
+    class const_iterator
+    {
+    private:
+        const PersistentVector* vector;
+        int i;
+        mutable const E* block; // Elements of the leaf holding i, or nullptr if not looked up yet
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = E;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const E*;
+        using reference = const E&;
+
+        const_iterator() : vector(nullptr), i(0), block(nullptr) {}
+        const_iterator(const PersistentVector* vector, int i) : vector(vector), i(i), block(nullptr) {}
+
+        const E& operator*() const
+        {
+            if (block == nullptr)
+                block = vector->leafFor(i)->elems();
+            return block[i & MASK];
+        }
+        const E* operator->() const { return &**this; }
+        const E& operator[](difference_type k) const { return (*vector)[i + static_cast<int>(k)]; }
+        const_iterator& operator++()
+        {
+            if ((++i & MASK) == 0)
+                block = nullptr;
+            return *this;
+        }
+        const_iterator operator++(int) { const_iterator tmp(*this); operator++(); return tmp; }
+        const_iterator& operator--()
+        {
+            if ((i-- & MASK) == 0)
+                block = nullptr;
+            return *this;
+        }
+        const_iterator operator--(int) { const_iterator tmp(*this); operator--(); return tmp; }
+        const_iterator& operator+=(difference_type k)
+        {
+            if (((i + k) >> BITS) != (i >> BITS))
+                block = nullptr;
+            i += static_cast<int>(k);
+            return *this;
+        }
+        const_iterator& operator-=(difference_type k) { return *this += -k; }
+        const_iterator operator+(difference_type k) const { const_iterator tmp(*this); return tmp += k; }
+        const_iterator operator-(difference_type k) const { const_iterator tmp(*this); return tmp -= k; }
+        difference_type operator-(const const_iterator& that) const { return i - that.i; }
+        bool operator==(const const_iterator& that) const { return i == that.i && vector == that.vector; }
+        bool operator!=(const const_iterator& that) const { return !(*this == that); }
+        bool operator<(const const_iterator& that) const { return i < that.i; }
+        bool operator>(const const_iterator& that) const { return i > that.i; }
+        bool operator<=(const const_iterator& that) const { return i <= that.i; }
+        bool operator>=(const const_iterator& that) const { return i >= that.i; }
+    };
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, n); }
+
+    /**
+    * Mutable builder over the nodes of a PersistentVector. Edits copy a
+    * node only while another vector still shares it, then change it in
+    * place, so building or patching a vector in a loop costs about what
+    * the same loop costs on a Vector.
+     */
+    class Transient
+    {
+    private:
+        PersistentVector v;
+    public:
+        explicit Transient(const PersistentVector& v) : v(v) {}
+
+        int size() const { return v.size(); }
+        bool empty() const { return v.empty(); }
+        const E& operator[](int i) const { return v[i]; }
+        const E& at(int i) const { return v.at(i); }
+        // Replace the element at the specified position
+        Transient& set(int i, E elem);
+        // Add an element to the end
+        Transient& insert_back(E elem) { v.push(std::move(elem)); return *this; }
+        // Remove the last element
+        Transient& remove_back();
+        // Return the result and leave the builder empty
+        PersistentVector persistent() { PersistentVector result(v.resource); result.swap(v); return result; }
+    };
+};
+
+/**
+ * @param resource: Memory resource for the nodes
+ */
+template<typename E>
+PersistentVector<E>::PersistentVector(MemoryResource* resource)
+    : resource(resource), n(0), shift(BITS), root(nullptr), tail(nullptr)
+{
+}
+
+/**
+ * @param first: Beginning of the range to copy
+ * @param last: End of the range to copy
+ * @param resource: Memory resource for the nodes
+ */
+template<typename E>
+template<typename InputIt>
+PersistentVector<E>::PersistentVector(InputIt first, InputIt last, MemoryResource* resource)
+    : PersistentVector(resource)
+{
+    for (; first != last; ++first)
+        push(*first);
+}
+
+/**
+ * O(1): the copy shares every node with that.
+ *
+ * @param that: PersistentVector to copy
+ */
+template<typename E>
+PersistentVector<E>::PersistentVector(const PersistentVector& that)
+    : resource(that.resource), n(that.n), shift(that.shift), root(that.root), tail(that.tail)
+{
+    retain(root);
+    retain(tail);
+}
+
+template<typename E>
+PersistentVector<E>::PersistentVector(PersistentVector&& that) noexcept
+    : resource(that.resource), n(that.n), shift(that.shift), root(that.root), tail(that.tail)
+{
+    that.n = 0;
+    that.shift = BITS;
+    that.root = nullptr;
+    that.tail = nullptr;
+}
+
+template<typename E>
+PersistentVector<E>::~PersistentVector()
+{
+    release(root, shift);
+    release(tail, 0);
+}
+
+template<typename E>
+template<typename T>
+T* PersistentVector<E>::make()
+{
+    return new (resource->allocate(sizeof(T), alignof(T))) T();
+}
+
+/**
+ * Drop one reference to x, destroying it and releasing its children when
+ * it was the last.
+ *
+ * @param x: Node, or nullptr
+ * @param level: Level of x: 0 for a Leaf
+ */
+template<typename E>
+void PersistentVector<E>::release(Node* x, int level)
+{
+    if (x == nullptr || x->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+    if (level == 0)
+    {
+        Leaf* leaf = static_cast<Leaf*>(x);
+        for (int i = 0; i < leaf->n; ++i)
+            leaf->elems()[i].~E();
+        leaf->~Leaf();
+        resource->deallocate(leaf, sizeof(Leaf), alignof(Leaf));
+    }
+    else
+    {
+        Branch* branch = static_cast<Branch*>(x);
+        for (int i = 0; i < WIDTH; ++i)
+            release(branch->child[i], level - BITS);
+        branch->~Branch();
+        resource->deallocate(branch, sizeof(Branch), alignof(Branch));
+    }
+}
+
+/**
+ * @param x: Branch this vector holds one reference to, or nullptr for a new one
+ * @param level: Level of x
+ * @return x if no one else refers to it, or a copy sharing its children
+ */
+template<typename E>
+typename PersistentVector<E>::Branch* PersistentVector<E>::own(Branch* x, int level)
+{
+    if (x != nullptr && x->refs.load(std::memory_order_acquire) == 1)
+        return x;
+    Branch* copy = make<Branch>();
+    if (x != nullptr)
+    {
+        for (int i = 0; i < WIDTH; ++i)
+        {
+            copy->child[i] = x->child[i];
+            retain(copy->child[i]);
+        }
+        release(x, level);
+    }
+    return copy;
+}
+
+/**
+ * @param x: Leaf this vector holds one reference to, or nullptr for a new one
+ * @return x if no one else refers to it, or a copy of its elements
+ */
+template<typename E>
+typename PersistentVector<E>::Leaf* PersistentVector<E>::own(Leaf* x)
+{
+    if (x != nullptr && x->refs.load(std::memory_order_acquire) == 1)
+        return x;
+    Leaf* copy = make<Leaf>();
+    if (x != nullptr)
+    {
+        CPPLIB_TRY
+        {
+            for (; copy->n < x->n; ++copy->n)
+                new (copy->elems() + copy->n) E(x->elems()[copy->n]);
+        }
+        CPPLIB_CATCH_ALL
+        {
+            release(copy, 0);
+            CPPLIB_RETHROW;
+        }
+        release(x, 0);
+    }
+    return copy;
+}
+
+/**
+ * @param i: Index of an element, 0 <= i < size()
+ * @return Leaf holding element i
+ */
+template<typename E>
+const typename PersistentVector<E>::Leaf* PersistentVector<E>::leafFor(int i) const
+{
+    if (i >= tailOffset())
+        return tail;
+    const Node* x = root;
+    for (int level = shift; level > 0; level -= BITS)
+        x = static_cast<const Branch*>(x)->child[(i >> level) & MASK];
+    return static_cast<const Leaf*>(x);
+}
+
+/**
+ * Hang a full leaf, holding elements [n - WIDTH, n), under x.
+ *
+ * @param level: Level of x
+ * @param x: Branch, consumed, or nullptr
+ * @return x or its copy, with leaf under it
+ */
+template<typename E>
+typename PersistentVector<E>::Branch* PersistentVector<E>::push_tail(int level, Branch* x, Leaf* leaf)
+{
+    Branch* b = own(x, level);
+    int k = ((n - 1) >> level) & MASK;
+    if (level == BITS)
+        b->child[k] = leaf;
+    else
+        b->child[k] = push_tail(level - BITS, static_cast<Branch*>(b->child[k]), leaf);
+    return b;
+}
+
+/**
+ * Detach the last leaf, holding elements [n - 1 - ..., n - 1), from x.
+ *
+ * @param level: Level of x
+ * @param x: Branch, consumed
+ * @return x or its copy without the leaf, or nullptr if nothing is left under it
+ */
+template<typename E>
+typename PersistentVector<E>::Branch* PersistentVector<E>::pop_tail(int level, Branch* x)
+{
+    Branch* b = own(x, level);
+    int k = ((n - 2) >> level) & MASK;
+    if (level == BITS)
+        release(b->child[k], 0);
+    else
+        b->child[k] = pop_tail(level - BITS, static_cast<Branch*>(b->child[k]));
+    if (level == BITS || b->child[k] == nullptr)
+    {
+        b->child[k] = nullptr;
+        if (k == 0)
+        {
+            release(b, level);
+            return nullptr;
+        }
+    }
+    return b;
+}
+
+template<typename E>
+void PersistentVector<E>::assign(int i, E elem)
+{
+    if (i < 0 || i >= n)
+        CPPLIB_THROW(std::out_of_range, "PersistentVector::set");
+    if (i >= tailOffset())
+    {
+        tail = own(tail);
+        tail->elems()[i & MASK] = std::move(elem);
+        return;
+    }
+    root = own(root, shift);
+    Branch* b = root;
+    for (int level = shift; level > BITS; level -= BITS)
+    {
+        Node*& slot = b->child[(i >> level) & MASK];
+        slot = own(static_cast<Branch*>(slot), level - BITS);
+        b = static_cast<Branch*>(slot);
+    }
+    Node*& slot = b->child[(i >> BITS) & MASK];
+    Leaf* leaf = own(static_cast<Leaf*>(slot));
+    slot = leaf;
+    leaf->elems()[i & MASK] = std::move(elem);
+}
+
+template<typename E>
+void PersistentVector<E>::push(E elem)
+{
+    if (tail == nullptr || tail->n < WIDTH)
+    {
+        tail = own(tail);
+        new (tail->elems() + tail->n) E(std::move(elem));
+        tail->n++;
+        n++;
+        return;
+    }
+    // The new leaf and root are freed on failure until they are linked in
+    Leaf* leaf = make<Leaf>();
+    Branch* up = nullptr;
+    CPPLIB_TRY
+    {
+        new (leaf->elems()) E(std::move(elem));
+        leaf->n = 1;
+        // The tail is full: move it, shared or not, into the tree, growing a level if the tree is full
+        if ((n >> BITS) > (1 << shift))
+        {
+            up = make<Branch>();
+            up->child[0] = root;
+            root = push_tail(shift + BITS, up, tail);
+            shift += BITS;
+        }
+        else
+        {
+            root = push_tail(shift, root, tail);
+        }
+    }
+    CPPLIB_CATCH_ALL
+    {
+        if (up != nullptr)
+        {
+            up->child[0] = nullptr;
+            release(up, shift + BITS);
+        }
+        release(leaf, 0);
+        CPPLIB_RETHROW;
+    }
+    tail = leaf;
+    n++;
+}
+
+template<typename E>
+void PersistentVector<E>::pop()
+{
+    if (empty())
+        CPPLIB_THROW(std::out_of_range, "PersistentVector::remove_back");
+    if (tail->n > 1)
+    {
+        tail = own(tail);
+        tail->elems()[--tail->n].~E();
+    }
+    else if (n == 1)
+    {
+        release(tail, 0);
+        tail = nullptr;
+    }
+    else
+    {
+        // The tail empties: the last leaf of the tree becomes the tail
+        Leaf* last = const_cast<Leaf*>(leafFor(n - 2));
+        retain(last);
+        release(tail, 0);
+        tail = last;
+        root = pop_tail(shift, root);
+        if (root != nullptr && shift > BITS && root->child[1] == nullptr)
+        {
+            Branch* down = static_cast<Branch*>(root->child[0]);
+            retain(down);
+            release(root, shift);
+            root = down;
+            shift -= BITS;
+        }
+        if (root == nullptr)
+            shift = BITS;
+    }
+    n--;
+}
+
+/**
+ * @param i: Index of the element to replace
+ * @param elem: New element
+ * @return A PersistentVector sharing all but the changed path with this one
+ * @throws std::out_of_range if i is not an index of this PersistentVector
+ */
+template<typename E>
+PersistentVector<E> PersistentVector<E>::set(int i, E elem) const
+{
+    PersistentVector result(*this);
+    result.assign(i, std::move(elem));
+    return result;
+}
+
+/**
+ * @param elem: Element to add
+ * @return A PersistentVector sharing all but the changed path with this one
+ */
+template<typename E>
+PersistentVector<E> PersistentVector<E>::insert_back(E elem) const
+{
+    PersistentVector result(*this);
+    result.push(std::move(elem));
+    return result;
+}
+
+/**
+ * @return A PersistentVector sharing all but the changed path with this one
+ * @throws std::out_of_range if the PersistentVector is empty
+ */
+template<typename E>
+PersistentVector<E> PersistentVector<E>::remove_back() const
+{
+    PersistentVector result(*this);
+    result.pop();
+    return result;
+}
+
+/**
+ * @param i: Index of the element
+ * @return A const reference to the element
+ * @throws std::out_of_range if i is not an index of this PersistentVector
+ */
+template<typename E>
+const E& PersistentVector<E>::at(int i) const
+{
+    if (i < 0 || i >= n)
+        CPPLIB_THROW(std::out_of_range, "PersistentVector::at");
+    return (*this)[i];
+}
+
+template<typename E>
+const E& PersistentVector<E>::front() const
+{
+    if (empty())
+        CPPLIB_THROW(std::out_of_range, "PersistentVector::front");
+    return (*this)[0];
+}
+
+template<typename E>
+const E& PersistentVector<E>::back() const
+{
+    if (empty())
+        CPPLIB_THROW(std::out_of_range, "PersistentVector::back");
+    return tail->elems()[tail->n - 1];
+}
+
+template<typename E>
+void PersistentVector<E>::swap(PersistentVector& that)
+{
+    using std::swap;
+    swap(resource, that.resource);
+    swap(n, that.n);
+    swap(shift, that.shift);
+    swap(root, that.root);
+    swap(tail, that.tail);
+}
+
+template<typename E>
+PersistentVector<E>& PersistentVector<E>::operator=(PersistentVector that)
+{
+    swap(that);
+    return *this;
+}
+
+template<typename E>
+typename PersistentVector<E>::Transient& PersistentVector<E>::Transient::set(int i, E elem)
+{
+    v.assign(i, std::move(elem));
+    return *this;
+}
+
+template<typename E>
+typename PersistentVector<E>::Transient& PersistentVector<E>::Transient::remove_back()
+{
+    v.pop();
+    return *this;
+}
+
+template<typename T>
+bool operator==(const PersistentVector<T>& lhs, const PersistentVector<T>& rhs)
+{
+    if (lhs.size() != rhs.size())
+        return false;
+    if (lhs.root == rhs.root && lhs.tail == rhs.tail)
+        return true;
+    auto i = lhs.begin();
+    auto j = rhs.begin();
+    for (; i != lhs.end(); ++i, ++j)
+    {
+        if (!(*i == *j))
+            return false;
+    }
+    return true;
+}
+
+template<typename T>
+bool operator!=(const PersistentVector<T>& lhs, const PersistentVector<T>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template<typename T>
+std::ostream& operator<<(std::ostream& os, const PersistentVector<T>& vector)
+{
+    for (auto i = vector.begin(); i != vector.end(); ++i)
+        os << *i << " ";
+    return os;
+}
+
+template<typename E>
+void swap(PersistentVector<E>& lhs, PersistentVector<E>& rhs)
+{
+    lhs.swap(rhs);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <pthread.h>
+
+/**
+ * Reader-writer lock over pthread_rwlock_t, for C++11 code without
+ * std::shared_mutex. lock()/unlock() take it exclusively and work with
+ * std::lock_guard; SharedLock holds it shared for a scope.
+ */
+class RwLock {
+private:
+    pthread_rwlock_t rw;
+public:
+    RwLock() { pthread_rwlock_init(&rw, nullptr); }
+    RwLock(const RwLock&) = delete;
+    RwLock& operator=(const RwLock&) = delete;
+    ~RwLock() { pthread_rwlock_destroy(&rw); }
+
+    void lock() { pthread_rwlock_wrlock(&rw); }
+    void unlock() { pthread_rwlock_unlock(&rw); }
+    void lockShared() { pthread_rwlock_rdlock(&rw); }
+    void unlockShared() { pthread_rwlock_unlock(&rw); }
+};
+
+class SharedLock {
+private:
+    RwLock& rw;
+public:
+    explicit SharedLock(RwLock& rw) : rw(rw) { rw.lockShared(); }
+    SharedLock(const SharedLock&) = delete;
+    SharedLock& operator=(const SharedLock&) = delete;
+    ~SharedLock() { rw.unlockShared(); }
+};
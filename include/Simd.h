@@ -0,0 +1,345 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Vectorized scans over contiguous arrays with runtime CPU dispatch.
+ *
+ * The kernels are written once with GCC vector extensions and compiled for
+ * each instruction set through target attributes: SSE2 (16-byte vectors),
+ * AVX2 (32) and AVX-512 (64). simdLevel() picks the widest one the CPU
+ * supports; element types that are not plain arithmetic values, and
+ * non-x86 targets, use the scalar loops. simdTransform() is always the
+ * scalar loop, since its op works on one element at a time.
+ *
+ * Floating point sum() adds lanes in a different order than a sequential
+ * loop, and min/max leave the result unspecified when NaNs are present.
+ */
+enum class SimdLevel { SCALAR, SSE2, AVX2, AVX512 };
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CPPLIB_SIMD_X86 1
+#endif
+
+#define CPPLIB_ALWAYS_INLINE inline __attribute__((always_inline))
+
+// Detect the widest instruction set the CPU supports
+inline SimdLevel simdDetect() {
+#ifdef CPPLIB_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SimdLevel::SSE2;
+#endif
+    return SimdLevel::SCALAR;
+}
+
+inline std::atomic<int>& simdLimitSlot() {
+    static std::atomic<int> limit(static_cast<int>(SimdLevel::AVX512));
+    return limit;
+}
+
+// Cap the level used by the kernels, e.g. to compare code paths
+inline void simdLimit(SimdLevel level) {
+    simdLimitSlot().store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+// Return the level the kernels dispatch to
+inline SimdLevel simdLevel() {
+    static const SimdLevel detected = simdDetect();
+    int limit = simdLimitSlot().load(std::memory_order_relaxed);
+    return static_cast<int>(detected) < limit ? detected : static_cast<SimdLevel>(limit);
+}
+
+inline const char* simdName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::SSE2:   return "sse2";
+    case SimdLevel::AVX2:   return "avx2";
+    case SimdLevel::AVX512: return "avx512";
+    default:                return "scalar";
+    }
+}
+
+// Element types the vector kernels handle
+template<typename E>
+struct IsSimdType : std::integral_constant<bool,
+    std::is_arithmetic<E>::value && !std::is_same<E, bool>::value && !std::is_same<E, long double>::value> {};
+
+// Type sum() accumulates in: integers wrap around in the unsigned type
+template<typename E, bool = std::is_integral<E>::value && !std::is_same<E, bool>::value>
+struct SimdSumType { typedef E type; };
+template<typename E>
+struct SimdSumType<E, true> { typedef typename std::make_unsigned<E>::type type; };
+
+/**
+ * Scalar reference loops, also used for non-arithmetic element types.
+ */
+struct SimdScalar {
+    template<typename E>
+    static size_t find(const E* p, size_t n, const E& x) {
+        for (size_t i = 0; i < n; ++i)
+            if (p[i] == x) return i;
+        return n;
+    }
+    template<typename E>
+    static size_t count(const E* p, size_t n, const E& x) {
+        size_t c = 0;
+        for (size_t i = 0; i < n; ++i)
+            c += p[i] == x;
+        return c;
+    }
+    template<typename E>
+    static void minmax(const E* p, size_t n, E& mn, E& mx) {
+        mn = mx = p[0];
+        for (size_t i = 1; i < n; ++i) {
+            if (p[i] < mn) mn = p[i];
+            if (mx < p[i]) mx = p[i];
+        }
+    }
+    template<typename E>
+    static E sum(const E* p, size_t n) {
+        typedef typename SimdSumType<E>::type A;
+        A s = A();
+        for (size_t i = 0; i < n; ++i)
+            s += static_cast<A>(p[i]);
+        return static_cast<E>(s);
+    }
+    template<typename E>
+    static bool equal(const E* a, const E* b, size_t n) {
+        for (size_t i = 0; i < n; ++i)
+            if (!(a[i] == b[i])) return false;
+        return true;
+    }
+    template<typename E>
+    static void fill(E* p, size_t n, const E& x) {
+        for (size_t i = 0; i < n; ++i)
+            p[i] = x;
+    }
+    template<typename E, typename Op>
+    static void transform(const E* in, E* out, size_t n, Op op) {
+        for (size_t i = 0; i < n; ++i)
+            out[i] = op(in[i]);
+    }
+};
+
+/**
+ * Kernels over W-byte vectors. Members are always inlined so each ISA entry
+ * point below compiles them with its own target.
+ */
+template<typename E, int W>
+struct SimdKernels {
+    typedef E V __attribute__((vector_size(W)));
+    typedef decltype(V() == V()) M;
+    static const size_t L = W / sizeof(E);
+    // Iterations before narrow count lanes could overflow
+    static const size_t FLUSH = sizeof(E) == 1 ? 127 : sizeof(E) == 2 ? 32767 : size_t(1) << 30;
+
+    // Check if any lane of a comparison result is set; takes a pointer
+    // because vector arguments change the ABI between targets
+    static CPPLIB_ALWAYS_INLINE bool any(const M* m) {
+        unsigned long long u[W / 8];
+        std::memcpy(u, m, W);
+        unsigned long long r = 0;
+        for (size_t j = 0; j < W / 8; ++j)
+            r |= u[j];
+        return r != 0;
+    }
+
+    static CPPLIB_ALWAYS_INLINE size_t find(const E* p, size_t n, E x) {
+        V s = V{} + x;
+        size_t i = 0;
+        for (; i + L <= n; i += L) {
+            V v;
+            std::memcpy(&v, p + i, W);
+            M m = v == s;
+            if (any(&m)) break;
+        }
+        for (; i < n; ++i)
+            if (p[i] == x) return i;
+        return n;
+    }
+
+    static CPPLIB_ALWAYS_INLINE size_t count(const E* p, size_t n, E x) {
+        V s = V{} + x;
+        size_t c = 0;
+        size_t i = 0;
+        while (i + L <= n) {
+            M acc = M{};
+            size_t stop = n - i < FLUSH * L ? n - n % L : i + FLUSH * L;
+            for (; i < stop; i += L) {
+                V v;
+                std::memcpy(&v, p + i, W);
+                acc -= (v == s);
+            }
+            for (size_t j = 0; j < L; ++j)
+                c += static_cast<size_t>(acc[j]);
+        }
+        for (; i < n; ++i)
+            c += p[i] == x;
+        return c;
+    }
+
+    static CPPLIB_ALWAYS_INLINE void minmax(const E* p, size_t n, E& mn, E& mx) {
+        if (n < L)
+            return SimdScalar::minmax(p, n, mn, mx);
+        V lo, hi;
+        std::memcpy(&lo, p, W);
+        hi = lo;
+        size_t i = L;
+        for (; i + L <= n; i += L) {
+            V v;
+            std::memcpy(&v, p + i, W);
+            lo = v < lo ? v : lo;
+            hi = hi < v ? v : hi;
+        }
+        mn = lo[0];
+        mx = hi[0];
+        for (size_t j = 1; j < L; ++j) {
+            if (lo[j] < mn) mn = lo[j];
+            if (mx < hi[j]) mx = hi[j];
+        }
+        for (; i < n; ++i) {
+            if (p[i] < mn) mn = p[i];
+            if (mx < p[i]) mx = p[i];
+        }
+    }
+
+    static CPPLIB_ALWAYS_INLINE E sum(const E* p, size_t n) {
+        typedef typename SimdSumType<E>::type A;
+        typedef A AV __attribute__((vector_size(W)));
+        AV a0 = AV{}, a1 = AV{};
+        size_t i = 0;
+        for (; i + 2 * L <= n; i += 2 * L) {
+            AV v0, v1;
+            std::memcpy(&v0, p + i, W);
+            std::memcpy(&v1, p + i + L, W);
+            a0 += v0;
+            a1 += v1;
+        }
+        a0 += a1;
+        A s = A();
+        for (size_t j = 0; j < L; ++j)
+            s += a0[j];
+        for (; i < n; ++i)
+            s += static_cast<A>(p[i]);
+        return static_cast<E>(s);
+    }
+
+    static CPPLIB_ALWAYS_INLINE bool equal(const E* a, const E* b, size_t n) {
+        size_t i = 0;
+        for (; i + L <= n; i += L) {
+            V va, vb;
+            std::memcpy(&va, a + i, W);
+            std::memcpy(&vb, b + i, W);
+            M m = va != vb;
+            if (any(&m)) return false;
+        }
+        for (; i < n; ++i)
+            if (!(a[i] == b[i])) return false;
+        return true;
+    }
+
+    static CPPLIB_ALWAYS_INLINE void fill(E* p, size_t n, E x) {
+        V s = V{} + x;
+        size_t i = 0;
+        for (; i + L <= n; i += L)
+            std::memcpy(p + i, &s, W);
+        for (; i < n; ++i)
+            p[i] = x;
+    }
+};
+
+#ifdef CPPLIB_SIMD_X86
+// One entry point per kernel and instruction set
+#define CPPLIB_SIMD_ISA(Isa, W, Target)                                                        \
+struct Isa {                                                                                    \
+    template<typename E> Target static size_t find(const E* p, size_t n, E x)                   \
+        { return SimdKernels<E, W>::find(p, n, x); }                                            \
+    template<typename E> Target static size_t count(const E* p, size_t n, E x)                  \
+        { return SimdKernels<E, W>::count(p, n, x); }                                           \
+    template<typename E> Target static void minmax(const E* p, size_t n, E& mn, E& mx)          \
+        { SimdKernels<E, W>::minmax(p, n, mn, mx); }                                            \
+    template<typename E> Target static E sum(const E* p, size_t n)                              \
+        { return SimdKernels<E, W>::sum(p, n); }                                                \
+    template<typename E> Target static bool equal(const E* a, const E* b, size_t n)             \
+        { return SimdKernels<E, W>::equal(a, b, n); }                                           \
+    template<typename E> Target static void fill(E* p, size_t n, E x)                           \
+        { SimdKernels<E, W>::fill(p, n, x); }                                                   \
+};
+
+CPPLIB_SIMD_ISA(SimdSse2, 16, __attribute__((target("sse2"))))
+CPPLIB_SIMD_ISA(SimdAvx2, 32, __attribute__((target("avx2"))))
+CPPLIB_SIMD_ISA(SimdAvx512, 64, __attribute__((target("avx512f,avx512bw"))))
+
+#undef CPPLIB_SIMD_ISA
+
+#define CPPLIB_SIMD_DISPATCH(call)                          \
+    switch (simdLevel()) {                                  \
+    case SimdLevel::AVX512: return SimdAvx512::call;        \
+    case SimdLevel::AVX2:   return SimdAvx2::call;          \
+    case SimdLevel::SSE2:   return SimdSse2::call;          \
+    default:                return SimdScalar::call;        \
+    }
+#else
+#define CPPLIB_SIMD_DISPATCH(call) return SimdScalar::call;
+#endif
+
+// Return the index of the first element equal to x, or n
+template<typename E>
+size_t simdFind(const E* p, size_t n, const E& x, std::true_type) { CPPLIB_SIMD_DISPATCH(find(p, n, x)) }
+template<typename E>
+size_t simdFind(const E* p, size_t n, const E& x, std::false_type) { return SimdScalar::find(p, n, x); }
+template<typename E>
+size_t simdFind(const E* p, size_t n, const E& x) { return simdFind(p, n, x, IsSimdType<E>()); }
+
+// Return the number of elements equal to x
+template<typename E>
+size_t simdCount(const E* p, size_t n, const E& x, std::true_type) { CPPLIB_SIMD_DISPATCH(count(p, n, x)) }
+template<typename E>
+size_t simdCount(const E* p, size_t n, const E& x, std::false_type) { return SimdScalar::count(p, n, x); }
+template<typename E>
+size_t simdCount(const E* p, size_t n, const E& x) { return simdCount(p, n, x, IsSimdType<E>()); }
+
+// Store the smallest and largest of n > 0 elements in mn and mx
+template<typename E>
+void simdMinmax(const E* p, size_t n, E& mn, E& mx, std::true_type) { CPPLIB_SIMD_DISPATCH(minmax(p, n, mn, mx)) }
+template<typename E>
+void simdMinmax(const E* p, size_t n, E& mn, E& mx, std::false_type) { SimdScalar::minmax(p, n, mn, mx); }
+template<typename E>
+void simdMinmax(const E* p, size_t n, E& mn, E& mx) { simdMinmax(p, n, mn, mx, IsSimdType<E>()); }
+
+// Return the sum of the elements, accumulated in E
+template<typename E>
+E simdSum(const E* p, size_t n, std::true_type) { CPPLIB_SIMD_DISPATCH(sum(p, n)) }
+template<typename E>
+E simdSum(const E* p, size_t n, std::false_type) { return SimdScalar::sum(p, n); }
+template<typename E>
+E simdSum(const E* p, size_t n) { return simdSum(p, n, IsSimdType<E>()); }
+
+// Check if a[0, n) and b[0, n) are element-wise equal
+template<typename E>
+bool simdEqual(const E* a, const E* b, size_t n, std::true_type) { CPPLIB_SIMD_DISPATCH(equal(a, b, n)) }
+template<typename E>
+bool simdEqual(const E* a, const E* b, size_t n, std::false_type) { return SimdScalar::equal(a, b, n); }
+template<typename E>
+bool simdEqual(const E* a, const E* b, size_t n) { return simdEqual(a, b, n, IsSimdType<E>()); }
+
+// Assign x to every element
+template<typename E>
+void simdFill(E* p, size_t n, const E& x, std::true_type) { CPPLIB_SIMD_DISPATCH(fill(p, n, x)) }
+template<typename E>
+void simdFill(E* p, size_t n, const E& x, std::false_type) { SimdScalar::fill(p, n, x); }
+template<typename E>
+void simdFill(E* p, size_t n, const E& x) { simdFill(p, n, x, IsSimdType<E>()); }
+
+// Store op(in[i]) in out[i]; in and out may be the same array. Not a vector
+// kernel: op takes one element, so this is the scalar loop, which the
+// compiler may still auto-vectorize once op is inlined.
+template<typename E, typename Op>
+void simdTransform(const E* in, E* out, size_t n, Op op) { SimdScalar::transform(in, out, n, op); }
@@ -0,0 +1,319 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include "Config.h"
+#include "EpochDomain.h"
+#include "Hash.h"
+#include "Vector.h"
+
+/**
+ * Read-mostly hash map for tables that are reloaded while many threads
+ * query them, in the style of read-copy-update.
+ *
+ * Readers look up keys in an immutable snapshot reached through one atomic
+ * pointer; a lookup takes no lock and writes only the reader's own epoch
+ * slot, so it is wait-free and readers never wait for a reload or for each
+ * other. A reload fills a Builder off to the side, either from scratch or
+ * starting from a copy of the current snapshot to apply a diff, then
+ * publish() swaps it in with one atomic exchange. The old snapshot is
+ * handed to an EpochDomain and freed once the last reader that could have
+ * loaded it leaves its read section.
+ *
+ * Each reading thread holds a Reader, which claims one of a fixed number of
+ * epoch slots. A View pins one snapshot, so several lookups see the same
+ * version; it also delays freeing every snapshot replaced while it lives.
+ */
+template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+class SnapshotMap {
+private:
+    static const uint32_t EMPTY = 0;
+
+    struct Entry {
+        K key;
+        V value;
+        uint32_t hash;
+    };
+
+    // Open addressing with linear probing; never modified once published
+    struct Table {
+        Vector<Entry> entries;
+        Vector<uint32_t> slots;    // entry + 1, or EMPTY
+        size_t mask;
+        uint64_t version;
+
+        explicit Table(size_t size);
+        // Return the slot holding key, or the empty slot ending its probe sequence
+        size_t findSlot(const K& key, uint32_t h, const Equal& equal) const;
+        // Return the slot pointing at entry i
+        size_t slotOf(uint32_t i) const;
+        // Empty slot j, shifting back the entries probed past it
+        void unindex(size_t j);
+        void rehash(size_t size);
+    };
+
+    Hash hasher;
+    Equal equal;
+    EpochDomain domain;
+    std::atomic<Table*> current;
+    std::mutex writer;    // Serializes publish() and copying the current snapshot
+
+    uint32_t hash(const K& key) const { return static_cast<uint32_t>(hashMix(hasher(key))); }
+public:
+    class Builder;
+    class Reader;
+    class View;
+
+    explicit SnapshotMap(int readers = 256);
+    SnapshotMap(const SnapshotMap&) = delete;
+    SnapshotMap& operator=(const SnapshotMap&) = delete;
+    // No Reader may outlive the map
+    ~SnapshotMap();
+
+    // Make the builder's contents the current snapshot; the builder is left empty
+    void publish(Builder&& builder);
+    // Return the version of the current snapshot, counting publish() calls
+    uint64_t version();
+    // Free the replaced snapshots no reader can see and return how many
+    size_t reclaim() { return domain.reclaim(); }
+    // Return the number of replaced snapshots not yet freed
+    size_t pending() { return domain.pending(); }
+
+    /**
+     * Contents of the next snapshot, owned by one writer thread.
+     */
+    class Builder {
+    private:
+        friend class SnapshotMap;
+        const SnapshotMap* map;
+        std::unique_ptr<Table> table;
+    public:
+        // Start empty, with room for capacity entries before growing
+        Builder(const SnapshotMap& map, size_t capacity);
+        // Start from a copy of the current snapshot of map, to apply a diff
+        explicit Builder(SnapshotMap& map);
+        Builder(Builder&& that) = default;
+        Builder& operator=(Builder&& that) = default;
+
+        // Insert or replace key's value
+        void put(const K& key, const V& value);
+        // Remove key; false if it is absent
+        bool erase(const K& key);
+        // Copy key's value into value; false if it is absent
+        bool find(const K& key, V& value) const;
+        int size() const { return table->entries.size(); }
+    };
+
+    /**
+     * A reading thread's handle on the map: holds an epoch slot.
+     */
+    class Reader {
+    private:
+        friend class View;
+        SnapshotMap& map;
+        EpochReader epoch;
+    public:
+        explicit Reader(SnapshotMap& map) : map(map), epoch(map.domain) {}
+
+        // Copy key's value in the current snapshot into value; false if it is absent
+        bool find(const K& key, V& value);
+    };
+
+    /**
+     * One snapshot pinned for the lifetime of the View.
+     */
+    class View {
+    private:
+        Reader& reader;
+        const Table* table;
+    public:
+        explicit View(Reader& reader);
+        View(const View&) = delete;
+        View& operator=(const View&) = delete;
+        ~View() { reader.epoch.exit(); }
+
+        bool find(const K& key, V& value) const;
+        bool contains(const K& key) const;
+        int size() const { return table->entries.size(); }
+        uint64_t version() const { return table->version; }
+    };
+};
+
+template<typename K, typename V, typename Hash, typename Equal>
+SnapshotMap<K, V, Hash, Equal>::Table::Table(size_t size) : entries(0), slots(static_cast<int>(size)), mask(size - 1),
+                                                            version(0) {
+    for (size_t j = 0; j < size; ++j)
+        slots.insert_back(EMPTY);
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+size_t SnapshotMap<K, V, Hash, Equal>::Table::findSlot(const K& key, uint32_t h, const Equal& equal) const {
+    size_t j = h & mask;
+    for (; slots[j] != EMPTY; j = (j + 1) & mask) {
+        const Entry& e = entries[slots[j] - 1];
+        if (e.hash == h && equal(e.key, key))
+            break;
+    }
+    return j;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+size_t SnapshotMap<K, V, Hash, Equal>::Table::slotOf(uint32_t i) const {
+    size_t j = entries[i].hash & mask;
+    while (slots[j] != i + 1)
+        j = (j + 1) & mask;
+    return j;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+void SnapshotMap<K, V, Hash, Equal>::Table::unindex(size_t j) {
+    for (size_t k = (j + 1) & mask; slots[k] != EMPTY; k = (k + 1) & mask) {
+        size_t home = entries[slots[k] - 1].hash & mask;
+        // The entry at k may fill j unless its home lies in (j, k]
+        if (((k - home) & mask) >= ((k - j) & mask)) {
+            slots[j] = slots[k];
+            j = k;
+        }
+    }
+    slots[j] = EMPTY;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+void SnapshotMap<K, V, Hash, Equal>::Table::rehash(size_t size) {
+    if (size > size_t(INT32_MAX))
+        CPPLIB_THROW(std::length_error, "SnapshotMap size.");
+    Vector<uint32_t> fresh(static_cast<int>(size));
+    for (size_t j = 0; j < size; ++j)
+        fresh.insert_back(EMPTY);
+    mask = size - 1;
+    for (int i = 0; i < entries.size(); ++i) {
+        size_t j = entries[i].hash & mask;
+        while (fresh[j] != EMPTY)
+            j = (j + 1) & mask;
+        fresh[j] = i + 1;
+    }
+    slots.swap(fresh);
+}
+
+/**
+ * @param readers: Maximum number of Readers at a time
+ */
+template<typename K, typename V, typename Hash, typename Equal>
+SnapshotMap<K, V, Hash, Equal>::SnapshotMap(int readers) : domain(readers), current(new Table(2)) {}
+
+template<typename K, typename V, typename Hash, typename Equal>
+SnapshotMap<K, V, Hash, Equal>::~SnapshotMap() {
+    delete current.load(std::memory_order_relaxed);
+}
+
+/**
+ * @param builder: Contents of the new snapshot
+ */
+template<typename K, typename V, typename Hash, typename Equal>
+void SnapshotMap<K, V, Hash, Equal>::publish(Builder&& builder) {
+    if (builder.map != this)
+        CPPLIB_THROW(std::invalid_argument, "SnapshotMap builder.");
+    Table* next = builder.table.release();
+    builder.table.reset(new Table(2));
+    {
+        std::lock_guard<std::mutex> lock(writer);
+        next->version = current.load(std::memory_order_relaxed)->version + 1;
+        Table* old = current.exchange(next, std::memory_order_seq_cst);
+        domain.retire(old);
+    }
+    domain.reclaim();
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+uint64_t SnapshotMap<K, V, Hash, Equal>::version() {
+    std::lock_guard<std::mutex> lock(writer);
+    return current.load(std::memory_order_relaxed)->version;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+SnapshotMap<K, V, Hash, Equal>::Builder::Builder(const SnapshotMap& map, size_t capacity) : map(&map) {
+    size_t size = 2;
+    while (size < 2 * capacity)
+        size *= 2;
+    table.reset(new Table(size));
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+SnapshotMap<K, V, Hash, Equal>::Builder::Builder(SnapshotMap& map) : map(&map) {
+    // Only publish() frees the current snapshot, and it takes the same lock
+    std::lock_guard<std::mutex> lock(map.writer);
+    table.reset(new Table(*map.current.load(std::memory_order_relaxed)));
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+void SnapshotMap<K, V, Hash, Equal>::Builder::put(const K& key, const V& value) {
+    uint32_t h = map->hash(key);
+    size_t j = table->findSlot(key, h, map->equal);
+    if (table->slots[j] != EMPTY) {
+        table->entries[table->slots[j] - 1].value = value;
+        return;
+    }
+    table->entries.insert_back(Entry{ key, value, h });
+    table->slots[j] = table->entries.size();
+    // Keep the load factor at most 1/2
+    if (size_t(table->entries.size()) * 2 > table->mask + 1)
+        table->rehash((table->mask + 1) * 2);
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+bool SnapshotMap<K, V, Hash, Equal>::Builder::erase(const K& key) {
+    size_t j = table->findSlot(key, map->hash(key), map->equal);
+    if (table->slots[j] == EMPTY)
+        return false;
+    uint32_t i = table->slots[j] - 1;
+    table->unindex(j);
+    // Move the last entry into the hole to keep entries dense
+    uint32_t last = table->entries.size() - 1;
+    if (i != last) {
+        table->slots[table->slotOf(last)] = i + 1;
+        table->entries[i] = std::move(table->entries[last]);
+    }
+    table->entries.remove_back();
+    return true;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+bool SnapshotMap<K, V, Hash, Equal>::Builder::find(const K& key, V& value) const {
+    size_t j = table->findSlot(key, map->hash(key), map->equal);
+    if (table->slots[j] == EMPTY)
+        return false;
+    value = table->entries[table->slots[j] - 1].value;
+    return true;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+bool SnapshotMap<K, V, Hash, Equal>::Reader::find(const K& key, V& value) {
+    View view(*this);
+    return view.find(key, value);
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+SnapshotMap<K, V, Hash, Equal>::View::View(Reader& reader) : reader(reader) {
+    reader.epoch.enter();
+    // Ordered after the epoch store, so publish() cannot miss this reader
+    table = reader.map.current.load(std::memory_order_seq_cst);
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+bool SnapshotMap<K, V, Hash, Equal>::View::find(const K& key, V& value) const {
+    size_t j = table->findSlot(key, reader.map.hash(key), reader.map.equal);
+    if (table->slots[j] == EMPTY)
+        return false;
+    value = table->entries[table->slots[j] - 1].value;
+    return true;
+}
+
+template<typename K, typename V, typename Hash, typename Equal>
+bool SnapshotMap<K, V, Hash, Equal>::View::contains(const K& key) const {
+    return table->slots[table->findSlot(key, reader.map.hash(key), reader.map.equal)] != EMPTY;
+}
@@ -0,0 +1,197 @@
+#pragma once
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include "Config.h"
+#include "Expected.h"
+
+/**
+ * FIFO queue of at most N elements in an inline ring buffer, for code that
+ * must not touch the heap. Same enqueue/dequeue/front/back/iterator surface
+ * as ArrayQueue, so generic code can take either as a template parameter;
+ * enqueue() on a full queue throws instead of growing.
+ *
+ * N must be a power of two so positions wrap with a mask instead of a
+ * division. As with StaticStack, all N elements are default-constructed up
+ * front, and under C++14 everything but swap() and operator<< is constexpr.
+ */
+template<typename E, size_t N>
+class StaticRingQueue {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "StaticRingQueue capacity must be a power of two");
+private:
+    static const size_t MASK = N - 1;
+
+    E items[N];
+    size_t head;
+    size_t n;
+public:
+    constexpr StaticRingQueue() : items{}, head(0), n(0) {}
+
+    constexpr int size() const { return static_cast<int>(n); }
+    constexpr bool isEmpty() const { return n == 0; }
+    constexpr bool isFull() const { return n == N; }
+    static constexpr int capacity() { return static_cast<int>(N); }
+    CPPLIB_CONSTEXPR14 void enqueue(E elem);
+    Expected<void> tryEnqueue(E elem);
+    template<typename... Args>
+    CPPLIB_CONSTEXPR14 void emplace(Args&&... args);
+    CPPLIB_CONSTEXPR14 E dequeue();
+    CPPLIB_CONSTEXPR14 bool tryDequeue(E& elem);
+    Expected<E> tryDequeue();
+    CPPLIB_CONSTEXPR14 E popBack();
+    CPPLIB_CONSTEXPR14 E& front();
+    constexpr const E& front() const {
+        return n > 0 ? items[head] : (CPPLIB_THROW(std::out_of_range, "Queue underflow."), items[head]);
+    }
+    CPPLIB_CONSTEXPR14 E& back();
+    constexpr const E& back() const {
+        return n > 0 ? items[(head + n - 1) & MASK] : (CPPLIB_THROW(std::out_of_range, "Queue underflow."), items[0]);
+    }
+    CPPLIB_CONSTEXPR14 void clear() { head = n = 0; }
+    void swap(StaticRingQueue& that);
+
+    // Iterate from the front of the queue to the back
+    template<typename Q, typename T>
+    class Iterator {
+    private:
+        Q* queue;
+        size_t i;
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = E;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        constexpr Iterator() : queue(nullptr), i(0) {}
+        constexpr Iterator(Q* queue, size_t i) : queue(queue), i(i) {}
+
+        constexpr T& operator*() const { return queue->items[(queue->head + i) & MASK]; }
+        constexpr T* operator->() const { return &**this; }
+        constexpr bool operator==(const Iterator& that) const { return queue == that.queue && i == that.i; }
+        constexpr bool operator!=(const Iterator& that) const { return !(*this == that); }
+        CPPLIB_CONSTEXPR14 Iterator& operator++() { i++; return *this; }
+        CPPLIB_CONSTEXPR14 Iterator operator++(int) { Iterator tmp(*this); i++; return tmp; }
+    };
+    using iterator = Iterator<StaticRingQueue, E>;
+    using const_iterator = Iterator<const StaticRingQueue, const E>;
+
+    CPPLIB_CONSTEXPR14 iterator begin() { return iterator(this, 0); }
+    CPPLIB_CONSTEXPR14 iterator end() { return iterator(this, n); }
+    constexpr const_iterator begin() const { return const_iterator(this, 0); }
+    constexpr const_iterator end() const { return const_iterator(this, n); }
+};
+
+template<typename E, size_t N>
+CPPLIB_CONSTEXPR14 void StaticRingQueue<E, N>::enqueue(E elem) {
+    if (n == N)
+        CPPLIB_THROW(std::out_of_range, "Queue overflow.");
+    items[(head + n++) & MASK] = std::move(elem);
+}
+
+// Add elem at the back, or return Error::FULL.
+template<typename E, size_t N>
+Expected<void> StaticRingQueue<E, N>::tryEnqueue(E elem) {
+    if (n == N)
+        return Error::FULL;
+    items[(head + n++) & MASK] = std::move(elem);
+    return Expected<void>();
+}
+
+template<typename E, size_t N>
+template<typename... Args>
+CPPLIB_CONSTEXPR14 void StaticRingQueue<E, N>::emplace(Args&&... args) {
+    if (n == N)
+        CPPLIB_THROW(std::out_of_range, "Queue overflow.");
+    items[(head + n++) & MASK] = E(std::forward<Args>(args)...);
+}
+
+template<typename E, size_t N>
+CPPLIB_CONSTEXPR14 E StaticRingQueue<E, N>::dequeue() {
+    if (n == 0)
+        CPPLIB_THROW(std::out_of_range, "Queue underflow.");
+    size_t i = head;
+    head = (head + 1) & MASK;
+    n--;
+    return std::move(items[i]);
+}
+
+// Move the front element into elem and remove it; return false if empty.
+template<typename E, size_t N>
+CPPLIB_CONSTEXPR14 bool StaticRingQueue<E, N>::tryDequeue(E& elem) {
+    if (n == 0)
+        return false;
+    elem = std::move(items[head]);
+    head = (head + 1) & MASK;
+    n--;
+    return true;
+}
+
+// Remove and return the front element, or Error::EMPTY.
+template<typename E, size_t N>
+Expected<E> StaticRingQueue<E, N>::tryDequeue() {
+    if (n == 0)
+        return Error::EMPTY;
+    return dequeue();
+}
+
+// Remove and return the most recently enqueued element.
+template<typename E, size_t N>
+CPPLIB_CONSTEXPR14 E StaticRingQueue<E, N>::popBack() {
+    if (n == 0)
+        CPPLIB_THROW(std::out_of_range, "Queue underflow.");
+    return std::move(items[(head + --n) & MASK]);
+}
+
+template<typename E, size_t N>
+CPPLIB_CONSTEXPR14 E& StaticRingQueue<E, N>::front() {
+    if (n == 0)
+        CPPLIB_THROW(std::out_of_range, "Queue underflow.");
+    return items[head];
+}
+
+template<typename E, size_t N>
+CPPLIB_CONSTEXPR14 E& StaticRingQueue<E, N>::back() {
+    if (n == 0)
+        CPPLIB_THROW(std::out_of_range, "Queue underflow.");
+    return items[(head + n - 1) & MASK];
+}
+
+template<typename E, size_t N>
+void StaticRingQueue<E, N>::swap(StaticRingQueue& that) {
+    using std::swap;
+    for (size_t i = 0; i < N; ++i)
+        swap(items[i], that.items[i]);
+    swap(head, that.head);
+    swap(n, that.n);
+}
+
+template<typename E, size_t N>
+CPPLIB_CONSTEXPR14 bool operator==(const StaticRingQueue<E, N>& lhs, const StaticRingQueue<E, N>& rhs) {
+    if (lhs.size() != rhs.size())
+        return false;
+    auto q = rhs.begin();
+    for (auto p = lhs.begin(); p != lhs.end(); ++p, ++q)
+        if (!(*p == *q))
+            return false;
+    return true;
+}
+
+template<typename E, size_t N>
+CPPLIB_CONSTEXPR14 bool operator!=(const StaticRingQueue<E, N>& lhs, const StaticRingQueue<E, N>& rhs) {
+    return !(lhs == rhs);
+}
+
+template<typename E, size_t N>
+std::ostream& operator<<(std::ostream& os, const StaticRingQueue<E, N>& queue) {
+    for (const E& elem : queue)
+        os << elem << " ";
+    return os;
+}
+
+template<typename E, size_t N>
+void swap(StaticRingQueue<E, N>& lhs, StaticRingQueue<E, N>& rhs) {
+    lhs.swap(rhs);
+}
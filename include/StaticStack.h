@@ -0,0 +1,143 @@
+#pragma once
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include "Config.h"
+#include "Expected.h"
+
+/**
+ * Stack of at most N elements stored inline, for code that must not touch
+ * the heap. Same push/pop/top/iterator surface as ArrayStack, so generic
+ * code can take either as a template parameter; push() on a full stack
+ * throws instead of growing.
+ *
+ * All N elements are default-constructed with the stack and popped ones are
+ * moved from rather than destroyed, so E must be default-constructible.
+ * Under C++14 every operation except swap() and operator<< is constexpr,
+ * and a StaticStack of a literal type can be filled inside a constexpr
+ * function, e.g. to build a lookup table at compile time.
+ */
+template<typename E, size_t N>
+class StaticStack {
+private:
+    E items[N];
+    size_t n;
+public:
+    constexpr StaticStack() : items{}, n(0) {}
+
+    constexpr int size() const { return static_cast<int>(n); }
+    constexpr bool isEmpty() const { return n == 0; }
+    constexpr bool isFull() const { return n == N; }
+    static constexpr int capacity() { return static_cast<int>(N); }
+    CPPLIB_CONSTEXPR14 void push(E elem);
+    Expected<void> tryPush(E elem);
+    template<typename... Args>
+    CPPLIB_CONSTEXPR14 void emplace(Args&&... args);
+    CPPLIB_CONSTEXPR14 E pop();
+    CPPLIB_CONSTEXPR14 bool tryPop(E& elem);
+    Expected<E> tryPop();
+    CPPLIB_CONSTEXPR14 E& top();
+    constexpr const E& top() const { return n > 0 ? items[n - 1] : (CPPLIB_THROW(std::out_of_range, "Stack underflow."), items[0]); }
+    CPPLIB_CONSTEXPR14 void clear() { n = 0; }
+    void swap(StaticStack& that);
+
+    // Iterate from the bottom of the stack to the top
+    using iterator = E*;
+    using const_iterator = const E*;
+    CPPLIB_CONSTEXPR14 iterator begin() { return items; }
+    CPPLIB_CONSTEXPR14 iterator end() { return items + n; }
+    constexpr const_iterator begin() const { return items; }
+    constexpr const_iterator end() const { return items + n; }
+};
+
+template<typename E, size_t N>
+CPPLIB_CONSTEXPR14 void StaticStack<E, N>::push(E elem) {
+    if (n == N)
+        CPPLIB_THROW(std::out_of_range, "Stack overflow.");
+    items[n++] = std::move(elem);
+}
+
+// Add elem on top, or return Error::FULL.
+template<typename E, size_t N>
+Expected<void> StaticStack<E, N>::tryPush(E elem) {
+    if (n == N)
+        return Error::FULL;
+    items[n++] = std::move(elem);
+    return Expected<void>();
+}
+
+template<typename E, size_t N>
+template<typename... Args>
+CPPLIB_CONSTEXPR14 void StaticStack<E, N>::emplace(Args&&... args) {
+    if (n == N)
+        CPPLIB_THROW(std::out_of_range, "Stack overflow.");
+    items[n++] = E(std::forward<Args>(args)...);
+}
+
+template<typename E, size_t N>
+CPPLIB_CONSTEXPR14 E StaticStack<E, N>::pop() {
+    if (n == 0)
+        CPPLIB_THROW(std::out_of_range, "Stack underflow.");
+    return std::move(items[--n]);
+}
+
+// Move the top element into elem and remove it; return false if empty.
+template<typename E, size_t N>
+CPPLIB_CONSTEXPR14 bool StaticStack<E, N>::tryPop(E& elem) {
+    if (n == 0)
+        return false;
+    elem = std::move(items[--n]);
+    return true;
+}
+
+// Remove and return the top element, or Error::EMPTY.
+template<typename E, size_t N>
+Expected<E> StaticStack<E, N>::tryPop() {
+    if (n == 0)
+        return Error::EMPTY;
+    return std::move(items[--n]);
+}
+
+template<typename E, size_t N>
+CPPLIB_CONSTEXPR14 E& StaticStack<E, N>::top() {
+    if (n == 0)
+        CPPLIB_THROW(std::out_of_range, "Stack underflow.");
+    return items[n - 1];
+}
+
+template<typename E, size_t N>
+void StaticStack<E, N>::swap(StaticStack& that) {
+    using std::swap;
+    for (size_t i = 0; i < N; ++i)
+        swap(items[i], that.items[i]);
+    swap(n, that.n);
+}
+
+template<typename E, size_t N>
+CPPLIB_CONSTEXPR14 bool operator==(const StaticStack<E, N>& lhs, const StaticStack<E, N>& rhs) {
+    if (lhs.size() != rhs.size())
+        return false;
+    for (const E *p = lhs.begin(), *q = rhs.begin(); p != lhs.end(); ++p, ++q)
+        if (!(*p == *q))
+            return false;
+    return true;
+}
+
+template<typename E, size_t N>
+CPPLIB_CONSTEXPR14 bool operator!=(const StaticStack<E, N>& lhs, const StaticStack<E, N>& rhs) {
+    return !(lhs == rhs);
+}
+
+template<typename E, size_t N>
+std::ostream& operator<<(std::ostream& os, const StaticStack<E, N>& stack) {
+    for (const E& elem : stack)
+        os << elem << " ";
+    return os;
+}
+
+template<typename E, size_t N>
+void swap(StaticStack<E, N>& lhs, StaticStack<E, N>& rhs) {
+    lhs.swap(rhs);
+}
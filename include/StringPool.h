@@ -0,0 +1,201 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include "Config.h"
+#include "Hash.h"
+#include "MemoryResource.h"
+#include "StringView.h"
+#include "Vector.h"
+
+/**
+ * String interning. Each distinct string is stored once, contiguously in a
+ * MonotonicArena, and named by a 32-bit StrId. Containers of StrId
+ * (Vector<StrId>, ArrayQueue<StrId>) take 4 bytes per element instead of a
+ * 32-byte std::string plus its heap buffer, and two ids of the same pool
+ * are equal exactly when their strings are.
+ *
+ *   - StringPool:        single-threaded; ids are dense from 0
+ *   - ShardedStringPool: thread-safe; strings are spread over mutex-guarded
+ *                        shards by hash
+ *
+ * Strings live until the pool is destroyed; views returned by str() stay
+ * valid that long.
+ */
+using StrId = uint32_t;
+
+class StringPool {
+private:
+    static const uint32_t EMPTY = 0;
+    static const size_t MIN_SLOTS = 16;
+
+    struct Entry {
+        const char* p;
+        uint32_t len;
+        uint32_t hash;
+    };
+
+    MonotonicArena arena;
+    Vector<Entry> entries;
+    // Open addressing with linear probing: id + 1, or EMPTY
+    std::unique_ptr<uint32_t[]> slots;
+    size_t mask;
+
+    void rehash(size_t count);
+public:
+    explicit StringPool(MemoryResource* upstream = newDeleteResource());
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    // Return the id of s, adding a copy of s if it is new
+    StrId intern(StringView s) { return intern(s, hashBytes(s.data(), s.size())); }
+    StrId intern(StringView s, uint64_t hash);
+    // Look s up without adding it; false if absent
+    bool find(StringView s, StrId& id) const { return find(s, hashBytes(s.data(), s.size()), id); }
+    bool find(StringView s, uint64_t hash, StrId& id) const;
+    StringView str(StrId id) const;
+    // Return the number of distinct strings
+    int size() const { return entries.size(); }
+    // Return the bytes of string data stored
+    size_t bytes() const { return arena.bytesUsed(); }
+};
+
+inline StringPool::StringPool(MemoryResource* upstream)
+    : arena(4096, upstream), entries(0), slots(new uint32_t[MIN_SLOTS]()), mask(MIN_SLOTS - 1) {}
+
+inline void StringPool::rehash(size_t count) {
+    std::unique_ptr<uint32_t[]> fresh(new uint32_t[count]());
+    size_t m = count - 1;
+    for (int i = 0; i < entries.size(); ++i) {
+        size_t j = entries[i].hash & m;
+        while (fresh[j] != EMPTY)
+            j = (j + 1) & m;
+        fresh[j] = i + 1;
+    }
+    slots.swap(fresh);
+    mask = m;
+}
+
+inline bool StringPool::find(StringView s, uint64_t hash, StrId& id) const {
+    uint32_t h = static_cast<uint32_t>(hash);
+    for (size_t j = h & mask; slots[j] != EMPTY; j = (j + 1) & mask) {
+        const Entry& e = entries[slots[j] - 1];
+        if (e.hash == h && StringView(e.p, e.len) == s) {
+            id = slots[j] - 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline StrId StringPool::intern(StringView s, uint64_t hash) {
+    uint32_t h = static_cast<uint32_t>(hash);
+    size_t j = h & mask;
+    for (; slots[j] != EMPTY; j = (j + 1) & mask) {
+        const Entry& e = entries[slots[j] - 1];
+        if (e.hash == h && StringView(e.p, e.len) == s)
+            return slots[j] - 1;
+    }
+    if (entries.size() == INT32_MAX)
+        CPPLIB_THROW(std::out_of_range, "StringPool overflow.");
+
+    char* p = static_cast<char*>(arena.allocate(s.size() > 0 ? s.size() : 1, 1));
+    std::memcpy(p, s.data(), s.size());
+    Entry e = { p, static_cast<uint32_t>(s.size()), h };
+    StrId id = entries.size();
+    entries.insert_back(e);
+    slots[j] = id + 1;
+    // Keep the load factor at most 1/2
+    if (2 * static_cast<size_t>(entries.size()) > mask + 1)
+        rehash(2 * (mask + 1));
+    return id;
+}
+
+inline StringView StringPool::str(StrId id) const {
+    if (id >= static_cast<StrId>(entries.size()))
+        CPPLIB_THROW(std::out_of_range, "StringPool::str");
+    const Entry& e = entries[id];
+    return StringView(e.p, e.len);
+}
+
+/**
+ * Thread-safe pool made of 2^k StringPools, each behind its own mutex. The
+ * top bits of the hash pick the shard and the id is local id * shards +
+ * shard, so ids are unique but not dense.
+ */
+class ShardedStringPool {
+private:
+    struct Shard {
+        std::mutex mtx;
+        StringPool pool;
+        explicit Shard(MemoryResource* upstream) : pool(upstream) {}
+    };
+
+    int bits;
+    std::unique_ptr<std::unique_ptr<Shard>[]> shards;
+
+    size_t shardOf(uint64_t hash) const { return bits > 0 ? hash >> (64 - bits) : 0; }
+public:
+    explicit ShardedStringPool(int bits = 4, MemoryResource* upstream = newDeleteResource());
+
+    StrId intern(StringView s);
+    bool find(StringView s, StrId& id) const;
+    StringView str(StrId id) const;
+    int size() const;
+    size_t bytes() const;
+};
+
+inline ShardedStringPool::ShardedStringPool(int bits, MemoryResource* upstream)
+    : bits(bits), shards(new std::unique_ptr<Shard>[size_t(1) << bits]) {
+    for (size_t i = 0; i < size_t(1) << bits; ++i)
+        shards[i].reset(new Shard(upstream));
+}
+
+inline StrId ShardedStringPool::intern(StringView s) {
+    uint64_t hash = hashBytes(s.data(), s.size());
+    size_t k = shardOf(hash);
+    Shard& shard = *shards[k];
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    StrId local = shard.pool.intern(s, hash);
+    if (local > (UINT32_MAX >> bits))
+        CPPLIB_THROW(std::out_of_range, "StringPool overflow.");
+    return (local << bits) | k;
+}
+
+inline bool ShardedStringPool::find(StringView s, StrId& id) const {
+    uint64_t hash = hashBytes(s.data(), s.size());
+    size_t k = shardOf(hash);
+    Shard& shard = *shards[k];
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    StrId local;
+    if (!shard.pool.find(s, hash, local))
+        return false;
+    id = (local << bits) | k;
+    return true;
+}
+
+inline StringView ShardedStringPool::str(StrId id) const {
+    Shard& shard = *shards[id & ((StrId(1) << bits) - 1)];
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    return shard.pool.str(id >> bits);
+}
+
+inline int ShardedStringPool::size() const {
+    int n = 0;
+    for (size_t i = 0; i < size_t(1) << bits; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i]->mtx);
+        n += shards[i]->pool.size();
+    }
+    return n;
+}
+
+inline size_t ShardedStringPool::bytes() const {
+    size_t n = 0;
+    for (size_t i = 0; i < size_t(1) << bits; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i]->mtx);
+        n += shards[i]->pool.bytes();
+    }
+    return n;
+}
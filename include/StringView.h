@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include "Config.h"
+
+/**
+ * Non-owning view of a character sequence, a C++11 stand-in for
+ * std::string_view. The viewed characters must outlive the view.
+ */
+class StringView {
+private:
+    const char* p;
+    size_t n;
+public:
+    StringView() : p(nullptr), n(0) {}
+    StringView(const char* p, size_t n) : p(p), n(n) {}
+    StringView(const char* s) : p(s), n(std::strlen(s)) {}
+    StringView(const std::string& s) : p(s.data()), n(s.size()) {}
+
+    const char* data() const { return p; }
+    size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    const char* begin() const { return p; }
+    const char* end() const { return p + n; }
+    char operator[](size_t i) const { return p[i]; }
+    // Return the view of at most count characters starting at pos
+    StringView substr(size_t pos, size_t count = std::string::npos) const;
+    // Copy the characters into a std::string
+    std::string str() const { return std::string(p, n); }
+    int compare(const StringView& that) const;
+
+    friend bool operator==(const StringView& lhs, const StringView& rhs) {
+        return lhs.n == rhs.n && (lhs.n == 0 || std::memcmp(lhs.p, rhs.p, lhs.n) == 0);
+    }
+    friend bool operator!=(const StringView& lhs, const StringView& rhs) { return !(lhs == rhs); }
+    friend bool operator<(const StringView& lhs, const StringView& rhs) { return lhs.compare(rhs) < 0; }
+    friend std::ostream& operator<<(std::ostream& os, const StringView& sv) { return os.write(sv.p, sv.n); }
+};
+
+inline StringView StringView::substr(size_t pos, size_t count) const {
+    if (pos > n)
+        CPPLIB_THROW(std::out_of_range, "StringView::substr");
+    return StringView(p + pos, count < n - pos ? count : n - pos);
+}
+
+inline int StringView::compare(const StringView& that) const {
+    size_t len = n < that.n ? n : that.n;
+    int r = len == 0 ? 0 : std::memcmp(p, that.p, len);
+    if (r != 0)
+        return r;
+    return n < that.n ? -1 : (n > that.n ? 1 : 0);
+}
@@ -10,23 +10,27 @@
 
 /**
  * Timer, used to measure the running time of a program.
- * Provides a static method to generate a millisecond precision timestamp.
+ * Provides static methods to generate millisecond precision timestamps:
+ * wall-clock time, and a monotonic clock that never jumps backwards, which
+ * the Timer itself uses to measure intervals.
  */
 class Timer
 {
 private:
     size_t time;
 public:
-    Timer() { time = time_millis(); }
+    Timer() { time = monotonic_millis(); }
     
     // Generate a millisecond precision timestamp
     static size_t time_millis();
+    // Generate a millisecond precision reading of a monotonic clock
+    static size_t monotonic_millis();
     // Start timing
-    void start() { time = time_millis(); } 
+    void start() { time = monotonic_millis(); } 
     // Reset timing
-    void reset() { time = time_millis(); } 
+    void reset() { time = monotonic_millis(); } 
     // Check the total seconds from the start of timing to the current time
-    double elapsed() { return (time_millis() - time) / 1000.0; }
+    double elapsed() { return (monotonic_millis() - time) / 1000.0; }
 };
 
 /**
@@ -34,9 +38,22 @@ public:
  *
  * @return A millisecond precision timestamp
  */
-size_t Timer::time_millis()
+inline size_t Timer::time_millis()
 {
     using millis = std::chrono::milliseconds;
     using system_clock = std::chrono::system_clock;
     return std::chrono::duration_cast<millis>(system_clock::now().time_since_epoch()).count();
 }
+
+/**
+ * Generate a millisecond precision reading of a monotonic clock. Only the
+ * difference between two readings is meaningful.
+ *
+ * @return Milliseconds since an unspecified starting point
+ */
+inline size_t Timer::monotonic_millis()
+{
+    using millis = std::chrono::milliseconds;
+    using steady_clock = std::chrono::steady_clock;
+    return std::chrono::duration_cast<millis>(steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,204 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include "ArrayQueue.h"
+#include "ArrayStack.h"
+#include "Config.h"
+#include "Timer.h"
+#include "Vector.h"
+
+/**
+ * Hierarchical timing wheel: O(1) schedule, cancel and per-tick expiry for
+ * large numbers of timeouts.
+ *
+ * Time is counted in ticks of a fixed number of milliseconds. Four levels
+ * of 256 slots cover 2^32 ticks; a timer due within 256 ticks sits in a
+ * level-0 slot, a later one in the level whose slot width matches its
+ * distance. When the level-0 index wraps, the next slot of level 1 is
+ * cascaded: its timers are placed again, now into level 0 or level 1, and
+ * likewise up the levels. Timers further out than 2^32 ticks wait in the
+ * top level and are placed again each time they cascade. Stretches of ticks
+ * with the lower levels empty are skipped a slot of the first non-empty
+ * level at a time.
+ *
+ * Slots are ArrayQueues of (index, generation, expiry) references into a
+ * slab of timers. cancel() frees the slab entry at once and bumps its
+ * generation; the stale reference left in the slot is dropped when it
+ * reaches level 0 and expires. Cascading reads only the slot, not the slab,
+ * so it moves through memory sequentially.
+ *
+ * advance() and poll() collect every timer that expires into one batch and
+ * hand it to the callback in a single call.
+ */
+using TimerHandle = uint64_t;
+
+template<typename T>
+class TimingWheel {
+private:
+    static const int LEVELS = 4;
+    static const int BITS = 8;
+    static const uint64_t SLOTS = 1 << BITS;
+    static const uint64_t MASK = SLOTS - 1;
+
+    struct Entry {
+        T value;
+        uint32_t generation;
+        bool active;
+    };
+
+    struct Ref {
+        uint64_t handle;
+        uint64_t expiry;
+    };
+
+    Vector<Entry> entries;
+    ArrayStack<uint32_t> freeList;
+    ArrayQueue<Ref> slots[LEVELS][SLOTS];
+    Vector<T> expired;
+    size_t resolution;
+    size_t origin;
+    uint64_t cur;        // Next tick to process
+    int active;
+    size_t queued[LEVELS];    // References in each level, including stale ones
+
+    static uint64_t ref(uint32_t index, uint32_t generation) { return uint64_t(generation) << 32 | index; }
+    // Put a reference into the slot its expiry falls in, relative to cur
+    void place(Ref r);
+    void cascade(int level);
+    void expire(uint64_t tick);
+public:
+    explicit TimingWheel(size_t resolution = 1);
+
+    // Return the number of scheduled timers
+    int size() const { return active; }
+    bool isEmpty() const { return active == 0; }
+    // Return the last tick processed
+    uint64_t now() const { return cur - 1; }
+    // Run value's timer delay ticks from now(), at least one
+    TimerHandle schedule(uint64_t delay, const T& value);
+    // Stop a timer; false if it already expired or was cancelled
+    bool cancel(TimerHandle handle);
+    // Process every tick up to and including tick, then call f(expired)
+    template<typename F>
+    void advance(uint64_t tick, F f);
+    // advance() to the tick the monotonic clock is at
+    template<typename F>
+    void poll(F f) { advance((Timer::monotonic_millis() - origin) / resolution, f); }
+};
+
+template<typename T>
+TimingWheel<T>::TimingWheel(size_t resolution)
+    : entries(0), freeList(0), expired(0), resolution(resolution > 0 ? resolution : 1),
+      origin(Timer::monotonic_millis()), cur(1), active(0), queued() {}
+
+template<typename T>
+void TimingWheel<T>::place(Ref r) {
+    uint64_t expiry = r.expiry;
+    uint64_t distance = expiry > cur ? expiry - cur : 0;
+    int level = 0;
+    while (level < LEVELS - 1 && distance >= (uint64_t(1) << (BITS * (level + 1))))
+        ++level;
+    if (level == LEVELS - 1 && distance >= (uint64_t(1) << (BITS * LEVELS)))
+        expiry = cur + (uint64_t(1) << (BITS * LEVELS)) - 1;
+    else if (expiry < cur)
+        expiry = cur;
+    slots[level][(expiry >> (BITS * level)) & MASK].enqueue(r);
+    queued[level]++;
+}
+
+template<typename T>
+TimerHandle TimingWheel<T>::schedule(uint64_t delay, const T& value) {
+    uint32_t index;
+    if (freeList.tryPop(index)) {
+        entries[index].value = value;
+    } else {
+        if (entries.size() == INT32_MAX)
+            CPPLIB_THROW(std::out_of_range, "TimingWheel overflow.");
+        index = entries.size();
+        entries.insert_back(Entry{ value, 0, false });
+    }
+    Entry& e = entries[index];
+    e.active = true;
+    active++;
+    Ref r = { ref(index, e.generation), cur - 1 + (delay > 0 ? delay : 1) };
+    place(r);
+    return r.handle;
+}
+
+template<typename T>
+bool TimingWheel<T>::cancel(TimerHandle handle) {
+    uint32_t index = static_cast<uint32_t>(handle);
+    if (index >= static_cast<uint32_t>(entries.size()))
+        return false;
+    Entry& e = entries[index];
+    if (!e.active || e.generation != handle >> 32)
+        return false;
+    e.active = false;
+    e.generation++;
+    active--;
+    freeList.push(index);
+    return true;
+}
+
+template<typename T>
+void TimingWheel<T>::cascade(int level) {
+    ArrayQueue<Ref>& slot = slots[level][(cur >> (BITS * level)) & MASK];
+    Ref r;
+    for (int k = slot.size(); k > 0 && slot.tryDequeue(r); --k) {
+        queued[level]--;
+        place(r);
+    }
+}
+
+template<typename T>
+void TimingWheel<T>::expire(uint64_t tick) {
+    ArrayQueue<Ref>& slot = slots[0][tick & MASK];
+    Ref r;
+    while (slot.tryDequeue(r)) {
+        queued[0]--;
+        uint32_t index = static_cast<uint32_t>(r.handle);
+        Entry& e = entries[index];
+        if (!e.active || e.generation != r.handle >> 32)
+            continue;
+        expired.insert_back(e.value);
+        e.active = false;
+        e.generation++;
+        active--;
+        freeList.push(index);
+    }
+}
+
+template<typename T>
+template<typename F>
+void TimingWheel<T>::advance(uint64_t tick, F f) {
+    for (; cur <= tick; ++cur) {
+        // With levels below l empty, nothing happens before the next slot of level l
+        int l = 0;
+        while (l < LEVELS && queued[l] == 0)
+            ++l;
+        if (l == LEVELS) {
+            cur = tick + 1;
+            break;
+        }
+        if (l > 0) {
+            uint64_t width = uint64_t(1) << (BITS * l);
+            cur = (cur + width - 1) & ~(width - 1);
+            if (cur > tick) {
+                cur = tick + 1;
+                break;
+            }
+        }
+        // Cascade from the highest level whose slot starts at this tick
+        int top = 0;
+        while (top < LEVELS - 1 && (cur & ((uint64_t(1) << (BITS * (top + 1))) - 1)) == 0)
+            ++top;
+        for (int level = top; level > 0; --level)
+            cascade(level);
+        expire(cur);
+    }
+    if (!expired.empty()) {
+        f(static_cast<const Vector<T>&>(expired));
+        expired.clear();
+    }
+}
@@ -0,0 +1,187 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "Config.h"
+#include "MemoryResource.h"
+#include "StringView.h"
+
+/**
+ * Whitespace and line tokenizer over a file descriptor.
+ *
+ * Input is read in large blocks into one buffer and tokens are returned as
+ * StringViews into it, without locale handling or a std::string per token.
+ * A token that straddles two blocks is moved to the front of the buffer
+ * before the next block is read; the buffer doubles only for a token
+ * longer than itself.
+ *
+ * A view is valid until the next call to next() or nextLine(). Given a
+ * MonotonicArena, the tokenizer copies every token into it instead, and the
+ * views stay valid until the arena is released.
+ */
+class Tokenizer {
+private:
+    static const size_t DEFAULT_BLOCK = 1 << 20;
+
+    int fd;
+    bool owned;
+    bool eof;
+    MonotonicArena* arena;
+    std::unique_ptr<char[]> buf;
+    size_t cap;
+    size_t pos;
+    size_t len;
+
+    static bool isSpace(char c) { return c == ' ' || static_cast<unsigned char>(c - '\t') <= '\r' - '\t'; }
+    // Return the first p in [p, end) whose isSpace() equals space, or end
+    static const char* scan(const char* p, const char* end, bool space);
+    // Keep buf[start, len), move it to the front and read more; false at end of input
+    bool refill(size_t& start);
+    StringView emit(size_t start, size_t end);
+    // Tell the kernel fd is read sequentially, where supported
+    void advise();
+public:
+    explicit Tokenizer(const char* path, MonotonicArena* arena = nullptr, size_t block = DEFAULT_BLOCK);
+    explicit Tokenizer(int fd, MonotonicArena* arena = nullptr, size_t block = DEFAULT_BLOCK);
+    Tokenizer(const Tokenizer&) = delete;
+    Tokenizer& operator=(const Tokenizer&) = delete;
+    ~Tokenizer() { if (owned && fd >= 0) close(fd); }
+
+    bool isOpen() const { return fd >= 0; }
+    // Read the next whitespace-delimited token; false at end of input
+    bool next(StringView& token);
+    // Read the next line without its '\n' (or "\r\n"); false at end of input
+    bool nextLine(StringView& line);
+};
+
+inline Tokenizer::Tokenizer(const char* path, MonotonicArena* arena, size_t block)
+    : Tokenizer(-1, arena, block) {
+    // Open only once the buffer is allocated, so a failed allocation cannot leak the fd
+    fd = open(path, O_RDONLY);
+    owned = true;
+    eof = fd < 0;
+    advise();
+}
+
+inline Tokenizer::Tokenizer(int fd, MonotonicArena* arena, size_t block)
+    : fd(fd), owned(false), eof(fd < 0), arena(arena), buf(new char[block > 0 ? block : 1]),
+      cap(block > 0 ? block : 1), pos(0), len(0) {
+    advise();
+}
+
+inline void Tokenizer::advise() {
+#ifdef POSIX_FADV_SEQUENTIAL
+    if (fd >= 0)
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+}
+
+inline bool Tokenizer::refill(size_t& start) {
+    if (eof)
+        return false;
+    size_t keep = len - start;
+    if (keep == cap) {
+        std::unique_ptr<char[]> bigger(new char[2 * cap]);
+        std::memcpy(bigger.get(), buf.get() + start, keep);
+        buf.swap(bigger);
+        cap *= 2;
+    } else if (start > 0) {
+        std::memmove(buf.get(), buf.get() + start, keep);
+    }
+    pos -= start;
+    len = keep;
+    start = 0;
+    for (;;) {
+        ssize_t got = read(fd, buf.get() + len, cap - len);
+        if (got > 0) {
+            len += got;
+            return true;
+        }
+        if (got == 0) {
+            eof = true;
+            return false;
+        }
+        if (errno != EINTR)
+            CPPLIB_THROW(std::runtime_error, (std::string("Tokenizer read error: ") + std::strerror(errno)).c_str());
+    }
+}
+
+inline const char* Tokenizer::scan(const char* p, const char* end, bool space) {
+#ifdef __SSE2__
+    // 16 bytes at a time: a mask bit is set for each whitespace byte
+    const __m128i blank = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i range = _mm_set1_epi8('\r' - '\t');
+    unsigned flip = space ? 0 : 0xFFFF;
+    for (; end - p >= 16; p += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i ctl = _mm_sub_epi8(x, tab);
+        __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(x, blank), _mm_cmpeq_epi8(_mm_min_epu8(ctl, range), ctl));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(ws)) ^ flip;
+        if (mask != 0)
+            return p + __builtin_ctz(mask);
+    }
+#endif
+    while (p < end && isSpace(*p) != space)
+        ++p;
+    return p;
+}
+
+inline StringView Tokenizer::emit(size_t start, size_t end) {
+    size_t n = end - start;
+    if (arena == nullptr)
+        return StringView(buf.get() + start, n);
+    char* copy = static_cast<char*>(arena->allocate(n > 0 ? n : 1, 1));
+    std::memcpy(copy, buf.get() + start, n);
+    return StringView(copy, n);
+}
+
+inline bool Tokenizer::next(StringView& token) {
+    for (;;) {
+        pos = scan(buf.get() + pos, buf.get() + len, false) - buf.get();
+        if (pos < len)
+            break;
+        size_t start = len;
+        if (!refill(start))
+            return false;
+    }
+    size_t start = pos;
+    for (;;) {
+        pos = scan(buf.get() + pos, buf.get() + len, true) - buf.get();
+        if (pos < len || !refill(start))
+            break;
+    }
+    token = emit(start, pos);
+    return true;
+}
+
+inline bool Tokenizer::nextLine(StringView& line) {
+    if (pos == len) {
+        size_t start = len;
+        if (!refill(start))
+            return false;
+    }
+    size_t start = pos;
+    const char* nl;
+    for (;;) {
+        nl = static_cast<const char*>(std::memchr(buf.get() + pos, '\n', len - pos));
+        if (nl != nullptr)
+            break;
+        pos = len;
+        if (!refill(start))
+            break;
+    }
+    size_t end = nl != nullptr ? nl - buf.get() : len;
+    pos = nl != nullptr ? end + 1 : len;
+    if (end > start && buf[end - 1] == '\r')
+        --end;
+    line = emit(start, end);
+    return true;
+}
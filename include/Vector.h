@@ -1,17 +1,31 @@
 #pragma once
 #include <cassert>
+#include <functional>
 #include <iostream>
 #include <iterator>
+#include <memory>
+#include <type_traits>
+#include "Config.h"
+#include "ContainerStats.h"
+#include "Expected.h"
+#include "MemoryResource.h"
+#include "Simd.h"
+
+template<typename L, typename R>
+class VectorConcat;
 
 /**
 * Vector implemented using templates.
 * Vector stored by dynamic contiguous array.
 * Random access iterator for Vector implemented.
+* Storage is obtained from Alloc; elements are constructed only when added.
  */
-template<typename E>
-class Vector
+template<typename E, typename Alloc = std::allocator<E>>
+class Vector : private StatsHook, private AllocHolder<Alloc>
 {
     static const int DEFAULT_CAPACITY = 10; // Default capacity of Vector.
+    using AllocTraits = std::allocator_traits<Alloc>;
+    using AllocHolder<Alloc>::alloc;
 
     // Raw pointers have all the characteristics of random access iterators.
     using iterator = E*;
@@ -23,13 +37,34 @@ private:
 
     // Expand Vector to specified capacity.
     void reserve(int count);
+    // Make room for count elements, growing capacity geometrically.
+    void grow(int count);
+    template<typename InputIt>
+    void append(InputIt first, InputIt last, std::input_iterator_tag);
+    template<typename ForwardIt>
+    void append(ForwardIt first, ForwardIt last, std::forward_iterator_tag);
     // Check if index is valid.
     bool valid(int i) const { return i >= 0 && i < n; }
+    // Return the index of the element p points to, or -1 if p is not in this Vector.
+    template<typename T>
+    int indexOf(T* p) const;
+    template<typename It>
+    int indexOf(const It&) const { return -1; }
 public:
-    explicit Vector(int count = DEFAULT_CAPACITY);
+    using value_type = E;
+    using allocator_type = Alloc;
+    using StatsHook::setStatsCategory;
+#ifdef CPPLIB_STATS
+    using StatsHook::stats;
+#endif
+
+    explicit Vector(int count = DEFAULT_CAPACITY, const Alloc& alloc = Alloc());
+    explicit Vector(const Alloc& alloc) : Vector(DEFAULT_CAPACITY, alloc) {}
     Vector(const Vector& that);
     Vector(Vector&& that) noexcept;
-    ~Vector() { delete[] pv; }
+    template<typename L, typename R>
+    Vector(const VectorConcat<L, R>& expr);
+    ~Vector();
 
     // Return the number of elements in the Vector
     int size() const { return n; }
@@ -41,6 +76,13 @@ public:
     void insert(iterator pos, E elem);
     // Add an element to the end of the Vector
     void insert_back(E elem);
+    // Add the elements of [first, last) to the end of the Vector; the range may
+    // be elements of this Vector given by its own iterators
+    template<typename InputIt>
+    void append(InputIt first, InputIt last);
+    // Add the elements of a range (anything with begin() and end()) to the end of the Vector
+    template<typename Range>
+    void append_range(const Range& range) { append(std::begin(range), std::end(range)); }
     // Remove the element at the specified position
     void remove(iterator pos);
     // Remove the last element of the Vector
@@ -49,6 +91,8 @@ public:
     E& at(int i) { return const_cast<E&>(static_cast<const Vector&>(*this).at(i)); }
     // Return a const reference to the element at the specified position, with bounds checking
     const E& at(int i) const;
+    // Return a copy of the element at the specified position, or Error::OUT_OF_RANGE
+    Expected<E> try_at(int i) const;
     // Return a reference to the first element of the Vector
     E& front() { return const_cast<E&>(static_cast<const Vector&>(*this).front()); }
     // Return a const reference to the first element of the Vector
@@ -60,7 +104,9 @@ public:
     // Swap two Vector objects
     void swap(Vector& that);
     // Clear all elements in the Vector
-    void clear() { n = 0; }
+    void clear();
+    // Return a copy of the allocator of the Vector
+    allocator_type get_allocator() const { return alloc(); }
 
     //  [] operator overloading
     E& operator[](int i) { return const_cast<E&>(static_cast<const Vector&>(*this)[i]); }
@@ -68,14 +114,14 @@ public:
     const E& operator[](int i) const;
     Vector& operator=(Vector that);
     Vector& operator+=(const Vector& that);
-    template<typename T>
-    friend Vector<T> operator+(Vector<T> lhs, const Vector<T>& rhs);
-    template <typename T>
-    friend bool operator==(const Vector<T>& lhs, const Vector<T>& rhs);
-    template <typename T>
-    friend bool operator!=(const Vector<T>& lhs, const Vector<T>& rhs);
-    template<typename T>
-    friend std::ostream& operator<<(std::ostream& os, const Vector<T>& vector);
+    template<typename L, typename R>
+    Vector& operator+=(const VectorConcat<L, R>& expr);
+    template <typename T, typename A>
+    friend bool operator==(const Vector<T, A>& lhs, const Vector<T, A>& rhs);
+    template <typename T, typename A>
+    friend bool operator!=(const Vector<T, A>& lhs, const Vector<T, A>& rhs);
+    template<typename T, typename A>
+    friend std::ostream& operator<<(std::ostream& os, const Vector<T, A>& vector);
 
     iterator begin() { return pv; }
     iterator end() { return pv + n; }
@@ -86,99 +132,210 @@ public:
 /**
  * @param count: 
  */
-template<typename E>
-Vector<E>::Vector(int count)
+template<typename E, typename Alloc>
+Vector<E, Alloc>::Vector(int count, const Alloc& alloc) : StatsHook("Vector"), AllocHolder<Alloc>(alloc)
 {
     n = 0;
     N = count;
-    pv = new E[N]();
+    pv = N > 0 ? AllocTraits::allocate(this->alloc(), N) : nullptr;
+    statsAllocate(N * sizeof(E));
+    statsCapacity(N);
 }
 
 /**
  * @param that:
  */
-template<typename E>
-Vector<E>::Vector(const Vector& that)
+template<typename E, typename Alloc>
+Vector<E, Alloc>::Vector(const Vector& that)
+    : StatsHook(that), AllocHolder<Alloc>(AllocTraits::select_on_container_copy_construction(that.alloc()))
 {
-    n = that.n;
+    n = 0;
     N = that.N;
-    pv = new E[N];
-    std::copy(that.begin(), that.end(), begin());
+    pv = N > 0 ? AllocTraits::allocate(alloc(), N) : nullptr;
+    for (; n < that.n; ++n)
+        AllocTraits::construct(alloc(), pv + n, that.pv[n]);
+    statsAllocate(N * sizeof(E));
+    statsCapacity(N);
+    statsSize(n);
 }
 
 /**
  * @param that: 
  */
-template<typename E>
-Vector<E>::Vector(Vector&& that) noexcept
+template<typename E, typename Alloc>
+Vector<E, Alloc>::Vector(Vector&& that) noexcept
+    : StatsHook(that), AllocHolder<Alloc>(std::move(that.alloc()))
 {
     n = that.n;
     N = that.N;
     pv = that.pv;
+    that.n = 0;
+    that.N = 0;
     that.pv = nullptr; 
 }
 
+/**
+ * Build the result of a chain of + in one allocation and one pass.
+ *
+ * @param expr: Concatenation of Vectors
+ */
+template<typename E, typename Alloc>
+template<typename L, typename R>
+Vector<E, Alloc>::Vector(const VectorConcat<L, R>& expr)
+    : Vector(expr.size(), AllocTraits::select_on_container_copy_construction(expr.get_allocator()))
+{
+    expr.construct(alloc(), pv);
+    n = expr.size();
+    statsSize(n);
+}
+
+template<typename E, typename Alloc>
+Vector<E, Alloc>::~Vector()
+{
+    clear();
+    if (pv != nullptr)
+        AllocTraits::deallocate(alloc(), pv, N);
+}
+
 /**
  * @param size: 
  */
-template<typename E>
-void Vector<E>::reserve(int count)
+template<typename E, typename Alloc>
+void Vector<E, Alloc>::reserve(int count)
 {
     assert(count >= size());
 
-    Vector tmp(count);
+    if (count < N && allocCanShrink(alloc(), N, count))
+    {
+        statsResize(N, count, 0, 0);
+        allocShrink(alloc(), pv, N, count);
+        N = count;
+        return;
+    }
 
-    std::move(begin(), end(), tmp.begin());
-    tmp.n = n; 
-    swap(tmp); 
+    E* pnew = AllocTraits::allocate(alloc(), count);
+    for (int i = 0; i < n; ++i)
+    {
+        AllocTraits::construct(alloc(), pnew + i, std::move(pv[i]));
+        AllocTraits::destroy(alloc(), pv + i);
+    }
+    if (pv != nullptr)
+        AllocTraits::deallocate(alloc(), pv, N);
+    statsResize(N, count, n, count * sizeof(E));
+    pv = pnew;
+    N = count;
+}
+
+/**
+ * @param count: Number of elements the Vector must be able to hold
+ */
+template<typename E, typename Alloc>
+void Vector<E, Alloc>::grow(int count)
+{
+    if (count > N)
+        reserve(count > 2 * N ? count : 2 * N);
 }
 
 /**
  * @param i: 
  * @throws 
  */
-template<typename E>
-void Vector<E>::insert(iterator pos, E elem)
+template<typename E, typename Alloc>
+void Vector<E, Alloc>::insert(iterator pos, E elem)
 {
+    int i = static_cast<int>(pos - begin());
     if (i == n)
-        insert_back(elem);
+        insert_back(std::move(elem));
     else if (!valid(i))
-        throw std::out_of_range("Vector::insert() i out of range.");
+        CPPLIB_THROW(std::out_of_range, "Vector::insert() i out of range.");
     else
     {
         if (n == N) reserve(N * 2);
-        std::move_backward(std::next(begin(), i), end(),
-                           std::next(begin(), n + 1));
+        AllocTraits::construct(alloc(), pv + n, std::move(pv[n - 1]));
+        std::move_backward(std::next(begin(), i), std::prev(end()),
+                           end());
         (*this)[i] = std::move(elem);
         n++;
+        statsSize(n);
     }
 }
 
 /**
  * @param elem: 
  */
-template<typename E>
-void Vector<E>::insert_back(E elem)
+template<typename E, typename Alloc>
+void Vector<E, Alloc>::insert_back(E elem)
 {
     if (n == N)
-        reserve(N * 2);
-    (*this)[n++] = std::move(elem);
+        reserve(N > 0 ? N * 2 : 1);
+    AllocTraits::construct(alloc(), pv + n, std::move(elem));
+    n++;
+    statsSize(n);
+}
+
+/**
+ * @param first: Beginning of the range to append
+ * @param last: End of the range to append
+ */
+template<typename E, typename Alloc>
+template<typename InputIt>
+void Vector<E, Alloc>::append(InputIt first, InputIt last)
+{
+    append(first, last, typename std::iterator_traits<InputIt>::iterator_category());
+}
+
+template<typename E, typename Alloc>
+template<typename InputIt>
+void Vector<E, Alloc>::append(InputIt first, InputIt last, std::input_iterator_tag)
+{
+    for (; first != last; ++first)
+        insert_back(*first);
+}
+
+template<typename E, typename Alloc>
+template<typename ForwardIt>
+void Vector<E, Alloc>::append(ForwardIt first, ForwardIt last, std::forward_iterator_tag)
+{
+    int count = static_cast<int>(std::distance(first, last));
+    int i = indexOf(first);
+    grow(n + count);
+    if (i >= 0)
+    {
+        // The range is in this Vector, and grow() may have moved it: index it instead
+        for (int k = 0; k < count; ++k, ++n)
+            AllocTraits::construct(alloc(), pv + n, pv[i + k]);
+    }
+    else
+    {
+        for (; first != last; ++first)
+            AllocTraits::construct(alloc(), pv + n++, *first);
+    }
+    statsSize(n);
+}
+
+template<typename E, typename Alloc>
+template<typename T>
+int Vector<E, Alloc>::indexOf(T* p) const
+{
+    std::less<const E*> less;
+    return !less(p, pv) && less(p, pv + n) ? static_cast<int>(p - pv) : -1;
 }
 
 /**
  * @param i: 
  * @throws 
  */
-template<typename E>
-void Vector<E>::remove(iterator pos)
+template<typename E, typename Alloc>
+void Vector<E, Alloc>::remove(iterator pos)
 {
+    int i = static_cast<int>(pos - begin());
     if (i == n - 1)
         return remove_back();
     if (!valid(i))
-        throw std::out_of_range("Vector::remove() i out of range.");
+        CPPLIB_THROW(std::out_of_range, "Vector::remove() i out of range.");
     std::move(std::next(begin(), i + 1), end(),
               std::next(begin(), i));
-    n--;
+    AllocTraits::destroy(alloc(), pv + --n);
     if (n > 0 && n == N / 4)
         reserve(N / 2);
 }
@@ -186,12 +343,13 @@ void Vector<E>::remove(iterator pos)
 /**
  * @throws 
  */
-template<typename E>
-void Vector<E>::remove_back()
+template<typename E, typename Alloc>
+void Vector<E, Alloc>::remove_back()
 {
     if (empty())
-        throw std::out_of_range("Vector::remove_back");
+        CPPLIB_THROW(std::out_of_range, "Vector::remove_back");
 
+    AllocTraits::destroy(alloc(), pv + --n);
     if (n > 0 && n == N / 4)
         reserve(N / 2);
 }
@@ -200,11 +358,11 @@ void Vector<E>::remove_back()
  * @return 
  * @throws 
  */
-template<typename E>
-const E& Vector<E>::front() const
+template<typename E, typename Alloc>
+const E& Vector<E, Alloc>::front() const
 {
     if (empty())
-        throw std::out_of_range("Vector::front");
+        CPPLIB_THROW(std::out_of_range, "Vector::front");
     return *begin();
 }
 
@@ -212,11 +370,11 @@ const E& Vector<E>::front() const
  * @return 
  * @throws 
  */
-template<typename E>
-const E& Vector<E>::back() const
+template<typename E, typename Alloc>
+const E& Vector<E, Alloc>::back() const
 {
     if (empty())
-        throw std::out_of_range("Vector::back");
+        CPPLIB_THROW(std::out_of_range, "Vector::back");
     return *std::prev(end());
 }
 
@@ -225,11 +383,23 @@ const E& Vector<E>::back() const
  * @return 
  * @throws 
  */
-template<typename E>
-const E& Vector<E>::at(int i) const
+template<typename E, typename Alloc>
+const E& Vector<E, Alloc>::at(int i) const
 {
     if (!valid(i))
-        throw std::out_of_range("Vector::at");
+        CPPLIB_THROW(std::out_of_range, "Vector::at");
+    return (*this)[i];
+}
+
+/**
+ * @param i: Index
+ * @return Copy of the element at index i, or Error::OUT_OF_RANGE
+ */
+template<typename E, typename Alloc>
+Expected<E> Vector<E, Alloc>::try_at(int i) const
+{
+    if (!valid(i))
+        return Error::OUT_OF_RANGE;
     return (*this)[i];
 }
 
@@ -237,22 +407,32 @@ const E& Vector<E>::at(int i) const
 
  * @param that: 
  */
-template<typename E>
-void Vector<E>::swap(Vector<E>& that)
+template<typename E, typename Alloc>
+void Vector<E, Alloc>::swap(Vector<E, Alloc>& that)
 {
     using std::swap;
+    swapStats(that);
+    swap(alloc(), that.alloc());
     swap(n, that.n);
     swap(N, that.N);
     swap(pv, that.pv);
 }
 
+template<typename E, typename Alloc>
+void Vector<E, Alloc>::clear()
+{
+    for (int i = 0; i < n; ++i)
+        AllocTraits::destroy(alloc(), pv + i);
+    n = 0;
+}
+
 /**
  
  * @param i: 
  * @return 
  */
-template<typename E>
-const E& Vector<E>::operator[](int i) const
+template<typename E, typename Alloc>
+const E& Vector<E, Alloc>::operator[](int i) const
 {
     return *std::next(begin(), i);
 }
@@ -261,8 +441,8 @@ const E& Vector<E>::operator[](int i) const
  * @param that: 
  * @return
  */
-template<typename E>
-Vector<E>& Vector<E>::operator=(Vector<E> that)
+template<typename E, typename Alloc>
+Vector<E, Alloc>& Vector<E, Alloc>::operator=(Vector<E, Alloc> that)
 {
     swap(that);
     return *this;
@@ -272,25 +452,149 @@ Vector<E>& Vector<E>::operator=(Vector<E> that)
  * @param that: 
  * @return 
  */
-template<typename E>
-Vector<E>& Vector<E>::operator+=(const Vector<E>& that)
+template<typename E, typename Alloc>
+Vector<E, Alloc>& Vector<E, Alloc>::operator+=(const Vector<E, Alloc>& that)
 {
-    reserve(N + that.N);
-    std::copy(that.begin(), that.end(), end());
-    n += that.n;
+    // Index rather than iterate: that may be *this, whose buffer grow() moves
+    int count = that.n;
+    grow(n + count);
+    for (int i = 0; i < count; ++i)
+        AllocTraits::construct(alloc(), pv + n + i, that.pv[i]);
+    n += count;
+    statsSize(n);
     return *this;
 }
 
 /**
- * @param lhs: 
- *        
+ * @param expr: Concatenation of Vectors, which may include *this
  * @return 
  */
-template<typename E>
-Vector<E> operator+(Vector<E> lhs, const Vector<E>& rhs)
+template<typename E, typename Alloc>
+template<typename L, typename R>
+Vector<E, Alloc>& Vector<E, Alloc>::operator+=(const VectorConcat<L, R>& expr)
+{
+    int count = expr.size();
+    grow(n + count);
+    expr.construct(alloc(), pv + n);
+    n += count;
+    statsSize(n);
+    return *this;
+}
+
+/**
+ * Lazy concatenation built by concat(). concat(a, b, c, d) computes the
+ * total size first, then the Vector it converts to (or appends to with +=)
+ * allocates once and copies every operand in one pass.
+ *
+ * Operand Vectors are held by reference, so an expression must not outlive
+ * them: convert it to a Vector within the same full-expression, or keep it
+ * only while its operands are alive. operator+ returns a Vector and has no
+ * such restriction.
+ */
+template<typename T>
+struct ConcatOperand { using type = const T&; };
+template<typename L, typename R>
+struct ConcatOperand<VectorConcat<L, R>> { using type = VectorConcat<L, R>; };
+
+template<typename L, typename R>
+class VectorConcat
+{
+    typename ConcatOperand<L>::type lhs;
+    typename ConcatOperand<R>::type rhs;
+
+    template<typename A, typename E, typename T, typename B>
+    static E* constructFrom(A& alloc, E* p, const Vector<T, B>& v);
+    template<typename A, typename E, typename X, typename Y>
+    static E* constructFrom(A& alloc, E* p, const VectorConcat<X, Y>& expr) { return expr.construct(alloc, p); }
+public:
+    using value_type = typename L::value_type;
+    using allocator_type = typename L::allocator_type;
+    static_assert(std::is_same<value_type, typename R::value_type>::value,
+                  "Concatenated Vectors must have the same element type.");
+
+    VectorConcat(const L& lhs, const R& rhs) : lhs(lhs), rhs(rhs) {}
+
+    // Return the number of elements of the result
+    int size() const { return lhs.size() + rhs.size(); }
+    // Return the allocator of the leftmost operand
+    allocator_type get_allocator() const { return lhs.get_allocator(); }
+    // Copy-construct every element into raw storage at p, return the end
+    template<typename A>
+    value_type* construct(A& alloc, value_type* p) const { return constructFrom(alloc, constructFrom(alloc, p, lhs), rhs); }
+};
+
+template<typename L, typename R>
+template<typename A, typename E, typename T, typename B>
+E* VectorConcat<L, R>::constructFrom(A& alloc, E* p, const Vector<T, B>& v)
+{
+    for (const T& elem : v)
+        std::allocator_traits<A>::construct(alloc, p++, elem);
+    return p;
+}
+
+template<typename T>
+struct IsConcatOperand : std::false_type {};
+template<typename E, typename Alloc>
+struct IsConcatOperand<Vector<E, Alloc>> : std::true_type {};
+template<typename L, typename R>
+struct IsConcatOperand<VectorConcat<L, R>> : std::true_type {};
+
+template<typename... Ts>
+struct ConcatResult;
+template<typename L, typename R>
+struct ConcatResult<L, R> { using type = VectorConcat<L, R>; };
+template<typename L, typename R, typename M, typename... Rest>
+struct ConcatResult<L, R, M, Rest...> : ConcatResult<VectorConcat<L, R>, M, Rest...> {};
+
+/**
+ * @param lhs: Vector or concatenation
+ * @param rhs: Vector or concatenation
+ * @return Lazy concatenation of lhs and rhs
+ */
+template<typename L, typename R>
+typename std::enable_if<IsConcatOperand<L>::value && IsConcatOperand<R>::value, VectorConcat<L, R>>::type
+concat(const L& lhs, const R& rhs)
+{
+    return VectorConcat<L, R>(lhs, rhs);
+}
+
+/**
+ * @param a: Vector or concatenation
+ * @param b: Vector or concatenation
+ * @param c: Vector or concatenation
+ * @param rest: More Vectors or concatenations
+ * @return Lazy concatenation of all operands, left to right
+ */
+template<typename L, typename R, typename M, typename... Rest>
+typename ConcatResult<L, R, M, Rest...>::type
+concat(const L& a, const R& b, const M& c, const Rest&... rest)
+{
+    return concat(concat(a, b), c, rest...);
+}
+
+/**
+ * @param lhs: First Vector
+ * @param rhs: Second Vector
+ * @return New Vector holding the elements of lhs followed by those of rhs
+ */
+template<typename E, typename Alloc>
+Vector<E, Alloc> operator+(const Vector<E, Alloc>& lhs, const Vector<E, Alloc>& rhs)
+{
+    return Vector<E, Alloc>(concat(lhs, rhs));
+}
+
+/**
+ * Appends to a temporary lhs in place, so a + b + c + d reuses one growing
+ * buffer instead of copying the accumulated prefix at every step.
+ * @param lhs: First Vector, a temporary
+ * @param rhs: Second Vector
+ * @return lhs with the elements of rhs appended
+ */
+template<typename E, typename Alloc>
+Vector<E, Alloc> operator+(Vector<E, Alloc>&& lhs, const Vector<E, Alloc>& rhs)
 {
     lhs += rhs;
-    return lhs;
+    return std::move(lhs);
 }
 
 /**
@@ -298,12 +602,12 @@ Vector<E> operator+(Vector<E> lhs, const Vector<E>& rhs)
  * @return 
  *         
  */
-template<typename E>
-bool operator==(const Vector<E>& lhs, const Vector<E>& rhs)
+template<typename E, typename Alloc>
+bool operator==(const Vector<E, Alloc>& lhs, const Vector<E, Alloc>& rhs)
 {
     if (&lhs == &rhs)             return true;
     if (lhs.size() != rhs.size()) return false;
-    return std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    return simdEqual(lhs.begin(), rhs.begin(), lhs.size());
 }
 
 /**
@@ -313,8 +617,8 @@ bool operator==(const Vector<E>& lhs, const Vector<E>& rhs)
  * @return 
  *         
  */
-template<typename E>
-bool operator!=(const Vector<E>& lhs, const Vector<E>& rhs)
+template<typename E, typename Alloc>
+bool operator!=(const Vector<E, Alloc>& lhs, const Vector<E, Alloc>& rhs)
 {
     return !(lhs == rhs);
 }
@@ -325,8 +629,8 @@ bool operator!=(const Vector<E>& lhs, const Vector<E>& rhs)
  *        
  * @return 
  */
-template<typename E>
-std::ostream& operator<<(std::ostream& os, const Vector<E>& vector)
+template<typename E, typename Alloc>
+std::ostream& operator<<(std::ostream& os, const Vector<E, Alloc>& vector)
 {
     for (auto i : vector)
         os << i << " ";
@@ -337,8 +641,8 @@ std::ostream& operator<<(std::ostream& os, const Vector<E>& vector)
  * @param lhs: 
  *        
  */
-template<typename E>
-void swap(Vector<E>& lhs, Vector<E>& rhs)
+template<typename E, typename Alloc>
+void swap(Vector<E, Alloc>& lhs, Vector<E, Alloc>& rhs)
 {
     lhs.swap(rhs);
 }
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "Config.h"
+#include "Simd.h"
+#include "Vector.h"
+
+/**
+ * Scans over Vector elements: vectorFind, vectorCount, vectorMin, vectorMax,
+ * vectorMinmax, vectorSum, vectorEqual, vectorFill and vectorTransform. The
+ * prefix keeps them apart from the std algorithms under using namespace std.
+ * Arithmetic element types run the vectorized kernels of Simd.h; other types
+ * fall back to scalar loops.
+ */
+
+// Non-deduced parameter type, so vectorFind(v, 0) works for a Vector<double>
+template<typename E>
+using SimdArg = typename std::common_type<E>::type;
+
+// Return the index of the first element equal to x, or -1
+template<typename E, typename Alloc>
+int vectorFind(const Vector<E, Alloc>& v, const SimdArg<E>& x)
+{
+    size_t i = simdFind(v.begin(), v.size(), x);
+    return i == size_t(v.size()) ? -1 : static_cast<int>(i);
+}
+
+// Return the number of elements equal to x
+template<typename E, typename Alloc>
+int vectorCount(const Vector<E, Alloc>& v, const SimdArg<E>& x)
+{
+    return static_cast<int>(simdCount(v.begin(), v.size(), x));
+}
+
+// Return the smallest and the largest element
+template<typename E, typename Alloc>
+std::pair<E, E> vectorMinmax(const Vector<E, Alloc>& v)
+{
+    if (v.empty())
+        CPPLIB_THROW(std::out_of_range, "vectorMinmax");
+    std::pair<E, E> r;
+    simdMinmax(v.begin(), v.size(), r.first, r.second);
+    return r;
+}
+
+// Return the smallest element
+template<typename E, typename Alloc>
+E vectorMin(const Vector<E, Alloc>& v)
+{
+    return vectorMinmax(v).first;
+}
+
+// Return the largest element
+template<typename E, typename Alloc>
+E vectorMax(const Vector<E, Alloc>& v)
+{
+    return vectorMinmax(v).second;
+}
+
+// Return the sum of the elements, accumulated in E
+template<typename E, typename Alloc>
+E vectorSum(const Vector<E, Alloc>& v)
+{
+    return simdSum(v.begin(), v.size());
+}
+
+// Check if two Vectors hold equal elements
+template<typename E, typename Alloc>
+bool vectorEqual(const Vector<E, Alloc>& lhs, const Vector<E, Alloc>& rhs)
+{
+    return lhs.size() == rhs.size() && simdEqual(lhs.begin(), rhs.begin(), lhs.size());
+}
+
+// Assign x to every element
+template<typename E, typename Alloc>
+void vectorFill(Vector<E, Alloc>& v, const SimdArg<E>& x)
+{
+    simdFill(v.begin(), v.size(), x);
+}
+
+// Replace every element e with op(e), one element at a time
+template<typename E, typename Alloc, typename Op>
+void vectorTransform(Vector<E, Alloc>& v, Op op)
+{
+    simdTransform(v.begin(), v.begin(), v.size(), op);
+}
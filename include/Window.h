@@ -0,0 +1,196 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include "ArrayQueue.h"
+#include "ArrayStack.h"
+#include "Config.h"
+#include "Timer.h"
+
+/**
+ * Sliding-window aggregates over event streams, in O(1) amortized time per
+ * event instead of rescanning the window.
+ *
+ *   - MonotonicWindow: ArrayQueue kept in monotonic order, so its front is
+ *                      the minimum (or maximum) of the window
+ *   - AggregateWindow: queue made of two ArrayStacks, each element carrying
+ *                      the running aggregate of an associative operation
+ *                      (sum, min, gcd, matrix product, ...)
+ *
+ * A window is bounded either by count (the last span events) or by time
+ * (events stamped within the last span milliseconds). Events are stamped
+ * with Timer::monotonic_millis(), a steady clock that clock adjustments do
+ * not move, unless the caller passes its own timestamps, which must not
+ * decrease either.
+ */
+enum class WindowBy { COUNT, TIME };
+
+/**
+ * Sliding minimum under Compare: value() is the element e of the window for
+ * which compare(x, e) is false for every other x. With std::greater it is the
+ * sliding maximum.
+ */
+template<typename E, typename Compare = std::less<E>, typename Alloc = std::allocator<E>>
+class MonotonicWindow {
+private:
+    struct Entry {
+        E value;
+        size_t stamp;
+        Entry(const E& value, size_t stamp) : value(value), stamp(stamp) {}
+    };
+    using EntryAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Entry>;
+
+    ArrayQueue<Entry, EntryAlloc> queue;
+    Compare compare;
+    WindowBy by;
+    size_t span;
+    size_t seq;
+
+    // Drop entries whose stamp is at least span behind clock
+    void evict(size_t clock);
+public:
+    using allocator_type = Alloc;
+
+    MonotonicWindow(WindowBy by, size_t span, const Compare& compare = Compare(), const Alloc& alloc = Alloc())
+        : queue(EntryAlloc(alloc)), compare(compare), by(by), span(span), seq(0) {}
+
+    bool isEmpty() const { return queue.isEmpty(); }
+    void push(const E& elem) { push(elem, by == WindowBy::TIME ? Timer::monotonic_millis() : 0); }
+    void push(const E& elem, size_t time);
+    void advance(size_t time);
+    const E& value() const;
+    void clear() { queue.clear(); }
+    allocator_type get_allocator() const { return queue.get_allocator(); }
+};
+
+template<typename E, typename Alloc = std::allocator<E>>
+using MinWindow = MonotonicWindow<E, std::less<E>, Alloc>;
+template<typename E, typename Alloc = std::allocator<E>>
+using MaxWindow = MonotonicWindow<E, std::greater<E>, Alloc>;
+
+template<typename E, typename Compare, typename Alloc>
+void MonotonicWindow<E, Compare, Alloc>::evict(size_t clock) {
+    while (!queue.isEmpty() && queue.front().stamp + span <= clock)
+        queue.dequeue();
+}
+
+// Add an event; time is ignored by count windows.
+template<typename E, typename Compare, typename Alloc>
+void MonotonicWindow<E, Compare, Alloc>::push(const E& elem, size_t time) {
+    size_t stamp = by == WindowBy::COUNT ? seq++ : time;
+    // Entries no better than elem can never be the answer again
+    while (!queue.isEmpty() && !compare(queue.back().value, elem))
+        queue.popBack();
+    queue.emplace(elem, stamp);
+    evict(stamp);
+}
+
+// Evict events older than span milliseconds before time, without adding one.
+template<typename E, typename Compare, typename Alloc>
+void MonotonicWindow<E, Compare, Alloc>::advance(size_t time) {
+    if (by == WindowBy::TIME)
+        evict(time);
+}
+
+template<typename E, typename Compare, typename Alloc>
+const E& MonotonicWindow<E, Compare, Alloc>::value() const {
+    if (queue.isEmpty())
+        CPPLIB_THROW(std::out_of_range, "Window underflow.");
+    return queue.front().value;
+}
+
+/**
+ * Sliding aggregate of an associative operation op, combined from the
+ * oldest to the newest event, so op need not be commutative.
+ *
+ * New events go on the back stack with the aggregate of the back stack so
+ * far. When the front stack runs out, the back stack is popped onto it,
+ * each element taking the aggregate of itself and everything newer on the
+ * front stack. The window aggregate is op(front.top(), back.top()).
+ */
+template<typename E, typename Op = std::plus<E>, typename Alloc = std::allocator<E>>
+class AggregateWindow {
+private:
+    struct Entry {
+        E value;
+        E agg;
+        size_t stamp;
+        Entry(const E& value, const E& agg, size_t stamp) : value(value), agg(agg), stamp(stamp) {}
+    };
+    using EntryAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Entry>;
+
+    ArrayStack<Entry, EntryAlloc> front;
+    ArrayStack<Entry, EntryAlloc> back;
+    Op op;
+    WindowBy by;
+    size_t span;
+    size_t seq;
+
+    const Entry& oldest() const { return front.isEmpty() ? *back.begin() : front.top(); }
+    void popOldest();
+    void evict(size_t clock);
+public:
+    using allocator_type = Alloc;
+
+    AggregateWindow(WindowBy by, size_t span, const Op& op = Op(), const Alloc& alloc = Alloc())
+        : front(EntryAlloc(alloc)), back(EntryAlloc(alloc)), op(op), by(by), span(span), seq(0) {}
+
+    int size() const { return front.size() + back.size(); }
+    bool isEmpty() const { return size() == 0; }
+    void push(const E& elem) { push(elem, by == WindowBy::TIME ? Timer::monotonic_millis() : 0); }
+    void push(const E& elem, size_t time);
+    void advance(size_t time);
+    E value() const;
+    void clear() { front.clear(); back.clear(); }
+    allocator_type get_allocator() const { return front.get_allocator(); }
+};
+
+template<typename E, typename Op, typename Alloc>
+void AggregateWindow<E, Op, Alloc>::popOldest() {
+    if (front.isEmpty()) {
+        while (!back.isEmpty()) {
+            Entry e = back.pop();
+            if (front.isEmpty())
+                front.emplace(e.value, e.value, e.stamp);
+            else
+                front.emplace(e.value, op(e.value, front.top().agg), e.stamp);
+        }
+    }
+    front.pop();
+}
+
+template<typename E, typename Op, typename Alloc>
+void AggregateWindow<E, Op, Alloc>::evict(size_t clock) {
+    while (!isEmpty() && oldest().stamp + span <= clock)
+        popOldest();
+}
+
+// Add an event; time is ignored by count windows.
+template<typename E, typename Op, typename Alloc>
+void AggregateWindow<E, Op, Alloc>::push(const E& elem, size_t time) {
+    size_t stamp = by == WindowBy::COUNT ? seq++ : time;
+    if (back.isEmpty())
+        back.emplace(elem, elem, stamp);
+    else
+        back.emplace(elem, op(back.top().agg, elem), stamp);
+    evict(stamp);
+}
+
+// Evict events older than span milliseconds before time, without adding one.
+template<typename E, typename Op, typename Alloc>
+void AggregateWindow<E, Op, Alloc>::advance(size_t time) {
+    if (by == WindowBy::TIME)
+        evict(time);
+}
+
+template<typename E, typename Op, typename Alloc>
+E AggregateWindow<E, Op, Alloc>::value() const {
+    if (isEmpty())
+        CPPLIB_THROW(std::out_of_range, "Window underflow.");
+    if (front.isEmpty())
+        return back.top().agg;
+    if (back.isEmpty())
+        return front.top().agg;
+    return op(front.top().agg, back.top().agg);
+}
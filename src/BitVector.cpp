@@ -0,0 +1,94 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++11 -O2 -Iinclude src/BitVector.cpp -o BitVector
+ * Execution:    ./BitVector [bits]
+ * Dependencies: BitVector.h VectorAlgorithm.h Benchmark.h
+ *
+ * Builds a presence bitmap of one bit in four as a Vector<bool> and as a
+ * BitVector, compares their size and count(), then times random rank1()
+ * and select1() queries with portable and hardware popcount, and select1()
+ * on a sparse bitmap of one bit in 65536.
+ ******************************************************************************/
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "Benchmark.h"
+#include "BitVector.h"
+#include "VectorAlgorithm.h"
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    size_t bits = argc > 1 ? atol(argv[1]) : size_t(1) << 30;
+    size_t queries = 10000000;
+    BitVector<> bv(bits);
+    Vector<bool> flags(static_cast<int>(bits < (1u << 30) ? bits : 1u << 30));
+    uint64_t x = 88172645463325252ULL;
+    for (size_t i = 0; i < bits; ++i)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        if ((x & 3) == 0)
+            bv.set(i);
+        if (i < static_cast<size_t>(flags.capacity()))
+            flags.insert_back((x & 3) == 0);
+    }
+
+    Benchmark bm;
+    bm.header("Presence bitmap of " + to_string(bits) + " bits:");
+    bm.run("Vector<bool> count", flags.size(), [&]() { Benchmark::keep(vectorCount(flags, true)); });
+    bm.run("BitVector count", bits, [&]() { Benchmark::keep(bv.count()); });
+    int best = bitLevel();
+    for (int level = 0; level <= best; level += best > 0 ? best : 1)
+    {
+        simdLimit(level == 0 ? SimdLevel::SCALAR : SimdLevel::AVX512);
+        string name = level == 0 ? "portable" : (level == 1 ? "popcnt" : "popcnt+bmi2");
+        RankSelect rs(bv);
+        bm.run(name + " rank1", queries, [&]() {
+            uint64_t y = 3, acc = 0;
+            for (size_t q = 0; q < queries; ++q)
+            {
+                y = y * 6364136223846793005ULL + 1442695040888963407ULL;
+                acc += rs.rank1((y >> 16) % bits);
+            }
+            Benchmark::keep(acc);
+        });
+        bm.run(name + " select1", queries, [&]() {
+            uint64_t y = 3, acc = 0;
+            for (size_t q = 0; q < queries; ++q)
+            {
+                y = y * 6364136223846793005ULL + 1442695040888963407ULL;
+                acc += rs.select1((y >> 16) % rs.count());
+            }
+            Benchmark::keep(acc);
+        });
+        if (level == 0)
+            cout << "Vector<bool>: " << flags.size() << " bytes, BitVector: " << bv.wordCount() * 8
+                 << " bytes, RankSelect: " << rs.bytes() << " bytes" << endl;
+    }
+
+    // One bit in 65536 leaves thousands of blocks between select samples
+    BitVector<> sparse(bits);
+    for (size_t i = 0; i < bits; i += 1 + (x >> 48))
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        sparse.set(i);
+    }
+    RankSelect srs(sparse);
+    bm.header("Sparse bitmap of " + to_string(srs.count()) + " ones:");
+    bm.run("select1", queries, [&]() {
+        uint64_t y = 3, acc = 0;
+        for (size_t q = 0; q < queries; ++q)
+        {
+            y = y * 6364136223846793005ULL + 1442695040888963407ULL;
+            acc += srs.select1((y >> 16) % srs.count());
+        }
+        Benchmark::keep(acc);
+    });
+    return 0;
+}
@@ -0,0 +1,161 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++20 -O2 -Iinclude src/Channel.cpp -o Channel -pthread
+ * Execution:    ./Channel [stages] [messages] [capacity]
+ * Dependencies: Channel.h Executor.h Benchmark.h
+ *
+ * Pushes messages through a chain of stages, each taking from one bounded
+ * queue, adding one and passing the result on. Compares one blocked OS
+ * thread per stage with one coroutine per stage over Channels, on a
+ * LoopExecutor and on PoolExecutors of 2 and 4 threads.
+ ******************************************************************************/
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ArrayQueue.h"
+#include "Benchmark.h"
+#include "Channel.h"
+#include "Executor.h"
+
+using namespace std;
+
+/**
+ * The blocking alternative: an ArrayQueue behind a mutex, with a condition
+ * variable for each of full and empty. A negative value closes it.
+ */
+class BlockingQueue
+{
+private:
+    mutex mtx;
+    condition_variable notFull, notEmpty;
+    ArrayQueue<int64_t> q;
+    int cap;
+public:
+    explicit BlockingQueue(int capacity) : cap(capacity) {}
+
+    void put(int64_t x)
+    {
+        unique_lock<mutex> lock(mtx);
+        notFull.wait(lock, [&]() { return q.size() < cap; });
+        q.enqueue(x);
+        notEmpty.notify_one();
+    }
+    int64_t take()
+    {
+        unique_lock<mutex> lock(mtx);
+        notEmpty.wait(lock, [&]() { return !q.isEmpty(); });
+        int64_t x = q.dequeue();
+        notFull.notify_one();
+        return x;
+    }
+};
+
+Task produce(Channel<int64_t>& out, int count)
+{
+    for (int i = 0; i < count; ++i)
+        co_await out.send(i);
+    out.close();
+}
+
+Task stage(Channel<int64_t>& in, Channel<int64_t>& out)
+{
+    while (optional<int64_t> x = co_await in.recv())
+        co_await out.send(*x + 1);
+    out.close();
+}
+
+Task consume(Channel<int64_t>& in, int64_t& sum)
+{
+    while (optional<int64_t> x = co_await in.recv())
+        sum += *x;
+}
+
+// Run the chain as coroutines on executor; return the sum the consumer saw
+template<typename Exec>
+int64_t coroutines(Exec& executor, int stages, int count, int capacity)
+{
+    vector<unique_ptr<Channel<int64_t>>> channels;
+    for (int i = 0; i <= stages; ++i)
+        channels.emplace_back(new Channel<int64_t>(executor, capacity));
+    int64_t sum = 0;
+    executor.spawn(produce(*channels[0], count));
+    for (int i = 0; i < stages; ++i)
+        executor.spawn(stage(*channels[i], *channels[i + 1]));
+    executor.spawn(consume(*channels[stages], sum));
+    executor.run();
+    return sum;
+}
+
+// Run the chain with one thread per stage; return the sum the consumer saw
+int64_t threads(int stages, int count, int capacity)
+{
+    vector<unique_ptr<BlockingQueue>> queues;
+    for (int i = 0; i <= stages; ++i)
+        queues.emplace_back(new BlockingQueue(capacity));
+    vector<thread> workers;
+    for (int i = 0; i < stages; ++i)
+    {
+        workers.emplace_back([&, i]() {
+            for (int64_t x; (x = queues[i]->take()) >= 0;)
+                queues[i + 1]->put(x + 1);
+            queues[i + 1]->put(-1);
+        });
+    }
+    int64_t sum = 0;
+    thread consumer([&]() {
+        for (int64_t x; (x = queues[stages]->take()) >= 0;)
+            sum += x;
+    });
+    for (int i = 0; i < count; ++i)
+        queues[0]->put(i);
+    queues[0]->put(-1);
+    for (thread& worker : workers)
+        worker.join();
+    consumer.join();
+    return sum;
+}
+
+int main(int argc, char* argv[])
+{
+    int stages = argc > 1 ? atoi(argv[1]) : 1000;
+    int count = argc > 2 ? atoi(argv[2]) : 10000;
+    int capacity = argc > 3 ? atoi(argv[3]) : 16;
+    if (stages < 1 || count < 1 || capacity < 1)
+    {
+        cerr << "Usage: argv[0] [stages] [messages] [capacity]" << endl;
+        exit(EXIT_FAILURE);
+    }
+    size_t hops = size_t(stages + 1) * count;
+
+    Benchmark bm;
+    bm.header(to_string(count) + " messages through " + to_string(stages) + " stages, capacity "
+              + to_string(capacity) + ":");
+    int64_t expected = int64_t(count) * (count - 1) / 2 + int64_t(count) * stages;
+    int64_t sum = 0;
+    bm.run("thread per stage", hops, [&]() { sum = threads(stages, count, capacity); });
+    if (sum != expected)
+        cerr << "thread per stage: sum " << sum << ", expected " << expected << endl;
+    bm.run("LoopExecutor", hops, [&]() {
+        LoopExecutor executor;
+        sum = coroutines(executor, stages, count, capacity);
+    });
+    if (sum != expected)
+        cerr << "LoopExecutor: sum " << sum << ", expected " << expected << endl;
+    for (int n = 2; n <= 4; n *= 2)
+    {
+        string name = "PoolExecutor " + to_string(n) + " threads";
+        bm.run(name, hops, [&]() {
+            PoolExecutor executor(n);
+            sum = coroutines(executor, stages, count, capacity);
+        });
+        if (sum != expected)
+            cerr << name << ": sum " << sum << ", expected " << expected << endl;
+    }
+    return 0;
+}
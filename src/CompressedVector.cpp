@@ -0,0 +1,157 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++11 -O2 -Iinclude src/CompressedVector.cpp -o CompressedVector
+ * Execution:    ./CompressedVector data/ip.csv [count]
+ * Dependencies: CompressedVector.h Vector.h Tokenizer.h Benchmark.h
+ *
+ * Compresses the sorted IPv4 addresses of data/ip.csv and a sorted list of
+ * IDs with random gaps below 32, reports the memory of each against
+ * Vector<uint32_t>, then compares the two at building, decoding, iterating,
+ * indexing and lower_bound over the IDs.
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "Benchmark.h"
+#include "CompressedVector.h"
+#include "Tokenizer.h"
+#include "Vector.h"
+
+using namespace std;
+
+// Parse a dotted IPv4 address
+uint32_t parseIp(const char* p, const char* end)
+{
+    uint32_t ip = 0, part = 0;
+    for (; p != end; ++p)
+    {
+        if (*p == '.')
+        {
+            ip = ip << 8 | part;
+            part = 0;
+        }
+        else if (*p >= '0' && *p <= '9')
+            part = part * 10 + (*p - '0');
+    }
+    return ip << 8 | part;
+}
+
+void report(const string& name, const Vector<uint32_t>& values, const CompressedVector& compressed)
+{
+    size_t plain = values.size() * sizeof(uint32_t);
+    cout << name << ": " << plain << " bytes in Vector, " << compressed.bytes() << " compressed, " << fixed
+         << setprecision(2) << double(plain) / compressed.bytes() << "x smaller" << endl;
+    cout.unsetf(ios::fixed);
+}
+
+int main(int argc, char* argv[])
+{
+    int count = argc > 2 ? atoi(argv[2]) : 1 << 24;
+    if (argc == 1 || count < 1)
+    {
+        cerr << "Usage: argv[0] filename [count]" << endl;
+        exit(EXIT_FAILURE);
+    }
+    Tokenizer in(argv[1]);
+    if (!in.isOpen())
+    {
+        cerr << "Can not open " << argv[1] << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    Vector<uint32_t> ips;
+    StringView line;
+    while (in.nextLine(line))
+    {
+        const char* comma = static_cast<const char*>(memchr(line.data(), ',', line.size()));
+        if (comma != nullptr)
+            ips.insert_back(parseIp(comma + 1, line.data() + line.size()));
+    }
+    sort(ips.begin(), ips.end());
+    report("ip.csv", ips, CompressedVector(ips.begin(), ips.end()));
+
+    Vector<uint32_t> ids(count);
+    uint32_t id = 0, x = 2463534242u;
+    for (int i = 0; i < count; ++i)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        id += x % 32;
+        ids.insert_back(id);
+    }
+    CompressedVector cv;
+
+    Benchmark bm;
+    bm.header("Sorted IDs, " + to_string(count) + " elements:");
+    bm.run("Vector insert_back", count, [&]() {
+        Vector<uint32_t> v;
+        for (uint32_t i : ids)
+            v.insert_back(i);
+        Benchmark::keep(v.size());
+    });
+    bm.run("CompressedVector insert_back", count, [&]() {
+        cv.clear();
+        for (uint32_t i : ids)
+            cv.insert_back(i);
+    });
+    bm.run("CompressedVector decode", count, [&]() {
+        uint32_t block[CompressedVector::BLOCK];
+        uint32_t last = 0;
+        for (int b = 0; b < cv.blocks(); ++b)
+        {
+            cv.decode(b, block);
+            last ^= block[b % CompressedVector::BLOCK];
+        }
+        Benchmark::keep(last);
+    });
+    bm.run("Vector iterate", count, [&]() {
+        uint64_t sum = 0;
+        for (uint32_t i : ids)
+            sum += i;
+        Benchmark::keep(sum);
+    });
+    bm.run("CompressedVector for_each", count, [&]() {
+        uint64_t sum = 0;
+        cv.for_each([&sum](uint32_t i) { sum += i; });
+        Benchmark::keep(sum);
+    });
+    bm.run("CompressedVector iterate", count, [&]() {
+        uint64_t sum = 0;
+        for (uint32_t i : cv)
+            sum += i;
+        Benchmark::keep(sum);
+    });
+
+    const int ops = 1000000;
+    bm.run("Vector index", ops, [&]() {
+        uint64_t sum = 0;
+        for (int i = 0; i < ops; ++i)
+            sum += ids[static_cast<int>(int64_t(i) * 7919 % count)];
+        Benchmark::keep(sum);
+    });
+    bm.run("CompressedVector index", ops, [&]() {
+        uint64_t sum = 0;
+        for (int i = 0; i < ops; ++i)
+            sum += cv[static_cast<int>(int64_t(i) * 7919 % count)];
+        Benchmark::keep(sum);
+    });
+    bm.run("Vector lower_bound", ops, [&]() {
+        int64_t sum = 0;
+        for (int i = 0; i < ops; ++i)
+            sum += lower_bound(ids.begin(), ids.end(), uint32_t(uint64_t(i) * 7919 % (id + 1))) - ids.begin();
+        Benchmark::keep(sum);
+    });
+    bm.run("CompressedVector lower_bound", ops, [&]() {
+        int64_t sum = 0;
+        for (int i = 0; i < ops; ++i)
+            sum += cv.lower_bound(uint32_t(uint64_t(i) * 7919 % (id + 1)));
+        Benchmark::keep(sum);
+    });
+    report("IDs", ids, cv);
+    return 0;
+}
@@ -1,7 +1,7 @@
 /*******************************************************************************
  * Compilation:  g++ -IDeque demo.cpp -o demo
  * Execution:    ./demo data/tobe.txt
- * Dependencies: Deque.h
+ * Dependencies: Deque.h Tokenizer.h
  *
  * % more data/tobe.txt 
  * to be or not to - be - - that - - - is
@@ -12,54 +12,54 @@
  ******************************************************************************/
 
 #include <cstdlib>
-#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
 #include "Deque.h"
+#include "MemoryResource.h"
+#include "Tokenizer.h"
 
 using namespace std;
 
 int main(int argc, char* argv[])
 {
     Deque<string> demo = Deque<string>();
-    vector<string> buf;
-    ifstream fin;
-    string elem;
+    vector<StringView> buf;
+    MonotonicArena arena;
+    StringView elem;
 
     if (argc == 1)
     {
         cerr << "Usage: argv[0] filename[s]" << endl;
         exit(EXIT_FAILURE);
     }
-    fin.open(argv[1]);
-    if (!fin.is_open())
+    // Tokens are copied into the arena, so the views outlive the tokenizer
+    Tokenizer in(argv[1], &arena);
+    if (!in.isOpen())
     {
         cerr << "Can not open " << argv[1] << endl;
         exit(EXIT_FAILURE);
     }
-    while (fin >> elem)
+    while (in.next(elem))
         buf.push_back(elem);
     cout << "As queue: ";
     for (auto i : buf)
     {
         if (i != "-")
-            demo.insert_back(i);
+            demo.insert_back(i.str());
         else
             cout << demo.remove_front() << " ";
     }
     cout << "(" << demo.size() << " left on deque)" << endl;
     demo.clear();
-    fin.open(argv[1]);
     cout << "As stack: ";
     for (auto i : buf)
     {
-        if (elem != "-")
-            demo.insert_back(i);
+        if (i != "-")
+            demo.insert_back(i.str());
         else
             cout << demo.remove_back() << " ";
     }
     cout << "(" << demo.size() << " left on deque)" << endl;
-    fin.close();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++11 -O2 -Iinclude src/ErrorPolicy.cpp -o ErrorPolicy
+ *               g++ -std=c++11 -O2 -fno-exceptions -Iinclude src/ErrorPolicy.cpp -o ErrorPolicyNoExceptions
+ * Execution:    ./ErrorPolicy [count]
+ * Dependencies: ArrayQueue.h ArrayStack.h Vector.h Expected.h Benchmark.h
+ *
+ * Reports the error policy the binary was built with and the size of its
+ * code, then times the checked hot paths of Vector, ArrayQueue and
+ * ArrayStack: the throwing members, the bool try* members, the Expected
+ * try* members and unchecked access, and the failure path of each policy.
+ * Build it with and without -fno-exceptions to compare.
+ ******************************************************************************/
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include "ArrayQueue.h"
+#include "ArrayStack.h"
+#include "Benchmark.h"
+#include "Expected.h"
+#include "Vector.h"
+
+#ifdef __linux__
+// Bounds of the code, defined by the linker
+extern "C" char __executable_start[];
+extern "C" char etext[];
+#endif
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    int count = argc > 1 ? atoi(argv[1]) : 1 << 22;
+    if (count < 1)
+    {
+        cerr << "Usage: argv[0] [count]" << endl;
+        exit(EXIT_FAILURE);
+    }
+#ifdef CPPLIB_NO_EXCEPTIONS
+    cout << "Error policy: abort" << endl;
+#else
+    cout << "Error policy: throw" << endl;
+#endif
+#ifdef __linux__
+    cout << "Code: " << etext - __executable_start << " bytes" << endl;
+#endif
+    struct stat st;
+    if (stat(argv[0], &st) == 0)
+        cout << "Binary: " << st.st_size << " bytes" << endl;
+
+    Vector<int> v(count);
+    for (int i = 0; i < count; ++i)
+        v.insert_back(i);
+    ArrayQueue<int> queue(count);
+    ArrayStack<int> stack(count);
+
+    Benchmark bm;
+    bm.header(to_string(count) + " elements:");
+    bm.run("Vector []", count, [&]() {
+        int64_t sum = 0;
+        for (int i = 0; i < count; ++i)
+            sum += v[i];
+        Benchmark::keep(sum);
+    });
+    bm.run("Vector at", count, [&]() {
+        int64_t sum = 0;
+        for (int i = 0; i < count; ++i)
+            sum += v.at(i);
+        Benchmark::keep(sum);
+    });
+    bm.run("Vector try_at", count, [&]() {
+        int64_t sum = 0;
+        for (int i = 0; i < count; ++i)
+            sum += v.try_at(i).valueOr(0);
+        Benchmark::keep(sum);
+    });
+
+    auto fillQueue = [&]() {
+        for (int i = 0; i < count; ++i)
+            queue.enqueue(i);
+    };
+    auto fillStack = [&]() {
+        for (int i = 0; i < count; ++i)
+            stack.push(i);
+    };
+    fillQueue();
+    bm.run("ArrayQueue dequeue", count, [&]() {
+        int64_t sum = 0;
+        for (int i = 0; i < count; ++i)
+            sum += queue.dequeue();
+        Benchmark::keep(sum);
+    });
+    fillQueue();
+    bm.run("ArrayQueue tryDequeue(E&)", count, [&]() {
+        int64_t sum = 0;
+        int x = 0;
+        while (queue.tryDequeue(x))
+            sum += x;
+        Benchmark::keep(sum);
+    });
+    fillQueue();
+    bm.run("ArrayQueue tryDequeue()", count, [&]() {
+        int64_t sum = 0;
+        for (Expected<int> x = queue.tryDequeue(); x; x = queue.tryDequeue())
+            sum += *x;
+        Benchmark::keep(sum);
+    });
+    fillStack();
+    bm.run("ArrayStack pop", count, [&]() {
+        int64_t sum = 0;
+        for (int i = 0; i < count; ++i)
+            sum += stack.pop();
+        Benchmark::keep(sum);
+    });
+    fillStack();
+    bm.run("ArrayStack tryPop()", count, [&]() {
+        int64_t sum = 0;
+        for (Expected<int> x = stack.tryPop(); x; x = stack.tryPop())
+            sum += *x;
+        Benchmark::keep(sum);
+    });
+
+    // Failures: an Expected costs a branch, a throw unwinds the stack
+    const int failures = 1 << 16;
+    bm.run("empty tryDequeue()", failures, [&]() {
+        int errors = 0;
+        for (int i = 0; i < failures; ++i)
+            errors += !queue.tryDequeue();
+        Benchmark::keep(errors);
+    });
+#ifndef CPPLIB_NO_EXCEPTIONS
+    bm.run("empty dequeue, catch", failures, [&]() {
+        int errors = 0;
+        for (int i = 0; i < failures; ++i)
+        {
+            try
+            {
+                Benchmark::keep(queue.dequeue());
+            }
+            catch (const std::out_of_range&)
+            {
+                ++errors;
+            }
+        }
+        Benchmark::keep(errors);
+    });
+#endif
+    return 0;
+}
@@ -0,0 +1,155 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++11 -O2 -Iinclude src/Filter.cpp -o Filter
+ * Execution:    ./Filter data/ip.csv [names] [fpr]
+ * Dependencies: BloomFilter.h CuckooFilter.h Tokenizer.h Benchmark.h
+ *
+ * Builds a table of names made from the hostnames in data/ip.csv, then
+ * looks up as many names that are not in it: straight in a hash set, and
+ * through a BloomFilter and CuckooFilters first. Reports the measured
+ * false-positive rates and the cost of saving and loading the filters.
+ ******************************************************************************/
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "Benchmark.h"
+#include "BloomFilter.h"
+#include "CuckooFilter.h"
+#include "Tokenizer.h"
+
+using namespace std;
+
+// Count the names the filter lets through to the table, one at a time and in bulk
+template<typename Filter>
+void bench(Benchmark& bm, const string& name, const Filter& filter, const unordered_set<string>& table,
+           const vector<StringView>& misses)
+{
+    size_t n = misses.size();
+    size_t passed = 0;
+    bm.run(name + " contains", n, [&]() {
+        size_t found = 0;
+        passed = 0;
+        for (const StringView& key : misses)
+        {
+            if (filter.contains(key))
+            {
+                ++passed;
+                found += table.count(string(key.data(), key.size()));
+            }
+        }
+        Benchmark::keep(found);
+    });
+    unique_ptr<bool[]> out(new bool[n]);
+    bm.run(name + " bulk contains", n, [&]() { Benchmark::keep(filter.contains(misses.data(), n, out.get())); });
+    cout << name << ": " << filter.bytes() / 1024 << " KiB, false positives " << fixed << setprecision(4)
+         << 100.0 * passed / n << "%" << endl;
+    cout.unsetf(ios::fixed);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc == 1)
+    {
+        cerr << "Usage: argv[0] filename [names] [fpr]" << endl;
+        exit(EXIT_FAILURE);
+    }
+    size_t count = argc > 2 ? atol(argv[2]) : 1000000;
+    double fpr = argc > 3 ? atof(argv[3]) : 0.01;
+
+    vector<string> hosts;
+    Tokenizer in(argv[1]);
+    if (!in.isOpen())
+    {
+        cerr << "Can not open " << argv[1] << endl;
+        exit(EXIT_FAILURE);
+    }
+    StringView line;
+    while (in.nextLine(line))
+    {
+        const char* comma = static_cast<const char*>(memchr(line.data(), ',', line.size()));
+        hosts.push_back(string(line.data(), comma != nullptr ? comma - line.data() : line.size()));
+    }
+    // Name i is "<i / hosts>.<host>" in the table and "x<i / hosts>.<host>" outside it
+    vector<string> names(count), others(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        names[i] = to_string(i / hosts.size()) + "." + hosts[i % hosts.size()];
+        others[i] = "x" + names[i];
+    }
+    vector<StringView> misses(others.begin(), others.end());
+
+    Benchmark bm;
+    bm.header(to_string(count) + " names in the table, " + to_string(count) + " lookups of absent names, fpr "
+              + to_string(fpr) + ":");
+    unordered_set<string> table;
+    bm.run("hash set insert", count, [&]() {
+        for (const string& name : names)
+            table.insert(name);
+    });
+    bm.run("hash set lookup", count, [&]() {
+        size_t found = 0;
+        for (const string& name : others)
+            found += table.count(name);
+        Benchmark::keep(found);
+    });
+
+    BloomFilter bloom(count, fpr);
+    bm.run("Bloom insert", count, [&]() {
+        for (const string& name : names)
+            bloom.insert(name);
+    });
+    bench(bm, "Bloom", bloom, table, misses);
+
+    CuckooFilter<uint8_t> cuckoo8(count);
+    CuckooFilter<> cuckoo16(count);
+    bm.run("Cuckoo 16-bit insert", count, [&]() {
+        for (const string& name : names)
+            cuckoo16.insert(name);
+    });
+    for (const string& name : names)
+        cuckoo8.insert(name);
+    bench(bm, "Cuckoo 8-bit", cuckoo8, table, misses);
+    bench(bm, "Cuckoo 16-bit", cuckoo16, table, misses);
+
+    // Whole filters, to and from memory
+    const int rounds = 100;
+    string saved;
+    bm.run("Bloom save", rounds, [&]() {
+        for (int i = 0; i < rounds; ++i)
+        {
+            ostringstream os;
+            bloom.save(os);
+            saved = os.str();
+        }
+    });
+    bm.run("Bloom load", rounds, [&]() {
+        for (int i = 0; i < rounds; ++i)
+        {
+            istringstream is(saved);
+            Benchmark::keep(BloomFilter::load(is).bytes());
+        }
+    });
+    bm.run("Cuckoo 16-bit save", rounds, [&]() {
+        for (int i = 0; i < rounds; ++i)
+        {
+            ostringstream os;
+            cuckoo16.save(os);
+            saved = os.str();
+        }
+    });
+    bm.run("Cuckoo 16-bit load", rounds, [&]() {
+        for (int i = 0; i < rounds; ++i)
+        {
+            istringstream is(saved);
+            Benchmark::keep(CuckooFilter<>::load(is).size());
+        }
+    });
+    return 0;
+}
@@ -0,0 +1,73 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++11 -O2 -Iinclude src/HugePage.cpp -o HugePage -pthread
+ * Execution:    ./HugePage [MiB]
+ * Dependencies: Vector.h HugePageResource.h Benchmark.h
+ *
+ * Fill, sequential scan and random access over a Vector<uint64_t> of the
+ * given size (default 1024 MiB), with std::allocator and with the huge page
+ * resource (lazy and prefaulted).
+ ******************************************************************************/
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "Benchmark.h"
+#include "HugePageResource.h"
+#include "Vector.h"
+
+using namespace std;
+
+template<typename V>
+void bench(Benchmark& bm, const string& name, V& v, int count)
+{
+    bm.run(name + " fill", count, [&]() {
+        for (int i = 0; i < count; ++i)
+            v.insert_back(uint64_t(i));
+    });
+    bm.run(name + " scan", count, [&]() {
+        uint64_t sum = 0;
+        for (int i = 0; i < count; ++i)
+            sum += v[i];
+        Benchmark::keep(sum);
+    });
+    bm.run(name + " random", count, [&]() {
+        uint64_t sum = 0;
+        uint64_t x = 88172645463325252ULL;
+        for (int i = 0; i < count; ++i)
+        {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            sum += v[int(x % uint64_t(count))];
+        }
+        Benchmark::keep(sum);
+    });
+}
+
+int main(int argc, char* argv[])
+{
+    size_t mib = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1024;
+    int count = int((mib << 20) / sizeof(uint64_t));
+    int threads = int(thread::hardware_concurrency());
+    using HugeVector = Vector<uint64_t, PolymorphicAllocator<uint64_t>>;
+
+    Benchmark bm;
+    bm.header("Vector<uint64_t> of " + to_string(mib) + " MiB:");
+    {
+        Vector<uint64_t> v(count);
+        bench(bm, "std::allocator", v, count);
+    }
+    {
+        HugePageResource huge;
+        HugeVector v(count, &huge);
+        bench(bm, "hugepage", v, count);
+    }
+    {
+        HugePageResource huge(HugePageResource::DEFAULT_THRESHOLD, HugePageResource::TOUCH, threads);
+        HugeVector v(count, &huge);
+        bench(bm, "hugepage+touch", v, count);
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++11 -O2 -Iinclude src/IntrusiveQueue.cpp -o IntrusiveQueue
+ * Execution:    ./IntrusiveQueue [hops] [messages]
+ * Dependencies: IntrusiveQueue.h LinkedQueue.h Benchmark.h
+ *
+ * Passes messages that live in one long-lived array around a ring of
+ * pipeline stages, one message at a time and a whole stage at a time.
+ * Compares LinkedQueues of messages and of pointers to them, which allocate
+ * a node per hop, with an IntrusiveQueue, which only relinks the message.
+ * An IntrusiveQueue hands a whole stage over with one splice, so that row
+ * counts stages rather than messages.
+ ******************************************************************************/
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "IntrusiveQueue.h"
+#include "LinkedQueue.h"
+
+using namespace std;
+
+const int STAGES = 4;
+
+struct Message : QueueHook<>
+{
+    uint64_t id;
+    uint64_t payload[7];
+
+    explicit Message(uint64_t id = 0) : id(id), payload() {}
+};
+
+// Every message handles and forwards its payload's first word
+inline uint64_t& work(Message& m) { return m.payload[0] += m.id; }
+inline uint64_t& work(Message* m) { return work(*m); }
+
+// Move hops messages one by one from each stage to the next, round the ring
+template<typename Queue>
+uint64_t relay(Queue* stages, size_t hops)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < hops; ++i)
+    {
+        Queue& from = stages[i % STAGES];
+        Queue& to = stages[(i + 1) % STAGES];
+        auto&& m = from.dequeue();
+        sum += work(m);
+        to.enqueue(m);
+    }
+    return sum;
+}
+
+// Move every message of each stage to the next in turn, hops messages in all
+template<typename Queue>
+uint64_t handoff(Queue* stages, size_t hops)
+{
+    uint64_t moved = 0;
+    for (size_t s = 0; moved < hops; ++s)
+    {
+        Queue& from = stages[s % STAGES];
+        Queue& to = stages[(s + 1) % STAGES];
+        moved += from.size();
+        while (!from.isEmpty())
+            to.enqueue(from.dequeue());
+    }
+    return moved;
+}
+
+// Splice each stage onto the next in turn, splices times
+uint64_t splice(IntrusiveQueue<Message>* stages, size_t splices)
+{
+    uint64_t moved = 0;
+    for (size_t s = 0; s < splices; ++s)
+    {
+        moved += stages[s % STAGES].size();
+        stages[(s + 1) % STAGES].splice(stages[s % STAGES]);
+    }
+    return moved;
+}
+
+// Load the messages evenly into the stages and run f over them
+template<typename Queue, typename Load, typename F>
+void bench(Benchmark& bm, const string& name, size_t hops, vector<Message>& messages, Load load, F f)
+{
+    Queue stages[STAGES];
+    for (size_t i = 0; i < messages.size(); ++i)
+        load(stages[i % STAGES], messages[i]);
+    bm.run(name, hops, [&]() { Benchmark::keep(f(stages, hops)); });
+}
+
+int main(int argc, char* argv[])
+{
+    size_t hops = argc > 1 ? atol(argv[1]) : 50000000;
+    size_t count = argc > 2 ? atol(argv[2]) : 4096;
+    if (count == 0)
+    {
+        cerr << "Usage: argv[0] [hops] [messages > 0]" << endl;
+        exit(EXIT_FAILURE);
+    }
+    vector<Message> messages;
+    for (size_t i = 0; i < count; ++i)
+        messages.emplace_back(i);
+
+    using ByValue = LinkedQueue<Message>;
+    using ByPointer = LinkedQueue<Message*>;
+    using Intrusive = IntrusiveQueue<Message>;
+    auto copy = [](ByValue& q, Message& m) { q.enqueue(m); };
+    auto point = [](ByPointer& q, Message& m) { q.enqueue(&m); };
+    auto link = [](Intrusive& q, Message& m) { q.enqueue(m); };
+
+    Benchmark bm;
+    bm.header(to_string(hops) + " hops of " + to_string(count) + " messages round " + to_string(STAGES)
+              + " stages:");
+    bench<ByValue>(bm, "LinkedQueue copy relay", hops, messages, copy, relay<ByValue>);
+    bench<ByPointer>(bm, "LinkedQueue pointer relay", hops, messages, point, relay<ByPointer>);
+    bench<Intrusive>(bm, "IntrusiveQueue relay", hops, messages, link, relay<Intrusive>);
+    bench<ByValue>(bm, "LinkedQueue copy handoff", hops, messages, copy, handoff<ByValue>);
+    bench<ByPointer>(bm, "LinkedQueue pointer handoff", hops, messages, point, handoff<ByPointer>);
+    bench<Intrusive>(bm, "IntrusiveQueue splice", hops, messages, link, splice);
+    return 0;
+}
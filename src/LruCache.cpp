@@ -0,0 +1,230 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++11 -O2 -Iinclude src/LruCache.cpp -o LruCache -pthread
+ * Execution:    ./LruCache data/ip.csv [names] [capacity] [ops]
+ * Dependencies: LruCache.h Tokenizer.h Benchmark.h
+ *
+ * Memoizes name to address lookups for names made from the hostnames in
+ * data/ip.csv, drawn from a Zipfian distribution, in a cache of the given
+ * capacity. Compares one mutex around a std::unordered_map and a std::list
+ * with ShardedLruCache in LRU and CLOCK mode, read through a Reader per
+ * thread, from 1 to 32 threads, and reports the hit rate of each.
+ ******************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Benchmark.h"
+#include "LruCache.h"
+#include "Tokenizer.h"
+
+using namespace std;
+
+/**
+ * The usual hand-rolled LRU cache: a map into a recency list, all behind
+ * one mutex.
+ */
+class MutexLru
+{
+private:
+    using Item = pair<string, uint32_t>;
+
+    mutex mtx;
+    size_t cap;
+    list<Item> items;
+    unordered_map<string, list<Item>::iterator> index;
+public:
+    explicit MutexLru(size_t capacity) : cap(capacity) {}
+
+    bool get(const string& key, uint32_t& value)
+    {
+        lock_guard<mutex> lock(mtx);
+        auto it = index.find(key);
+        if (it == index.end())
+            return false;
+        items.splice(items.begin(), items, it->second);
+        value = it->second->second;
+        return true;
+    }
+    void put(const string& key, uint32_t value)
+    {
+        lock_guard<mutex> lock(mtx);
+        auto it = index.find(key);
+        if (it != index.end())
+        {
+            it->second->second = value;
+            items.splice(items.begin(), items, it->second);
+            return;
+        }
+        if (items.size() == cap)
+        {
+            index.erase(items.back().first);
+            items.pop_back();
+        }
+        items.emplace_front(key, value);
+        index[key] = items.begin();
+    }
+};
+
+// Parse a dotted IPv4 address
+uint32_t parseIp(StringView s)
+{
+    uint32_t ip = 0, part = 0;
+    for (size_t i = 0; i < s.size(); ++i)
+    {
+        if (s.data()[i] == '.')
+        {
+            ip = ip << 8 | part;
+            part = 0;
+        }
+        else
+        {
+            part = part * 10 + (s.data()[i] - '0');
+        }
+    }
+    return ip << 8 | part;
+}
+
+// Draw count ranks in [0, n) with probability proportional to 1 / (rank + 1)^s
+vector<uint32_t> zipf(size_t n, double s, size_t count)
+{
+    vector<double> cdf(n);
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i)
+        cdf[i] = sum += 1 / pow(double(i + 1), s);
+    vector<uint32_t> ranks(count);
+    uint64_t x = 88172645463325252ULL;
+    for (size_t i = 0; i < count; ++i)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        double u = (x >> 11) * (sum / 9007199254740992.0);
+        ranks[i] = min<size_t>(lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin(), n - 1);
+    }
+    return ranks;
+}
+
+struct Workload
+{
+    vector<string> names;
+    unordered_map<string, uint32_t> resolver;
+    vector<uint32_t> ops;
+};
+
+// Serve ops[first, last) from cache, resolving and inserting on a miss
+template<typename Cache>
+size_t serve(Cache& cache, const Workload& w, size_t first, size_t last)
+{
+    size_t hits = 0;
+    for (size_t i = first; i < last; ++i)
+    {
+        const string& name = w.names[w.ops[i]];
+        uint32_t ip;
+        if (cache.get(name, ip))
+        {
+            ++hits;
+        }
+        else
+        {
+            ip = w.resolver.find(name)->second;
+            cache.put(name, ip);
+        }
+        Benchmark::keep(ip);
+    }
+    return hits;
+}
+
+// Serve ops[first, last) from one thread
+template<typename Cache>
+size_t work(Cache& cache, const Workload& w, size_t first, size_t last)
+{
+    return serve(cache, w, first, last);
+}
+
+// Each thread reads a sharded cache through its own Reader, which in CLOCK mode takes no lock
+size_t work(ShardedLruCache<string, uint32_t>& cache, const Workload& w, size_t first, size_t last)
+{
+    ShardedLruCache<string, uint32_t>::Reader reader(cache);
+    return serve(reader, w, first, last);
+}
+
+// Run the workload on a fresh cache from make() with 1 to 32 threads
+template<typename Cache, typename Make>
+void bench(Benchmark& bm, const string& name, Make make, const Workload& w)
+{
+    for (int threads = 1; threads <= 32; threads *= 2)
+    {
+        unique_ptr<Cache> cache(make());
+        atomic<size_t> hits(0);
+        size_t per = w.ops.size() / threads;
+        bm.run(name + " " + to_string(threads) + " threads", per * threads, [&]() {
+            vector<thread> workers;
+            for (int t = 0; t < threads; ++t)
+                workers.emplace_back([&, t]() { hits += work(*cache, w, t * per, (t + 1) * per); });
+            for (auto& worker : workers)
+                worker.join();
+        });
+        if (threads == 1)
+            cout << name << " hit rate: " << 100.0 * hits / per << "%" << endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc == 1)
+    {
+        cerr << "Usage: argv[0] filename [names] [capacity] [ops]" << endl;
+        exit(EXIT_FAILURE);
+    }
+    size_t count = argc > 2 ? atol(argv[2]) : 1000000;
+    size_t capacity = argc > 3 ? atol(argv[3]) : 65536;
+    size_t total = argc > 4 ? atol(argv[4]) : 4000000;
+
+    vector<string> hosts;
+    vector<uint32_t> ips;
+    Tokenizer in(argv[1]);
+    if (!in.isOpen())
+    {
+        cerr << "Can not open " << argv[1] << endl;
+        exit(EXIT_FAILURE);
+    }
+    StringView line;
+    while (in.nextLine(line))
+    {
+        const char* comma = static_cast<const char*>(memchr(line.data(), ',', line.size()));
+        if (comma == nullptr)
+            continue;
+        size_t len = comma - line.data();
+        hosts.push_back(string(line.data(), len));
+        ips.push_back(parseIp(line.substr(len + 1)));
+    }
+    // Name i is "<i / hosts>.<host>", resolving to the host's address plus i / hosts
+    Workload w;
+    w.names.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        w.names[i] = to_string(i / hosts.size()) + "." + hosts[i % hosts.size()];
+        w.resolver[w.names[i]] = ips[i % hosts.size()] + uint32_t(i / hosts.size());
+    }
+    w.ops = zipf(count, 0.99, total);
+
+    Benchmark bm;
+    bm.header(to_string(total) + " lookups of " + to_string(count) + " names (Zipf 0.99), capacity "
+              + to_string(capacity) + ":");
+    using Sharded = ShardedLruCache<string, uint32_t>;
+    bench<MutexLru>(bm, "mutex LRU", [&]() { return new MutexLru(capacity); }, w);
+    bench<Sharded>(bm, "sharded LRU", [&]() { return new Sharded(capacity, 4, Eviction::LRU); }, w);
+    bench<Sharded>(bm, "sharded CLOCK", [&]() { return new Sharded(capacity, 4, Eviction::CLOCK); }, w);
+    return 0;
+}
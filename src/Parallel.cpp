@@ -0,0 +1,100 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++11 -O2 -Iinclude src/Parallel.cpp -o Parallel -pthread
+ * Execution:    ./Parallel [count] [threads]
+ * Dependencies: Parallel.h Vector.h Benchmark.h
+ *
+ * Turns a Vector of record lengths into the offsets of an index, serially
+ * with std::partial_sum and with parallel_exclusive_scan, then sums and
+ * transforms it and runs a for_each whose cost grows along the range, on
+ * pools of 1 up to the given number of threads with static and dynamic
+ * partitioning.
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <thread>
+#include "Benchmark.h"
+#include "Parallel.h"
+#include "Vector.h"
+
+using namespace std;
+
+// Task whose cost is its number of hashing rounds
+struct Job
+{
+    uint32_t cost;
+    uint64_t result;
+};
+
+inline void runJob(Job& job)
+{
+    uint64_t h = job.cost;
+    for (uint32_t i = 0; i < job.cost; ++i)
+        h = h * 0x9e3779b97f4a7c15ULL + i;
+    job.result = h;
+}
+
+int main(int argc, char* argv[])
+{
+    int count = argc > 1 ? atoi(argv[1]) : 1 << 25;
+    int maxThreads = argc > 2 ? atoi(argv[2]) : max(4u, thread::hardware_concurrency());
+    if (count < 1 || maxThreads < 1)
+    {
+        cerr << "Usage: argv[0] [count] [threads]" << endl;
+        exit(EXIT_FAILURE);
+    }
+    Vector<uint64_t> lengths(count);
+    uint32_t x = 2463534242u;
+    for (int i = 0; i < count; ++i)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        lengths.insert_back(x % 4096);
+    }
+    Vector<uint64_t> offsets(lengths);
+    // Jobs growing from 0 to 511 rounds along the range, so equal slices are not equal work
+    int jobCount = max(count / 64, 1);
+    Vector<Job> jobs(jobCount);
+    for (int i = 0; i < jobCount; ++i)
+        jobs.insert_back(Job{ static_cast<uint32_t>(int64_t(i) * 512 / jobCount), 0 });
+
+    Benchmark bm;
+    bm.header("Offsets of " + to_string(count) + " records:");
+    bm.run("serial scan", count, [&]() {
+        partial_sum(lengths.begin(), lengths.end(), offsets.begin());
+        Benchmark::keep(offsets[count - 1]);
+    });
+    bm.run("serial reduce", count, [&]() { Benchmark::keep(accumulate(lengths.begin(), lengths.end(), uint64_t(0))); });
+    bm.run("serial uneven for_each", jobCount, [&]() {
+        for (Job& job : jobs)
+            runJob(job);
+    });
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        ThreadPool pool(threads);
+        for (int s = 0; s < 2; ++s)
+        {
+            ParallelPolicy policy(s == 0 ? Schedule::STATIC : Schedule::DYNAMIC, 0, &pool);
+            string name = to_string(threads) + (s == 0 ? " static " : " dynamic ");
+            bm.run(name + "scan", count, [&]() {
+                parallel_exclusive_scan(lengths.begin(), lengths.end(), offsets.begin(), uint64_t(0),
+                                        plus<uint64_t>(), policy);
+                Benchmark::keep(offsets[count - 1]);
+            });
+            bm.run(name + "reduce", count, [&]() {
+                Benchmark::keep(parallel_reduce(lengths, uint64_t(0), plus<uint64_t>(), policy));
+            });
+            bm.run(name + "transform", count, [&]() {
+                parallel_transform(lengths.begin(), lengths.end(), offsets.begin(),
+                                   [](uint64_t n) { return (n + 63) & ~uint64_t(63); }, policy);
+            });
+            bm.run(name + "uneven for_each", jobCount, [&]() { parallel_for_each(jobs, runJob, policy); });
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,156 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++11 -O2 -Iinclude src/PersistentVector.cpp -o PersistentVector -pthread
+ * Execution:    ./PersistentVector [size] [readers]
+ * Dependencies: PersistentVector.h Vector.h Benchmark.h
+ *
+ * Builds a state vector of the given size, then compares Vector with
+ * PersistentVector at the operations a request handler needs: taking a
+ * snapshot, updating, appending, reading and iterating. Finally a writer
+ * publishes a new version per update while reader threads take snapshots
+ * and read them.
+ ******************************************************************************/
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Benchmark.h"
+#include "PersistentVector.h"
+#include "Vector.h"
+
+using namespace std;
+
+// Sum count elements of v at a stride that visits every leaf
+template<typename Vec>
+int64_t probe(const Vec& v, size_t count)
+{
+    int64_t sum = 0;
+    int size = v.size();
+    for (size_t i = 0; i < count; ++i)
+        sum += v[static_cast<int>(i * 7919 % size)];
+    return sum;
+}
+
+int main(int argc, char* argv[])
+{
+    int size = argc > 1 ? atoi(argv[1]) : 1000000;
+    int readers = argc > 2 ? atoi(argv[2]) : 4;
+    if (size < 1 || readers < 1)
+    {
+        cerr << "Usage: argv[0] [size] [readers]" << endl;
+        exit(EXIT_FAILURE);
+    }
+    const size_t ops = 1000000;
+    const int copies = 100;
+
+    Benchmark bm;
+    bm.header("State of " + to_string(size) + " elements:");
+    Vector<int> vec;
+    PersistentVector<int> pv;
+    bm.run("Vector insert_back", size, [&]() {
+        for (int i = 0; i < size; ++i)
+            vec.insert_back(i);
+    });
+    bm.run("PersistentVector insert_back", size, [&]() {
+        PersistentVector<int> v;
+        for (int i = 0; i < size; ++i)
+            v = v.insert_back(i);
+        Benchmark::keep(v.size());
+    });
+    bm.run("Transient insert_back", size, [&]() {
+        PersistentVector<int>::Transient t = PersistentVector<int>().transient();
+        for (int i = 0; i < size; ++i)
+            t.insert_back(i);
+        pv = t.persistent();
+    });
+
+    bm.run("Vector snapshot", copies, [&]() {
+        for (int i = 0; i < copies; ++i)
+        {
+            Vector<int> snapshot(vec);
+            Benchmark::keep(snapshot[i]);
+        }
+    });
+    bm.run("PersistentVector snapshot", ops, [&]() {
+        for (size_t i = 0; i < ops; ++i)
+        {
+            PersistentVector<int> snapshot(pv);
+            Benchmark::keep(snapshot.size());
+        }
+    });
+
+    bm.run("Vector set", ops, [&]() {
+        for (size_t i = 0; i < ops; ++i)
+            vec[static_cast<int>(i * 7919 % size)] = static_cast<int>(i);
+    });
+    bm.run("PersistentVector set", ops, [&]() {
+        PersistentVector<int> v(pv);
+        for (size_t i = 0; i < ops; ++i)
+            v = v.set(static_cast<int>(i * 7919 % size), static_cast<int>(i));
+        Benchmark::keep(v.size());
+    });
+    bm.run("Transient set", ops, [&]() {
+        PersistentVector<int>::Transient t = pv.transient();
+        for (size_t i = 0; i < ops; ++i)
+            t.set(static_cast<int>(i * 7919 % size), static_cast<int>(i));
+        pv = t.persistent();
+    });
+
+    bm.run("Vector index", ops, [&]() { Benchmark::keep(probe(vec, ops)); });
+    bm.run("PersistentVector index", ops, [&]() { Benchmark::keep(probe(pv, ops)); });
+    bm.run("Vector iterate", size, [&]() {
+        int64_t sum = 0;
+        for (int x : vec)
+            sum += x;
+        Benchmark::keep(sum);
+    });
+    bm.run("PersistentVector iterate", size, [&]() {
+        int64_t sum = 0;
+        for (int x : pv)
+            sum += x;
+        Benchmark::keep(sum);
+    });
+
+    // One writer publishing versions, readers snapshotting the latest under a short lock
+    mutex mtx;
+    PersistentVector<int> published(pv);
+    atomic<bool> done(false);
+    atomic<size_t> reads(0);
+    const size_t updates = ops / 10;
+    bm.run("publish with " + to_string(readers) + " readers", updates, [&]() {
+        vector<thread> threads;
+        for (int r = 0; r < readers; ++r)
+        {
+            threads.emplace_back([&]() {
+                size_t count = 0;
+                while (!done)
+                {
+                    PersistentVector<int> snapshot;
+                    {
+                        lock_guard<mutex> lock(mtx);
+                        snapshot = published;
+                    }
+                    Benchmark::keep(probe(snapshot, 64));
+                    ++count;
+                }
+                reads += count;
+            });
+        }
+        PersistentVector<int> v(pv);
+        for (size_t i = 0; i < updates; ++i)
+        {
+            v = v.set(static_cast<int>(i * 7919 % size), static_cast<int>(i));
+            lock_guard<mutex> lock(mtx);
+            published = v;
+        }
+        done = true;
+        for (thread& t : threads)
+            t.join();
+    });
+    cout << "snapshots read: " << reads << endl;
+    return 0;
+}
@@ -0,0 +1,46 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++11 -Iinclude src/Queue.cpp -o Queue
+ * Execution:    ./Queue data/tobe.txt
+ * Dependencies: ArrayQueue.h Tokenizer.h
+ *
+ * % more data/tobe.txt 
+ * to be or not to - be - - that - - - is
+ *
+ * % ./Queue data/tobe.txt
+ * to be or not to be (2 left on queue)
+ ******************************************************************************/
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "ArrayQueue.h"
+#include "Tokenizer.h"
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    ArrayQueue<string> queue;
+    StringView elem;
+
+    if (argc == 1)
+    {
+        cerr << "Usage: argv[0] filename" << endl;
+        exit(EXIT_FAILURE);
+    }
+    Tokenizer in(argv[1]);
+    if (!in.isOpen())
+    {
+        cerr << "Can not open " << argv[1] << endl;
+        exit(EXIT_FAILURE);
+    }
+    while (in.next(elem))
+    {
+        if (elem != "-")
+            queue.enqueue(elem.str());
+        else
+            cout << queue.dequeue() << " ";
+    }
+    cout << "(" << queue.size() << " left on queue)" << endl;
+    return 0;
+}
@@ -0,0 +1,124 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++11 -O2 -Iinclude src/QueueBenchmark.cpp -o QueueBenchmark
+ * Execution:    ./QueueBenchmark [count]
+ * Dependencies: ArrayQueue.h ArrayStack.h LinkedQueue.h Benchmark.h
+ *               PerfCounters.h
+ *
+ * Drains stacks and queues of 64-byte std::string payloads three ways:
+ * copying the front element out (what the by-value front()/dequeue() used
+ * to cost), the moving dequeue()/pop(), and tryDequeue()/tryPop(). Then
+ * iterates over queues of integers, where the per-operation cache misses,
+ * when the CPU's counters are available, show the cost of LinkedQueue's
+ * separately allocated nodes.
+ ******************************************************************************/
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include "ArrayQueue.h"
+#include "ArrayStack.h"
+#include "Benchmark.h"
+#include "LinkedQueue.h"
+
+using namespace std;
+
+template<typename Q>
+void fill(Q& q, int count, const string& payload)
+{
+    for (int i = 0; i < count; ++i)
+        q.emplace(payload);
+}
+
+template<typename Q>
+void benchQueue(Benchmark& bm, const string& name, int count, const string& payload)
+{
+    Q q;
+    fill(q, count, payload);
+    bm.run(name + " copy front", count, [&]() {
+        size_t len = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            string elem = static_cast<const Q&>(q).front();
+            q.dequeue();
+            len += elem.size();
+        }
+        Benchmark::keep(len);
+    });
+    fill(q, count, payload);
+    bm.run(name + " dequeue", count, [&]() {
+        size_t len = 0;
+        for (int i = 0; i < count; ++i)
+            len += q.dequeue().size();
+        Benchmark::keep(len);
+    });
+    fill(q, count, payload);
+    bm.run(name + " tryDequeue", count, [&]() {
+        size_t len = 0;
+        string elem;
+        while (q.tryDequeue(elem))
+            len += elem.size();
+        Benchmark::keep(len);
+    });
+}
+
+template<typename Q>
+void benchIterate(Benchmark& bm, const string& name, int count)
+{
+    Q q;
+    for (int i = 0; i < count; ++i)
+        q.enqueue(i);
+    bm.run(name + " iterate", count, [&]() {
+        uint64_t sum = 0;
+        for (uint64_t x : q)
+            sum += x;
+        Benchmark::keep(sum);
+    });
+}
+
+void benchStack(Benchmark& bm, int count, const string& payload)
+{
+    ArrayStack<string> s;
+    fill(s, count, payload);
+    bm.run("ArrayStack copy top", count, [&]() {
+        size_t len = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            string elem = static_cast<const ArrayStack<string>&>(s).top();
+            s.pop();
+            len += elem.size();
+        }
+        Benchmark::keep(len);
+    });
+    fill(s, count, payload);
+    bm.run("ArrayStack pop", count, [&]() {
+        size_t len = 0;
+        for (int i = 0; i < count; ++i)
+            len += s.pop().size();
+        Benchmark::keep(len);
+    });
+    fill(s, count, payload);
+    bm.run("ArrayStack tryPop", count, [&]() {
+        size_t len = 0;
+        string elem;
+        while (s.tryPop(elem))
+            len += elem.size();
+        Benchmark::keep(len);
+    });
+}
+
+int main(int argc, char* argv[])
+{
+    int count = argc > 1 ? atoi(argv[1]) : 2000000;
+    string payload(64, 'x');
+
+    Benchmark bm;
+    bm.header("Draining " + to_string(count) + " strings of 64 bytes:");
+    benchQueue<ArrayQueue<string>>(bm, "ArrayQueue", count, payload);
+    benchQueue<LinkedQueue<string>>(bm, "LinkedQueue", count, payload);
+    benchStack(bm, count, payload);
+
+    bm.header("Iterating " + to_string(count * 8) + " integers:");
+    benchIterate<ArrayQueue<uint64_t>>(bm, "ArrayQueue", count * 8);
+    benchIterate<LinkedQueue<uint64_t>>(bm, "LinkedQueue", count * 8);
+    return 0;
+}
@@ -0,0 +1,46 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++11 -O2 -Iinclude src/Simd.cpp -o Simd
+ * Execution:    ./Simd [count]
+ * Dependencies: VectorAlgorithm.h Benchmark.h
+ *
+ * Runs find, count, minmax, sum and equal over a Vector<uint32_t> of
+ * counters at every instruction set level the CPU supports.
+ ******************************************************************************/
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include "Benchmark.h"
+#include "VectorAlgorithm.h"
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    int count = argc > 1 ? atoi(argv[1]) : 1 << 26;
+    Vector<uint32_t> a(count);
+    uint32_t x = 2463534242u;
+    for (int i = 0; i < count; ++i)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        a.insert_back(x % 1000000u);
+    }
+    Vector<uint32_t> b(a);
+
+    Benchmark bm;
+    bm.header("Scans over " + to_string(count) + " uint32_t:");
+    SimdLevel best = simdDetect();
+    for (int level = 0; level <= static_cast<int>(best); ++level)
+    {
+        simdLimit(static_cast<SimdLevel>(level));
+        string name = simdName(static_cast<SimdLevel>(level));
+        bm.run(name + " find", count, [&]() { Benchmark::keep(vectorFind(a, 1000000u)); });
+        bm.run(name + " count", count, [&]() { Benchmark::keep(vectorCount(a, 42u)); });
+        bm.run(name + " minmax", count, [&]() { Benchmark::keep(vectorMinmax(a)); });
+        bm.run(name + " sum", count, [&]() { Benchmark::keep(vectorSum(a)); });
+        bm.run(name + " equal", count, [&]() { Benchmark::keep(vectorEqual(a, b)); });
+    }
+    return 0;
+}
@@ -0,0 +1,235 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++11 -O2 -Iinclude src/SnapshotMap.cpp -o SnapshotMap -pthread
+ * Execution:    ./SnapshotMap data/ip.csv [names] [threads] [ops]
+ * Dependencies: SnapshotMap.h EpochDomain.h RwLock.h Tokenizer.h Benchmark.h
+ *
+ * Loads a host to address table of names made from the hostnames in
+ * data/ip.csv, then looks names up from 1 up to the given number of reader
+ * threads while a writer reloads the table without pause: in full, or as a
+ * diff changing 1% of the addresses. Compares a std::unordered_map behind
+ * an RwLock, swapped or patched under the exclusive lock, with SnapshotMap,
+ * and reports the number of reloads done alongside the lookups.
+ ******************************************************************************/
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Benchmark.h"
+#include "RwLock.h"
+#include "SnapshotMap.h"
+#include "Tokenizer.h"
+
+using namespace std;
+
+struct Hosts
+{
+    vector<string> names;
+    vector<uint32_t> ips;
+    vector<uint32_t> ops; // Names to look up
+};
+
+/**
+ * The table behind a reader-writer lock: lookups share it, reloads take it
+ * exclusively.
+ */
+class LockedTable
+{
+private:
+    RwLock lock;
+    unique_ptr<unordered_map<string, uint32_t>> map;
+public:
+    LockedTable() : map(new unordered_map<string, uint32_t>()) {}
+
+    bool find(const string& name, uint32_t& ip)
+    {
+        SharedLock shared(lock);
+        auto it = map->find(name);
+        if (it == map->end())
+            return false;
+        ip = it->second;
+        return true;
+    }
+    // Build the new table aside, swap it in, and free the old one after unlocking
+    void reload(const Hosts& t, uint32_t round)
+    {
+        unique_ptr<unordered_map<string, uint32_t>> next(new unordered_map<string, uint32_t>(t.names.size()));
+        for (size_t i = 0; i < t.names.size(); ++i)
+            (*next)[t.names[i]] = t.ips[i] + round;
+        lock_guard<RwLock> exclusive(lock);
+        map.swap(next);
+    }
+    void patch(const Hosts& t, uint32_t round)
+    {
+        lock_guard<RwLock> exclusive(lock);
+        for (size_t i = round % 100; i < t.names.size(); i += 100)
+            (*map)[t.names[i]] = t.ips[i] + round;
+    }
+};
+
+using HostMap = SnapshotMap<string, uint32_t>;
+
+class SnapshotTable
+{
+private:
+    HostMap map;
+public:
+    SnapshotTable() : map(1024) {}
+
+    HostMap& get() { return map; }
+    void reload(const Hosts& t, uint32_t round)
+    {
+        HostMap::Builder next(map, t.names.size());
+        for (size_t i = 0; i < t.names.size(); ++i)
+            next.put(t.names[i], t.ips[i] + round);
+        map.publish(move(next));
+    }
+    void patch(const Hosts& t, uint32_t round)
+    {
+        HostMap::Builder next(map);
+        for (size_t i = round % 100; i < t.names.size(); i += 100)
+            next.put(t.names[i], t.ips[i] + round);
+        map.publish(move(next));
+    }
+};
+
+// Reader loop over ops[first, last) for each kind of table
+size_t serve(LockedTable& table, const Hosts& t, size_t first, size_t last)
+{
+    size_t found = 0;
+    uint32_t ip = 0;
+    for (size_t i = first; i < last; ++i)
+        found += table.find(t.names[t.ops[i]], ip);
+    Benchmark::keep(ip);
+    return found;
+}
+
+size_t serve(SnapshotTable& table, const Hosts& t, size_t first, size_t last)
+{
+    HostMap::Reader reader(table.get());
+    size_t found = 0;
+    uint32_t ip = 0;
+    for (size_t i = first; i < last; ++i)
+        found += reader.find(t.names[t.ops[i]], ip);
+    Benchmark::keep(ip);
+    return found;
+}
+
+// Look up all ops with 1 up to maxThreads readers while one writer reloads
+template<typename Kind>
+void bench(Benchmark& bm, const string& name, const Hosts& t, int maxThreads, bool diff)
+{
+    vector<size_t> reloads;
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        Kind table;
+        table.reload(t, 0);
+        atomic<int> running(threads);
+        size_t rounds = 0;
+        size_t per = t.ops.size() / threads;
+        bm.run(name + " " + to_string(threads) + " threads", per * threads, [&]() {
+            vector<thread> readers;
+            for (int r = 0; r < threads; ++r)
+            {
+                readers.emplace_back([&, r]() {
+                    Benchmark::keep(serve(table, t, r * per, (r + 1) * per));
+                    --running;
+                });
+            }
+            while (running > 0)
+            {
+                ++rounds;
+                if (diff)
+                    table.patch(t, static_cast<uint32_t>(rounds));
+                else
+                    table.reload(t, static_cast<uint32_t>(rounds));
+            }
+            for (thread& reader : readers)
+                reader.join();
+        });
+        reloads.push_back(rounds);
+    }
+    cout << name << " reloads:";
+    for (size_t r : reloads)
+        cout << " " << r;
+    cout << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc == 1)
+    {
+        cerr << "Usage: argv[0] filename [names] [threads] [ops]" << endl;
+        exit(EXIT_FAILURE);
+    }
+    size_t count = argc > 2 ? atol(argv[2]) : 100000;
+    int maxThreads = argc > 3 ? atoi(argv[3]) : 16;
+    size_t total = argc > 4 ? atol(argv[4]) : 4000000;
+    if (count < 1 || maxThreads < 1 || maxThreads > 1024)
+    {
+        cerr << "Usage: argv[0] filename [names] [threads] [ops]" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    vector<string> hosts;
+    vector<uint32_t> ips;
+    Tokenizer in(argv[1]);
+    if (!in.isOpen())
+    {
+        cerr << "Can not open " << argv[1] << endl;
+        exit(EXIT_FAILURE);
+    }
+    StringView line;
+    while (in.nextLine(line))
+    {
+        const char* comma = static_cast<const char*>(memchr(line.data(), ',', line.size()));
+        if (comma == nullptr)
+            continue;
+        size_t len = comma - line.data();
+        hosts.push_back(string(line.data(), len));
+        uint32_t ip = 0, part = 0;
+        for (const char* p = comma + 1; p != line.data() + line.size(); ++p)
+        {
+            if (*p == '.')
+            {
+                ip = ip << 8 | part;
+                part = 0;
+            }
+            else
+            {
+                part = part * 10 + (*p - '0');
+            }
+        }
+        ips.push_back(ip << 8 | part);
+    }
+    // Name i is "<i / hosts>.<host>", resolving to the host's address plus i / hosts
+    Hosts t;
+    for (size_t i = 0; i < count; ++i)
+    {
+        t.names.push_back(to_string(i / hosts.size()) + "." + hosts[i % hosts.size()]);
+        t.ips.push_back(ips[i % hosts.size()] + uint32_t(i / hosts.size()));
+    }
+    uint64_t x = 88172645463325252ULL;
+    for (size_t i = 0; i < total; ++i)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        t.ops.push_back(static_cast<uint32_t>(x % count));
+    }
+
+    Benchmark bm;
+    bm.header(to_string(total) + " lookups of " + to_string(count) + " names during reloads:");
+    bench<LockedTable>(bm, "RwLock full", t, maxThreads, false);
+    bench<SnapshotTable>(bm, "SnapshotMap full", t, maxThreads, false);
+    bench<LockedTable>(bm, "RwLock diff", t, maxThreads, true);
+    bench<SnapshotTable>(bm, "SnapshotMap diff", t, maxThreads, true);
+    return 0;
+}
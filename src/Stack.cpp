@@ -0,0 +1,46 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++11 -Iinclude src/Stack.cpp -o Stack
+ * Execution:    ./Stack data/tobe.txt
+ * Dependencies: ArrayStack.h Tokenizer.h
+ *
+ * % more data/tobe.txt 
+ * to be or not to - be - - that - - - is
+ *
+ * % ./Stack data/tobe.txt
+ * to be not that or be (2 left on stack)
+ ******************************************************************************/
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "ArrayStack.h"
+#include "Tokenizer.h"
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    ArrayStack<string> stack;
+    StringView elem;
+
+    if (argc == 1)
+    {
+        cerr << "Usage: argv[0] filename" << endl;
+        exit(EXIT_FAILURE);
+    }
+    Tokenizer in(argv[1]);
+    if (!in.isOpen())
+    {
+        cerr << "Can not open " << argv[1] << endl;
+        exit(EXIT_FAILURE);
+    }
+    while (in.next(elem))
+    {
+        if (elem != "-")
+            stack.push(elem.str());
+        else
+            cout << stack.pop() << " ";
+    }
+    cout << "(" << stack.size() << " left on stack)" << endl;
+    return 0;
+}
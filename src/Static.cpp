@@ -0,0 +1,105 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++14 -O2 -Iinclude src/Static.cpp -o Static
+ * Execution:    ./Static [count]
+ * Dependencies: StaticStack.h StaticRingQueue.h ArrayStack.h ArrayQueue.h
+ *               Benchmark.h
+ *
+ * Runs the same templated producer/consumer loops over the heap-allocated
+ * ArrayStack and ArrayQueue and the inline StaticStack and StaticRingQueue.
+ * Built as C++14, it also prints a table computed at compile time with a
+ * StaticRingQueue.
+ ******************************************************************************/
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "ArrayQueue.h"
+#include "ArrayStack.h"
+#include "Benchmark.h"
+#include "StaticRingQueue.h"
+#include "StaticStack.h"
+
+using namespace std;
+
+// Keep a window of the last 64 values in flight, as a bounded pipeline stage would
+template<typename Queue>
+uint64_t pipeline(Queue& q, size_t count)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (q.size() == 64)
+            sum += q.dequeue();
+        q.enqueue(i);
+    }
+    uint64_t elem;
+    while (q.tryDequeue(elem))
+        sum += elem;
+    return sum;
+}
+
+// Push and pop in bursts of up to 32, as an explicit DFS stack would
+template<typename Stack>
+uint64_t bursts(Stack& s, size_t count)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i += 32)
+    {
+        for (size_t j = 0; j < 32; ++j)
+            s.push(i + j);
+        while (!s.isEmpty())
+            sum += s.pop();
+    }
+    return sum;
+}
+
+#if __cplusplus >= 201402L
+// F(0) to F(15), each the sum of the two values in a ring of two
+constexpr StaticStack<uint64_t, 16> fibonacci()
+{
+    StaticStack<uint64_t, 16> table;
+    StaticRingQueue<uint64_t, 2> last;
+    last.enqueue(0);
+    last.enqueue(1);
+    while (!table.isFull())
+    {
+        table.push(last.front());
+        uint64_t next = last.front() + last.back();
+        last.dequeue();
+        last.enqueue(next);
+    }
+    return table;
+}
+
+constexpr StaticStack<uint64_t, 16> FIBONACCI = fibonacci();
+static_assert(FIBONACCI.top() == 610, "F(15) is 610");
+#endif
+
+int main(int argc, char* argv[])
+{
+    size_t count = argc > 1 ? atol(argv[1]) : 100000000;
+
+    Benchmark bm;
+    bm.header("Bounded stacks and queues over " + to_string(count) + " elements:");
+    bm.run("ArrayQueue pipeline", count, [&]() {
+        ArrayQueue<uint64_t> q;
+        Benchmark::keep(pipeline(q, count));
+    });
+    bm.run("StaticRingQueue pipeline", count, [&]() {
+        StaticRingQueue<uint64_t, 64> q;
+        Benchmark::keep(pipeline(q, count));
+    });
+    bm.run("ArrayStack bursts", count, [&]() {
+        ArrayStack<uint64_t> s;
+        Benchmark::keep(bursts(s, count));
+    });
+    bm.run("StaticStack bursts", count, [&]() {
+        StaticStack<uint64_t, 32> s;
+        Benchmark::keep(bursts(s, count));
+    });
+#if __cplusplus >= 201402L
+    cout << "Computed at compile time: " << FIBONACCI << endl;
+#endif
+    return 0;
+}
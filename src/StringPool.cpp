@@ -0,0 +1,116 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++11 -O2 -Iinclude src/StringPool.cpp -o StringPool -pthread
+ * Execution:    ./StringPool data/ip.csv [count] [threads]
+ * Dependencies: StringPool.h Tokenizer.h Benchmark.h
+ *
+ * Fills containers with count hostnames drawn from data/ip.csv, once as
+ * std::string and once as StrId from a StringPool, and compares their
+ * memory and the cost of building and searching them. Then interns the same
+ * stream from several threads through a ShardedStringPool.
+ ******************************************************************************/
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ArrayQueue.h"
+#include "Benchmark.h"
+#include "StringPool.h"
+#include "Tokenizer.h"
+#include "VectorAlgorithm.h"
+
+using namespace std;
+
+using TrackedString = basic_string<char, char_traits<char>, PolymorphicAllocator<char>>;
+
+int main(int argc, char* argv[])
+{
+    if (argc == 1)
+    {
+        cerr << "Usage: argv[0] filename [count] [threads]" << endl;
+        exit(EXIT_FAILURE);
+    }
+    int count = argc > 2 ? atoi(argv[2]) : 10000000;
+    int threads = argc > 3 ? atoi(argv[3]) : 4;
+
+    vector<string> hosts;
+    Tokenizer in(argv[1]);
+    if (!in.isOpen())
+    {
+        cerr << "Can not open " << argv[1] << endl;
+        exit(EXIT_FAILURE);
+    }
+    StringView line;
+    while (in.nextLine(line))
+    {
+        const char* comma = static_cast<const char*>(memchr(line.data(), ',', line.size()));
+        hosts.push_back(string(line.data(), comma != nullptr ? comma - line.data() : line.size()));
+    }
+    vector<uint32_t> picks(count);
+    uint32_t x = 2463534242u;
+    for (int i = 0; i < count; ++i)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        picks[i] = x % hosts.size();
+    }
+    const string& needle = hosts[hosts.size() / 2];
+
+    Benchmark bm;
+    bm.header(to_string(count) + " hostnames from " + to_string(hosts.size()) + " distinct:");
+
+    // Route the strings' heap buffers through a TrackingResource to count them
+    TrackingResource tracking;
+    setDefaultResource(&tracking);
+    Vector<TrackedString> strings(count);
+    bm.run("Vector<string> build", count, [&]() {
+        for (int i = 0; i < count; ++i)
+            strings.insert_back(TrackedString(hosts[picks[i]].data(), hosts[picks[i]].size()));
+    });
+    setDefaultResource(newDeleteResource());
+    TrackedString key(needle.data(), needle.size(), PolymorphicAllocator<char>(newDeleteResource()));
+    bm.run("Vector<string> count", count, [&]() { Benchmark::keep(vectorCount(strings, key)); });
+
+    StringPool pool;
+    Vector<StrId> ids(count);
+    bm.run("Vector<StrId> build", count, [&]() {
+        for (int i = 0; i < count; ++i)
+            ids.insert_back(pool.intern(hosts[picks[i]]));
+    });
+    StrId id = pool.intern(needle);
+    bm.run("Vector<StrId> count", count, [&]() { Benchmark::keep(vectorCount(ids, id)); });
+
+    ArrayQueue<StrId> queue;
+    bm.run("ArrayQueue<StrId> drain", count, [&]() {
+        for (int i = 0; i < count; ++i)
+            queue.enqueue(ids[i]);
+        size_t len = 0;
+        StrId elem;
+        while (queue.tryDequeue(elem))
+            len += pool.str(elem).size();
+        Benchmark::keep(len);
+    });
+
+    ShardedStringPool sharded;
+    int per = count / threads;
+    bm.run("ShardedStringPool " + to_string(threads) + " threads", size_t(per) * threads, [&]() {
+        vector<thread> workers;
+        for (int t = 0; t < threads; ++t)
+            workers.emplace_back([&, t]() {
+                for (int i = t * per; i < (t + 1) * per; ++i)
+                    Benchmark::keep(sharded.intern(hosts[picks[i]]));
+            });
+        for (auto& w : workers)
+            w.join();
+    });
+
+    size_t stringBytes = count * sizeof(TrackedString) + tracking.bytesAllocated();
+    size_t idBytes = count * sizeof(StrId) + pool.bytes();
+    cout << "Vector<string>: " << stringBytes / (1 << 20) << " MiB, "
+         << "Vector<StrId> + pool: " << idBytes / (1 << 20) << " MiB ("
+         << pool.size() << " strings, " << pool.bytes() << " bytes)" << endl;
+    return 0;
+}
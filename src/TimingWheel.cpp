@@ -0,0 +1,168 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++11 -O2 -Iinclude src/TimingWheel.cpp -o TimingWheel
+ * Execution:    ./TimingWheel [count] [horizon]
+ * Dependencies: TimingWheel.h Benchmark.h
+ *
+ * Schedules count timers with random delays of up to horizon ticks, cancels
+ * every other one and runs the clock until the rest expire, on a timing
+ * wheel and on an indexed binary heap that supports cancellation.
+ ******************************************************************************/
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "TimingWheel.h"
+
+using namespace std;
+
+/**
+ * Binary min-heap of (expiry, id) with each id's position tracked, so a
+ * timer can be removed in O(log n).
+ */
+class HeapTimers
+{
+private:
+    struct Node
+    {
+        uint64_t expiry;
+        uint32_t id;
+    };
+
+    vector<Node> heap;
+    vector<int> pos;
+
+    void put(size_t i, const Node& n)
+    {
+        heap[i] = n;
+        pos[n.id] = i;
+    }
+    void up(size_t i)
+    {
+        Node n = heap[i];
+        for (; i > 0 && n.expiry < heap[(i - 1) / 2].expiry; i = (i - 1) / 2)
+            put(i, heap[(i - 1) / 2]);
+        put(i, n);
+    }
+    void down(size_t i)
+    {
+        Node n = heap[i];
+        for (size_t c; (c = 2 * i + 1) < heap.size(); i = c)
+        {
+            if (c + 1 < heap.size() && heap[c + 1].expiry < heap[c].expiry)
+                ++c;
+            if (!(heap[c].expiry < n.expiry))
+                break;
+            put(i, heap[c]);
+        }
+        put(i, n);
+    }
+public:
+    explicit HeapTimers(size_t ids) : pos(ids, -1) {}
+
+    void schedule(uint32_t id, uint64_t expiry)
+    {
+        heap.push_back(Node{ expiry, id });
+        up(heap.size() - 1);
+    }
+    bool cancel(uint32_t id)
+    {
+        if (pos[id] < 0)
+            return false;
+        size_t i = pos[id];
+        pos[id] = -1;
+        Node last = heap.back();
+        heap.pop_back();
+        if (i < heap.size())
+        {
+            put(i, last);
+            up(i);
+            down(pos[last.id]);
+        }
+        return true;
+    }
+    // Pop every timer due by tick and return how many there were
+    size_t advance(uint64_t tick)
+    {
+        size_t n = 0;
+        while (!heap.empty() && heap[0].expiry <= tick)
+        {
+            pos[heap[0].id] = -1;
+            Node last = heap.back();
+            heap.pop_back();
+            if (!heap.empty())
+            {
+                put(0, last);
+                down(0);
+            }
+            ++n;
+        }
+        return n;
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    size_t count = argc > 1 ? atol(argv[1]) : 10000000;
+    uint64_t horizon = argc > 2 ? atol(argv[2]) : 100000;
+    vector<uint64_t> delays(count);
+    uint64_t x = 88172645463325252ull;
+    for (size_t i = 0; i < count; ++i)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        delays[i] = 1 + x % horizon;
+    }
+
+    Benchmark bm;
+    bm.header("Scheduling " + to_string(count) + " timers up to " + to_string(horizon)
+              + " ticks out, cancelling half, expiring the rest:");
+
+    // Timers are scheduled while the clock moves one tick per 100 timers
+    vector<TimerHandle> handles(count);
+    TimingWheel<uint32_t> wheel;
+    size_t fired = 0;
+    auto collect = [&](const Vector<uint32_t>& batch) { fired += batch.size(); };
+    bm.run("TimingWheel schedule", count, [&]() {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (i % 100 == 0)
+                wheel.advance(i / 100, collect);
+            handles[i] = wheel.schedule(delays[i], i);
+        }
+    });
+    bm.run("TimingWheel cancel", count / 2, [&]() {
+        for (size_t i = 0; i < count; i += 2)
+            wheel.cancel(handles[i]);
+    });
+    bm.run("TimingWheel expire", count - count / 2, [&]() {
+        wheel.advance(count / 100 + horizon, collect);
+    });
+    size_t wheelFired = fired;
+
+    HeapTimers heap(count);
+    fired = 0;
+    bm.run("binary heap schedule", count, [&]() {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (i % 100 == 0)
+                fired += heap.advance(i / 100);
+            heap.schedule(i, i / 100 + delays[i]);
+        }
+    });
+    bm.run("binary heap cancel", count / 2, [&]() {
+        for (size_t i = 0; i < count; i += 2)
+            heap.cancel(i);
+    });
+    bm.run("binary heap expire", count - count / 2, [&]() {
+        fired += heap.advance(count / 100 + horizon);
+    });
+    if (fired != wheelFired)
+    {
+        cout << "Mismatch: the wheel fired " << wheelFired << " timers, the heap " << fired << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+/*******************************************************************************
+ * Compilation:  g++ -std=c++11 -O2 -Iinclude src/Window.cpp -o Window
+ * Execution:    ./Window [count] [span]
+ * Dependencies: Window.h Benchmark.h
+ *
+ * Feeds count events, stamped as if arriving at 10^7 events per second,
+ * through sliding windows bounded by span events or by the milliseconds
+ * span events take to arrive, and compares them with rescanning the window
+ * on every event.
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "Window.h"
+
+using namespace std;
+
+// Events per millisecond at 10^7 events per second
+const size_t RATE = 10000;
+
+struct Min {
+    uint32_t operator()(uint32_t a, uint32_t b) const { return b < a ? b : a; }
+};
+
+int main(int argc, char* argv[])
+{
+    size_t count = argc > 1 ? atol(argv[1]) : 10000000;
+    size_t span = argc > 2 ? atol(argv[2]) : 1000;
+    size_t millis = max<size_t>(span / RATE, 1);
+    vector<uint32_t> events(count);
+    uint32_t x = 2463534242u;
+    for (size_t i = 0; i < count; ++i)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        events[i] = x % 1000000u;
+    }
+
+    Benchmark bm;
+    bm.header("Sliding windows of " + to_string(span) + " events (" + to_string(millis) + " ms) over "
+              + to_string(count) + " events:");
+
+    // Rescanning costs O(span) per event, so it only sees a prefix of the stream
+    size_t prefix = min(count, max<size_t>(count / span * 10, 1000));
+    bm.run("rescan min", prefix, [&]() {
+        ArrayQueue<uint32_t> window;
+        uint64_t acc = 0;
+        for (size_t i = 0; i < prefix; ++i)
+        {
+            window.enqueue(events[i]);
+            if (static_cast<size_t>(window.size()) > span)
+                window.dequeue();
+            acc += *min_element(window.begin(), window.end());
+        }
+        Benchmark::keep(acc);
+    });
+    bm.run("MinWindow count", count, [&]() {
+        MinWindow<uint32_t> window(WindowBy::COUNT, span);
+        uint64_t acc = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            window.push(events[i]);
+            acc += window.value();
+        }
+        Benchmark::keep(acc);
+    });
+    bm.run("MaxWindow time", count, [&]() {
+        MaxWindow<uint32_t> window(WindowBy::TIME, millis);
+        uint64_t acc = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            window.push(events[i], i / RATE);
+            acc += window.value();
+        }
+        Benchmark::keep(acc);
+    });
+    bm.run("AggregateWindow sum count", count, [&]() {
+        AggregateWindow<uint64_t> window(WindowBy::COUNT, span);
+        uint64_t acc = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            window.push(events[i]);
+            acc += window.value();
+        }
+        Benchmark::keep(acc);
+    });
+    bm.run("AggregateWindow min time", count, [&]() {
+        AggregateWindow<uint32_t, Min> window(WindowBy::TIME, millis);
+        uint64_t acc = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            window.push(events[i], i / RATE);
+            acc += window.value();
+        }
+        Benchmark::keep(acc);
+    });
+    bm.run("MinWindow Timer stamps", count, [&]() {
+        MinWindow<uint32_t> window(WindowBy::TIME, millis);
+        uint64_t acc = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            window.push(events[i]);
+            acc += window.value();
+        }
+        Benchmark::keep(acc);
+    });
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "BitVector.h"
+#include "TestError.h"
+#include "gtest/gtest.h"
+
+class TestBitVector : public testing::Test
+{
+protected:
+    std::mt19937_64 rng;
+    size_t scale;
+public:
+    virtual void SetUp() { rng.seed(2017); scale = 100000; }
+    virtual void TearDown() { simdLimit(SimdLevel::AVX512); }
+
+    // Fill bv and ref with n bits, each set with probability percent / 100
+    void fill(BitVector<>& bv, std::vector<bool>& ref, size_t n, int percent)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            bool bit = int(rng() % 100) < percent;
+            bv.insert_back(bit);
+            ref.push_back(bit);
+        }
+    }
+    void expectRankSelect(const BitVector<>& bv, const std::vector<bool>& ref)
+    {
+        RankSelect rs(bv);
+        std::vector<size_t> ones;
+        for (size_t i = 0; i <= ref.size(); ++i)
+        {
+            ASSERT_EQ(ones.size(), rs.rank1(i));
+            if (i < ref.size() && ref[i])
+                ones.push_back(i);
+        }
+        ASSERT_EQ(ones.size(), rs.count());
+        for (size_t k = 0; k < ones.size(); ++k)
+            ASSERT_EQ(ones[k], rs.select1(k));
+        EXPECT_ERROR(rs.select1(ones.size()), std::out_of_range);
+    }
+};
+
+TEST_F(TestBitVector, Bits)
+{
+    BitVector<> bv(130, true);
+    EXPECT_EQ(size_t(130), bv.count());
+    bv.reset(0);
+    bv.flip(129);
+    bv.set(1, false);
+    EXPECT_FALSE(bv[0]);
+    EXPECT_FALSE(bv.at(129));
+    EXPECT_EQ(size_t(127), bv.count());
+    EXPECT_ERROR(bv.at(130), std::out_of_range);
+
+    bv.resize(70);
+    EXPECT_EQ(size_t(68), bv.count());
+    bv.resize(200, true);
+    EXPECT_EQ(size_t(198), bv.count());
+    bv.resize(260);
+    EXPECT_EQ(size_t(198), bv.count());
+    EXPECT_EQ(5, bv.wordCount());
+}
+
+TEST_F(TestBitVector, Ranges)
+{
+    BitVector<> bv;
+    std::vector<bool> ref;
+    fill(bv, ref, 5000, 50);
+    for (int op = 0; op < 200; ++op)
+    {
+        size_t first = rng() % (ref.size() + 1);
+        size_t last = rng() % (ref.size() + 1);
+        if (first > last)
+            std::swap(first, last);
+        int kind = op % 3;
+        if (kind == 0)
+            bv.setRange(first, last);
+        else if (kind == 1)
+            bv.resetRange(first, last);
+        else
+            bv.flipRange(first, last);
+        for (size_t i = first; i < last; ++i)
+            ref[i] = kind == 0 ? true : (kind == 1 ? false : !ref[i]);
+        size_t expected = 0;
+        for (size_t i = first / 2; i < last; ++i)
+            expected += ref[i];
+        ASSERT_EQ(expected, bv.count(first / 2, last));
+    }
+    for (size_t i = 0; i < ref.size(); ++i)
+        ASSERT_EQ(ref[i], bv[i]);
+    EXPECT_ERROR(bv.setRange(10, ref.size() + 1), std::out_of_range);
+    EXPECT_ERROR(bv.count(10, 5), std::out_of_range);
+}
+
+TEST_F(TestBitVector, Logic)
+{
+    BitVector<> a(300), b(300);
+    a.setRange(0, 200);
+    b.setRange(100, 300);
+    BitVector<> c(a);
+    c &= b;
+    EXPECT_EQ(size_t(100), c.count());
+    c = a;
+    c |= b;
+    EXPECT_EQ(size_t(300), c.count());
+    c = a;
+    c ^= b;
+    EXPECT_EQ(size_t(200), c.count());
+    EXPECT_TRUE(a != b);
+    b.resetRange(200, 300);
+    b.setRange(0, 100);
+    EXPECT_TRUE(a == b);
+    EXPECT_ERROR(a &= BitVector<>(10), std::invalid_argument);
+}
+
+TEST_F(TestBitVector, RankSelect)
+{
+    size_t sizes[] = { 0, 1, 64, 511, 512, 2047, 2048, 2049, scale };
+    int percents[] = { 1, 50, 100 };
+    for (size_t n : sizes)
+    {
+        for (int percent : percents)
+        {
+            BitVector<> bv;
+            std::vector<bool> ref;
+            fill(bv, ref, n, percent);
+            expectRankSelect(bv, ref);
+        }
+    }
+}
+
+TEST_F(TestBitVector, Sparse)
+{
+    // Gaps of up to 2^17 bits put thousands of blocks between select samples
+    size_t n = size_t(1) << 26;
+    BitVector<> bv(n);
+    std::vector<size_t> ones;
+    for (size_t i = rng() % 1000; i < n; i += 1 + rng() % (size_t(1) << 17))
+    {
+        // An occasional dense run, so samples are unevenly spaced too
+        size_t run = ones.size() % 97 == 0 ? 20000 : 1;
+        for (size_t j = i; j < n && j < i + run; j += 2)
+        {
+            bv.set(j);
+            ones.push_back(j);
+        }
+        i = ones.back();
+    }
+    for (SimdLevel limit : { SimdLevel::SCALAR, SimdLevel::AVX512 })
+    {
+        simdLimit(limit);
+        RankSelect rs(bv);
+        ASSERT_EQ(ones.size(), rs.count());
+        for (size_t k = 0; k < ones.size(); ++k)
+        {
+            ASSERT_EQ(ones[k], rs.select1(k));
+            ASSERT_EQ(k, rs.rank1(ones[k]));
+        }
+    }
+}
+
+TEST_F(TestBitVector, Scalar)
+{
+    simdLimit(SimdLevel::SCALAR);
+    BitVector<> bv;
+    std::vector<bool> ref;
+    fill(bv, ref, scale, 30);
+    expectRankSelect(bv, ref);
+    uint64_t w = 0xF0F0F0F0F0F0F0F1ULL;
+    for (int i = 0, k = 0; i < 64; ++i)
+    {
+        if ((w >> i) & 1)
+        {
+            EXPECT_EQ(i, bitSelect(w, k));
+            k++;
+        }
+    }
+}
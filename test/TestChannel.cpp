@@ -0,0 +1,149 @@
+#include <atomic>
+#include <optional>
+#include <vector>
+#include "Channel.h"
+#include "Executor.h"
+#include "TestError.h"
+#include "gtest/gtest.h"
+
+using std::optional;
+using std::vector;
+
+Task produce(Channel<int>& out, int from, int count, bool close)
+{
+    for (int i = from; i < from + count; ++i)
+        co_await out.send(i);
+    if (close)
+        out.close();
+}
+
+Task consume(Channel<int>& in, vector<int>& got)
+{
+    while (optional<int> x = co_await in.recv())
+        got.push_back(*x);
+}
+
+Task sendOne(Channel<int>& out, int x, std::atomic<int>& results)
+{
+    bool sent = co_await out.send(x);
+    results += sent ? 1 : 100;
+}
+
+Task recvOne(Channel<int>& in, std::atomic<int>& results)
+{
+    optional<int> x = co_await in.recv();
+    results += x ? 1 : 100;
+}
+
+class TestChannel : public testing::Test
+{
+protected:
+    int scale;
+public:
+    virtual void SetUp() { scale = 10000; }
+    virtual void TearDown() {}
+};
+
+TEST_F(TestChannel, Rendezvous)
+{
+    // With capacity 0 nothing is buffered: every value goes sender to receiver
+    for (int cap : { 0, 1, 16 })
+    {
+        LoopExecutor ex;
+        Channel<int> ch(ex, cap);
+        vector<int> got;
+        ex.spawn(consume(ch, got));
+        ex.spawn(produce(ch, 0, scale, true));
+        EXPECT_EQ(0, ex.run());
+        ASSERT_EQ(size_t(scale), got.size());
+        for (int i = 0; i < scale; ++i)
+            ASSERT_EQ(i, got[i]);
+        EXPECT_EQ(0, ch.size());
+        EXPECT_TRUE(ch.isClosed());
+    }
+}
+
+TEST_F(TestChannel, CloseWakesWaiters)
+{
+    LoopExecutor ex;
+    Channel<int> ch(ex, 0);
+    std::atomic<int> results(0);
+    // A lone sender on a rendezvous channel waits for a receiver
+    ex.spawn(sendOne(ch, 1, results));
+    ex.spawn(sendOne(ch, 2, results));
+    EXPECT_EQ(2, ex.run());
+    EXPECT_EQ(0, ch.size());
+    // A receiver takes the first waiting sender's value directly
+    ex.spawn(recvOne(ch, results));
+    EXPECT_EQ(1, ex.run());
+    EXPECT_EQ(2, results.load());
+    // Closing fails the remaining sender and later sends and receives
+    ch.close();
+    EXPECT_EQ(0, ex.run());
+    EXPECT_EQ(102, results.load());
+    ex.spawn(sendOne(ch, 3, results));
+    ex.spawn(recvOne(ch, results));
+    EXPECT_EQ(0, ex.run());
+    EXPECT_EQ(302, results.load());
+
+    Channel<int> idle(ex, 0);
+    results = 0;
+    ex.spawn(recvOne(idle, results));
+    ex.spawn(recvOne(idle, results));
+    EXPECT_EQ(2, ex.run());
+    idle.close();
+    EXPECT_EQ(0, ex.run());
+    EXPECT_EQ(200, results.load());
+}
+
+TEST_F(TestChannel, Drain)
+{
+    LoopExecutor ex;
+    Channel<int> ch(ex, 4);
+    std::atomic<int> results(0);
+    ex.spawn(produce(ch, 0, 3, true));
+    EXPECT_EQ(0, ex.run());
+    EXPECT_EQ(3, ch.size());
+    ex.spawn(sendOne(ch, 3, results));
+    EXPECT_EQ(0, ex.run());
+    EXPECT_EQ(100, results.load());
+    // Buffered values are still delivered after close, then receives end
+    vector<int> got;
+    ex.spawn(consume(ch, got));
+    EXPECT_EQ(0, ex.run());
+    EXPECT_EQ(vector<int>({ 0, 1, 2 }), got);
+    EXPECT_ERROR(Channel<int>(ex, -1), std::invalid_argument);
+}
+
+TEST_F(TestChannel, Pool)
+{
+    for (int cap : { 0, 8 })
+    {
+        PoolExecutor ex(4);
+        Channel<int> ch(ex, cap);
+        const int producers = 4, consumers = 3;
+        vector<vector<int>> got(consumers);
+        for (int c = 0; c < consumers; ++c)
+            ex.spawn(consume(ch, got[c]));
+        for (int p = 0; p < producers; ++p)
+            ex.spawn(produce(ch, p * scale, scale, false));
+        // Consumers stay suspended until the channel is closed
+        EXPECT_EQ(consumers, ex.run());
+        ch.close();
+        EXPECT_EQ(0, ex.run());
+        vector<int> seen(producers * scale, 0);
+        for (const vector<int>& g : got)
+        {
+            // Each producer's values reach any one consumer in order
+            vector<int> last(producers, -1);
+            for (int x : g)
+            {
+                ASSERT_LT(last[x / scale], x);
+                last[x / scale] = x;
+                seen[x]++;
+            }
+        }
+        for (int n : seen)
+            ASSERT_EQ(1, n);
+    }
+}
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <vector>
+#include "CompressedVector.h"
+#include "TestError.h"
+#include "gtest/gtest.h"
+
+using std::vector;
+
+class TestCompressedVector : public testing::Test
+{
+protected:
+    std::mt19937_64 rng;
+public:
+    virtual void SetUp() { rng.seed(2017); }
+    virtual void TearDown() {}
+
+    // Sorted values whose blocks need every delta width from 0 to 24 bits
+    vector<uint32_t> widths(int blocks, int extra)
+    {
+        vector<uint32_t> a;
+        uint32_t x = 0;
+        for (int b = 0; b < blocks; ++b)
+        {
+            int w = b % 25;
+            for (int i = 0; i < CompressedVector::BLOCK; ++i)
+            {
+                if (w >= 2)
+                    x += uint32_t(rng() % (uint64_t(1) << (w - 2)));
+                a.push_back(x);
+            }
+        }
+        for (int i = 0; i < extra; ++i)
+            a.push_back(x += uint32_t(rng() % 3));
+        return a;
+    }
+
+    // Compare every way of reading c with the sorted model a
+    void compare(const vector<uint32_t>& a, const CompressedVector& c)
+    {
+        ASSERT_EQ(int(a.size()), c.size());
+        ASSERT_EQ((int(a.size()) + 127) / 128, c.blocks());
+        for (size_t i = 0; i < a.size(); ++i)
+            ASSERT_EQ(a[i], c[int(i)]);
+        vector<uint32_t> got;
+        for (uint32_t x : c)
+            got.push_back(x);
+        ASSERT_EQ(a, got);
+        got.clear();
+        c.for_each([&](uint32_t x) { got.push_back(x); });
+        ASSERT_EQ(a, got);
+        uint32_t block[CompressedVector::BLOCK];
+        for (int b = 0; b < c.blocks(); ++b)
+        {
+            int count = c.decode(b, block);
+            ASSERT_EQ(std::min<int>(128, c.size() - b * 128), count);
+            ASSERT_TRUE(std::equal(block, block + count, a.begin() + b * 128));
+        }
+        // lower_bound at every value, just around it, and at random points
+        vector<uint32_t> probes = { 0, UINT32_MAX };
+        for (size_t i = 0; i < a.size(); i += 1 + rng() % 5)
+        {
+            probes.push_back(a[i]);
+            probes.push_back(a[i] + 1);
+            probes.push_back(a[i] - 1);
+        }
+        for (int i = 0; i < 1000; ++i)
+            probes.push_back(uint32_t(rng()));
+        for (uint32_t x : probes)
+            ASSERT_EQ(int(std::lower_bound(a.begin(), a.end(), x) - a.begin()), c.lower_bound(x));
+    }
+};
+
+TEST_F(TestCompressedVector, Widths)
+{
+    for (int extra : { 0, 1, 77, 127 })
+    {
+        vector<uint32_t> a = widths(60, extra);
+        CompressedVector c(a.begin(), a.end());
+        compare(a, c);
+        // Narrow deltas take far less than four bytes a value
+        EXPECT_LT(c.bytes(), a.size() * sizeof(uint32_t) / 2);
+    }
+}
+
+TEST_F(TestCompressedVector, Extremes)
+{
+    // Full 32-bit deltas, long runs of one value and the largest value
+    vector<uint32_t> a;
+    for (int i = 0; i < 300; ++i)
+        a.push_back(i < 150 ? 0 : UINT32_MAX);
+    for (int i = 0; i < 10; ++i)
+        a.push_back(UINT32_MAX);
+    CompressedVector c(a.begin(), a.end());
+    compare(a, c);
+
+    vector<uint32_t> r(5000);
+    for (uint32_t& x : r)
+        x = uint32_t(rng());
+    std::sort(r.begin(), r.end());
+    CompressedVector d(r.begin(), r.end());
+    compare(r, d);
+    for (size_t n = 0; n <= 260; ++n)
+    {
+        vector<uint32_t> prefix(r.begin(), r.begin() + n);
+        CompressedVector p(prefix.begin(), prefix.end());
+        compare(prefix, p);
+    }
+}
+
+TEST_F(TestCompressedVector, Basics)
+{
+    CompressedVector c;
+    EXPECT_TRUE(c.empty());
+    EXPECT_EQ(0, c.lower_bound(5));
+    EXPECT_ERROR(c.front(), std::out_of_range);
+    EXPECT_ERROR(c.at(0), std::out_of_range);
+    for (uint32_t x = 0; x < 300; ++x)
+        c.insert_back(x * 3);
+    EXPECT_EQ(0u, c.front());
+    EXPECT_EQ(897u, c.back());
+    EXPECT_EQ(897u, c.at(299));
+    EXPECT_ERROR(c.at(300), std::out_of_range);
+    EXPECT_ERROR(c.insert_back(896), std::invalid_argument);
+    EXPECT_NO_ERROR(c.insert_back(897));
+    EXPECT_EQ(301, c.size());
+
+    vector<uint32_t> a(c.begin(), c.end());
+    CompressedVector d(a.begin(), a.end());
+    EXPECT_TRUE(c == d);
+    d.insert_back(1000);
+    EXPECT_TRUE(c != d);
+    swap(c, d);
+    EXPECT_EQ(302, c.size());
+    EXPECT_EQ(301, d.size());
+    c.clear();
+    EXPECT_TRUE(c.empty());
+    c.insert_back(7);
+    std::ostringstream os;
+    os << c;
+    EXPECT_EQ("7 ", os.str());
+}
@@ -0,0 +1,87 @@
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include "ArrayQueue.h"
+#include "ArrayStack.h"
+#include "ContainerStats.h"
+#include "LinkedQueue.h"
+#include "Vector.h"
+#include "gtest/gtest.h"
+
+#ifdef CPPLIB_STATS
+
+class TestContainerStats : public testing::Test
+{
+public:
+    virtual void SetUp() { StatsRegistry::instance().reset(); }
+    virtual void TearDown() {}
+};
+
+TEST_F(TestContainerStats, Counters)
+{
+    Vector<int> v(100);
+    for (int i = 0; i < 50; ++i)
+        v.insert_back(i);
+    const ContainerStats& vs = v.stats();
+    EXPECT_EQ(size_t(100), vs.peakCapacity.load());
+    EXPECT_EQ(size_t(50), vs.peakSize.load());
+    EXPECT_EQ(size_t(1), vs.allocations.load());
+    EXPECT_EQ(100 * sizeof(int), vs.bytes.load());
+    EXPECT_EQ(size_t(0), vs.grows.load());
+
+    for (int i = 50; i < 101; ++i)
+        v.insert_back(i);
+    EXPECT_EQ(size_t(1), vs.grows.load());
+    EXPECT_EQ(size_t(100), vs.moved.load());
+    EXPECT_EQ(size_t(2), vs.allocations.load());
+    EXPECT_LE(size_t(101), vs.peakCapacity.load());
+
+    Vector<int> copy(v);
+    EXPECT_EQ(size_t(3), vs.allocations.load());
+    EXPECT_EQ(size_t(101), vs.peakSize.load());
+
+    ArrayStack<int> stack(64);
+    ArrayQueue<int> queue(32);
+    queue.enqueue(1);
+    EXPECT_EQ(size_t(64), stack.stats().peakCapacity.load());
+    EXPECT_EQ(size_t(0), stack.stats().peakSize.load());
+    EXPECT_EQ(size_t(32), queue.stats().peakCapacity.load());
+    EXPECT_EQ(size_t(1), queue.stats().peakSize.load());
+
+    LinkedQueue<int> list;
+    for (int i = 0; i < 5; ++i)
+        list.enqueue(i);
+    EXPECT_EQ(size_t(5), list.stats().allocations.load());
+    EXPECT_EQ(size_t(5), list.stats().peakSize.load());
+}
+
+TEST_F(TestContainerStats, Categories)
+{
+    Vector<int> a;
+    a.setStatsCategory("Vector \"a\"\n");
+    for (int i = 0; i < 20; ++i)
+        a.insert_back(i);
+    EXPECT_EQ(size_t(20), a.stats().peakSize.load());
+    EXPECT_EQ(&a.stats(), StatsRegistry::instance().category("Vector \"a\"\n"));
+
+    std::ostringstream os;
+    StatsRegistry::instance().dumpJson(os);
+    std::string json = os.str();
+    EXPECT_NE(std::string::npos, json.find("\"Vector \\\"a\\\"\\u000a\": {\"grows\": 1, "));
+    EXPECT_NE(std::string::npos, json.find("\"peakSize\": 20, "));
+}
+
+#else
+
+TEST(TestContainerStats, Disabled)
+{
+    EXPECT_TRUE(std::is_empty<StatsHook>::value);
+    EXPECT_EQ(2 * sizeof(int) + sizeof(int*), sizeof(Vector<int>));
+    EXPECT_EQ(2 * sizeof(int) + sizeof(int*), sizeof(ArrayStack<int>));
+    Vector<int> v;
+    v.setStatsCategory("Vector");
+    v.insert_back(1);
+    EXPECT_EQ(1, v.size());
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <string>
 #include "Deque.h"
+#include "TestError.h"
 #include "gtest/gtest.h"
 
 using std::string;
@@ -47,7 +48,7 @@ public:
 
 TEST_F(TestDeque, Basic)
 {
-    EXPECT_NO_THROW({
+    EXPECT_NO_ERROR({
         Deque<string> s1;
         Deque<string> s2(scale);
         Deque<string> s3(scale, "Hello World!");
@@ -75,7 +76,7 @@ TEST_F(TestDeque, Capacity)
     EXPECT_TRUE(deque.empty());
 
     insert_n(deque, scale, false);
-    EXPECT_NO_THROW({
+    EXPECT_NO_ERROR({
         deque.shrink_to_fit();
     });
     EXPECT_EQ(scale, deque.size());
@@ -83,9 +84,9 @@ TEST_F(TestDeque, Capacity)
 
 TEST_F(TestDeque, ElementAccess)
 {
-    EXPECT_THROW(deque.front(), std::out_of_range);
-    EXPECT_THROW(deque.back(), std::out_of_range);
-    EXPECT_NO_THROW({
+    EXPECT_ERROR(deque.front(), std::out_of_range);
+    EXPECT_ERROR(deque.back(), std::out_of_range);
+    EXPECT_NO_ERROR({
         for (size_t i = 0; i < scale; ++i)
         {
             deque.insert_back(std::to_string(i));
@@ -107,8 +108,8 @@ TEST_F(TestDeque, ElementAccess)
             deque.remove_back();
         }
     });
-    EXPECT_THROW(deque.front(), std::out_of_range);
-    EXPECT_THROW(deque.back(), std::out_of_range);
+    EXPECT_ERROR(deque.front(), std::out_of_range);
+    EXPECT_ERROR(deque.back(), std::out_of_range);
 
     insert_n(deque, scale);
     for (size_t i = 0; i < scale; ++i)
@@ -116,8 +117,8 @@ TEST_F(TestDeque, ElementAccess)
         EXPECT_EQ(std::to_string(i), deque.at(i));
         EXPECT_EQ(std::to_string(i), deque[i]);
     }
-    EXPECT_THROW(deque.at(-1), std::out_of_range);
-    EXPECT_THROW(deque.at(scale), std::out_of_range);
+    EXPECT_ERROR(deque.at(-1), std::out_of_range);
+    EXPECT_ERROR(deque.at(scale), std::out_of_range);
 }
 
 TEST_F(TestDeque, Iterators)
@@ -151,12 +152,12 @@ TEST_F(TestDeque, Iterators)
 
 TEST_F(TestDeque, Modifiers)
 {
-    EXPECT_THROW(deque.remove_back(), std::out_of_range);
-    EXPECT_THROW(deque.remove_front(), std::out_of_range);
-    EXPECT_THROW(deque.remove(deque.begin()), std::out_of_range);
-    EXPECT_THROW(deque.remove(deque.end()), std::out_of_range);
+    EXPECT_ERROR(deque.remove_back(), std::out_of_range);
+    EXPECT_ERROR(deque.remove_front(), std::out_of_range);
+    EXPECT_ERROR(deque.remove(deque.begin()), std::out_of_range);
+    EXPECT_ERROR(deque.remove(deque.end()), std::out_of_range);
 
-    EXPECT_NO_THROW({
+    EXPECT_NO_ERROR({
         insert_n(deque, scale, true);
         for (size_t i = 0; i < scale; ++i)
         {
@@ -185,15 +186,15 @@ TEST_F(TestDeque, Modifiers)
 //            deque.remove(deque.begin());
 //        }
     });
-    EXPECT_THROW(deque.remove_back(), std::out_of_range);
-    EXPECT_THROW(deque.remove_front(), std::out_of_range);
-    EXPECT_THROW(deque.remove(deque.begin()), std::out_of_range);
-    EXPECT_THROW(deque.remove(deque.end()), std::out_of_range);
+    EXPECT_ERROR(deque.remove_back(), std::out_of_range);
+    EXPECT_ERROR(deque.remove_front(), std::out_of_range);
+    EXPECT_ERROR(deque.remove(deque.begin()), std::out_of_range);
+    EXPECT_ERROR(deque.remove(deque.end()), std::out_of_range);
 
     insert_n(deque, scale);
     deque.clear();
     EXPECT_TRUE(deque.empty());
-    EXPECT_THROW(deque.remove_back(), std::out_of_range);
+    EXPECT_ERROR(deque.remove_back(), std::out_of_range);
 
     insert_n(a, scale);
     b.swap(a);
@@ -0,0 +1,15 @@
+#pragma once
+#include "Config.h"
+#include "gtest/gtest.h"
+
+/**
+ * Expectations that follow the error policy of Config.h: a failure throws
+ * Type, or under CPPLIB_NO_EXCEPTIONS aborts with Type in the message.
+ */
+#ifdef CPPLIB_NO_EXCEPTIONS
+#define EXPECT_ERROR(statement, Type) EXPECT_DEATH(statement, #Type)
+#define EXPECT_NO_ERROR(statement) do { statement; } while (0)
+#else
+#define EXPECT_ERROR(statement, Type) EXPECT_THROW(statement, Type)
+#define EXPECT_NO_ERROR(statement) EXPECT_NO_THROW(statement)
+#endif
@@ -0,0 +1,135 @@
+#include <stdexcept>
+#include <string>
+#include "ArrayQueue.h"
+#include "ArrayStack.h"
+#include "Expected.h"
+#include "LinkedQueue.h"
+#include "StaticRingQueue.h"
+#include "StaticStack.h"
+#include "Vector.h"
+#include "TestError.h"
+#include "gtest/gtest.h"
+
+using std::string;
+
+TEST(TestExpected, Value)
+{
+    Expected<string> x(string("Hello"));
+    EXPECT_TRUE(x.hasValue());
+    EXPECT_EQ("Hello", x.value());
+    EXPECT_EQ(5u, x->size());
+    EXPECT_EQ("Hello", x.valueOr("World"));
+
+    Expected<string> y(Error::EMPTY);
+    EXPECT_FALSE(y);
+    EXPECT_EQ(Error::EMPTY, y.error());
+    EXPECT_EQ("World", y.valueOr("World"));
+    EXPECT_ERROR(y.value(), std::out_of_range);
+    EXPECT_ERROR(Expected<int>(Error::INVALID_ARGUMENT).value(), std::invalid_argument);
+
+    y = x;
+    EXPECT_EQ("Hello", *y);
+    x = Error::FULL;
+    EXPECT_EQ(Error::FULL, x.error());
+    EXPECT_EQ("Hello", *y);
+
+    Expected<void> ok;
+    EXPECT_TRUE(ok);
+    EXPECT_NO_ERROR(ok.value());
+    EXPECT_ERROR(Expected<void>(Error::FULL).value(), std::out_of_range);
+}
+
+TEST(TestExpected, Queues)
+{
+    ArrayQueue<string> aq;
+    LinkedQueue<string> lq;
+    StaticRingQueue<string, 4> sq;
+    EXPECT_EQ(Error::EMPTY, aq.tryDequeue().error());
+    EXPECT_EQ(Error::EMPTY, lq.tryDequeue().error());
+    EXPECT_EQ(Error::EMPTY, sq.tryDequeue().error());
+    for (int i = 0; i < 4; ++i)
+    {
+        aq.enqueue(std::to_string(i));
+        lq.enqueue(std::to_string(i));
+        EXPECT_TRUE(sq.tryEnqueue(std::to_string(i)));
+    }
+    EXPECT_EQ(Error::FULL, sq.tryEnqueue("4").error());
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_EQ(std::to_string(i), aq.tryDequeue().value());
+        EXPECT_EQ(std::to_string(i), lq.tryDequeue().value());
+        EXPECT_EQ(std::to_string(i), sq.tryDequeue().value());
+    }
+    EXPECT_FALSE(aq.tryDequeue());
+    EXPECT_FALSE(lq.tryDequeue());
+    EXPECT_FALSE(sq.tryDequeue());
+    EXPECT_ERROR(aq.dequeue(), std::out_of_range);
+    EXPECT_ERROR(sq.front(), std::out_of_range);
+}
+
+TEST(TestExpected, Stacks)
+{
+    ArrayStack<int> as;
+    StaticStack<int, 2> ss;
+    EXPECT_EQ(Error::EMPTY, as.tryPop().error());
+    EXPECT_EQ(Error::EMPTY, ss.tryPop().error());
+    as.push(1);
+    EXPECT_TRUE(ss.tryPush(1));
+    EXPECT_TRUE(ss.tryPush(2));
+    EXPECT_EQ(Error::FULL, ss.tryPush(3).error());
+    EXPECT_EQ(1, as.tryPop().value());
+    EXPECT_EQ(2, ss.tryPop().value());
+    EXPECT_ERROR(as.pop(), std::out_of_range);
+    ss.push(3);
+    EXPECT_ERROR(ss.push(4), std::out_of_range);
+}
+
+TEST(TestExpected, Vector)
+{
+    Vector<int> v;
+    for (int i = 0; i < 10; ++i)
+        v.insert_back(i);
+    EXPECT_EQ(3, v.try_at(3).value());
+    EXPECT_EQ(Error::OUT_OF_RANGE, v.try_at(10).error());
+    EXPECT_EQ(Error::OUT_OF_RANGE, v.try_at(-1).error());
+    EXPECT_ERROR(v.at(10), std::out_of_range);
+}
+
+#ifndef CPPLIB_NO_EXCEPTIONS
+// Copies fine; moving throws while fail is set
+struct Fragile
+{
+    static int live;
+    static bool fail;
+    int x;
+    explicit Fragile(int x) : x(x) { live++; }
+    Fragile(const Fragile& that) : x(that.x) { live++; }
+    Fragile(Fragile&& that) : x(that.x)
+    {
+        if (fail)
+            throw std::runtime_error("move");
+        live++;
+    }
+    ~Fragile() { live--; }
+};
+int Fragile::live = 0;
+bool Fragile::fail = false;
+
+TEST(TestExpected, Assign)
+{
+    {
+        Expected<Fragile> x(Fragile(1));
+        Expected<Fragile> y(Fragile(2));
+        Fragile::fail = true;
+        // The copy into the parameter succeeds, moving it into x throws
+        EXPECT_THROW(x = y, std::runtime_error);
+        Fragile::fail = false;
+        EXPECT_FALSE(x.hasValue());
+        EXPECT_EQ(1, Fragile::live);
+        x = y;
+        EXPECT_EQ(2, x->x);
+        EXPECT_EQ(2, Fragile::live);
+    }
+    EXPECT_EQ(0, Fragile::live);
+}
+#endif
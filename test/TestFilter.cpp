@@ -0,0 +1,196 @@
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "BloomFilter.h"
+#include "CuckooFilter.h"
+#include "Tokenizer.h"
+#include "TestError.h"
+#include "gtest/gtest.h"
+
+using std::string;
+using std::vector;
+
+class TestFilter : public testing::Test
+{
+protected:
+    vector<string> hosts;    // The hostnames of data/ip.csv
+    vector<string> absent;   // Names not among them
+public:
+    virtual void SetUp()
+    {
+        Tokenizer in("data/ip.csv");
+        ASSERT_TRUE(in.isOpen());
+        StringView line;
+        while (in.nextLine(line))
+        {
+            const char* comma = static_cast<const char*>(memchr(line.data(), ',', line.size()));
+            hosts.push_back(string(line.data(), comma != nullptr ? comma - line.data() : line.size()));
+        }
+        ASSERT_GT(hosts.size(), 100u);
+        for (int i = 0; i < 200; ++i)
+            for (const string& host : hosts)
+                absent.push_back("x" + std::to_string(i) + "." + host);
+    }
+    virtual void TearDown() {}
+
+    template<typename Filter>
+    double falsePositives(const Filter& filter)
+    {
+        size_t hits = 0;
+        for (const string& name : absent)
+            hits += filter.contains(name);
+        return static_cast<double>(hits) / absent.size();
+    }
+};
+
+TEST_F(TestFilter, Bloom)
+{
+    for (double fpr : { 0.1, 0.01, 0.001 })
+    {
+        BloomFilter filter(hosts.size(), fpr);
+        for (const string& host : hosts)
+            filter.insert(host);
+        for (const string& host : hosts)
+            EXPECT_TRUE(filter.contains(host));
+        EXPECT_LE(filter.falsePositiveRate(hosts.size()), fpr);
+        EXPECT_LT(falsePositives(filter), 2 * fpr);
+    }
+    EXPECT_ERROR(BloomFilter(10, 0.0), std::invalid_argument);
+}
+
+TEST_F(TestFilter, BloomMoves)
+{
+    BloomFilter filter(hosts.size(), 0.01);
+    for (const string& host : hosts)
+        filter.insert(host);
+    BloomFilter moved(std::move(filter));
+    EXPECT_TRUE(moved.contains(hosts[0]));
+
+    // The moved-from filter has no bits, and copying it or querying it reads none
+    EXPECT_EQ(0u, filter.bytes());
+    EXPECT_FALSE(filter.contains(hosts[0]));
+    BloomFilter copy(filter);
+    EXPECT_EQ(0u, copy.bytes());
+    vector<StringView> keys(hosts.begin(), hosts.begin() + 40);
+    bool out[40] = { true };
+    EXPECT_EQ(0u, copy.contains(keys.data(), keys.size(), out));
+    EXPECT_FALSE(out[0]);
+    copy.clear();
+    EXPECT_ERROR(copy.insert(hosts[0]), std::logic_error);
+
+    // Assigning makes it usable again
+    filter = moved;
+    EXPECT_EQ(moved.bytes(), filter.bytes());
+    for (const string& host : hosts)
+        EXPECT_TRUE(filter.contains(host));
+}
+
+TEST_F(TestFilter, Cuckoo)
+{
+    CuckooFilter<uint8_t> small(hosts.size());
+    CuckooFilter<> filter(hosts.size());
+    for (const string& host : hosts)
+    {
+        EXPECT_TRUE(small.insert(host));
+        EXPECT_TRUE(filter.insert(host));
+    }
+    EXPECT_EQ(filter.size(), static_cast<int>(hosts.size()));
+    for (const string& host : hosts)
+        EXPECT_TRUE(small.contains(host) && filter.contains(host));
+    EXPECT_LT(falsePositives(small), 0.06);
+    EXPECT_LT(falsePositives(filter), 0.001);
+
+    // Erase every other host
+    for (size_t i = 0; i < hosts.size(); i += 2)
+        EXPECT_TRUE(filter.erase(hosts[i]));
+    EXPECT_EQ(filter.size(), static_cast<int>(hosts.size() / 2));
+    for (size_t i = 1; i < hosts.size(); i += 2)
+        EXPECT_TRUE(filter.contains(hosts[i]));
+    size_t stale = 0;
+    for (size_t i = 0; i < hosts.size(); i += 2)
+        stale += filter.contains(hosts[i]);
+    EXPECT_LE(stale, 1u);
+
+    // Fill past capacity until it reports full; nothing inserted is lost
+    CuckooFilter<> full(64);
+    size_t added = 0;
+    while (added < absent.size() && full.insert(absent[added]))
+        ++added;
+    EXPECT_TRUE(full.isFull());
+    EXPECT_GE(added, 64u);
+    for (size_t i = 0; i < added; ++i)
+        EXPECT_TRUE(full.contains(absent[i]));
+}
+
+TEST_F(TestFilter, Bulk)
+{
+    BloomFilter bloom(hosts.size(), 0.01);
+    CuckooFilter<> cuckoo(hosts.size());
+    for (const string& host : hosts)
+    {
+        bloom.insert(host);
+        cuckoo.insert(host);
+    }
+    vector<StringView> keys;
+    for (size_t i = 0; i < hosts.size(); ++i)
+    {
+        keys.push_back(hosts[i]);
+        keys.push_back(absent[i]);
+    }
+    std::unique_ptr<bool[]> out(new bool[keys.size()]);
+    size_t hits, expect;
+    // Both the AVX2 and the portable kernel, where the CPU has AVX2
+    for (SimdLevel level : { SimdLevel::AVX512, SimdLevel::SSE2 })
+    {
+        simdLimit(level);
+        hits = bloom.contains(keys.data(), keys.size(), out.get());
+        expect = 0;
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            EXPECT_EQ(out[i], bloom.contains(keys[i]));
+            expect += out[i];
+        }
+        EXPECT_EQ(hits, expect);
+    }
+    simdLimit(SimdLevel::AVX512);
+    hits = cuckoo.contains(keys.data(), keys.size(), out.get());
+    expect = 0;
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        EXPECT_EQ(out[i], cuckoo.contains(keys[i]));
+        expect += out[i];
+    }
+    EXPECT_EQ(hits, expect);
+}
+
+TEST_F(TestFilter, Serialize)
+{
+    BloomFilter bloom(hosts.size(), 0.01);
+    CuckooFilter<> cuckoo(hosts.size());
+    for (const string& host : hosts)
+    {
+        bloom.insert(host);
+        cuckoo.insert(host);
+    }
+    std::stringstream ss;
+    bloom.save(ss);
+    cuckoo.save(ss);
+    BloomFilter bloom2 = BloomFilter::load(ss);
+    CuckooFilter<> cuckoo2 = CuckooFilter<>::load(ss);
+    EXPECT_EQ(bloom2.bytes(), bloom.bytes());
+    EXPECT_EQ(cuckoo2.size(), cuckoo.size());
+    for (const string& host : hosts)
+        EXPECT_TRUE(bloom2.contains(host) && cuckoo2.contains(host));
+    for (const string& name : absent)
+    {
+        EXPECT_EQ(bloom2.contains(name), bloom.contains(name));
+        EXPECT_EQ(cuckoo2.contains(name), cuckoo.contains(name));
+    }
+
+    std::stringstream bad("not a filter at all, not a filter at all");
+    EXPECT_ERROR(BloomFilter::load(bad), std::runtime_error);
+    std::stringstream wrongTag;
+    cuckoo.save(wrongTag);
+    EXPECT_ERROR(CuckooFilter<uint32_t>::load(wrongTag), std::runtime_error);
+}
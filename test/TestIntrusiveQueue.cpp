@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "IntrusiveQueue.h"
+#include "TestError.h"
+#include "gtest/gtest.h"
+
+using std::string;
+
+struct Retry {};
+
+// Linked into two queues at once through two hooks
+struct Message : QueueHook<>, QueueHook<Retry>
+{
+    int id;
+    explicit Message(int id = 0) : id(id) {}
+};
+
+std::ostream& operator<<(std::ostream& os, const Message& m) { return os << m.id; }
+
+class TestIntrusiveQueue : public testing::Test
+{
+protected:
+    std::mt19937_64 rng;
+    std::vector<Message> pool;
+public:
+    virtual void SetUp()
+    {
+        rng.seed(2017);
+        for (int i = 0; i < 1000; ++i)
+            pool.push_back(Message(i));
+    }
+    virtual void TearDown() {}
+
+    static string str(const IntrusiveQueue<Message>& q)
+    {
+        std::ostringstream os;
+        os << q;
+        return os.str();
+    }
+};
+
+TEST_F(TestIntrusiveQueue, Model)
+{
+    // Elements move between two queues; the model tracks which and in what order
+    IntrusiveQueue<Message> a, b;
+    std::deque<int> ma, mb;
+    size_t next = 0;
+    for (int i = 0; i < 50000; ++i)
+    {
+        int r = int(rng() % 8);
+        if (r < 3 && next < pool.size())
+        {
+            a.enqueue(pool[next]);
+            ma.push_back(int(next++));
+        }
+        else if (r < 5 && !a.isEmpty())
+        {
+            Message& m = a.dequeue();
+            ASSERT_EQ(ma.front(), m.id);
+            ASSERT_FALSE(m.QueueHook<>::isLinked());
+            ma.pop_front();
+            b.enqueue(m);
+            mb.push_back(m.id);
+        }
+        else if (r < 7)
+        {
+            Message* m;
+            ASSERT_EQ(!mb.empty(), b.tryDequeue(m));
+            if (!mb.empty())
+            {
+                ASSERT_EQ(mb.front(), m->id);
+                mb.pop_front();
+                a.enqueue(*m);
+                ma.push_back(m->id);
+            }
+        }
+        else
+        {
+            a.splice(b);
+            ma.insert(ma.end(), mb.begin(), mb.end());
+            mb.clear();
+            ASSERT_TRUE(b.isEmpty());
+        }
+        ASSERT_EQ(int(ma.size()), a.size());
+        ASSERT_EQ(int(mb.size()), b.size());
+        if (!ma.empty())
+        {
+            ASSERT_EQ(ma.front(), a.front().id);
+            ASSERT_EQ(ma.back(), a.back().id);
+        }
+    }
+    std::vector<int> ids;
+    for (const Message& m : a)
+        ids.push_back(m.id);
+    EXPECT_TRUE(std::equal(ma.begin(), ma.end(), ids.begin()));
+    a.clear();
+    b.clear();
+    for (const Message& m : pool)
+        ASSERT_FALSE(m.QueueHook<>::isLinked());
+}
+
+TEST_F(TestIntrusiveQueue, Splice)
+{
+    IntrusiveQueue<Message> a, b, empty;
+    a.splice(b);
+    EXPECT_TRUE(a.isEmpty());
+    for (int i = 0; i < 3; ++i)
+        b.enqueue(pool[i]);
+    a.splice(b);
+    EXPECT_EQ("0 1 2 ", str(a));
+    EXPECT_TRUE(b.isEmpty() && b.begin() == b.end());
+    a.splice(empty);
+    for (int i = 3; i < 5; ++i)
+        b.enqueue(pool[i]);
+    a.splice(b);
+    EXPECT_EQ(5, a.size());
+    EXPECT_EQ(4, a.back().id);
+    // The spliced tail still ends the queue, so it can be extended and drained
+    a.enqueue(pool[5]);
+    EXPECT_EQ("0 1 2 3 4 5 ", str(a));
+    b.enqueue(pool[6]);
+    b.splice(a);
+    EXPECT_EQ("6 0 1 2 3 4 5 ", str(b));
+
+    IntrusiveQueue<Message> moved(std::move(b));
+    EXPECT_TRUE(b.isEmpty());
+    EXPECT_EQ(7, moved.size());
+    a = std::move(moved);
+    swap(a, b);
+    EXPECT_EQ(7, b.size());
+    EXPECT_ERROR(a.dequeue(), std::out_of_range);
+    EXPECT_ERROR(a.front(), std::out_of_range);
+}
+
+TEST_F(TestIntrusiveQueue, Tags)
+{
+    IntrusiveQueue<Message> inbox;
+    IntrusiveQueue<Message, Retry> retries;
+    for (int i = 0; i < 4; ++i)
+        inbox.enqueue(pool[i]);
+    retries.enqueue(pool[2]);
+    retries.enqueue(pool[0]);
+    EXPECT_TRUE(pool[0].QueueHook<Retry>::isLinked());
+    EXPECT_EQ(0, inbox.dequeue().id);
+    EXPECT_EQ(2, retries.front().id);
+    EXPECT_EQ(0, retries.back().id);
+    EXPECT_TRUE(pool[0].QueueHook<Retry>::isLinked());
+    // A copy is not linked anywhere
+    Message copy(pool[1]);
+    EXPECT_FALSE(copy.QueueHook<>::isLinked());
+    inbox.clear();
+    retries.clear();
+}
+
+#ifndef NDEBUG
+TEST_F(TestIntrusiveQueue, Asserts)
+{
+    IntrusiveQueue<Message> a, b;
+    a.enqueue(pool[0]);
+    EXPECT_DEATH(a.enqueue(pool[0]), "already in an IntrusiveQueue");
+    EXPECT_DEATH(b.enqueue(pool[0]), "already in an IntrusiveQueue");
+    EXPECT_DEATH(a.splice(a), "onto itself");
+    EXPECT_DEATH({ IntrusiveQueue<Message> q; Message m; q.enqueue(m); }, "destroyed while in an IntrusiveQueue");
+    a.clear();
+}
+#endif
@@ -0,0 +1,293 @@
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "LruCache.h"
+#include "MemoryResource.h"
+#include "RwLock.h"
+#include "TestError.h"
+#include "gtest/gtest.h"
+
+using std::string;
+
+// Collides every key into a few buckets so probing and backward shifts run
+struct WeakHash
+{
+    size_t operator()(int x) const { return size_t(x % 3); }
+};
+
+class TestLruCache : public testing::Test
+{
+protected:
+    std::mt19937_64 rng;
+    int scale;
+public:
+    virtual void SetUp() { rng.seed(2017); scale = 50000; }
+    virtual void TearDown() {}
+
+    // Exact LRU: recency list with the most recent first, plus its index
+    template<typename Hash>
+    void compare(size_t capacity, int keys)
+    {
+        LruCache<int, int, Hash> cache(capacity);
+        std::list<std::pair<int, int>> order;
+        std::unordered_map<int, std::list<std::pair<int, int>>::iterator> index;
+        for (int i = 0; i < scale; ++i)
+        {
+            int key = int(rng() % keys), r = int(rng() % 10);
+            auto it = index.find(key);
+            if (r < 5)
+            {
+                int v = -1;
+                ASSERT_EQ(it != index.end(), cache.get(key, v));
+                if (it != index.end())
+                {
+                    ASSERT_EQ(it->second->second, v);
+                    order.splice(order.begin(), order, it->second);
+                }
+            }
+            else if (r < 9)
+            {
+                cache.put(key, i);
+                if (it != index.end())
+                {
+                    it->second->second = i;
+                    order.splice(order.begin(), order, it->second);
+                }
+                else
+                {
+                    if (order.size() == capacity)
+                    {
+                        index.erase(order.back().first);
+                        order.pop_back();
+                    }
+                    order.push_front(std::make_pair(key, i));
+                    index[key] = order.begin();
+                }
+            }
+            else
+            {
+                ASSERT_EQ(it != index.end(), cache.erase(key));
+                if (it != index.end())
+                {
+                    order.erase(it->second);
+                    index.erase(it);
+                }
+            }
+            ASSERT_EQ(int(order.size()), cache.size());
+            ASSERT_EQ(index.count(key) > 0, cache.contains(key));
+        }
+    }
+};
+
+TEST_F(TestLruCache, Lru)
+{
+    compare<std::hash<int>>(1, 4);
+    compare<std::hash<int>>(100, 150);
+    compare<std::hash<int>>(1000, 5000);
+    compare<WeakHash>(64, 200);
+}
+
+TEST_F(TestLruCache, Clock)
+{
+    LruCache<string, int> cache(4, Eviction::CLOCK);
+    EXPECT_EQ(Eviction::CLOCK, cache.eviction());
+    for (int i = 0; i < 4; ++i)
+        cache.put(string(1, char('a' + i)), i);
+    int v;
+    // a is referenced, so the hand clears its bit and evicts b instead
+    ASSERT_TRUE(cache.get("a", v));
+    cache.put("e", 4);
+    EXPECT_TRUE(cache.contains("a"));
+    EXPECT_FALSE(cache.contains("b"));
+    EXPECT_EQ(4, cache.size());
+    // The hand has passed a; with no bits set, c is next
+    cache.put("f", 5);
+    EXPECT_FALSE(cache.contains("c"));
+    EXPECT_TRUE(cache.erase("a"));
+    cache.put("g", 6);
+    EXPECT_TRUE(cache.contains("d") && cache.contains("e") && cache.contains("f") && cache.contains("g"));
+    cache.clear();
+    EXPECT_TRUE(cache.isEmpty());
+    EXPECT_FALSE(cache.get("g", v));
+
+    // Whatever it evicts, a hit returns the last value put
+    LruCache<int, int, WeakHash> weak(50, Eviction::CLOCK);
+    std::unordered_map<int, int> last;
+    for (int i = 0; i < scale; ++i)
+    {
+        int key = int(rng() % 120);
+        if (rng() % 2)
+        {
+            weak.put(key, i);
+            last[key] = i;
+        }
+        else if (weak.get(key, v))
+        {
+            ASSERT_EQ(last[key], v);
+        }
+        ASSERT_LE(weak.size(), 50);
+    }
+    EXPECT_EQ(50, weak.size());
+}
+
+TEST_F(TestLruCache, Resource)
+{
+    TrackingResource tracker;
+    {
+        LruCache<int, int> cache(1000, Eviction::LRU, &tracker);
+        for (int i = 0; i < 5000; ++i)
+            cache.put(i, i);
+        EXPECT_EQ(1000, cache.size());
+        EXPECT_EQ(size_t(1000), cache.capacity());
+        EXPECT_GT(tracker.bytesInUse(), size_t(0));
+    }
+    EXPECT_EQ(size_t(0), tracker.bytesInUse());
+    EXPECT_ERROR((LruCache<int, int>(0)), std::invalid_argument);
+}
+
+TEST_F(TestLruCache, Sharded)
+{
+    const Eviction modes[] = { Eviction::LRU, Eviction::CLOCK };
+    for (Eviction mode : modes)
+    {
+        ShardedLruCache<int, int> cache(1000, 3, mode);
+        EXPECT_EQ(size_t(1000), cache.capacity());
+        std::atomic<int> wrong(0), hits(0);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < 4; ++t)
+        {
+            workers.emplace_back([&, t]()
+            {
+                std::mt19937_64 r(t);
+                for (int i = 0; i < 20000; ++i)
+                {
+                    int key = int(r() % 2000), v;
+                    if (r() % 4 == 0)
+                        cache.put(key, key * 7);
+                    else if (r() % 50 == 0)
+                        cache.erase(key);
+                    else if (cache.get(key, v))
+                    {
+                        hits++;
+                        if (v != key * 7)
+                            wrong++;
+                    }
+                }
+            });
+        }
+        for (std::thread& w : workers)
+            w.join();
+        EXPECT_EQ(0, wrong.load());
+        EXPECT_GT(hits.load(), 0);
+        EXPECT_LE(cache.size(), 1000);
+        EXPECT_GT(cache.size(), 0);
+    }
+}
+
+TEST_F(TestLruCache, Readers)
+{
+    // One shard evicts like a CLOCK LruCache, whether hits go through a Reader or not
+    ShardedLruCache<string, int> one(4, 0, Eviction::CLOCK);
+    ShardedLruCache<string, int>::Reader reader(one);
+    for (int i = 0; i < 4; ++i)
+        one.put(string(1, char('a' + i)), i);
+    int v;
+    ASSERT_TRUE(reader.get("a", v));
+    EXPECT_EQ(0, v);
+    one.put("e", 4);
+    EXPECT_FALSE(reader.get("b", v));
+    EXPECT_TRUE(one.get("a", v));
+    EXPECT_TRUE(one.erase("c"));
+    EXPECT_FALSE(one.erase("c"));
+    one.put("f", 5);
+    EXPECT_EQ(4, one.size());
+    EXPECT_TRUE(reader.get("d", v) && reader.get("e", v) && reader.get("f", v));
+    EXPECT_EQ(5, v);
+
+    // Readers race writers that replace, evict and erase under heavy probing
+    ShardedLruCache<int, string, WeakHash> cache(200, 1, Eviction::CLOCK, newDeleteResource(), 8);
+    std::atomic<int> wrong(0), hits(0);
+    std::atomic<bool> done(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            ShardedLruCache<int, string, WeakHash>::Reader r(cache);
+            std::mt19937_64 g(t);
+            string value;
+            while (!done.load())
+            {
+                int key = int(g() % 300);
+                if (r.get(key, value))
+                {
+                    hits++;
+                    if (value.compare(0, std::to_string(key).size() + 1, std::to_string(key) + ":") != 0)
+                        wrong++;
+                }
+            }
+        });
+    }
+    for (int i = 0; i < scale; ++i)
+    {
+        int key = int(rng() % 300);
+        if (rng() % 8 == 0)
+            cache.erase(key);
+        else
+            cache.put(key, std::to_string(key) + ":" + string(size_t(i % 40), 'x'));
+    }
+    done = true;
+    for (std::thread& t : threads)
+        t.join();
+    EXPECT_EQ(0, wrong.load());
+    EXPECT_GT(hits.load(), 0);
+    EXPECT_LE(cache.size(), 200);
+}
+
+TEST_F(TestLruCache, RwLock)
+{
+    RwLock rw;
+    // Two shared holders at once; an exclusive lock would deadlock here
+    {
+        SharedLock a(rw);
+        bool entered = false;
+        std::thread t([&]() { SharedLock b(rw); entered = true; });
+        t.join();
+        EXPECT_TRUE(entered);
+    }
+
+    // Writers keep the pair equal; readers must never see it torn
+    long long x = 0, y = 0;
+    std::atomic<int> torn(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for (int i = 0; i < 20000; ++i)
+            {
+                if (t < 2)
+                {
+                    std::lock_guard<RwLock> lock(rw);
+                    x++;
+                    y++;
+                }
+                else
+                {
+                    SharedLock lock(rw);
+                    if (x != y)
+                        torn++;
+                }
+            }
+        });
+    }
+    for (std::thread& t : threads)
+        t.join();
+    EXPECT_EQ(0, torn.load());
+    EXPECT_EQ(40000, x);
+}
@@ -0,0 +1,186 @@
+#include <stdexcept>
+#include <string>
+#include "ArrayQueue.h"
+#include "ArrayStack.h"
+#include "HugePageResource.h"
+#include "LinkedQueue.h"
+#include "MemoryResource.h"
+#include "Vector.h"
+#include "gtest/gtest.h"
+
+using std::string;
+
+template<typename T>
+using Alloc = PolymorphicAllocator<T>;
+
+class TestMemoryResource : public testing::Test
+{
+protected:
+    TrackingResource tracker;
+    size_t scale;
+public:
+    virtual void SetUp() { scale = 1000; }
+    virtual void TearDown() {}
+};
+
+TEST_F(TestMemoryResource, Tracking)
+{
+    {
+        Vector<string, Alloc<string>> v(4, &tracker);
+        for (size_t i = 0; i < scale; ++i)
+            v.insert_back(std::to_string(i));
+        EXPECT_EQ(scale, size_t(v.size()));
+        EXPECT_EQ("999", v.back());
+        EXPECT_GT(tracker.allocations(), size_t(1));
+        EXPECT_GT(tracker.bytesInUse(), size_t(0));
+    }
+    EXPECT_EQ(tracker.allocations(), tracker.deallocations());
+    EXPECT_EQ(size_t(0), tracker.bytesInUse());
+    EXPECT_GE(tracker.peakBytes(), scale * sizeof(string));
+
+    tracker.reset();
+    EXPECT_EQ(size_t(0), tracker.allocations());
+    EXPECT_EQ(size_t(0), tracker.peakBytes());
+}
+
+#ifndef CPPLIB_NO_EXCEPTIONS
+// Throws from its constructor on the given value
+struct Fragile
+{
+    int value;
+    Fragile(int value) : value(value) { if (value < 0) throw std::invalid_argument("Fragile"); }
+};
+
+TEST_F(TestMemoryResource, Rollback)
+{
+    {
+        LinkedQueue<Fragile, Alloc<Fragile>> list(&tracker);
+        list.emplace(1);
+        EXPECT_THROW(list.emplace(-1), std::invalid_argument);
+        EXPECT_EQ(1, list.size());
+        EXPECT_EQ(tracker.allocations(), tracker.deallocations() + 1);
+    }
+    EXPECT_EQ(size_t(0), tracker.bytesInUse());
+}
+#endif
+
+TEST_F(TestMemoryResource, Arena)
+{
+    MonotonicArena arena(256, &tracker);
+    {
+        ArrayQueue<string, Alloc<string>> queue(&arena);
+        ArrayStack<int, Alloc<int>> stack(&arena);
+        LinkedQueue<int, Alloc<int>> list(&arena);
+        for (size_t i = 0; i < scale; ++i)
+        {
+            queue.enqueue(std::to_string(i));
+            stack.push(int(i));
+            list.enqueue(int(i));
+        }
+        for (size_t i = 0; i < scale; ++i)
+        {
+            EXPECT_EQ(std::to_string(i), queue.dequeue());
+            EXPECT_EQ(int(scale - i - 1), stack.pop());
+            EXPECT_EQ(int(i), list.dequeue());
+        }
+        EXPECT_EQ(&arena, queue.get_allocator().resource());
+    }
+    EXPECT_GT(arena.bytesUsed(), size_t(0));
+    EXPECT_GT(tracker.bytesInUse(), size_t(0));
+    arena.release();
+    EXPECT_EQ(size_t(0), arena.bytesUsed());
+    EXPECT_EQ(size_t(0), tracker.bytesInUse());
+}
+
+TEST_F(TestMemoryResource, Pool)
+{
+    PoolResource pool(&tracker);
+    void* a = pool.allocate(24);
+    pool.deallocate(a, 24);
+    void* b = pool.allocate(20);
+    EXPECT_EQ(a, b);
+    pool.deallocate(b, 20);
+
+    void* c = pool.allocate(64, 64);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(c) % 64);
+    pool.deallocate(c, 64, 64);
+
+    size_t chunks = tracker.allocations();
+    void* big = pool.allocate(4096);
+    EXPECT_EQ(chunks + 1, tracker.allocations());
+    pool.deallocate(big, 4096);
+
+    LinkedQueue<string, Alloc<string>> list(threadLocalPoolResource());
+    for (size_t i = 0; i < scale; ++i)
+        list.enqueue(std::to_string(i));
+    EXPECT_EQ(int(scale), list.size());
+    pool.release();
+    EXPECT_EQ(size_t(0), tracker.bytesInUse());
+}
+
+TEST_F(TestMemoryResource, HugePage)
+{
+    HugePageResource huge(1 << 16, HugePageResource::TOUCH, 2, &tracker);
+    EXPECT_FALSE(huge.mapped(1024));
+    EXPECT_TRUE(huge.mapped(1 << 20));
+
+    void* p = huge.allocate(3 << 20);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p) % HugePageResource::HUGE_PAGE);
+    EXPECT_EQ(size_t(0), tracker.allocations());
+    ASSERT_TRUE(huge.canShrink(3 << 20, 1 << 20));
+    huge.shrink(p, 3 << 20, 1 << 20);
+    static_cast<char*>(p)[(1 << 20) - 1] = 1;
+    huge.deallocate(p, 1 << 20);
+
+    int count = 1 << 16;
+    Vector<int, Alloc<int>> v(&huge);
+    ArrayQueue<int, Alloc<int>> queue(&huge);
+    ArrayStack<int, Alloc<int>> stack(&huge);
+    for (int i = 0; i < count; ++i)
+    {
+        v.insert_back(i);
+        queue.enqueue(i);
+        stack.push(i);
+    }
+    // Rotate the ring so shrinking has to compact a wrapped queue
+    for (int i = 0; i < count / 2; ++i)
+        queue.enqueue(queue.dequeue());
+    for (int i = count - 1; i >= count / 16; --i)
+    {
+        EXPECT_EQ(i, v.back());
+        v.remove_back();
+        EXPECT_EQ(i, stack.pop());
+    }
+    for (int i = 0; i < count - count / 16; ++i)
+        EXPECT_EQ((i + count / 2) % count, queue.dequeue());
+    EXPECT_GT(tracker.allocations(), size_t(0));
+    for (int i = 0; i < count / 16; ++i)
+    {
+        EXPECT_EQ(i, v[i]);
+        EXPECT_EQ((i + count / 2 + count - count / 16) % count, queue.dequeue());
+    }
+}
+
+TEST_F(TestMemoryResource, Other)
+{
+    NewDeleteResource* res = static_cast<NewDeleteResource*>(newDeleteResource());
+    void* p = res->allocate(100, 256);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p) % 256);
+    res->deallocate(p, 100, 256);
+
+    MonotonicArena arena;
+    MemoryResource* old = setDefaultResource(&arena);
+    EXPECT_EQ(&arena, Alloc<int>().resource());
+    setDefaultResource(old);
+    EXPECT_EQ(newDeleteResource(), Alloc<int>().resource());
+
+    Vector<string, Alloc<string>> a(&tracker);
+    Vector<string, Alloc<string>> b(&arena);
+    a.insert_back("x");
+    b = a;
+    EXPECT_TRUE(a == b);
+    a.insert(a.begin(), "y");
+    a.remove(a.begin() + 1);
+    EXPECT_EQ("y", a.front());
+    EXPECT_TRUE(a != b);
+}
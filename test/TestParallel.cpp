@@ -0,0 +1,175 @@
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Parallel.h"
+#include "TestError.h"
+#include "Vector.h"
+#include "gtest/gtest.h"
+
+using std::string;
+using std::vector;
+
+class TestParallel : public testing::Test
+{
+protected:
+    std::mt19937_64 rng;
+    ThreadPool pool;
+    vector<ParallelPolicy> policies;
+public:
+    TestParallel() : pool(4) {}
+    virtual void SetUp()
+    {
+        rng.seed(2017);
+        // Both schedules, with grains that give one chunk, a few, and many uneven ones
+        for (size_t grain : { 1, 7, 1000, 1 << 20 })
+        {
+            policies.push_back(ParallelPolicy(Schedule::STATIC, grain, &pool));
+            policies.push_back(ParallelPolicy(Schedule::DYNAMIC, grain, &pool));
+        }
+        policies.push_back(ParallelPolicy());
+    }
+    virtual void TearDown() {}
+
+    vector<int64_t> random(size_t n)
+    {
+        vector<int64_t> a(n);
+        for (int64_t& x : a)
+            x = int64_t(rng() % 2001) - 1000;
+        return a;
+    }
+};
+
+TEST_F(TestParallel, Reduce)
+{
+    for (size_t n : { 0, 1, 2, 5, 1000, 100003 })
+    {
+        vector<int64_t> a = random(n);
+        int64_t expected = std::accumulate(a.begin(), a.end(), int64_t(7));
+        for (const ParallelPolicy& policy : policies)
+        {
+            ASSERT_EQ(expected, parallel_reduce(a.begin(), a.end(), int64_t(7), std::plus<int64_t>(), policy));
+            auto largest = [](int64_t x, int64_t y) { return std::max(x, y); };
+            ASSERT_EQ(std::accumulate(a.begin(), a.end(), int64_t(-5000), largest),
+                      parallel_reduce(a.begin(), a.end(), int64_t(-5000), largest, policy));
+        }
+        ASSERT_EQ(expected, parallel_reduce(a.begin(), a.end(), int64_t(7)));
+    }
+}
+
+TEST_F(TestParallel, Scans)
+{
+    for (size_t n : { 0, 1, 2, 5, 1000, 100003 })
+    {
+        vector<int64_t> a = random(n), inclusive(n), exclusive(n);
+        std::partial_sum(a.begin(), a.end(), inclusive.begin());
+        for (size_t i = 0; i < n; ++i)
+            exclusive[i] = i == 0 ? 3 : exclusive[i - 1] + a[i - 1];
+        for (const ParallelPolicy& policy : policies)
+        {
+            vector<int64_t> out(n, -1);
+            parallel_inclusive_scan(a.begin(), a.end(), out.begin(), std::plus<int64_t>(), policy);
+            ASSERT_EQ(inclusive, out);
+            parallel_exclusive_scan(a.begin(), a.end(), out.begin(), int64_t(3), std::plus<int64_t>(), policy);
+            ASSERT_EQ(exclusive, out);
+            // In place
+            out = a;
+            parallel_inclusive_scan(out.begin(), out.end(), out.begin(), std::plus<int64_t>(), policy);
+            ASSERT_EQ(inclusive, out);
+            out = a;
+            parallel_exclusive_scan(out.begin(), out.end(), out.begin(), int64_t(3), std::plus<int64_t>(), policy);
+            ASSERT_EQ(exclusive, out);
+        }
+    }
+}
+
+TEST_F(TestParallel, Order)
+{
+    // Concatenation is associative but not commutative, so chunks must combine in order
+    vector<string> words;
+    for (int i = 0; i < 3000; ++i)
+        words.push_back(string(1, char('a' + i % 26)));
+    string all;
+    vector<string> prefix;
+    for (const string& w : words)
+    {
+        all += w;
+        prefix.push_back(all);
+    }
+    for (const ParallelPolicy& policy : policies)
+    {
+        ASSERT_EQ(">" + all, parallel_reduce(words.begin(), words.end(), string(">"), std::plus<string>(), policy));
+        vector<string> out(words.size());
+        parallel_inclusive_scan(words.begin(), words.end(), out.begin(), std::plus<string>(), policy);
+        ASSERT_EQ(prefix, out);
+        parallel_exclusive_scan(words.begin(), words.end(), out.begin(), string(), std::plus<string>(), policy);
+        ASSERT_EQ("", out[0]);
+        ASSERT_EQ(prefix[2998], out[2999]);
+    }
+}
+
+TEST_F(TestParallel, ForEach)
+{
+    vector<int64_t> a = random(50000);
+    for (const ParallelPolicy& policy : policies)
+    {
+        vector<std::atomic<int>> seen(a.size());
+        for (std::atomic<int>& s : seen)
+            s = 0;
+        vector<size_t> index(a.size());
+        std::iota(index.begin(), index.end(), 0);
+        parallel_for_each(index.begin(), index.end(), [&](size_t i) { seen[i]++; }, policy);
+        for (std::atomic<int>& s : seen)
+            ASSERT_EQ(1, s.load());
+        vector<int64_t> out(a.size());
+        parallel_transform(a.begin(), a.end(), out.begin(), [](int64_t x) { return x * x - 1; }, policy);
+        for (size_t i = 0; i < a.size(); ++i)
+            ASSERT_EQ(a[i] * a[i] - 1, out[i]);
+    }
+}
+
+TEST_F(TestParallel, Vector)
+{
+    Vector<int> v;
+    for (int i = 0; i < 10000; ++i)
+        v.insert_back(i % 100);
+    ParallelPolicy policy(Schedule::DYNAMIC, 64, &pool);
+    EXPECT_EQ(495000, parallel_reduce(v, 0));
+    parallel_transform(v, [](int x) { return x + 1; }, policy);
+    EXPECT_EQ(505000, parallel_reduce(v, 0, std::plus<int>(), policy));
+    parallel_for_each(v, [](int& x) { x = 1; }, policy);
+    parallel_inclusive_scan(v, std::plus<int>(), policy);
+    EXPECT_EQ(10000, v.back());
+    EXPECT_EQ(1, v.front());
+    parallel_exclusive_scan(v, 5);
+    EXPECT_EQ(5, v.front());
+    EXPECT_EQ(5 + 9999 * 10000 / 2, v.back());
+    Vector<int> w(0);
+    w.insert_back(2);
+    parallel_inclusive_scan(w);
+    EXPECT_EQ(2, w[0]);
+}
+
+TEST_F(TestParallel, Pool)
+{
+    EXPECT_EQ(4, pool.size());
+    // Every thread runs once; a nested run() runs serially on the calling thread
+    std::atomic<int> calls(0), nested(0);
+    pool.run([&](int t) {
+        calls += 1 << (8 * t);
+        pool.run([&](int) { nested++; });
+    });
+    EXPECT_EQ(0x01010101, calls.load());
+    EXPECT_EQ(16, nested.load());
+#ifndef CPPLIB_NO_EXCEPTIONS
+    EXPECT_THROW(pool.run([](int t) { if (t == 2) throw std::runtime_error("job"); }), std::runtime_error);
+    // The pool still works after a job threw
+    calls = 0;
+    pool.run([&](int) { calls++; });
+    EXPECT_EQ(4, calls.load());
+#endif
+}
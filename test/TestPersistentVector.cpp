@@ -0,0 +1,217 @@
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "MemoryResource.h"
+#include "PersistentVector.h"
+#include "TestError.h"
+#include "gtest/gtest.h"
+
+using std::string;
+using std::vector;
+
+class TestPersistentVector : public testing::Test
+{
+protected:
+    std::mt19937_64 rng;
+    TrackingResource tracker;
+public:
+    virtual void SetUp() { rng.seed(2017); }
+    virtual void TearDown() { EXPECT_EQ(size_t(0), tracker.bytesInUse()); }
+
+    template<typename V>
+    static void same(const vector<int>& model, const V& v)
+    {
+        ASSERT_EQ(int(model.size()), v.size());
+        for (int i = 0; i < v.size(); ++i)
+            ASSERT_EQ(model[i], v[i]);
+    }
+};
+
+TEST_F(TestPersistentVector, Snapshots)
+{
+    // Every version keeps its contents while later ones are derived from it
+    vector<PersistentVector<int>> versions;
+    vector<vector<int>> models;
+    PersistentVector<int> v(&tracker);
+    vector<int> model;
+    for (int i = 0; i < 40000; ++i)
+    {
+        int r = int(rng() % 10);
+        if (r < 7 || model.empty())
+        {
+            v = v.insert_back(i);
+            model.push_back(i);
+        }
+        else if (r < 9)
+        {
+            int k = int(rng() % model.size());
+            v = v.set(k, -i);
+            model[k] = -i;
+        }
+        else
+        {
+            v = v.remove_back();
+            model.pop_back();
+        }
+        if (i % 4000 == 0)
+        {
+            versions.push_back(v);
+            models.push_back(model);
+        }
+    }
+    same(model, v);
+    for (size_t k = 0; k < versions.size(); ++k)
+        same(models[k], versions[k]);
+    // Shrink across every level back to empty
+    while (!v.empty())
+    {
+        v = v.remove_back();
+        model.pop_back();
+        if (model.size() % 997 == 0)
+            same(model, v);
+    }
+    EXPECT_ERROR(v.remove_back(), std::out_of_range);
+    for (size_t k = 0; k < versions.size(); ++k)
+        same(models[k], versions[k]);
+}
+
+TEST_F(TestPersistentVector, Transient)
+{
+    vector<int> model;
+    for (int i = 0; i < 5000; ++i)
+        model.push_back(i);
+    PersistentVector<int> base(model.begin(), model.end(), &tracker);
+    size_t shared = tracker.bytesInUse();
+
+    // Edits copy shared nodes once and leave base alone
+    PersistentVector<int>::Transient t = base.transient();
+    vector<int> edited = model;
+    for (int i = 0; i < 20000; ++i)
+    {
+        int r = int(rng() % 4);
+        if (r == 0)
+        {
+            t.insert_back(i);
+            edited.push_back(i);
+        }
+        else if (r == 1 && !edited.empty())
+        {
+            t.remove_back();
+            edited.pop_back();
+        }
+        else if (!edited.empty())
+        {
+            int k = int(rng() % edited.size());
+            t.set(k, i);
+            edited[k] = i;
+        }
+    }
+    same(edited, t);
+    same(model, base);
+    EXPECT_LE(tracker.bytesInUse(), 3 * shared);
+    EXPECT_ERROR(t.set(t.size(), 0), std::out_of_range);
+    EXPECT_ERROR(t.at(-1), std::out_of_range);
+
+    PersistentVector<int> done = t.persistent();
+    EXPECT_TRUE(t.empty());
+    same(edited, done);
+    EXPECT_TRUE(done != base);
+    EXPECT_TRUE(done.transient().persistent() == done);
+    // A transient over unshared nodes edits in place
+    size_t before = tracker.allocations();
+    PersistentVector<int>::Transient u = PersistentVector<int>(&tracker).transient();
+    for (int i = 0; i < 32; ++i)
+        u.insert_back(i);
+    for (int i = 0; i < 32; ++i)
+        u.set(i, -i);
+    EXPECT_EQ(before + 1, tracker.allocations());
+}
+
+TEST_F(TestPersistentVector, Iterators)
+{
+    vector<string> model;
+    PersistentVector<string> v(&tracker);
+    for (int i = 0; i < 1100; ++i)
+    {
+        model.push_back(std::to_string(i));
+        v = v.insert_back(model.back());
+    }
+    EXPECT_EQ("0", v.front());
+    EXPECT_EQ("1099", v.back());
+    auto it = v.begin();
+    it += 1000;
+    EXPECT_EQ("1000", *it);
+    EXPECT_EQ("999", *--it);
+    EXPECT_EQ("63", it[-936]);
+    EXPECT_EQ(1099, v.end() - it - 1 + 999);
+    size_t i = 0;
+    for (const string& s : v)
+        ASSERT_EQ(model[i++], s);
+    std::ostringstream os;
+    os << v.remove_back().set(0, "x");
+    EXPECT_EQ(0u, os.str().find("x 1 2 "));
+    EXPECT_ERROR(PersistentVector<string>().front(), std::out_of_range);
+}
+
+#ifndef CPPLIB_NO_EXCEPTIONS
+// Fails the allocation after the next limit ones
+class FailingResource : public MemoryResource
+{
+private:
+    MemoryResource* upstream;
+public:
+    int limit;
+    explicit FailingResource(MemoryResource* upstream) : upstream(upstream), limit(-1) {}
+protected:
+    void* doAllocate(size_t bytes, size_t align) override
+    {
+        if (limit == 0)
+            throw std::bad_alloc();
+        if (limit > 0)
+            limit--;
+        return upstream->allocate(bytes, align);
+    }
+    void doDeallocate(void* p, size_t bytes, size_t align) override { upstream->deallocate(p, bytes, align); }
+};
+
+TEST_F(TestPersistentVector, Rollback)
+{
+    // Fill so the next push moves a full tail into a full tree and grows a level
+    FailingResource failing(&tracker);
+    vector<int> model;
+    for (int i = 0; i < 33 * 32; ++i)
+        model.push_back(i);
+    for (int shared = 0; shared < 2; ++shared)
+    {
+        PersistentVector<int> v(model.begin(), model.end(), &failing);
+        size_t bytes = tracker.bytesInUse();
+        for (int limit = 0; ; ++limit)
+        {
+            PersistentVector<int>::Transient t = shared ? v.transient() : PersistentVector<int>(v).transient();
+            if (!shared)
+                v = PersistentVector<int>(&failing);
+            failing.limit = limit;
+            try
+            {
+                t.insert_back(-1);
+            }
+            catch (const std::bad_alloc&)
+            {
+                failing.limit = -1;
+                same(model, t);
+                if (!shared)
+                    v = t.persistent();
+                ASSERT_EQ(bytes, tracker.bytesInUse());
+                continue;
+            }
+            failing.limit = -1;
+            vector<int> grown = model;
+            grown.push_back(-1);
+            same(grown, t);
+            break;
+        }
+    }
+}
+#endif
@@ -0,0 +1,139 @@
+#include <memory>
+#include <string>
+#include <utility>
+#include "ArrayQueue.h"
+#include "ArrayStack.h"
+#include "LinkedQueue.h"
+#include "TestError.h"
+#include "gtest/gtest.h"
+
+using std::string;
+using std::unique_ptr;
+
+// Constructed from several arguments, so emplace has something to forward
+struct Point
+{
+    int x, y;
+    string name;
+    Point(int x, int y, const string& name) : x(x), y(y), name(name) {}
+};
+
+class TestQueue : public testing::Test
+{
+protected:
+    int scale;
+public:
+    virtual void SetUp() { scale = 1000; }
+    virtual void TearDown() {}
+};
+
+TEST_F(TestQueue, Emplace)
+{
+    ArrayQueue<Point> aq(2);
+    LinkedQueue<Point> lq;
+    ArrayStack<Point> as(2);
+    for (int i = 0; i < scale; ++i)
+    {
+        aq.emplace(i, -i, std::to_string(i));
+        lq.emplace(i, -i, std::to_string(i));
+        as.emplace(i, -i, std::to_string(i));
+    }
+    EXPECT_EQ("0", aq.front().name);
+    EXPECT_EQ(scale - 1, aq.back().x);
+    EXPECT_EQ("0", lq.front().name);
+    EXPECT_EQ(1 - scale, lq.back().y);
+    EXPECT_EQ(std::to_string(scale - 1), as.top().name);
+    for (int i = 0; i < scale; ++i)
+    {
+        EXPECT_EQ(i, aq.dequeue().x);
+        EXPECT_EQ(-i, lq.dequeue().y);
+        EXPECT_EQ(std::to_string(scale - 1 - i), as.pop().name);
+    }
+}
+
+TEST_F(TestQueue, TryPop)
+{
+    ArrayQueue<string> aq;
+    LinkedQueue<string> lq;
+    ArrayStack<string> as;
+    string x = "unchanged";
+    EXPECT_FALSE(aq.tryDequeue(x));
+    EXPECT_FALSE(lq.tryDequeue(x));
+    EXPECT_FALSE(as.tryPop(x));
+    EXPECT_EQ("unchanged", x);
+    for (int i = 0; i < scale; ++i)
+    {
+        aq.enqueue(std::to_string(i));
+        lq.enqueue(std::to_string(i));
+        as.push(std::to_string(i));
+    }
+    for (int i = 0; i < scale; ++i)
+    {
+        ASSERT_TRUE(aq.tryDequeue(x));
+        EXPECT_EQ(std::to_string(i), x);
+        ASSERT_TRUE(lq.tryDequeue(x));
+        EXPECT_EQ(std::to_string(i), x);
+        ASSERT_TRUE(as.tryPop(x));
+        EXPECT_EQ(std::to_string(scale - 1 - i), x);
+    }
+    EXPECT_TRUE(aq.isEmpty());
+    EXPECT_TRUE(lq.isEmpty());
+    EXPECT_TRUE(as.isEmpty());
+    EXPECT_ERROR(aq.front(), std::out_of_range);
+    EXPECT_ERROR(lq.back(), std::out_of_range);
+    EXPECT_ERROR(as.top(), std::out_of_range);
+}
+
+TEST_F(TestQueue, References)
+{
+    ArrayQueue<string> aq(4);
+    LinkedQueue<string> lq;
+    ArrayStack<string> as;
+    // Rotate the ring so front and back wrap around the buffer
+    for (int i = 0; i < 3; ++i)
+        aq.enqueue("x");
+    for (int i = 0; i < 6; ++i)
+        aq.enqueue(aq.dequeue() + std::to_string(i));
+    aq.front() = "front";
+    aq.back() += "!";
+    lq.enqueue("a");
+    lq.enqueue("b");
+    lq.front() += "1";
+    lq.back() += "2";
+    as.push("a");
+    as.top() = "top";
+
+    const ArrayQueue<string>& caq = aq;
+    const LinkedQueue<string>& clq = lq;
+    const ArrayStack<string>& cas = as;
+    EXPECT_EQ("front", caq.front());
+    EXPECT_EQ("x25!", caq.back());
+    EXPECT_EQ("a1", clq.front());
+    EXPECT_EQ("b2", clq.back());
+    EXPECT_EQ("top", cas.top());
+}
+
+TEST_F(TestQueue, MoveOnly)
+{
+    ArrayQueue<unique_ptr<int>> aq(1);
+    LinkedQueue<unique_ptr<int>> lq;
+    ArrayStack<unique_ptr<int>> as(1);
+    for (int i = 0; i < scale; ++i)
+    {
+        aq.enqueue(unique_ptr<int>(new int(i)));
+        lq.emplace(new int(i));
+        as.emplace(new int(i));
+    }
+    unique_ptr<int> p;
+    ASSERT_TRUE(aq.tryDequeue(p));
+    EXPECT_EQ(0, *p);
+    EXPECT_EQ(1, *aq.dequeue());
+    ASSERT_TRUE(lq.tryDequeue(p));
+    EXPECT_EQ(0, *p);
+    EXPECT_EQ(1, *lq.dequeue());
+    ASSERT_TRUE(as.tryPop(p));
+    EXPECT_EQ(scale - 1, *p);
+    EXPECT_EQ(scale - 2, *as.pop());
+    EXPECT_EQ(2, *aq.tryDequeue().value());
+    EXPECT_EQ(scale - 3, *as.tryPop().value());
+}
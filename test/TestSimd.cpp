@@ -0,0 +1,118 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "Simd.h"
+#include "TestError.h"
+#include "Vector.h"
+#include "VectorAlgorithm.h"
+#include "gtest/gtest.h"
+
+using std::string;
+
+class TestSimd : public testing::Test
+{
+protected:
+    std::mt19937_64 rng;
+public:
+    virtual void SetUp() { rng.seed(2017); }
+    virtual void TearDown() { simdLimit(SimdLevel::AVX512); }
+
+    // Compare every kernel with SimdScalar at every level, over all lengths
+    // up to 300 and all starting offsets within a 64-byte vector
+    template<typename E>
+    void compare(int range)
+    {
+        std::vector<E> a(300 + 64), b;
+        for (E& x : a)
+            x = static_cast<E>(rng() % range);
+        b = a;
+        const SimdLevel levels[] = { SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512 };
+        for (SimdLevel level : levels)
+        {
+            simdLimit(level);
+            SCOPED_TRACE(simdName(simdLevel()));
+            for (size_t off = 0; off < 64 / sizeof(E); ++off)
+            {
+                for (size_t n = 0; n <= 300; n += off == 0 ? 1 : 37)
+                {
+                    const E* p = a.data() + off;
+                    E x = p[n / 2 % (n + 1)];
+                    ASSERT_EQ(SimdScalar::find(p, n, x), simdFind(p, n, x));
+                    ASSERT_EQ(SimdScalar::count(p, n, x), simdCount(p, n, x));
+                    ASSERT_EQ(SimdScalar::sum(p, n), simdSum(p, n));
+                    ASSERT_TRUE(simdEqual(p, b.data() + off, n));
+                    if (n > 0)
+                    {
+                        E mn, mx, smn, smx;
+                        simdMinmax(p, n, mn, mx);
+                        SimdScalar::minmax(p, n, smn, smx);
+                        ASSERT_EQ(smn, mn);
+                        ASSERT_EQ(smx, mx);
+                        b[off + n - 1] += 1;
+                        ASSERT_FALSE(simdEqual(p, b.data() + off, n));
+                        b[off + n - 1] = a[off + n - 1];
+                    }
+                    std::vector<E> f(n + 2, E(7));
+                    simdFill(f.data() + 1, n, x);
+                    ASSERT_EQ(n, SimdScalar::count(f.data() + 1, n, x));
+                    ASSERT_EQ(E(7), f[n + 1]);
+                }
+            }
+        }
+    }
+};
+
+TEST_F(TestSimd, Kernels)
+{
+    compare<uint8_t>(256);
+    compare<int8_t>(3);
+    compare<int16_t>(1000);
+    compare<uint32_t>(7);
+    compare<int32_t>(1 << 30);
+    compare<uint64_t>(1000000);
+    compare<float>(1000);
+    compare<double>(100);
+}
+
+TEST_F(TestSimd, Count)
+{
+    // Enough equal bytes to overflow the narrow count lanes without a flush
+    std::vector<uint8_t> a(100000, 42);
+    a[777] = 0;
+    for (int level = 0; level <= static_cast<int>(SimdLevel::AVX512); ++level)
+    {
+        simdLimit(static_cast<SimdLevel>(level));
+        EXPECT_EQ(a.size() - 1, simdCount(a.data(), a.size(), uint8_t(42)));
+        EXPECT_EQ(size_t(777), simdFind(a.data(), a.size(), uint8_t(0)));
+    }
+}
+
+TEST_F(TestSimd, Vector)
+{
+    Vector<int> v;
+    for (int i = 0; i < 100; ++i)
+        v.insert_back(i % 10);
+    EXPECT_EQ(3, vectorFind(v, 3));
+    EXPECT_EQ(-1, vectorFind(v, 10));
+    EXPECT_EQ(10, vectorCount(v, 3));
+    EXPECT_EQ(0, vectorMin(v));
+    EXPECT_EQ(9, vectorMax(v));
+    EXPECT_EQ(450, vectorSum(v));
+    Vector<int> w(v);
+    EXPECT_TRUE(vectorEqual(v, w));
+    vectorTransform(w, [](int x) { return x * 2 + 1; });
+    EXPECT_EQ(1000, vectorSum(w));
+    vectorFill(w, 5);
+    EXPECT_EQ(100, vectorCount(w, 5));
+    EXPECT_FALSE(vectorEqual(v, w));
+    EXPECT_ERROR(vectorMinmax(Vector<int>()), std::out_of_range);
+
+    Vector<string> s;
+    s.insert_back("b");
+    s.insert_back("a");
+    s.insert_back("b");
+    EXPECT_EQ(2, vectorCount(s, "b"));
+    EXPECT_EQ(1, vectorFind(s, "a"));
+    EXPECT_EQ("a", vectorMin(s));
+}
@@ -0,0 +1,207 @@
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "EpochDomain.h"
+#include "SnapshotMap.h"
+#include "TestError.h"
+#include "gtest/gtest.h"
+
+using std::string;
+
+// Counts live instances, to see every snapshot freed
+struct Counted
+{
+    static std::atomic<int> live;
+    int x;
+    Counted(int x = 0) : x(x) { live++; }
+    Counted(const Counted& that) : x(that.x) { live++; }
+    Counted& operator=(const Counted& that) { x = that.x; return *this; }
+    ~Counted() { live--; }
+};
+std::atomic<int> Counted::live(0);
+
+// Collides every key into a few buckets so probing and backward shifts run
+struct WeakHash
+{
+    size_t operator()(int x) const { return size_t(x % 5); }
+};
+
+class TestSnapshotMap : public testing::Test
+{
+protected:
+    std::mt19937_64 rng;
+public:
+    virtual void SetUp() { rng.seed(2017); Counted::live = 0; }
+    virtual void TearDown() { EXPECT_EQ(0, Counted::live.load()); }
+};
+
+TEST_F(TestSnapshotMap, Builder)
+{
+    // Diffs applied through Builders match a map edited in place
+    SnapshotMap<int, int, WeakHash> map;
+    SnapshotMap<int, int, WeakHash>::Reader reader(map);
+    std::unordered_map<int, int> model;
+    for (int round = 0; round < 50; ++round)
+    {
+        SnapshotMap<int, int, WeakHash>::Builder b(map);
+        ASSERT_EQ(int(model.size()), b.size());
+        for (int i = 0; i < 200; ++i)
+        {
+            int key = int(rng() % 300), v;
+            if (rng() % 3)
+            {
+                b.put(key, round * 1000 + i);
+                model[key] = round * 1000 + i;
+            }
+            else
+            {
+                ASSERT_EQ(model.erase(key) > 0, b.erase(key));
+            }
+            ASSERT_EQ(model.count(key) > 0, b.find(key, v));
+        }
+        map.publish(std::move(b));
+        EXPECT_EQ(0, b.size());
+        ASSERT_EQ(uint64_t(round + 1), map.version());
+        SnapshotMap<int, int, WeakHash>::View view(reader);
+        ASSERT_EQ(int(model.size()), view.size());
+        for (int key = 0; key < 300; ++key)
+        {
+            int v = -1;
+            ASSERT_EQ(model.count(key) > 0, view.find(key, v));
+            if (model.count(key))
+            {
+                ASSERT_EQ(model[key], v);
+            }
+        }
+    }
+}
+
+TEST_F(TestSnapshotMap, Views)
+{
+    SnapshotMap<string, Counted> map(4);
+    SnapshotMap<string, Counted>::Reader reader(map);
+    SnapshotMap<string, Counted>::Builder b(map, 10);
+    b.put("a", 1);
+    b.put("b", 2);
+    map.publish(std::move(b));
+    Counted c;
+    EXPECT_TRUE(reader.find("a", c));
+    EXPECT_EQ(1, c.x);
+    EXPECT_FALSE(reader.find("z", c));
+
+    // A View keeps its version, and the replaced snapshot, until it ends
+    {
+        SnapshotMap<string, Counted>::View view(reader);
+        SnapshotMap<string, Counted>::Builder diff(map);
+        diff.put("a", 10);
+        diff.erase("b");
+        map.publish(std::move(diff));
+        EXPECT_EQ(uint64_t(1), view.version());
+        EXPECT_TRUE(view.contains("b"));
+        EXPECT_TRUE(view.find("a", c));
+        EXPECT_EQ(1, c.x);
+        EXPECT_EQ(size_t(1), map.pending());
+        EXPECT_EQ(size_t(0), map.reclaim());
+    }
+    EXPECT_EQ(size_t(1), map.reclaim());
+    EXPECT_EQ(size_t(0), map.pending());
+    SnapshotMap<string, Counted>::View view(reader);
+    EXPECT_EQ(uint64_t(2), view.version());
+    EXPECT_FALSE(view.contains("b"));
+    EXPECT_TRUE(view.find("a", c));
+    EXPECT_EQ(10, c.x);
+
+    SnapshotMap<string, Counted> other;
+    SnapshotMap<string, Counted>::Builder foreign(other, 1);
+    EXPECT_ERROR(map.publish(std::move(foreign)), std::invalid_argument);
+}
+
+TEST_F(TestSnapshotMap, Readers)
+{
+    // A fixed number of slots; one freed by a Reader can be claimed again
+    using Map = SnapshotMap<int, int>;
+    Map map(2);
+    Map::Reader a(map);
+    {
+        Map::Reader b(map);
+        EXPECT_ERROR(Map::Reader c(map), std::length_error);
+    }
+    Map::Reader c(map);
+    int v;
+    EXPECT_FALSE(c.find(1, v));
+    EXPECT_ERROR(EpochDomain(0), std::invalid_argument);
+}
+
+TEST_F(TestSnapshotMap, Epochs)
+{
+    EpochDomain domain(4);
+    EpochReader reader(domain);
+    reader.enter();
+    domain.retire(new Counted(1));
+    domain.retire(new Counted(2));
+    // Both were retired while the reader was inside
+    EXPECT_EQ(size_t(0), domain.reclaim());
+    EXPECT_EQ(size_t(2), domain.pending());
+    reader.exit();
+    reader.enter();
+    domain.retire(new Counted(3));
+    EXPECT_EQ(size_t(2), domain.reclaim());
+    EXPECT_EQ(1, Counted::live.load());
+    reader.exit();
+    domain.synchronize();
+    EXPECT_EQ(size_t(0), domain.pending());
+    // The domain frees whatever is still retired when it goes
+    {
+        EpochDomain d;
+        d.retire(new Counted(4));
+    }
+    EXPECT_EQ(0, Counted::live.load());
+}
+
+TEST_F(TestSnapshotMap, Concurrent)
+{
+    // Every snapshot maps each key to its version; readers must never see a mix
+    const int keys = 64, readers = 3;
+    SnapshotMap<int, Counted> map(readers);
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0), views(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < readers; ++t)
+    {
+        threads.emplace_back([&]()
+        {
+            SnapshotMap<int, Counted>::Reader reader(map);
+            while (!done.load())
+            {
+                SnapshotMap<int, Counted>::View view(reader);
+                Counted c;
+                for (int key = 0; key < keys; ++key)
+                    if (view.find(key, c) && uint64_t(c.x) != view.version())
+                        torn++;
+                views++;
+            }
+        });
+    }
+    // Publish only once the readers are running
+    while (views.load() == 0)
+        std::this_thread::yield();
+    for (int version = 1; version <= 500; ++version)
+    {
+        SnapshotMap<int, Counted>::Builder b(map, keys);
+        for (int key = 0; key < keys; ++key)
+            b.put(key, version);
+        map.publish(std::move(b));
+    }
+    done = true;
+    for (std::thread& t : threads)
+        t.join();
+    EXPECT_EQ(0, torn.load());
+    EXPECT_GT(views.load(), 0);
+    EXPECT_EQ(uint64_t(500), map.version());
+    map.reclaim();
+    EXPECT_EQ(size_t(0), map.pending());
+}
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <sstream>
+#include <string>
+#include "ArrayStack.h"
+#include "StaticRingQueue.h"
+#include "StaticStack.h"
+#include "TestError.h"
+#include "gtest/gtest.h"
+
+using std::string;
+
+// Usable in constant expressions under C++11
+constexpr StaticStack<int, 4> EMPTY_STACK;
+static_assert(EMPTY_STACK.isEmpty() && EMPTY_STACK.size() == 0, "empty StaticStack");
+static_assert(StaticRingQueue<int, 8>::capacity() == 8, "StaticRingQueue capacity");
+
+#if __cplusplus >= 201402L
+// Built at compile time: squares, then the queue rotated so it wraps
+constexpr StaticStack<int, 8> squares()
+{
+    StaticStack<int, 8> s;
+    for (int i = 0; i < 8; ++i)
+        s.push(i * i);
+    s.pop();
+    s.top() += 1;
+    return s;
+}
+constexpr StaticRingQueue<int, 4> rotated()
+{
+    StaticRingQueue<int, 4> q;
+    for (int i = 0; i < 4; ++i)
+        q.enqueue(i);
+    for (int i = 4; i < 7; ++i)
+        q.enqueue(q.dequeue() + i);
+    return q;
+}
+constexpr int sum(const StaticRingQueue<int, 4>& q)
+{
+    int s = 0;
+    for (int x : q)
+        s += x;
+    return s;
+}
+constexpr StaticStack<int, 8> SQUARES = squares();
+static_assert(SQUARES.size() == 7 && SQUARES.top() == 37, "constexpr StaticStack");
+static_assert(SQUARES == squares() && !(SQUARES != squares()), "constexpr StaticStack equality");
+#endif
+
+class TestStatic : public testing::Test
+{
+protected:
+    std::mt19937_64 rng;
+    int scale;
+public:
+    virtual void SetUp() { rng.seed(2017); scale = 20000; }
+    virtual void TearDown() {}
+};
+
+TEST_F(TestStatic, Constexpr)
+{
+#if __cplusplus >= 201402L
+    constexpr StaticRingQueue<int, 4> q = rotated();
+    static_assert(q.isFull(), "constexpr StaticRingQueue");
+    static_assert(q.front() == 3 && q.back() == 8, "constexpr StaticRingQueue ends");
+    static_assert(sum(q) == 3 + 4 + 6 + 8, "constexpr StaticRingQueue iteration");
+    EXPECT_EQ(21, sum(q));
+    EXPECT_EQ(36 + 1, SQUARES.top());
+#else
+    EXPECT_TRUE(EMPTY_STACK.isEmpty());
+#endif
+}
+
+TEST_F(TestStatic, Model)
+{
+    // Same results as the growable containers, and full exactly at N
+    StaticStack<int, 16> ss;
+    StaticRingQueue<int, 16> sq;
+    ArrayStack<int> as;
+    std::deque<int> dq;
+    for (int i = 0; i < scale; ++i)
+    {
+        int r = int(rng() % 3);
+        if (r == 0 && !ss.isFull())
+        {
+            ss.push(i);
+            as.push(i);
+        }
+        else if (r == 0)
+        {
+            ASSERT_EQ(16, as.size());
+            ASSERT_TRUE(ss.tryPush(i).error() == Error::FULL);
+        }
+        else if (r == 1 && !ss.isEmpty())
+        {
+            ASSERT_EQ(as.pop(), ss.pop());
+        }
+        if (rng() % 2 && !sq.isFull())
+        {
+            sq.enqueue(i);
+            dq.push_back(i);
+        }
+        else if (!sq.isEmpty())
+        {
+            if (rng() % 4 == 0)
+            {
+                ASSERT_EQ(dq.back(), sq.popBack());
+                dq.pop_back();
+            }
+            else
+            {
+                int x;
+                ASSERT_TRUE(sq.tryDequeue(x));
+                ASSERT_EQ(dq.front(), x);
+                dq.pop_front();
+            }
+        }
+        ASSERT_EQ(as.size(), ss.size());
+        ASSERT_EQ(int(dq.size()), sq.size());
+        ASSERT_TRUE(std::equal(dq.begin(), dq.end(), sq.begin()));
+    }
+}
+
+TEST_F(TestStatic, Errors)
+{
+    StaticStack<string, 2> s;
+    StaticRingQueue<string, 2> q;
+    EXPECT_ERROR(s.pop(), std::out_of_range);
+    EXPECT_ERROR(s.top(), std::out_of_range);
+    EXPECT_ERROR(q.dequeue(), std::out_of_range);
+    EXPECT_ERROR(q.back(), std::out_of_range);
+    StaticStack<int, 1> full;
+    full.push(1);
+    EXPECT_ERROR(full.push(2), std::out_of_range);
+    EXPECT_TRUE(s.tryPop().error() == Error::EMPTY);
+    EXPECT_TRUE(q.tryDequeue().error() == Error::EMPTY);
+    s.emplace(3, 'a');
+    s.push("b");
+    q.emplace("x");
+    q.enqueue("y");
+    EXPECT_ERROR(q.enqueue("z"), std::out_of_range);
+    EXPECT_TRUE(q.tryEnqueue("z").error() == Error::FULL);
+
+    StaticStack<string, 2> t;
+    swap(s, t);
+    EXPECT_TRUE(s.isEmpty());
+    std::ostringstream os;
+    os << t << q;
+    EXPECT_EQ("aaa b x y ", os.str());
+    EXPECT_EQ("b", t.tryPop().value());
+    EXPECT_EQ("x", q.tryDequeue().value());
+}
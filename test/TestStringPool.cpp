@@ -0,0 +1,126 @@
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "MemoryResource.h"
+#include "StringPool.h"
+#include "TestError.h"
+#include "gtest/gtest.h"
+
+using std::string;
+using std::vector;
+
+class TestStringPool : public testing::Test
+{
+protected:
+    std::mt19937_64 rng;
+    vector<string> words;
+public:
+    virtual void SetUp()
+    {
+        rng.seed(2017);
+        // Short, repeated and empty strings, and some with embedded NULs
+        for (int i = 0; i < 5000; ++i)
+            words.push_back("w" + std::to_string(rng() % 2000));
+        words.push_back("");
+        words.push_back(string("a\0b", 3));
+        words.push_back(string("a\0c", 3));
+        words.push_back(string(1000, 'x'));
+    }
+    virtual void TearDown() {}
+};
+
+TEST_F(TestStringPool, Intern)
+{
+    StringPool pool;
+    std::unordered_map<string, StrId> ids;
+    for (const string& w : words)
+    {
+        StrId id = pool.intern(w);
+        auto it = ids.insert(std::make_pair(w, id)).first;
+        ASSERT_EQ(it->second, id);
+        ASSERT_EQ(w, pool.str(id).str());
+    }
+    EXPECT_EQ(int(ids.size()), pool.size());
+    // Ids are dense, and every view still points at its string
+    for (const auto& p : ids)
+    {
+        StrId id = 0;
+        ASSERT_TRUE(pool.find(p.first, id));
+        EXPECT_EQ(p.second, id);
+        EXPECT_LT(id, StrId(pool.size()));
+        EXPECT_EQ(p.first, pool.str(id).str());
+    }
+    StrId id = 12345;
+    EXPECT_FALSE(pool.find("missing", id));
+    EXPECT_EQ(StrId(12345), id);
+    EXPECT_EQ(0u, pool.str(pool.intern("")).size());
+    EXPECT_ERROR(pool.str(StrId(pool.size())), std::out_of_range);
+}
+
+TEST_F(TestStringPool, Bytes)
+{
+    TrackingResource tracker;
+    {
+        StringPool pool(&tracker);
+        size_t distinct = 0;
+        std::set<string> seen;
+        for (const string& w : words)
+            if (seen.insert(w).second)
+                distinct += w.size();
+        for (const string& w : words)
+            pool.intern(w);
+        EXPECT_GE(pool.bytes(), distinct);
+        size_t before = pool.bytes();
+        for (const string& w : words)
+            pool.intern(w);
+        // Interning again stores nothing new
+        EXPECT_EQ(before, pool.bytes());
+        EXPECT_GT(tracker.bytesInUse(), size_t(0));
+    }
+    EXPECT_EQ(size_t(0), tracker.bytesInUse());
+}
+
+TEST_F(TestStringPool, Sharded)
+{
+    for (int bits : { 0, 1, 4 })
+    {
+        ShardedStringPool pool(bits);
+        const int threads = 4;
+        vector<vector<StrId>> ids(threads);
+        vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]()
+            {
+                // Each thread interns every word, starting at a different place
+                for (size_t i = 0; i < words.size(); ++i)
+                    ids[t].push_back(pool.intern(words[(i + t * 997) % words.size()]));
+            });
+        }
+        for (std::thread& w : workers)
+            w.join();
+
+        std::set<string> distinct(words.begin(), words.end());
+        EXPECT_EQ(int(distinct.size()), pool.size());
+        std::set<StrId> unique;
+        for (int t = 0; t < threads; ++t)
+        {
+            for (size_t i = 0; i < words.size(); ++i)
+            {
+                const string& w = words[(i + t * 997) % words.size()];
+                ASSERT_EQ(w, pool.str(ids[t][i]).str());
+                StrId id;
+                ASSERT_TRUE(pool.find(w, id));
+                ASSERT_EQ(id, ids[t][i]);
+                unique.insert(id);
+            }
+        }
+        EXPECT_EQ(distinct.size(), unique.size());
+        StrId id;
+        EXPECT_FALSE(pool.find("missing", id));
+        EXPECT_GE(pool.bytes(), size_t(1000));
+    }
+}
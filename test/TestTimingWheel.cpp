@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <vector>
+#include "TimingWheel.h"
+#include "TestError.h"
+#include "gtest/gtest.h"
+
+using std::vector;
+
+class TestTimingWheel : public testing::Test
+{
+protected:
+    std::mt19937_64 rng;
+    int scale;
+    TimingWheel<int> wheel;
+    // Reference model: handle -> (expiry, value) of every pending timer
+    std::map<TimerHandle, std::pair<uint64_t, int>> pending;
+public:
+    virtual void SetUp() { rng.seed(2017); scale = 20000; }
+    virtual void TearDown() {}
+
+    void schedule(uint64_t delay, int value)
+    {
+        TimerHandle h = wheel.schedule(delay, value);
+        ASSERT_EQ(0u, pending.count(h));
+        pending[h] = std::make_pair(wheel.now() + std::max<uint64_t>(delay, 1), value);
+    }
+    // Advance both and compare the batch with what the model says is due
+    void advance(uint64_t tick)
+    {
+        vector<int> due, got;
+        for (auto it = pending.begin(); it != pending.end(); )
+        {
+            if (it->second.first <= tick)
+            {
+                due.push_back(it->second.second);
+                it = pending.erase(it);
+            }
+            else
+                ++it;
+        }
+        int calls = 0;
+        wheel.advance(tick, [&](const Vector<int>& batch)
+        {
+            ++calls;
+            got.assign(batch.begin(), batch.end());
+        });
+        std::sort(due.begin(), due.end());
+        std::sort(got.begin(), got.end());
+        ASSERT_EQ(due, got);
+        ASSERT_EQ(due.empty() ? 0 : 1, calls);
+        ASSERT_GE(wheel.now(), tick);
+        ASSERT_EQ(int(pending.size()), wheel.size());
+    }
+    uint64_t delay()
+    {
+        switch (rng() % 8)
+        {
+        case 0: return 0;
+        case 1: return rng() % 256;
+        case 2: return rng() % 65536;
+        case 3: return rng() % (1 << 24);
+        case 4: return rng() % (uint64_t(1) << 34);
+        default: return rng() % 1000;
+        }
+    }
+};
+
+TEST_F(TestTimingWheel, Model)
+{
+    uint64_t now = 0;
+    for (int i = 0; i < scale; ++i)
+    {
+        int r = int(rng() % 10);
+        if (r < 6)
+            schedule(delay(), i);
+        else if (r < 8 && !pending.empty())
+        {
+            auto it = pending.begin();
+            std::advance(it, rng() % pending.size());
+            ASSERT_TRUE(wheel.cancel(it->first));
+            ASSERT_FALSE(wheel.cancel(it->first));
+            pending.erase(it);
+        }
+        else
+        {
+            // Mostly single ticks, sometimes a jump across several levels
+            now += rng() % 20 == 0 ? rng() % (uint64_t(1) << 26) : rng() % 300;
+            advance(now);
+        }
+    }
+    // Drain everything, including timers past the top level
+    advance(uint64_t(1) << 35);
+    EXPECT_TRUE(wheel.isEmpty());
+    EXPECT_TRUE(pending.empty());
+}
+
+TEST_F(TestTimingWheel, Boundaries)
+{
+    // Expiries on and around every slot and level edge
+    for (int level = 0; level < 4; ++level)
+    {
+        uint64_t edge = uint64_t(1) << (8 * level);
+        for (uint64_t d : { edge - 1, edge, edge + 1, 2 * edge, 255 * edge })
+            schedule(d, int(level * 10 + pending.size()));
+    }
+    schedule(uint64_t(1) << 32, -1);
+    schedule((uint64_t(1) << 32) + 1, -2);
+    schedule(uint64_t(1) << 40, -3);
+    for (uint64_t t = 0; t < 600; ++t)
+        advance(t);
+    for (uint64_t t : { 65535, 65536, 65537, 1 << 20, 16777215, 16777216, 16777217 })
+        advance(t);
+    advance(uint64_t(1) << 32);
+    advance((uint64_t(1) << 32) + 1);
+    advance(uint64_t(1) << 40);
+    EXPECT_TRUE(wheel.isEmpty());
+}
+
+TEST_F(TestTimingWheel, Handles)
+{
+    TimerHandle a = wheel.schedule(10, 1);
+    wheel.schedule(10, 2);
+    EXPECT_EQ(2, wheel.size());
+    EXPECT_TRUE(wheel.cancel(a));
+    // The slab entry is reused with a new generation; the old handle is dead
+    TimerHandle c = wheel.schedule(5, 3);
+    EXPECT_NE(a, c);
+    EXPECT_EQ(uint32_t(a), uint32_t(c));
+    EXPECT_FALSE(wheel.cancel(a));
+    EXPECT_FALSE(wheel.cancel(TimerHandle(1000)));
+    vector<int> got;
+    wheel.advance(100, [&](const Vector<int>& batch) { got.assign(batch.begin(), batch.end()); });
+    std::sort(got.begin(), got.end());
+    EXPECT_EQ(vector<int>({ 2, 3 }), got);
+    EXPECT_FALSE(wheel.cancel(c));
+    EXPECT_EQ(uint64_t(100), wheel.now());
+
+    // Going back in time processes nothing
+    wheel.schedule(1, 4);
+    int calls = 0;
+    wheel.advance(50, [&](const Vector<int>&) { ++calls; });
+    EXPECT_EQ(0, calls);
+    EXPECT_EQ(1, wheel.size());
+    TimingWheel<int> clock(1000);
+    clock.schedule(1000000, 5);
+    clock.poll([&](const Vector<int>&) { ++calls; });
+    EXPECT_EQ(0, calls);
+}
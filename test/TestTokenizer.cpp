@@ -0,0 +1,180 @@
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "MemoryResource.h"
+#include "StringView.h"
+#include "Tokenizer.h"
+#include "TestError.h"
+#include "gtest/gtest.h"
+
+using std::string;
+using std::vector;
+
+class TestTokenizer : public testing::Test
+{
+protected:
+    std::mt19937_64 rng;
+    string path;
+public:
+    virtual void SetUp()
+    {
+        rng.seed(2017);
+        char name[] = "/tmp/TestTokenizerXXXXXX";
+        int fd = mkstemp(name);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        path = name;
+    }
+    virtual void TearDown() { std::remove(path.c_str()); }
+
+    void write(const string& text)
+    {
+        FILE* f = std::fopen(path.c_str(), "wb");
+        ASSERT_NE(nullptr, f);
+        std::fwrite(text.data(), 1, text.size(), f);
+        std::fclose(f);
+    }
+    // Random text of words, every kind of whitespace, CRLF and long tokens
+    string text(size_t n)
+    {
+        const char* spaces[] = { " ", "  ", "\t", "\n", "\r\n", "\v", "\f", "\n\n" };
+        string s;
+        while (s.size() < n)
+        {
+            size_t len = rng() % 10 == 0 ? rng() % 100 : rng() % 8 + 1;
+            for (size_t i = 0; i < len; ++i)
+                s += char('!' + rng() % 94);
+            s += spaces[rng() % 8];
+        }
+        return s;
+    }
+    static vector<string> words(const string& s)
+    {
+        std::istringstream in(s);
+        vector<string> r;
+        string w;
+        while (in >> w)
+            r.push_back(w);
+        return r;
+    }
+    static vector<string> lines(const string& s)
+    {
+        std::istringstream in(s);
+        vector<string> r;
+        string l;
+        while (std::getline(in, l))
+        {
+            if (!l.empty() && l.back() == '\r')
+                l.pop_back();
+            r.push_back(l);
+        }
+        return r;
+    }
+};
+
+TEST_F(TestTokenizer, Tokens)
+{
+    string s = text(20000);
+    write(s);
+    vector<string> expected = words(s);
+    for (size_t block : { 1, 3, 16, 64, 1 << 20 })
+    {
+        Tokenizer in(path.c_str(), nullptr, block);
+        ASSERT_TRUE(in.isOpen());
+        StringView token;
+        size_t i = 0;
+        while (in.next(token))
+        {
+            ASSERT_LT(i, expected.size());
+            ASSERT_EQ(expected[i++], token.str());
+        }
+        EXPECT_EQ(expected.size(), i);
+        EXPECT_FALSE(in.next(token));
+    }
+}
+
+TEST_F(TestTokenizer, Lines)
+{
+    string s = text(20000) + "last line without newline";
+    write(s);
+    vector<string> expected = lines(s);
+    for (size_t block : { 1, 5, 64, 1 << 20 })
+    {
+        Tokenizer in(path.c_str(), nullptr, block);
+        StringView line;
+        size_t i = 0;
+        while (in.nextLine(line))
+        {
+            ASSERT_LT(i, expected.size());
+            ASSERT_EQ(expected[i++], line.str());
+        }
+        EXPECT_EQ(expected.size(), i);
+    }
+
+    write("");
+    Tokenizer empty(path.c_str());
+    StringView line;
+    EXPECT_FALSE(empty.nextLine(line));
+    EXPECT_FALSE(empty.next(line));
+}
+
+TEST_F(TestTokenizer, Arena)
+{
+    string s = text(5000);
+    write(s);
+    vector<string> expected = words(s);
+    MonotonicArena arena;
+    Tokenizer in(path.c_str(), &arena, 7);
+    vector<StringView> views;
+    StringView token;
+    while (in.next(token))
+        views.push_back(token);
+    ASSERT_EQ(expected.size(), views.size());
+    // Views copied into the arena survive the reads that followed them
+    for (size_t i = 0; i < views.size(); ++i)
+        ASSERT_EQ(expected[i], views[i].str());
+    EXPECT_GE(arena.bytesUsed(), s.size() / 2);
+}
+
+TEST_F(TestTokenizer, Descriptor)
+{
+    Tokenizer missing("/nonexistent/TestTokenizer");
+    StringView token;
+    EXPECT_FALSE(missing.isOpen());
+    EXPECT_FALSE(missing.next(token));
+
+    int fds[2];
+    ASSERT_EQ(0, pipe(fds));
+    string s = "to be or\nnot to - be";
+    ASSERT_EQ(ssize_t(s.size()), ::write(fds[1], s.data(), s.size()));
+    close(fds[1]);
+    {
+        Tokenizer in(fds[0], nullptr, 4);
+        vector<string> got;
+        while (in.next(token))
+            got.push_back(token.str());
+        EXPECT_EQ(words(s), got);
+    }
+    close(fds[0]);
+}
+
+TEST_F(TestTokenizer, StringView)
+{
+    StringView a("hello world");
+    EXPECT_EQ(11u, a.size());
+    EXPECT_EQ("world", a.substr(6).str());
+    EXPECT_EQ("lo", a.substr(3, 2).str());
+    EXPECT_TRUE(a.substr(11).empty());
+    EXPECT_ERROR(a.substr(12), std::out_of_range);
+    EXPECT_TRUE(StringView("abc") < StringView("abd"));
+    EXPECT_TRUE(StringView("ab") < StringView("abc"));
+    EXPECT_EQ(0, StringView().compare(StringView("", 0)));
+    EXPECT_TRUE(StringView(string("xy")) == "xy");
+    std::ostringstream os;
+    os << a.substr(0, 5);
+    EXPECT_EQ("hello", os.str());
+}
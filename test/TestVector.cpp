@@ -0,0 +1,151 @@
+#include <iterator>
+#include <list>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "MemoryResource.h"
+#include "Vector.h"
+#include "TestError.h"
+#include "gtest/gtest.h"
+
+using std::string;
+
+class TestVector : public testing::Test
+{
+protected:
+    Vector<string> a, b, c;
+public:
+    virtual void SetUp()
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            a.insert_back("a" + std::to_string(i));
+            b.insert_back("b" + std::to_string(i));
+            c.insert_back("c" + std::to_string(i));
+        }
+    }
+    virtual void TearDown() {}
+
+    static Vector<string> make(const string& prefix, int count)
+    {
+        Vector<string> v;
+        for (int i = 0; i < count; ++i)
+            v.insert_back(prefix + std::to_string(i));
+        return v;
+    }
+    static string join(const Vector<string>& v)
+    {
+        string s;
+        for (const string& x : v)
+            s += x + " ";
+        return s;
+    }
+};
+
+TEST_F(TestVector, Append)
+{
+    Vector<int> v(2);
+    std::vector<int> source = { 1, 2, 3, 4, 5 };
+    v.append(source.begin(), source.end());
+    std::list<int> list = { 6, 7 };
+    v.append_range(list);
+    std::istringstream in("8 9");
+    v.append(std::istream_iterator<int>(in), std::istream_iterator<int>());
+    ASSERT_EQ(9, v.size());
+    for (int i = 0; i < 9; ++i)
+        EXPECT_EQ(i + 1, v[i]);
+
+    // The range is the Vector itself, whose buffer grows while copying
+    Vector<string> s(3);
+    s.append_range(a);
+    s.append(s.begin(), s.end());
+    EXPECT_EQ("a0 a1 a2 a0 a1 a2 ", join(s));
+    s.append(s.begin() + 4, s.end());
+    s.append_range(s);
+    EXPECT_EQ("a0 a1 a2 a0 a1 a2 a1 a2 a0 a1 a2 a0 a1 a2 a1 a2 ", join(s));
+    s.append(s.end(), s.end());
+    EXPECT_EQ(16, s.size());
+}
+
+TEST_F(TestVector, Plus)
+{
+    Vector<string> ab = a + b;
+    EXPECT_EQ("a0 a1 a2 b0 b1 b2 ", join(ab));
+    EXPECT_TRUE(a + b == ab);
+    EXPECT_TRUE(a + b + c != ab);
+    auto x = make("x", 2) + make("y", 2);
+    EXPECT_EQ("x0 x1 y0 y1 ", join(x));
+
+    Vector<string> s(a);
+    s += b;
+    s += s;
+    EXPECT_EQ(12, s.size());
+    EXPECT_EQ("b2", s.back());
+}
+
+TEST_F(TestVector, Concat)
+{
+    Vector<string> abc = concat(a, b, c);
+    EXPECT_EQ("a0 a1 a2 b0 b1 b2 c0 c1 c2 ", join(abc));
+    EXPECT_EQ(9, abc.capacity());
+    Vector<string> nested = concat(concat(a, b), concat(c, a));
+    EXPECT_EQ("a0 a1 a2 b0 b1 b2 c0 c1 c2 a0 a1 a2 ", join(nested));
+    EXPECT_TRUE(Vector<string>(concat(a, b, c, a)) == nested);
+
+    // The destination may be one of the operands
+    Vector<string> s(a);
+    s += concat(b, s);
+    EXPECT_EQ("a0 a1 a2 b0 b1 b2 a0 a1 a2 ", join(s));
+    s += concat(concat(c, s), concat(a, b));
+    EXPECT_EQ(27, s.size());
+    EXPECT_EQ("b2", s.back());
+
+    TrackingResource tracker;
+    {
+        Vector<int, PolymorphicAllocator<int>> x(2, &tracker), y(3, &tracker);
+        for (int i = 0; i < 2; ++i)
+            x.insert_back(i);
+        size_t before = tracker.allocations();
+        Vector<int, PolymorphicAllocator<int>> z = concat(x, x, x, x, x);
+        EXPECT_EQ(before + 1, tracker.allocations());
+        EXPECT_EQ(10, z.size());
+        EXPECT_EQ(&tracker, z.get_allocator().resource());
+    }
+    EXPECT_EQ(size_t(0), tracker.bytesInUse());
+}
+
+TEST_F(TestVector, PlusChain)
+{
+    // a + b allocates once; the rest append into that temporary as it grows
+    TrackingResource tracker;
+    {
+        using Vec = Vector<int, PolymorphicAllocator<int>>;
+        Vec w(4, &tracker), x(4, &tracker), y(4, &tracker), z(4, &tracker);
+        for (int i = 0; i < 4; ++i)
+        {
+            w.insert_back(i);
+            x.insert_back(4 + i);
+            y.insert_back(8 + i);
+            z.insert_back(12 + i);
+        }
+        size_t before = tracker.allocations();
+        Vec sum = w + x + y + z;
+        EXPECT_EQ(before + 2, tracker.allocations());
+        ASSERT_EQ(16, sum.size());
+        for (int i = 0; i < 16; ++i)
+            EXPECT_EQ(i, sum[i]);
+        EXPECT_EQ(4, w.size());
+    }
+    EXPECT_EQ(size_t(0), tracker.bytesInUse());
+    EXPECT_EQ("a0 a1 a2 b0 b1 b2 c0 c1 c2 a0 a1 a2 ", join(a + b + c + a));
+}
+
+TEST_F(TestVector, Access)
+{
+    EXPECT_EQ("a1", a.at(1));
+    EXPECT_ERROR(a.at(3), std::out_of_range);
+    EXPECT_ERROR(a.at(-1), std::out_of_range);
+    a.insert(a.begin(), "x");
+    a.remove(a.begin() + 1);
+    EXPECT_EQ("x a1 a2 ", join(a));
+}
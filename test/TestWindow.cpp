@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <random>
+#include <string>
+#include <utility>
+#include "Window.h"
+#include "TestError.h"
+#include "gtest/gtest.h"
+
+using std::string;
+
+class TestWindow : public testing::Test
+{
+protected:
+    std::mt19937_64 rng;
+    int scale;
+    // Events of the window, rescanned by the reference model
+    std::deque<std::pair<int, size_t>> events;
+public:
+    virtual void SetUp() { rng.seed(2017); scale = 20000; }
+    virtual void TearDown() {}
+
+    // Next stamp: repeats, small steps and gaps longer than any span
+    size_t step(size_t time)
+    {
+        int r = int(rng() % 10);
+        return time + (r < 3 ? 0 : r < 9 ? rng() % 5 : 50);
+    }
+    // Apply the eviction rules of Window.h to the reference model
+    void evict(WindowBy by, size_t span, size_t time)
+    {
+        if (by == WindowBy::COUNT)
+        {
+            while (events.size() > span)
+                events.pop_front();
+        }
+        else
+        {
+            while (!events.empty() && events.front().second + span <= time)
+                events.pop_front();
+        }
+    }
+    int rescanMin() const
+    {
+        int m = events.front().first;
+        for (const auto& e : events)
+            m = std::min(m, e.first);
+        return m;
+    }
+    int rescanMax() const
+    {
+        int m = events.front().first;
+        for (const auto& e : events)
+            m = std::max(m, e.first);
+        return m;
+    }
+    long long rescanSum() const
+    {
+        long long s = 0;
+        for (const auto& e : events)
+            s += e.first;
+        return s;
+    }
+};
+
+TEST_F(TestWindow, Monotonic)
+{
+    const WindowBy kinds[] = { WindowBy::COUNT, WindowBy::TIME };
+    for (WindowBy by : kinds)
+    {
+        for (size_t span : { 1, 7, 40 })
+        {
+            MinWindow<int> min(by, span);
+            MaxWindow<int> max(by, span);
+            events.clear();
+            size_t time = 0;
+            for (int i = 0; i < scale; ++i)
+            {
+                time = step(time);
+                int x = int(rng() % 1000);
+                min.push(x, time);
+                max.push(x, time);
+                events.push_back(std::make_pair(x, time));
+                evict(by, span, time);
+                ASSERT_EQ(rescanMin(), min.value());
+                ASSERT_EQ(rescanMax(), max.value());
+                if (by == WindowBy::TIME && i % 100 == 99)
+                {
+                    time += span / 2;
+                    min.advance(time);
+                    max.advance(time);
+                    evict(by, span, time);
+                    ASSERT_EQ(events.empty(), min.isEmpty());
+                    if (!events.empty())
+                    {
+                        ASSERT_EQ(rescanMin(), min.value());
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_F(TestWindow, Aggregate)
+{
+    const WindowBy kinds[] = { WindowBy::COUNT, WindowBy::TIME };
+    for (WindowBy by : kinds)
+    {
+        for (size_t span : { 1, 7, 40 })
+        {
+            AggregateWindow<long long> sum(by, span);
+            auto least = [](int a, int b) { return std::min(a, b); };
+            AggregateWindow<int, decltype(least)> min(by, span, least);
+            events.clear();
+            size_t time = 0;
+            for (int i = 0; i < scale; ++i)
+            {
+                time = step(time);
+                int x = int(rng() % 1000) - 500;
+                sum.push(x, time);
+                min.push(x, time);
+                events.push_back(std::make_pair(x, time));
+                evict(by, span, time);
+                ASSERT_EQ(int(events.size()), sum.size());
+                ASSERT_EQ(rescanSum(), sum.value());
+                ASSERT_EQ(rescanMin(), min.value());
+                if (by == WindowBy::TIME && i % 100 == 99)
+                {
+                    time += span;
+                    sum.advance(time);
+                    evict(by, span, time);
+                    ASSERT_TRUE(sum.isEmpty());
+                }
+            }
+        }
+    }
+}
+
+TEST_F(TestWindow, Order)
+{
+    // Concatenation is associative but not commutative
+    AggregateWindow<string> w(WindowBy::COUNT, 3);
+    string all;
+    for (char c = 'a'; c <= 'z'; ++c)
+    {
+        w.push(string(1, c));
+        all += c;
+        EXPECT_EQ(all.substr(all.size() > 3 ? all.size() - 3 : 0), w.value());
+    }
+    w.clear();
+    EXPECT_ERROR(w.value(), std::out_of_range);
+    MinWindow<int> m(WindowBy::COUNT, 2);
+    EXPECT_ERROR(m.value(), std::out_of_range);
+}
+
+TEST_F(TestWindow, Clock)
+{
+    // Stamped by the monotonic clock: nothing is a minute old yet
+    MaxWindow<int> max(WindowBy::TIME, 60000);
+    AggregateWindow<int> sum(WindowBy::TIME, 60000);
+    for (int i = 0; i < 100; ++i)
+    {
+        max.push(i);
+        sum.push(i);
+    }
+    EXPECT_EQ(99, max.value());
+    EXPECT_EQ(4950, sum.value());
+    max.advance(Timer::monotonic_millis() + 60000);
+    sum.advance(Timer::monotonic_millis() + 60000);
+    EXPECT_TRUE(max.isEmpty());
+    EXPECT_TRUE(sum.isEmpty());
+}